@@ -26,311 +26,163 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "esp_wifi.h"
 #include "nvs_flash.h"
-#include "mbedtls/base64.h"
 
-#include "esp_http_client.h"
 #include "sdkconfig.h"
-#include "audio_element.h"
-#include "audio_pipeline.h"
 #include "audio_event_iface.h"
 #include "audio_common.h"
 #include "audio_hal.h"
-#include "http_stream.h"
-#include "i2s_stream.h"
-#include "mp3_decoder.h"
-#include "baidu_sr.h"
-#include "json_utils.h"
 
 #include "board.h"
 #include "esp_peripherals.h"
 #include "periph_button.h"
 #include "periph_wifi.h"
 #include "periph_led.h"
-#include "baidu_sr.h"
-#include "baidu_access_token.h"
+#include "sr_core.h"
+#include "sr_provider_baidu.h"
+#include "sr_provider_xunfei.h"
+#include "sr_provider_mock.h"
+#include "sr_provider_hedge.h"
+#include "sr_provider_netem.h"
+#include "sr_bench.h"
+#include "baidu_sr_token.h"
+#include "sr_clock.h"
+#include "xunfei_sr_auth.h"
 
 static const char *TAG = "BAIDU_SR";
-static char *baidu_access_token = NULL;
 /*
 curl -i -k 'https://aip.baidubce.com/oauth/2.0/token?grant_type=client_credentials&client_id=TcYGnnNycQwKVwitm6PAseNG&client_secret=inumzr0DjbLEmVyQBSOT0PxtFbzjvPa8'
 24.f73a28b84aa7285aa69079a610d9a9ed.2592000.1563181441.282335-16147548
 curl -i -X POST -H "Content-Type: audio/wav;rate=16000" "http://vop.baidu.com/server_api?dev_pid=1536&cuid=xxxxx&token=24.f73a28b84aa7285aa69079a610d9a9ed.2592000.1563181441.282335-16147548" --data-binary "@/home/wyx/esp/REC.WAV"
 */
-#define BAIDU_SR_ENDPOINT  "http://vop.baidu.com/server_api"
-//#define BAIDU_SR_ENDPOINT  "http://192.168.43.171:8000/upload"
-//#define BAIDU_SR_CONFIG           "{\"languageCode\": \"%s\", \"encoding\": \"%s\", \"sampleRateHertz\": %d}"
-//#define BAIDU_SR_BEGIN            "{\"config\": " BAIDU_SR_CONFIG ", \"audio\": {\"content\":\""
-//#define BAIDU_SR_CONFIG           "dev_pid=1536&cuid=xxxxx&token=24.f73a28b84aa7285aa69079a610d9a9ed.2592000.1563181441.282335-16147548"
-#define BAIDU_SR_BEGIN            "{\"dev_pid\":1537,\"rate\":16000,\"channel\":1,\"cuid\":\"%s\",\"format\":\"%s\",\"token\":\"%s\",\"speech\":\""
-#define BAIDU_SR_END              "\",\"len\":%d}"
-#define BAIDU_SR_TASK_STACK (8*1024)
 
-
-#define EXAMPLE_RECORD_PLAYBACK_SAMPLE_RATE (16000)
+#define EXAMPLE_RECORD_PLAYBACK_SAMPLE_RATE (CONFIG_SR_CAPTURE_RATE)
+#if CONFIG_SR_UPLOAD_NARROWBAND
+#define EXAMPLE_UPLOAD_SAMPLE_RATE          (8000)
+#else
+#define EXAMPLE_UPLOAD_SAMPLE_RATE          (16000)
+#endif
+#define EXAMPLE_MAX_PROVIDERS (5)
 
 esp_periph_handle_t led_handle = NULL;
-typedef struct baidu_sr {
-    audio_pipeline_handle_t pipeline;  
-    int                     remain_len;
-    int                     sr_total_write;
-    bool                    is_begin;
-    char                    *buffer;
-    char                    *b64_buffer;
-    audio_element_handle_t  i2s_reader;
-    audio_element_handle_t  http_stream_writer;
-    char                    *cuid;
-    char                    *format;
-    char                    *token;
-    int                     sample_rates;
-    int                     buffer_size;
-    baidu_sr_encoding_t    encoding;
-    char                    *response_text;
-    baidu_sr_event_handle_t on_begin;
-} baidu_sr_t;
-
-void baidu_sr_begin(baidu_sr_handle_t sr)
+
+typedef struct {
+    const sr_provider_t *provider;
+    const void          *config;
+} example_provider_t;
+
+void baidu_sr_begin(sr_core_handle_t sr)
 {
     if (led_handle) {
         periph_led_blink(led_handle, get_green_led_gpio(), 500, 500, true, -1);
     }
     ESP_LOGW(TAG, "Start speaking now");
 }
-    
-static int _http_write_chunk(esp_http_client_handle_t http, const char *buffer, int len)
-{
-    char header_chunk_buffer[16];
-    int header_chunk_len = sprintf(header_chunk_buffer, "%x\r\n", len);
-    if (esp_http_client_write(http, header_chunk_buffer, header_chunk_len) <= 0) {
-        return ESP_FAIL;
-    }
-    int write_len = esp_http_client_write(http, buffer, len);
-    if (write_len <= 0) {
-        ESP_LOGE(TAG, "Error write chunked content");
-        return ESP_FAIL;
-    }
-    if (esp_http_client_write(http, "\r\n", 2) <= 0) {
-        return ESP_FAIL;
-    }
-    return write_len;
-}
-
-static esp_err_t _http_stream_writer_event_handle(http_stream_event_msg_t *msg)
-{
-    esp_http_client_handle_t http = (esp_http_client_handle_t)msg->http_client;
-    baidu_sr_t *sr = (baidu_sr_t *)msg->user_data;
-    int write_len;
-    size_t need_write = 0;
-    
-    if (msg->event_id == HTTP_STREAM_PRE_REQUEST) {
-        // set header
-        ESP_LOGI(TAG, "[ + ] HTTP client HTTP_STREAM_PRE_REQUEST, lenght=%d", msg->buffer_len);
-        sr->sr_total_write = 0;
-        sr->is_begin = true;
-        sr->remain_len = 0;
-        esp_http_client_set_method(http, HTTP_METHOD_POST);
-        esp_http_client_set_post_field(http, NULL, -1); // Chunk content
-        esp_http_client_set_header(http, "Content-Type", "application/json");
-        return ESP_OK;
-    }
-
-    if (msg->event_id == HTTP_STREAM_ON_REQUEST) {
-         //ESP_LOGI(TAG, "HTTP_STREAM_ON_REQUEST, lenght=%d, begin=%d", msg->buffer_len, sr->is_begin);
-        /* Write first chunk */
-        if (sr->is_begin) {
-            sr->is_begin = false;
-            //#define BAIDU_SR_CONFIG           "{\"languageCode\": \"%s\", \"encoding\": \"%s\", \"sampleRateHertz\": %d}"
-            //#define BAIDU_SR_BEGIN            "{\"config\": " BAIDU_SR_CONFIG ", \"audio\": {\"content\":\""
-            int sr_begin_len = snprintf(sr->buffer, sr->buffer_size, BAIDU_SR_BEGIN, sr->cuid,sr->format,sr->token);
-            if (sr->on_begin) {
-                sr->on_begin(sr);
-            }
-            return _http_write_chunk(http, sr->buffer, sr_begin_len);
-        }
-
-        if (msg->buffer_len > sr->buffer_size * 3 / 2) {
-            ESP_LOGE(TAG, "Please use SR Buffer size greeter than %d", msg->buffer_len * 3 / 2);
-            return ESP_FAIL;
-        }
-    
-        /* Write b64 audio data */
-        memcpy(sr->buffer + sr->remain_len, msg->buffer, msg->buffer_len);
-        //sr->sr_total_write += msg->buffer_len;
-        sr->remain_len += msg->buffer_len;
-        int keep_next_time = sr->remain_len % 3;
-        sr->remain_len -= keep_next_time;
-        if (mbedtls_base64_encode((unsigned char *)sr->b64_buffer, sr->buffer_size,  &need_write, (unsigned char *)sr->buffer, sr->remain_len) != 0) {
-            ESP_LOGE(TAG, "Error encode b64");
-            return ESP_FAIL;
-        }
-        sr->sr_total_write+= sr->remain_len;
-        if (keep_next_time > 0) {
-            memcpy(sr->buffer, sr->buffer + sr->remain_len, keep_next_time);
-        }
-        sr->remain_len = keep_next_time;
-        ESP_LOGD(TAG, "Total bytes written: %d", sr->sr_total_write);
-        //   printf("Total bytes written: %d\n",  sr->sr_total_write);
-        write_len = _http_write_chunk(http, (const char *)sr->b64_buffer, need_write);
-        if (write_len <= 0) {
-            return write_len;
-        }
-     
-        if(write_len==need_write)
-        {
-
-        }
-        //sr->sr_total_write += write_len;
-        return write_len;
-    }
-
-    /* Write End chunk */
-    if (msg->event_id == HTTP_STREAM_POST_REQUEST) {
-     
-        need_write = 0;
-        if (sr->remain_len) {
-            if (mbedtls_base64_encode((unsigned char *)sr->b64_buffer, sr->buffer_size,  &need_write, (unsigned char *)sr->buffer, sr->remain_len) != 0) {
-                ESP_LOGE(TAG, "Error encode b64");
-                return ESP_FAIL;
-            }
-            sr->sr_total_write+= sr->remain_len;
-            write_len = _http_write_chunk(http, (const char *)sr->b64_buffer, need_write);
-            if (write_len <= 0) {
-                return write_len;
-            }
-        }
-        ESP_LOGI(TAG, "[ + ] HTTP client HTTP_STREAM_POST_REQUEST, write end chunked marker,total:%d",sr->sr_total_write);   
-        int sr_end_len = snprintf(sr->buffer, sr->buffer_size, BAIDU_SR_END, sr->sr_total_write);    
-        //write_len = _http_write_chunk(http, BAIDU_SR_END, strlen(BAIDU_SR_END));
-        write_len =_http_write_chunk(http, sr->buffer, sr_end_len);
-
-        if (write_len <= 0) {
-            return ESP_FAIL;
-        }
-        /* Finish chunked */
-        if (esp_http_client_write(http, "0\r\n\r\n", 5) <= 0) {
-            return ESP_FAIL;
-        }
-        return write_len;
-    }
-
-    if (msg->event_id == HTTP_STREAM_FINISH_REQUEST) {
 
-        int read_len = esp_http_client_read(http, (char *)sr->buffer, sr->buffer_size);
-        ESP_LOGI(TAG, "[ + ] HTTP client HTTP_STREAM_FINISH_REQUEST, read_len=%d", read_len);
-        if (read_len <= 0) {
-            return ESP_FAIL;
-        }
-        if (read_len > sr->buffer_size - 1) {
-            read_len = sr->buffer_size - 1;
-        }
-        sr->buffer[read_len] = 0;
-        ESP_LOGI(TAG, "Got HTTP Response = %s", (char *)sr->buffer);
-        if (sr->response_text) {
-            free(sr->response_text);
-        }
-        sr->response_text = json_get_token_value(sr->buffer, "result");
-        return ESP_OK;
-    }
-    return ESP_OK;
-}
+#if CONFIG_SR_PROVIDER_BAIDU
+static baidu_sr_token_handle_t token;
+static sr_provider_baidu_config_t baidu_config = {
+    .cuid = "wyx",
+#if CONFIG_BAIDU_SR_RAW_UPLOAD
+    .upload_mode = BAIDU_SR_UPLOAD_RAW,
+#endif
+};
 
-baidu_sr_handle_t baidu_sr_init(baidu_sr_config_t *config)
+static void _token_refreshed(const char *token, void *user_data)
 {
-    audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
-    baidu_sr_t *sr = calloc(1, sizeof(baidu_sr_t));
-    AUDIO_MEM_CHECK(TAG, sr, return NULL);
-    sr->pipeline = audio_pipeline_init(&pipeline_cfg);
-
-    sr->buffer_size = config->buffer_size;
-    if (sr->buffer_size <= 0) {
-        sr->buffer_size = DEFAULT_SR_BUFFER_SIZE;
-    }
-
-    sr->buffer = malloc(sr->buffer_size);
-    AUDIO_MEM_CHECK(TAG, sr->buffer, goto exit_sr_init);
-    sr->b64_buffer = malloc(sr->buffer_size );
-    AUDIO_MEM_CHECK(TAG, sr->b64_buffer, goto exit_sr_init);
-    sr->format = strdup(config->format);
-    AUDIO_MEM_CHECK(TAG, sr->format, goto exit_sr_init);
-    sr->token = strdup(config->token);
-    AUDIO_MEM_CHECK(TAG, sr->token, goto exit_sr_init);
-     sr->cuid = strdup(config->cuid);
-    AUDIO_MEM_CHECK(TAG, sr->cuid, goto exit_sr_init);
-
-    i2s_stream_cfg_t i2s_cfg = I2S_STREAM_CFG_DEFAULT();
-    i2s_cfg.type = AUDIO_STREAM_READER;
-    i2s_cfg.out_rb_size=81920;
-    sr->i2s_reader = i2s_stream_init(&i2s_cfg);
-
-    http_stream_cfg_t http_cfg = {
-        .type = AUDIO_STREAM_WRITER,
-        .event_handle = _http_stream_writer_event_handle,
-        .user_data = sr,
-        .task_stack = BAIDU_SR_TASK_STACK,
-        .task_core=1,
-        //.out_rb_size=40960,
-    };
-    sr->http_stream_writer = http_stream_init(&http_cfg);
-    sr->sample_rates = config->record_sample_rates;
-    //sr->encoding = config->encoding;
-    sr->on_begin = config->on_begin;
-
-    audio_pipeline_register(sr->pipeline, sr->http_stream_writer, "sr_http");
-    audio_pipeline_register(sr->pipeline, sr->i2s_reader,         "sr_i2s");
-    audio_pipeline_link(sr->pipeline, (const char *[]) {"sr_i2s", "sr_http"}, 2);
-    i2s_stream_set_clk(sr->i2s_reader, config->record_sample_rates, 16, 1);
-
-    return sr;
-exit_sr_init:
-    baidu_sr_destroy(sr);
-    return NULL;
+    // Ignored by the other providers
+    sr_core_set_credential((sr_core_handle_t)user_data, token);
 }
-
-esp_err_t baidu_sr_destroy(baidu_sr_handle_t sr)
+#endif
+
+#if CONFIG_SR_PROVIDER_XUNFEI
+static const sr_provider_xunfei_config_t xunfei_config = {
+    .app_id = CONFIG_Xunfei_APPID,
+    .api_key = CONFIG_Xunfei_APIKey,
+    .api_secret = CONFIG_Xunfei_APISecret,
+};
+#endif
+
+#if CONFIG_SR_PROVIDER_BAIDU && CONFIG_SR_PROVIDER_XUNFEI
+static const sr_provider_hedge_config_t hedge_config = {
+    .primary = { &sr_provider_baidu, &baidu_config },
+    .backup = { &sr_provider_xunfei, &xunfei_config },
+    .delay_ms = CONFIG_SR_HEDGE_DELAY_MS,
+};
+#endif
+
+static const sr_provider_mock_config_t mock_config = {
+    .latency_ms = CONFIG_SR_MOCK_LATENCY_MS,
+};
+
+// The mock again, framing like the real service and behind an emulated network
+static const sr_provider_mock_config_t netem_mock_config = {
+    .latency_ms = CONFIG_SR_MOCK_LATENCY_MS,
+#if CONFIG_BAIDU_SR_RAW_UPLOAD
+    .wire = SR_MOCK_WIRE_BAIDU_RAW,
+#else
+    .wire = SR_MOCK_WIRE_BAIDU_JSON,
+#endif
+};
+static sr_provider_netem_config_t netem_config = {
+    .provider = &sr_provider_mock,
+    .config = &netem_mock_config,
+};
+
+#if CONFIG_SR_STEREO_CAPTURE
+static const sr_downmix_cfg_t downmix_config = {
+#if CONFIG_SR_DOWNMIX_DELAY_SUM
+    .mode = SR_DOWNMIX_DELAY_SUM,
+    .delay_us = CONFIG_SR_MIC_DELAY_US,
+#elif CONFIG_SR_DOWNMIX_ADAPTIVE
+    .mode = SR_DOWNMIX_ADAPTIVE,
+#else
+    .mode = SR_DOWNMIX_AVERAGE,
+#endif
+    .spacing_mm = CONFIG_SR_MIC_SPACING_MM,
+};
+#endif
+
+#if CONFIG_SR_SPOOL
+static void _spool_forwarded(sr_core_handle_t sr, const char *text, uint32_t timestamp)
 {
-    if (sr == NULL) {
-        return ESP_FAIL;
-    }
-    audio_pipeline_terminate(sr->pipeline);
-    audio_pipeline_remove_listener(sr->pipeline);
-    audio_pipeline_deinit(sr->pipeline);
-    audio_element_deinit(sr->i2s_reader);
-    audio_element_deinit(sr->http_stream_writer);
-    free(sr->buffer);
-    free(sr->b64_buffer);
-    free(sr->format);
-    free(sr->cuid);
-    free(sr->token);
-    free(sr);
-    return ESP_OK;
+    ESP_LOGI(TAG, "Spooled text (%s, recorded at %u) = %s", sr_core_get_provider_name(sr), timestamp, text);
 }
+#endif
 
-esp_err_t baidu_sr_set_listener(baidu_sr_handle_t sr, audio_event_iface_handle_t listener)
-{
-    if (listener) {
-        audio_pipeline_set_listener(sr->pipeline, listener);
-    }
-    return ESP_OK;
-}
+static example_provider_t providers[EXAMPLE_MAX_PROVIDERS];
+static int provider_count;
+static int provider_index;
 
-esp_err_t baidu_sr_start(baidu_sr_handle_t sr)
+static void _add_provider(const sr_provider_t *provider, const void *config)
 {
-   // snprintf(sr->buffer, sr->buffer_size, BAIDU_SR_ENDPOINT, sr->api_key);
-    audio_element_set_uri(sr->http_stream_writer, BAIDU_SR_ENDPOINT);//sr->buffer);
-    audio_pipeline_reset_items_state(sr->pipeline);
-    audio_pipeline_reset_ringbuffer(sr->pipeline);
-    audio_pipeline_run(sr->pipeline);
-    return ESP_OK;
+    providers[provider_count].provider = provider;
+    providers[provider_count].config = config;
+    provider_count++;
 }
 
-char *baidu_sr_stop(baidu_sr_handle_t sr)
+/* Only between utterances, a Baidu provider is created with the token current at this point */
+static void _next_provider(sr_core_handle_t sr)
 {
-    audio_pipeline_stop(sr->pipeline);
-    ESP_LOGI(TAG, "baidu_sr_stop 1");
-    audio_pipeline_wait_for_stop(sr->pipeline);
-    ESP_LOGI(TAG, "baidu_sr_stop 2");
-    return sr->response_text;
+    int next = (provider_index + 1) % provider_count;
+    // One latency table per provider
+    sr_core_latency_dump(sr);
+    sr_core_task_stats_dump(sr);
+    sr_core_latency_reset(sr);
+#if CONFIG_SR_PROVIDER_BAIDU
+    // The hedge may contain Baidu too
+    char *access_token = baidu_sr_token_get(token);
+    baidu_config.token = access_token ? access_token : "";
+#endif
+    if (sr_core_set_provider(sr, providers[next].provider, providers[next].config) == ESP_OK) {
+        provider_index = next;
+        sr_core_preconnect(sr);
+    }
+#if CONFIG_SR_PROVIDER_BAIDU
+    free(access_token);
+#endif
 }
 
 void app_main(void)
@@ -348,6 +200,18 @@ void app_main(void)
     }
     tcpip_adapter_init();
 
+#if CONFIG_SR_BENCH
+    // Before Wi-Fi starts, so nothing else competes for the CPU
+    sr_bench_config_t bench_cfg = {
+        .sample_rate = EXAMPLE_UPLOAD_SAMPLE_RATE,
+        .capture_rate = EXAMPLE_RECORD_PLAYBACK_SAMPLE_RATE,
+        .repeats = CONFIG_SR_BENCH_REPEATS,
+    };
+    if (sr_bench_run(&bench_cfg) != ESP_OK) {
+        ESP_LOGE(TAG, "Upload path over its benchmark thresholds");
+    }
+#endif
+
     ESP_LOGI(TAG, "[ 0 ] Start and wait for Wi-Fi network");
     esp_periph_config_t periph_cfg = DEFAULT_ESP_PERIPH_SET_CONFIG();
     esp_periph_set_handle_t set = esp_periph_set_init(&periph_cfg);
@@ -381,27 +245,90 @@ void app_main(void)
     audio_board_handle_t board_handle = audio_board_init();
     audio_hal_ctrl_codec(board_handle->audio_hal, AUDIO_HAL_CODEC_MODE_BOTH, AUDIO_HAL_CTRL_START);
 
-     if (baidu_access_token == NULL) {
-        // Must freed `baidu_access_token` after used
-        baidu_access_token = baidu_get_access_token(CONFIG_BAIDU_ACCESS_KEY, CONFIG_BAIDU_SECRET_KEY);
+    // Signing and token expiry need the wall clock, the token request also sets it from its Date header
+    sr_clock_init("http://" XUNFEI_SR_AUTH_HOST "/");
+#if CONFIG_SR_PROVIDER_BAIDU
+    // The token cached in NVS is used as is, it is only fetched here on the first boot
+    baidu_sr_token_config_t token_cfg = {
+        .access_key = CONFIG_BAIDU_ACCESS_KEY,
+        .secret_key = CONFIG_BAIDU_SECRET_KEY,
+    };
+    token = baidu_sr_token_init(&token_cfg);
+    if (token == NULL) {
+        ESP_LOGE(TAG, "No access token, can not recognize");
+        return;
     }
-    //ESP_LOGE(TAG,"baidu_access_token:%s" ,(char *)baidu_access_token);
-    baidu_sr_config_t sr_config = {
-        .format="pcm",
-        .token=(char *)baidu_access_token,
-        //.token="24.e29088d370bb70.2592000.1594802208.282335-16147548",
-        .cuid="wyx",
+    // Must freed `baidu_access_token` after used
+    char *baidu_access_token = baidu_sr_token_get(token);
+    baidu_config.token = baidu_access_token;
+    _add_provider(&sr_provider_baidu, &baidu_config);
+#endif
+#if CONFIG_SR_PROVIDER_XUNFEI
+    _add_provider(&sr_provider_xunfei, &xunfei_config);
+#endif
+#if CONFIG_SR_PROVIDER_BAIDU && CONFIG_SR_PROVIDER_XUNFEI
+    _add_provider(&sr_provider_hedge, &hedge_config);
+#endif
+    _add_provider(&sr_provider_mock, &mock_config);
+    netem_config.scenario = sr_netem_scenario_find(CONFIG_SR_NETEM_SCENARIO);
+    if (netem_config.scenario) {
+        _add_provider(&sr_provider_netem, &netem_config);
+    } else if (strlen(CONFIG_SR_NETEM_SCENARIO) > 0) {
+        ESP_LOGW(TAG, "No network scenario %s", CONFIG_SR_NETEM_SCENARIO);
+    }
+
+    sr_core_placement_t placement = SR_CORE_DEFAULT_PLACEMENT();
+#if CONFIG_SR_AUDIO_ON_APP_CPU
+    // Wi-Fi runs on core 0, the audio gets core 1 and the uploader and hedge senders join Wi-Fi and lwIP
+    placement.i2s.core = 1;
+    placement.downmix.core = 1;
+    placement.resample.core = 1;
+    placement.capture.core = 1;
+    placement.encoder.core = 1;
+    placement.upload.core = 0;
+    placement.hedge.core = 0;
+#endif
+    sr_core_config_t sr_config = {
+        .provider = providers[0].provider,
+        .provider_config = providers[0].config,
         .record_sample_rates = EXAMPLE_RECORD_PLAYBACK_SAMPLE_RATE,
+        .upload_sample_rate = EXAMPLE_UPLOAD_SAMPLE_RATE,
+#if CONFIG_SR_STEREO_CAPTURE
+        .downmix = &downmix_config,
+#endif
+#if CONFIG_BAIDU_SR_AMRWB_UPLOAD
+        .encoding = SR_AUDIO_AMR_WB,
+#endif
+        .preroll_ms = CONFIG_BAIDU_SR_PREROLL_MS,
+        .memory_budget = CONFIG_BAIDU_SR_MEMORY_BUDGET_KB * 1024,
+        .max_stall_ms = CONFIG_BAIDU_SR_MAX_STALL_MS,
+#if CONFIG_BAIDU_SR_WARM_PIPELINE
+        .warm_pipeline = true,
+#endif
+        .replay_size = CONFIG_SR_REPLAY_KB > 0 ? CONFIG_SR_REPLAY_KB * 1024 : -1,
+        .max_retries = CONFIG_SR_MAX_RETRIES > 0 ? CONFIG_SR_MAX_RETRIES : -1,
         .on_begin = baidu_sr_begin,
+#if CONFIG_SR_SPOOL
+        .spool_partition = CONFIG_SR_SPOOL_PARTITION,
+        .on_forward = _spool_forwarded,
+#endif
+        .placement = &placement,
+#if CONFIG_SR_TASK_STATS
+        .task_stats = true,
+#endif
     };
-    baidu_sr_handle_t sr = baidu_sr_init(&sr_config);
+    sr_core_handle_t sr = sr_core_init(&sr_config);
+#if CONFIG_SR_PROVIDER_BAIDU
+    free(baidu_access_token);
+    baidu_sr_token_start_refresh(token, _token_refreshed, sr);
+#endif
 
     ESP_LOGI(TAG, "[ 4 ] Set up  event listener");
     audio_event_iface_cfg_t evt_cfg = AUDIO_EVENT_IFACE_DEFAULT_CFG();
     audio_event_iface_handle_t evt = audio_event_iface_init(&evt_cfg);
 
     ESP_LOGI(TAG, "[4.1] Listening event from the pipeline");
-    baidu_sr_set_listener(sr, evt); 
+    sr_core_set_listener(sr, evt);
 
     ESP_LOGI(TAG, "[4.2] Listening event from peripherals");
     audio_event_iface_set_listener(esp_periph_set_get_event_iface(set), evt);
@@ -409,6 +336,9 @@ void app_main(void)
     ESP_LOGI(TAG, "[ 5 ] Listen for all pipeline events");
     ESP_LOGE(TAG, "AUDIO_ELEMENT_TYPE_ELEMENT:%x",AUDIO_ELEMENT_TYPE_ELEMENT);
     ESP_LOGE(TAG, "AUDIO_ELEMENT_TYPE_PERIPH:%x",AUDIO_ELEMENT_TYPE_PERIPH);
+    ESP_LOGI(TAG, "Ready to record, %d ms after boot", (int)(esp_timer_get_time() / 1000));
+    // The first press then finds the connection open
+    sr_core_preconnect(sr);
     while (1) {
         audio_event_iface_msg_t msg;
         if (audio_event_iface_listen(evt, &msg, portMAX_DELAY) != ESP_OK) {
@@ -418,13 +348,35 @@ void app_main(void)
 
         ESP_LOGI(TAG, "[ * ] Event received: src_type:0x%x, source:%p cmd:%d, data:%p, data_len:%d",msg.source_type, msg.source, msg.cmd, msg.data, msg.data_len);
 
+        if (msg.source_type == SR_CORE_EVENT_SOURCE && msg.cmd == SR_CORE_EVENT_LATENCY) {
+            const sr_latency_report_t *report = (const sr_latency_report_t *)msg.data;
+            sr_latency_stats_t total;
+            sr_core_get_latency(sr, SR_LATENCY_STAGE_TOTAL, &total);
+            ESP_LOGI(TAG, "Release to result %d ms, p50 %d p95 %d p99 %d over %d utterances",
+                     report->stage_ms[SR_LATENCY_STAGE_TOTAL], total.p50_ms, total.p95_ms, total.p99_ms, total.count);
+            if (CONFIG_SR_LATENCY_DUMP_EVERY > 0 && total.count > 0 && total.count % CONFIG_SR_LATENCY_DUMP_EVERY == 0) {
+                sr_core_latency_dump(sr);
+                sr_core_task_stats_dump(sr);
+            }
+            continue;
+        }
+
+        // Back online, forward what was spooled meanwhile
+        if (msg.source_type == PERIPH_ID_WIFI && msg.cmd == PERIPH_WIFI_CONNECTED) {
+            sr_core_spool_flush(sr);
+            continue;
+        }
+
         if (msg.source_type != PERIPH_ID_BUTTON) {
             continue;
         }
 
         // It's MODE button
         if ((int)msg.data == get_input_mode_id()) {
-           // break;
+            if (msg.cmd == PERIPH_BUTTON_PRESSED && provider_count > 1) {
+                _next_provider(sr);
+            }
+            continue;
         }
 
         if ((int)msg.data != get_input_rec_id()) {
@@ -433,29 +385,37 @@ void app_main(void)
 
         if (msg.cmd == PERIPH_BUTTON_PRESSED) {         
             ESP_LOGI(TAG, "[ * ] Resuming pipeline");
-            baidu_sr_start(sr);
+            sr_core_start(sr);
         } else if (msg.cmd == PERIPH_BUTTON_RELEASE || msg.cmd == PERIPH_BUTTON_LONG_RELEASE) {
             ESP_LOGI(TAG, "[ * ] Stop pipeline");
 
             periph_led_stop(led_handle, get_green_led_gpio());
 
-            char *original_text = baidu_sr_stop(sr);
+            char *original_text = sr_core_stop(sr);
+            // Normally a no-op, reopens the connection if the server did not keep it
+            sr_core_preconnect(sr);
             if (original_text == NULL) {
                 continue;
             }
-            ESP_LOGI(TAG, "Original text = %s", original_text);
+            sr_core_result_info_t info;
+            sr_core_get_result_info(sr, &info);
+            ESP_LOGI(TAG, "Original text (%s, %d retries, +%d ms) = %s", sr_core_get_provider_name(sr),
+                     info.retries, info.retry_ms, original_text);
            // char *translated_text = baidu_translate(original_text, BAIDU_TRANSLATE_LANG_FROM, BAIDU_TRANSLATE_LANG_TO, CONFIG_BAIDU_API_KEY);
           //  if (translated_text == NULL) {
           //      continue;
          //  }
           //  ESP_LOGI(TAG, "Translated text = %s", translated_text);
-         
+
         }//else if
 
     }//while(1)
     ESP_LOGI(TAG, "[ 6 ] Stop audio_pipeline");
-    baidu_sr_destroy(sr);
-   
+#if CONFIG_SR_PROVIDER_BAIDU
+    baidu_sr_token_destroy(token);
+#endif
+    sr_core_destroy(sr);
+
     /* Stop all periph before removing the listener */
     esp_periph_set_stop_all(set);
     audio_event_iface_remove_listener(esp_periph_set_get_event_iface(set), evt);
@@ -0,0 +1,79 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+#include "baidu_sr_proto.h"
+
+#define BAIDU_SR_BEGIN            "{\"dev_pid\":%d,\"rate\":%d,\"channel\":1,\"cuid\":\"%s\",\"format\":\"%s\",\"token\":\"%s\",\"speech\":\""
+#define BAIDU_SR_END              "\",\"len\":%d}"
+#define BAIDU_SR_RAW_URI          "%s?dev_pid=%d&cuid=%s&token=%s"
+#define BAIDU_SR_RAW_CONTENT_TYPE "audio/%s;rate=%d"
+
+/* Three "%s" and two "%d" replaced by the fields, one NUL */
+_Static_assert(sizeof(BAIDU_SR_BEGIN) - 11 + BAIDU_SR_PROTO_DEV_PID_DIGITS + BAIDU_SR_PROTO_RATE_DIGITS + BAIDU_SR_PROTO_CUID_MAX + BAIDU_SR_PROTO_FORMAT_MAX + BAIDU_SR_PROTO_TOKEN_MAX
+               <= BAIDU_SR_PROTO_JSON_BEGIN_MAX, "BAIDU_SR_PROTO_JSON_BEGIN_MAX too small");
+_Static_assert(sizeof(BAIDU_SR_END) - 3 + 10 <= BAIDU_SR_PROTO_JSON_END_MAX, "BAIDU_SR_PROTO_JSON_END_MAX too small");
+_Static_assert(sizeof(BAIDU_SR_RAW_URI) - 9 + BAIDU_SR_PROTO_DEV_PID_DIGITS <= BAIDU_SR_PROTO_RAW_URI_MAX(0) - BAIDU_SR_PROTO_CUID_MAX - BAIDU_SR_PROTO_TOKEN_MAX,
+               "BAIDU_SR_PROTO_RAW_URI_MAX too small");
+
+int baidu_sr_proto_chunk_header(char *out, int len)
+{
+    return sprintf(out, "%x\r\n", len);
+}
+
+int baidu_sr_proto_json_begin(char *out, int size, int dev_pid, const char *cuid, const char *format, int rate, const char *token)
+{
+    int len = snprintf(out, size, BAIDU_SR_BEGIN, dev_pid, rate, cuid, format, token);
+    if (len < 0 || len >= size) {
+        return -1;
+    }
+    return len;
+}
+
+int baidu_sr_proto_json_end(char *out, int size, int total_len)
+{
+    int len = snprintf(out, size, BAIDU_SR_END, total_len);
+    if (len < 0 || len >= size) {
+        return -1;
+    }
+    return len;
+}
+
+int baidu_sr_proto_raw_uri(char *out, int size, const char *endpoint, int dev_pid, const char *cuid, const char *token)
+{
+    int len = snprintf(out, size, BAIDU_SR_RAW_URI, endpoint, dev_pid, cuid, token);
+    if (len < 0 || len >= size) {
+        return -1;
+    }
+    return len;
+}
+
+int baidu_sr_proto_raw_content_type(char *out, int size, const char *format, int rate)
+{
+    int len = snprintf(out, size, BAIDU_SR_RAW_CONTENT_TYPE, format, rate);
+    if (len < 0 || len >= size) {
+        return -1;
+    }
+    return len;
+}
@@ -0,0 +1,128 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _BAIDU_SR_PROTO_H_
+#define _BAIDU_SR_PROTO_H_
+
+/*
+ * Wire format of the Baidu `server_api` upload.
+ *
+ * Nothing in here depends on FreeRTOS, the audio pipeline or the HTTP client,
+ * so the framing can be compiled and exercised on a host as well as on target.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BAIDU_SR_PROTO_CHUNK_HEADER_MAX   (11)   /*!< "%x\r\n" for a 32-bit length, with the NUL sprintf adds */
+#define BAIDU_SR_PROTO_CHUNK_TRAILER      "\r\n"
+#define BAIDU_SR_PROTO_CHUNK_TRAILER_LEN  (2)
+#define BAIDU_SR_PROTO_CHUNK_OVERHEAD     (BAIDU_SR_PROTO_CHUNK_HEADER_MAX + BAIDU_SR_PROTO_CHUNK_TRAILER_LEN)
+#define BAIDU_SR_PROTO_LAST_CHUNK         "0\r\n\r\n"
+#define BAIDU_SR_PROTO_LAST_CHUNK_LEN     (5)
+
+#define BAIDU_SR_PROTO_TOKEN_MAX          (128)  /*!< Access tokens are about 70 characters */
+#define BAIDU_SR_PROTO_CUID_MAX           (64)
+#define BAIDU_SR_PROTO_FORMAT_MAX         (8)
+#define BAIDU_SR_PROTO_DEV_PID_DIGITS     (5)    /*!< Language models are numbered 1536-80001 */
+#define BAIDU_SR_PROTO_DEFAULT_DEV_PID    (1537) /*!< Mandarin */
+#define BAIDU_SR_PROTO_RATE_DIGITS        (5)    /*!< The service takes 8000 or 16000 Hz */
+/** Worst case baidu_sr_proto_json_begin() length for fields within the limits above */
+#define BAIDU_SR_PROTO_JSON_BEGIN_MAX     (96 + BAIDU_SR_PROTO_CUID_MAX + BAIDU_SR_PROTO_FORMAT_MAX + BAIDU_SR_PROTO_TOKEN_MAX)
+/** Worst case baidu_sr_proto_json_end() length, the total length has at most 10 digits */
+#define BAIDU_SR_PROTO_JSON_END_MAX       (20)
+/** Worst case baidu_sr_proto_raw_uri() length for an endpoint of `endpoint_len` characters */
+#define BAIDU_SR_PROTO_RAW_URI_MAX(endpoint_len) ((endpoint_len) + 32 + BAIDU_SR_PROTO_CUID_MAX + BAIDU_SR_PROTO_TOKEN_MAX)
+
+/**
+ * @brief      Format the hex size line that precedes a chunk of `len` bytes
+ *
+ * @param[out] out       Output buffer, at least BAIDU_SR_PROTO_CHUNK_HEADER_MAX bytes
+ * @param[in]  len       Chunk payload length
+ *
+ * @return     Number of bytes written to `out`
+ */
+int baidu_sr_proto_chunk_header(char *out, int len);
+
+/**
+ * @brief      Format the JSON prefix sent before the base64 `speech` value
+ *
+ * @param[out] out       Output buffer
+ * @param[in]  size      Size of the output buffer
+ * @param[in]  dev_pid   Language model, at most BAIDU_SR_PROTO_DEV_PID_DIGITS digits
+ * @param[in]  cuid      Device id
+ * @param[in]  format    Audio format, e.g. "pcm"
+ * @param[in]  rate      Sample rate in Hz
+ * @param[in]  token     Access token
+ *
+ * @return     Number of bytes written, or -1 if `out` is too small
+ */
+int baidu_sr_proto_json_begin(char *out, int size, int dev_pid, const char *cuid, const char *format, int rate, const char *token);
+
+/**
+ * @brief      Format the JSON suffix closing the `speech` value
+ *
+ * @param[out] out       Output buffer
+ * @param[in]  size      Size of the output buffer
+ * @param[in]  total_len Raw (not base64) length of the uploaded audio
+ *
+ * @return     Number of bytes written, or -1 if `out` is too small
+ */
+int baidu_sr_proto_json_end(char *out, int size, int total_len);
+
+/**
+ * @brief      Format the request URI for a raw audio upload
+ *
+ * In raw mode `dev_pid`, `cuid` and `token` travel in the query string and
+ * the body is the bare audio stream.
+ *
+ * @param[out] out       Output buffer
+ * @param[in]  size      Size of the output buffer
+ * @param[in]  endpoint  Recognizer endpoint without query string
+ * @param[in]  dev_pid   Language model, at most BAIDU_SR_PROTO_DEV_PID_DIGITS digits
+ * @param[in]  cuid      Device id
+ * @param[in]  token     Access token
+ *
+ * @return     Number of bytes written, or -1 if `out` is too small
+ */
+int baidu_sr_proto_raw_uri(char *out, int size, const char *endpoint, int dev_pid, const char *cuid, const char *token);
+
+/**
+ * @brief      Format the Content-Type header for a raw audio upload, e.g. "audio/pcm;rate=16000"
+ *
+ * @param[out] out       Output buffer
+ * @param[in]  size      Size of the output buffer
+ * @param[in]  format    Audio format, e.g. "pcm"
+ * @param[in]  rate      Sample rate in Hz
+ *
+ * @return     Number of bytes written, or -1 if `out` is too small
+ */
+int baidu_sr_proto_raw_content_type(char *out, int size, const char *format, int rate);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,321 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "esp_http_client.h"
+#include "audio_error.h"
+#include "baidu_sr_token.h"
+#include "sr_clock.h"
+#include "sr_json.h"
+
+static const char *TAG = "BAIDU_SR_TOKEN";
+
+#define BAIDU_SR_TOKEN_NVS_NAMESPACE    "baidu_sr"
+#define BAIDU_SR_TOKEN_NVS_TOKEN        "token"
+#define BAIDU_SR_TOKEN_NVS_EXPIRE       "expire"
+#define BAIDU_SR_TOKEN_LIFETIME         (2592000)
+#define BAIDU_SR_TOKEN_TIME_VALID       (1546300800)    /* 2019-01-01, anything earlier means the clock was never set */
+#define BAIDU_SR_TOKEN_RETRY_S          (60)
+#define BAIDU_SR_TOKEN_CHECK_S          (3600)
+#define BAIDU_SR_TOKEN_TASK_STACK       (8*1024)
+#define BAIDU_SR_TOKEN_TASK_PRIO        (1)
+#define BAIDU_SR_TOKEN_HTTP_TIMEOUT_MS  (10000)
+#define BAIDU_SR_TOKEN_SIZE_MAX         (256)
+
+typedef struct baidu_sr_token {
+    char                        *endpoint;
+    char                        *access_key;
+    char                        *secret_key;
+    char                        *token;
+    time_t                      expire;             /* Wall clock expiry, 0 if unknown */
+    int64_t                     refresh_time;       /* esp_timer deadline for a token fetched in this boot, 0 if none */
+    int                         margin_s;
+    SemaphoreHandle_t           lock;
+    SemaphoreHandle_t           exited;
+    TaskHandle_t                task;
+    volatile bool               running;
+    baidu_sr_token_refresh_cb_t on_refresh;
+    void                        *user_data;
+} baidu_sr_token_t;
+
+/* "24.<hash>.<expires_in>.<issued>.<id>" */
+static int _token_lifetime(const char *token, time_t *expire)
+{
+    long expires_in = 0;
+    long issued = 0;
+    if (sscanf(token, "%*[^.].%*[^.].%ld.%ld", &expires_in, &issued) != 2 || expires_in <= 0) {
+        *expire = 0;
+        return BAIDU_SR_TOKEN_LIFETIME;
+    }
+    *expire = issued + expires_in;
+    return expires_in;
+}
+
+static void _token_load(baidu_sr_token_t *t)
+{
+    nvs_handle handle;
+    size_t len = 0;
+    int64_t expire = 0;
+    if (nvs_open(BAIDU_SR_TOKEN_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return;
+    }
+    if (nvs_get_str(handle, BAIDU_SR_TOKEN_NVS_TOKEN, NULL, &len) == ESP_OK && len > 1) {
+        t->token = malloc(len);
+        if (t->token && nvs_get_str(handle, BAIDU_SR_TOKEN_NVS_TOKEN, t->token, &len) != ESP_OK) {
+            free(t->token);
+            t->token = NULL;
+        }
+    }
+    if (nvs_get_i64(handle, BAIDU_SR_TOKEN_NVS_EXPIRE, &expire) == ESP_OK) {
+        t->expire = expire;
+    }
+    nvs_close(handle);
+}
+
+static void _token_save(baidu_sr_token_t *t)
+{
+    nvs_handle handle;
+    if (nvs_open(BAIDU_SR_TOKEN_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        ESP_LOGW(TAG, "Error open NVS, token not saved");
+        return;
+    }
+    if (nvs_set_str(handle, BAIDU_SR_TOKEN_NVS_TOKEN, t->token) != ESP_OK
+            || nvs_set_i64(handle, BAIDU_SR_TOKEN_NVS_EXPIRE, t->expire) != ESP_OK
+            || nvs_commit(handle) != ESP_OK) {
+        ESP_LOGW(TAG, "Error save token to NVS");
+    }
+    nvs_close(handle);
+}
+
+typedef struct {
+    char    token[BAIDU_SR_TOKEN_SIZE_MAX];
+    int     len;
+} baidu_sr_token_reply_t;
+
+static void _token_on_value(sr_json_t *json, sr_json_type_t type, const char *data, int len, bool done, void *user_data)
+{
+    baidu_sr_token_reply_t *reply = (baidu_sr_token_reply_t *)user_data;
+    if (type == SR_JSON_STRING && sr_json_path_is(json, "access_token")) {
+        sr_json_append(reply->token, sizeof(reply->token), &reply->len, data, len);
+    }
+}
+
+/*
+ * Same request as baidu_get_access_token() of ESP-ADF, made here so that the
+ * `Date` of the reply sets the clock before SNTP has answered.
+ */
+static char *_token_request(baidu_sr_token_t *t)
+{
+    baidu_sr_token_reply_t reply = { 0 };
+    char buf[128];
+    sr_json_t json;
+    char *token = NULL;
+    int url_len = snprintf(NULL, 0, "%s?grant_type=client_credentials&client_id=%s&client_secret=%s",
+                           t->endpoint, t->access_key, t->secret_key);
+    char *url = malloc(url_len + 1);
+    AUDIO_MEM_CHECK(TAG, url, return NULL);
+    snprintf(url, url_len + 1, "%s?grant_type=client_credentials&client_id=%s&client_secret=%s",
+             t->endpoint, t->access_key, t->secret_key);
+    esp_http_client_config_t http_cfg = {
+        .url = url,
+        .timeout_ms = BAIDU_SR_TOKEN_HTTP_TIMEOUT_MS,
+        .event_handler = sr_clock_http_event_handler,
+    };
+    esp_http_client_handle_t http = esp_http_client_init(&http_cfg);
+    AUDIO_MEM_CHECK(TAG, http, goto exit_token_request);
+    if (esp_http_client_open(http, 0) != ESP_OK) {
+        ESP_LOGE(TAG, "Error connect to %s", t->endpoint);
+        goto exit_token_request;
+    }
+    esp_http_client_fetch_headers(http);
+    if (esp_http_client_get_status_code(http) != 200) {
+        ESP_LOGE(TAG, "Token request failed, status %d", esp_http_client_get_status_code(http));
+        goto exit_token_request;
+    }
+    sr_json_init(&json, _token_on_value, &reply);
+    int ret = SR_JSON_MORE;
+    int len;
+    while (ret == SR_JSON_MORE && (len = esp_http_client_read(http, buf, sizeof(buf))) > 0) {
+        ret = sr_json_feed(&json, buf, len);
+    }
+    if (ret != SR_JSON_DONE || reply.len == 0) {
+        ESP_LOGE(TAG, "No access_token in the reply");
+        goto exit_token_request;
+    }
+    token = strdup(reply.token);
+exit_token_request:
+    if (http) {
+        esp_http_client_cleanup(http);
+    }
+    free(url);
+    return token;
+}
+
+static esp_err_t _token_fetch(baidu_sr_token_t *t)
+{
+    int64_t start = esp_timer_get_time();
+    char *token = _token_request(t);
+    if (token == NULL) {
+        ESP_LOGE(TAG, "Error fetch access token");
+        return ESP_FAIL;
+    }
+    xSemaphoreTake(t->lock, portMAX_DELAY);
+    free(t->token);
+    t->token = token;
+    int lifetime = _token_lifetime(token, &t->expire);
+    t->refresh_time = esp_timer_get_time() + (int64_t)(lifetime - t->margin_s) * 1000000;
+    _token_save(t);
+    xSemaphoreGive(t->lock);
+    ESP_LOGI(TAG, "Fetched access token in %d ms, valid for %d s", (int)((esp_timer_get_time() - start) / 1000), lifetime);
+    return ESP_OK;
+}
+
+/* Seconds until the token should be refreshed */
+static int64_t _token_refresh_in(baidu_sr_token_t *t)
+{
+    time_t now = time(NULL);
+    if (now >= BAIDU_SR_TOKEN_TIME_VALID && t->expire > 0) {
+        return (int64_t)t->expire - t->margin_s - now;
+    }
+    if (t->refresh_time > 0) {
+        return (t->refresh_time - esp_timer_get_time()) / 1000000;
+    }
+    return 0;
+}
+
+static void _token_task(void *pv)
+{
+    baidu_sr_token_t *t = (baidu_sr_token_t *)pv;
+    while (t->running) {
+        int64_t wait_s = _token_refresh_in(t);
+        if (wait_s <= 0) {
+            if (_token_fetch(t) == ESP_OK) {
+                xSemaphoreTake(t->lock, portMAX_DELAY);
+                if (t->on_refresh) {
+                    t->on_refresh(t->token, t->user_data);
+                }
+                xSemaphoreGive(t->lock);
+                continue;
+            }
+            wait_s = BAIDU_SR_TOKEN_RETRY_S;
+        }
+        if (wait_s > BAIDU_SR_TOKEN_CHECK_S) {
+            wait_s = BAIDU_SR_TOKEN_CHECK_S;
+        }
+        /* Woken early by baidu_sr_token_destroy */
+        ulTaskNotifyTake(pdTRUE, wait_s * 1000 / portTICK_PERIOD_MS);
+    }
+    xSemaphoreGive(t->exited);
+    vTaskDelete(NULL);
+}
+
+baidu_sr_token_handle_t baidu_sr_token_init(baidu_sr_token_config_t *config)
+{
+    baidu_sr_token_t *t = calloc(1, sizeof(baidu_sr_token_t));
+    AUDIO_MEM_CHECK(TAG, t, return NULL);
+    t->endpoint = strdup(config->endpoint ? config->endpoint : BAIDU_SR_TOKEN_ENDPOINT);
+    AUDIO_MEM_CHECK(TAG, t->endpoint, goto exit_token_init);
+    t->access_key = strdup(config->access_key);
+    AUDIO_MEM_CHECK(TAG, t->access_key, goto exit_token_init);
+    t->secret_key = strdup(config->secret_key);
+    AUDIO_MEM_CHECK(TAG, t->secret_key, goto exit_token_init);
+    t->lock = xSemaphoreCreateMutex();
+    AUDIO_MEM_CHECK(TAG, t->lock, goto exit_token_init);
+    t->exited = xSemaphoreCreateBinary();
+    AUDIO_MEM_CHECK(TAG, t->exited, goto exit_token_init);
+    t->margin_s = config->refresh_margin_s;
+    if (t->margin_s <= 0) {
+        t->margin_s = BAIDU_SR_TOKEN_DEFAULT_MARGIN;
+    }
+
+    _token_load(t);
+    if (t->token) {
+        ESP_LOGI(TAG, "Using access token from NVS");
+        return t;
+    }
+    if (_token_fetch(t) != ESP_OK) {
+        goto exit_token_init;
+    }
+    return t;
+exit_token_init:
+    baidu_sr_token_destroy(t);
+    return NULL;
+}
+
+char *baidu_sr_token_get(baidu_sr_token_handle_t t)
+{
+    xSemaphoreTake(t->lock, portMAX_DELAY);
+    char *token = strdup(t->token);
+    xSemaphoreGive(t->lock);
+    return token;
+}
+
+esp_err_t baidu_sr_token_start_refresh(baidu_sr_token_handle_t t, baidu_sr_token_refresh_cb_t on_refresh, void *user_data)
+{
+    if (t->task) {
+        return ESP_FAIL;
+    }
+    t->on_refresh = on_refresh;
+    t->user_data = user_data;
+    t->running = true;
+    if (xTaskCreate(_token_task, "sr_token", BAIDU_SR_TOKEN_TASK_STACK, t, BAIDU_SR_TOKEN_TASK_PRIO, &t->task) != pdPASS) {
+        ESP_LOGE(TAG, "Error create token refresh task");
+        t->running = false;
+        t->task = NULL;
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t baidu_sr_token_destroy(baidu_sr_token_handle_t t)
+{
+    if (t == NULL) {
+        return ESP_FAIL;
+    }
+    if (t->task) {
+        t->running = false;
+        xTaskNotifyGive(t->task);
+        xSemaphoreTake(t->exited, portMAX_DELAY);
+    }
+    if (t->lock) {
+        vSemaphoreDelete(t->lock);
+    }
+    if (t->exited) {
+        vSemaphoreDelete(t->exited);
+    }
+    free(t->endpoint);
+    free(t->access_key);
+    free(t->secret_key);
+    free(t->token);
+    free(t);
+    return ESP_OK;
+}
@@ -0,0 +1,108 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _BAIDU_SR_TOKEN_H_
+#define _BAIDU_SR_TOKEN_H_
+
+/*
+ * Baidu access token kept in NVS across boots.
+ *
+ * A token is valid for 2592000 s (30 days), so fetching one at every boot
+ * only delays the first recording. The cached token is used right away and
+ * a low priority task replaces it ahead of expiry.
+ */
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BAIDU_SR_TOKEN_DEFAULT_MARGIN   (24*3600)   /*!< Refresh one day before expiry */
+#define BAIDU_SR_TOKEN_ENDPOINT         "https://aip.baidubce.com/oauth/2.0/token"
+
+typedef struct baidu_sr_token* baidu_sr_token_handle_t;
+
+/**
+ * Called from the refresh task with the new token, which is only valid during the call
+ */
+typedef void (*baidu_sr_token_refresh_cb_t)(const char *token, void *user_data);
+
+typedef struct {
+   const char *access_key;             /*!< Baidu Cloud API Key */
+   const char *secret_key;             /*!< Baidu Cloud Secret Key */
+   int refresh_margin_s;               /*!< Refresh this long before expiry, BAIDU_SR_TOKEN_DEFAULT_MARGIN if 0 */
+   const char *endpoint;               /*!< OAuth token url, BAIDU_SR_TOKEN_ENDPOINT if NULL */
+} baidu_sr_token_config_t;
+
+/**
+ * @brief      Load the token stored in NVS, fetch one only if there is none
+ *
+ * @param      config  The token cache configuration
+ *
+ * @return     The token cache, NULL if no token could be loaded or fetched
+ */
+baidu_sr_token_handle_t baidu_sr_token_init(baidu_sr_token_config_t *config);
+
+/**
+ * @brief      Get a copy of the current token
+ *
+ * @param[in]  token   The token cache
+ *
+ * @return     Token string, must be freed by the caller
+ */
+char *baidu_sr_token_get(baidu_sr_token_handle_t token);
+
+/**
+ * @brief      Start the background task that refreshes the token ahead of expiry
+ *
+ * Without a valid wall clock the age of a stored token is unknown, it is
+ * then refreshed once in the background and tracked with esp_timer.
+ *
+ * @param[in]  token       The token cache
+ * @param[in]  on_refresh  Receives every new token
+ * @param[in]  user_data   Passed to `on_refresh`
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_FAIL
+ */
+esp_err_t baidu_sr_token_start_refresh(baidu_sr_token_handle_t token, baidu_sr_token_refresh_cb_t on_refresh, void *user_data);
+
+/**
+ * @brief      Stop the refresh task and free the token cache
+ *
+ * @param[in]  token   The token cache
+ *
+ * @return
+ *  - ESP_OK
+ *  - ESP_FAIL
+ */
+esp_err_t baidu_sr_token_destroy(baidu_sr_token_handle_t token);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
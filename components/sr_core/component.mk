@@ -0,0 +1,5 @@
+#
+# Speech recognizer core shared by the example apps: pipelines, memory plan
+# and the recognizer providers.
+#
+COMPONENT_ADD_INCLUDEDIRS := .
@@ -0,0 +1,104 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include <string.h>
+#include "sr_base64.h"
+
+static const char b64_alphabet[64] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/* One 24-bit word in, four table lookups out */
+static inline char *_b64_encode_word(char *out, uint32_t w)
+{
+    out[0] = b64_alphabet[(w >> 18) & 0x3f];
+    out[1] = b64_alphabet[(w >> 12) & 0x3f];
+    out[2] = b64_alphabet[(w >> 6) & 0x3f];
+    out[3] = b64_alphabet[w & 0x3f];
+    return out + 4;
+}
+
+#define B64_LOAD_WORD(p)    (((uint32_t)(p)[0] << 16) | ((uint32_t)(p)[1] << 8) | (uint32_t)(p)[2])
+
+void sr_base64_reset(sr_base64_t *b64)
+{
+    b64->carry_len = 0;
+}
+
+int sr_base64_encode_update(sr_base64_t *b64, char *out, const uint8_t *in, int len)
+{
+    char *p = out;
+
+    if (b64->carry_len > 0) {
+        while (b64->carry_len < 3 && len > 0) {
+            b64->carry[b64->carry_len++] = *in++;
+            len--;
+        }
+        if (b64->carry_len < 3) {
+            return 0;
+        }
+        p = _b64_encode_word(p, B64_LOAD_WORD(b64->carry));
+        b64->carry_len = 0;
+    }
+    /*
+     * Byte loads only: the pipeline buffer has no alignment guarantee and
+     * unaligned 32-bit loads trap on Xtensa.
+     */
+    while (len >= 12) {
+        p = _b64_encode_word(p, B64_LOAD_WORD(in));
+        p = _b64_encode_word(p, B64_LOAD_WORD(in + 3));
+        p = _b64_encode_word(p, B64_LOAD_WORD(in + 6));
+        p = _b64_encode_word(p, B64_LOAD_WORD(in + 9));
+        in += 12;
+        len -= 12;
+    }
+    while (len >= 3) {
+        p = _b64_encode_word(p, B64_LOAD_WORD(in));
+        in += 3;
+        len -= 3;
+    }
+    if (len > 0) {
+        memcpy(b64->carry, in, len);
+        b64->carry_len = len;
+    }
+    return p - out;
+}
+
+int sr_base64_encode_finish(sr_base64_t *b64, char *out)
+{
+    if (b64->carry_len == 0) {
+        return 0;
+    }
+    uint32_t w = (uint32_t)b64->carry[0] << 16;
+    if (b64->carry_len == 2) {
+        w |= (uint32_t)b64->carry[1] << 8;
+    }
+    _b64_encode_word(out, w);
+    out[3] = '=';
+    if (b64->carry_len == 1) {
+        out[2] = '=';
+    }
+    b64->carry_len = 0;
+    return 4;
+}
@@ -0,0 +1,100 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#ifndef _SR_BASE64_H_
+#define _SR_BASE64_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Worst case number of base64 characters produced when `len` new input bytes
+ * are fed to an encoder that may already hold a 2 byte carry
+ */
+#define SR_BASE64_ENCODE_MAX(len)   ((((len) + 2) / 3) * 4)
+
+/**
+ * Incremental base64 encoder
+ *
+ * Input that does not fill a complete 3 byte group is kept in `carry` and
+ * prepended to the next update, so the output of every update is a valid
+ * unpadded base64 string and audio can be encoded straight out of the
+ * pipeline buffer without copying it first.
+ */
+typedef struct {
+    uint8_t carry[3];
+    int     carry_len;
+} sr_base64_t;
+
+/**
+ * @brief      Drop any carried input and start a new stream
+ *
+ * @param[in]  b64   The encoder
+ */
+void sr_base64_reset(sr_base64_t *b64);
+
+/**
+ * @brief      Exact number of characters the next update with `len` bytes will produce
+ *
+ * @param[in]  b64   The encoder
+ * @param[in]  len   Input length
+ *
+ * @return     Output length of sr_base64_encode_update()
+ */
+static inline int sr_base64_encode_len(const sr_base64_t *b64, int len)
+{
+    return ((b64->carry_len + len) / 3) * 4;
+}
+
+/**
+ * @brief      Encode as many complete 3 byte groups as available
+ *
+ * @param[in]  b64   The encoder
+ * @param[out] out   Output buffer, at least SR_BASE64_ENCODE_MAX(len) bytes, not NUL terminated
+ * @param[in]  in    Input data
+ * @param[in]  len   Input length
+ *
+ * @return     Number of characters written to `out`
+ */
+int sr_base64_encode_update(sr_base64_t *b64, char *out, const uint8_t *in, int len);
+
+/**
+ * @brief      Flush the carried bytes with `=` padding and reset the encoder
+ *
+ * @param[in]  b64   The encoder
+ * @param[out] out   Output buffer, at least 4 bytes, not NUL terminated
+ *
+ * @return     Number of characters written to `out` (0 or 4)
+ */
+int sr_base64_encode_finish(sr_base64_t *b64, char *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
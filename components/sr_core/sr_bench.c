@@ -0,0 +1,500 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "audio_error.h"
+#include "sdkconfig.h"
+#include "xtensa/hal.h"
+#if CONFIG_HEAP_TRACING_STANDALONE
+#include "esp_heap_trace.h"
+#endif
+#include "sr_bench.h"
+#include "sr_core.h"
+#include "sr_provider_mock.h"
+#include "sr_resample.h"
+#include "sr_downmix.h"
+
+static const char *TAG = "SR_BENCH";
+
+#define SR_BENCH_DEFAULT_SAMPLE_RATE    (16000)
+#define SR_BENCH_HEAP_RECORDS           (64)    /* Allocations counted per utterance, more saturate */
+#define SR_BENCH_RESAMPLE_MS            (2000)
+#define SR_BENCH_RESAMPLE_TONE_HZ       (440)
+#define SR_BENCH_RESAMPLE_MAX_CYCLES    (250)   /* Per input sample, 48 to 16 kHz is 32 multiply-adds */
+#define SR_BENCH_RESAMPLE_MIN_SNR_DB    (60)
+#define SR_BENCH_DOWNMIX_MS             (3000)
+#define SR_BENCH_DOWNMIX_WARMUP_MS      (500)   /* The adaptive delay settles first */
+#define SR_BENCH_DOWNMIX_DELAY_US       (125)   /* The right microphone hears the talker 2 samples later at 16 kHz */
+#define SR_BENCH_DOWNMIX_MAX_CYCLES     (100)   /* Per stereo frame */
+#define SR_BENCH_DOWNMIX_MIN_GAIN_DB    (2)     /* Delay and sum of two microphones, 3 dB at best */
+
+typedef enum {
+    SR_BENCH_SILENCE = 0,
+    SR_BENCH_TONE,
+    SR_BENCH_NOISE,
+    SR_BENCH_SPEECH,
+} sr_bench_clip_type_t;
+
+/* Synthetic, so the corpus is the same on every board without a file system */
+static const struct {
+    const char              *name;
+    sr_bench_clip_type_t    type;
+    int                     ms;
+} sr_bench_corpus[] = {
+    { "silence", SR_BENCH_SILENCE, 1000 },
+    { "tone",    SR_BENCH_TONE,    2000 },  /* 440 Hz at -12 dBFS */
+    { "noise",   SR_BENCH_NOISE,   3000 },  /* White at -20 dBFS */
+    { "speech",  SR_BENCH_SPEECH,  5000 },  /* Noise on a 150 Hz buzz, in 4 syllables a second */
+};
+
+static const sr_provider_mock_config_t sr_bench_mock_raw = { .wire = SR_MOCK_WIRE_BAIDU_RAW };
+static const sr_provider_mock_config_t sr_bench_mock_json = { .wire = SR_MOCK_WIRE_BAIDU_JSON };
+static const sr_provider_mock_config_t sr_bench_mock_xunfei = { .wire = SR_MOCK_WIRE_XUNFEI };
+
+/*
+ * Wire bytes per 1000 bytes of audio were 1004, 1339 and 1423 over the synthetic corpus, base64 being 1333, and no
+ * case allocates per utterance. 8000 kcycles/s, 5% of a 160 MHz core, is the budget of the upload task.
+ */
+static const sr_bench_case_t sr_bench_default_cases[] = {
+    { "baidu_raw",  &sr_provider_mock, &sr_bench_mock_raw,    SR_AUDIO_PCM, 8000, 1010, 50, SR_BENCH_NO_ALLOCS },
+    { "baidu_json", &sr_provider_mock, &sr_bench_mock_json,   SR_AUDIO_PCM, 8000, 1350, 50, SR_BENCH_NO_ALLOCS },
+    { "xunfei",     &sr_provider_mock, &sr_bench_mock_xunfei, SR_AUDIO_PCM, 8000, 1435, 50, SR_BENCH_NO_ALLOCS },
+};
+
+/* The codec rates to the upload rates */
+static const struct {
+    int in_rate;
+    int out_rate;
+} sr_bench_resample_default[] = {
+    { 48000, 16000 },
+    { 44100, 16000 },
+    { 16000, 8000 },
+};
+
+#if CONFIG_HEAP_TRACING_STANDALONE
+static heap_trace_record_t sr_bench_heap_records[SR_BENCH_HEAP_RECORDS];
+#endif
+
+static void _sr_bench_synth(sr_bench_clip_type_t type, int16_t *out, int samples, int offset, int sample_rate,
+                            uint32_t *seed)
+{
+    for (int i = 0; i < samples; i++) {
+        float t = (float)(offset + i) / sample_rate;
+        *seed = *seed * 1664525 + 1013904223;
+        float noise = (float)(int16_t)(*seed >> 16) / 32768;
+        float value = 0;
+        switch (type) {
+        case SR_BENCH_TONE:
+            value = 0.25f * sinf(2 * M_PI * 440 * t);
+            break;
+        case SR_BENCH_NOISE:
+            value = 0.1f * noise;
+            break;
+        case SR_BENCH_SPEECH:
+            value = fabsf(sinf(M_PI * 4 * t)) * (0.2f * sinf(2 * M_PI * 150 * t) + 0.1f * noise);
+            break;
+        default:
+            break;
+        }
+        out[i] = (int16_t)(value * 32767);
+    }
+}
+
+/* Heap in use, the allocation count starts over */
+static int _sr_bench_heap_begin(void)
+{
+#if CONFIG_HEAP_TRACING_STANDALONE
+    heap_trace_start(HEAP_TRACE_ALL);
+#endif
+    return heap_caps_get_free_size(MALLOC_CAP_8BIT);
+}
+
+static int _sr_bench_heap_end(int free_before, int *allocs)
+{
+#if CONFIG_HEAP_TRACING_STANDALONE
+    heap_trace_stop();
+    *allocs += heap_trace_get_count();
+#else
+    *allocs = -1;
+#endif
+    return free_before - (int)heap_caps_get_free_size(MALLOC_CAP_8BIT);
+}
+
+/* Cycles of the calling core since `start`, CCOUNT wraps after 26 s at 160 MHz so only time short spans */
+static inline uint32_t _sr_bench_cycles(uint32_t start)
+{
+    return xthal_get_ccount() - start;
+}
+
+static esp_err_t _sr_bench_case(const sr_bench_config_t *config, const sr_bench_case_t *bench, char *buffer,
+                                sr_result_t *result)
+{
+    sr_latency_t latency = { 0 };
+    sr_provider_env_t env = {
+        .sample_rate = config->sample_rate,
+        .format = bench->format,
+        .frame_max = config->buffer_size,
+        .result = result,
+        .latency = &latency,
+    };
+    sr_latency_hist_t *hist = calloc(1, sizeof(sr_latency_hist_t));
+    AUDIO_MEM_CHECK(TAG, hist, return ESP_FAIL);
+    void *ctx = bench->provider->create(bench->config, &env);
+    if (ctx == NULL) {
+        ESP_LOGE(TAG, "Error create %s", bench->name);
+        free(hist);
+        return ESP_FAIL;
+    }
+
+    esp_err_t ret = ESP_OK;
+    int64_t total_cycles = 0;
+    int64_t total_audio_bytes = 0;
+    int64_t total_wire_bytes = 0;
+    int max_allocs = 0;
+    int clip_count = config->clips ? config->clip_count : sizeof(sr_bench_corpus) / sizeof(sr_bench_corpus[0]);
+    for (int clip = 0; clip < clip_count && ret == ESP_OK; clip++) {
+        const char *clip_name = config->clips ? config->clips[clip].name : sr_bench_corpus[clip].name;
+        int clip_bytes = config->clips ? config->clips[clip].frames * 2
+                         : (int)((int64_t)sr_bench_corpus[clip].ms * config->sample_rate / 1000) * 2;
+        int64_t clip_cycles = 0;
+        int wire_bytes = 0;
+        int allocs = 0;
+        int heap_retained = 0;
+        for (int run = 0; run < config->repeats && ret == ESP_OK; run++) {
+            uint32_t seed = clip + 1;
+            int heap = _sr_bench_heap_begin();
+            sr_result_reset(result);
+            sr_latency_open(&latency);
+            uint32_t start = xthal_get_ccount();
+            ret = bench->provider->begin(ctx);
+            clip_cycles += _sr_bench_cycles(start);
+            for (int offset = 0; offset < clip_bytes && ret == ESP_OK; offset += config->buffer_size) {
+                int len = clip_bytes - offset < config->buffer_size ? clip_bytes - offset : config->buffer_size;
+                /* Only the provider is timed, not the synthesis */
+                if (config->clips) {
+                    memcpy(buffer, (const char *)config->clips[clip].samples + offset, len);
+                } else {
+                    _sr_bench_synth(sr_bench_corpus[clip].type, (int16_t *)buffer, len / 2, offset / 2,
+                                    config->sample_rate, &seed);
+                }
+                start = xthal_get_ccount();
+                if (bench->provider->frame(ctx, buffer, len) <= 0) {
+                    ret = ESP_FAIL;
+                }
+                clip_cycles += _sr_bench_cycles(start);
+            }
+            sr_latency_mark(&latency, SR_LATENCY_LAST_SENT);
+            if (bench->provider->end(ctx) != ESP_OK || !result->valid) {
+                ret = ESP_FAIL;
+            }
+            sr_latency_mark(&latency, SR_LATENCY_RESULT);
+            sr_latency_close(&latency);
+            heap_retained += _sr_bench_heap_end(heap, &allocs);
+            sr_latency_report_t report;
+            sr_latency_report(&latency, &report);
+            sr_latency_hist_add(hist, &report);
+            wire_bytes += bench->provider->wire_bytes ? bench->provider->wire_bytes(ctx) : 0;
+        }
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "%s failed on %s", bench->name, clip_name);
+            break;
+        }
+        int64_t audio_bytes = (int64_t)clip_bytes * config->repeats;
+        int64_t audio_ms = audio_bytes * 1000 / (config->sample_rate * 2);
+        /* Cycles per ms of audio are kcycles per s */
+        printf("sr_bench,%s,%s,%d,%d,%d,%d,%d,%d\n", bench->name, clip_name, (int)(audio_ms / config->repeats),
+               (int)(clip_cycles / audio_ms), wire_bytes / config->repeats, (int)(wire_bytes * 1000LL / audio_ms),
+               allocs < 0 ? -1 : allocs / config->repeats, heap_retained / config->repeats);
+        if (allocs < 0 || max_allocs < 0) {
+            max_allocs = -1;
+        } else if (allocs / config->repeats > max_allocs) {
+            max_allocs = allocs / config->repeats;
+        }
+        total_cycles += clip_cycles;
+        total_audio_bytes += audio_bytes;
+        total_wire_bytes += wire_bytes;
+    }
+
+    sr_latency_stats_t stats;
+    sr_latency_hist_stats(hist, SR_LATENCY_STAGE_FINAL, &stats);
+    printf("sr_bench_latency,%s,%d,%d,%d,%d,%d\n", bench->name, stats.count, stats.p50_ms, stats.p95_ms, stats.p99_ms,
+           stats.max_ms);
+    if (ret == ESP_OK) {
+        int64_t audio_ms = total_audio_bytes * 1000 / (config->sample_rate * 2);
+        int kcycles_per_s = (int)(total_cycles / audio_ms);
+        int wire_permille = bench->provider->wire_bytes ? (int)(total_wire_bytes * 1000 / total_audio_bytes) : 0;
+        if (bench->max_kcycles_per_s > 0 && kcycles_per_s > bench->max_kcycles_per_s) {
+            printf("sr_bench_result,%s,FAIL,%d kcycles/s over %d\n", bench->name, kcycles_per_s, bench->max_kcycles_per_s);
+            ret = ESP_FAIL;
+        }
+        if (bench->max_wire_permille > 0 && wire_permille > bench->max_wire_permille) {
+            printf("sr_bench_result,%s,FAIL,%d wire bytes per 1000 over %d\n", bench->name, wire_permille,
+                   bench->max_wire_permille);
+            ret = ESP_FAIL;
+        }
+        if (bench->max_p95_ms > 0 && stats.p95_ms > bench->max_p95_ms) {
+            printf("sr_bench_result,%s,FAIL,p95 %d ms over %d\n", bench->name, stats.p95_ms, bench->max_p95_ms);
+            ret = ESP_FAIL;
+        }
+        int allowed_allocs = bench->max_allocs == SR_BENCH_NO_ALLOCS ? 0 : bench->max_allocs;
+        if (bench->max_allocs != 0 && max_allocs < 0) {
+            printf("sr_bench_result,%s,FAIL,allocations not counted without heap tracing\n", bench->name);
+            ret = ESP_FAIL;
+        } else if (bench->max_allocs != 0 && max_allocs > allowed_allocs) {
+            printf("sr_bench_result,%s,FAIL,%d allocations per utterance over %d\n", bench->name, max_allocs,
+                   allowed_allocs);
+            ret = ESP_FAIL;
+        }
+        if (ret == ESP_OK) {
+            printf("sr_bench_result,%s,PASS,\n", bench->name);
+        }
+    } else {
+        printf("sr_bench_result,%s,FAIL,did not run\n", bench->name);
+    }
+    bench->provider->destroy(ctx);
+    free(hist);
+    return ret;
+}
+
+static esp_err_t _sr_bench_resample(const sr_bench_config_t *config, int in_rate, int out_rate, char *buffer)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "resample_%d_%d", in_rate, out_rate);
+    sr_resample_t rs;
+    int block = config->buffer_size / 2;
+    if (sr_resample_init(&rs, in_rate, out_rate, block) != 0) {
+        printf("sr_bench_result,%s,FAIL,did not run\n", name);
+        return ESP_FAIL;
+    }
+    int16_t *out = malloc(SR_RESAMPLE_OUT_MAX(&rs, block) * sizeof(int16_t));
+    if (out == NULL) {
+        sr_resample_deinit(&rs);
+        printf("sr_bench_result,%s,FAIL,did not run\n", name);
+        return ESP_FAIL;
+    }
+
+    /* Least squares fit of the tone to the output, all but the fit is noise and aliases */
+    double ss = 0, cc = 0, sc = 0, sy = 0, cy = 0, yy = 0;
+    int64_t total_cycles = 0;
+    int in_samples = (int)((int64_t)SR_BENCH_RESAMPLE_MS * in_rate / 1000);
+    int out_count = 0;
+    uint32_t seed = 1;
+    for (int offset = 0; offset < in_samples; offset += block) {
+        int len = in_samples - offset < block ? in_samples - offset : block;
+        _sr_bench_synth(SR_BENCH_TONE, (int16_t *)buffer, len, offset, in_rate, &seed);
+        uint32_t start = xthal_get_ccount();
+        int count = sr_resample_process(&rs, (int16_t *)buffer, len, out);
+        total_cycles += _sr_bench_cycles(start);
+        for (int i = 0; i < count; i++, out_count++) {
+            /* Skip the filter filling up */
+            if (out_count < rs.taps) {
+                continue;
+            }
+            double w = 2 * M_PI * SR_BENCH_RESAMPLE_TONE_HZ * out_count / out_rate;
+            double sw = sin(w), cw = cos(w), y = out[i];
+            ss += sw * sw;
+            cc += cw * cw;
+            sc += sw * cw;
+            sy += sw * y;
+            cy += cw * y;
+            yy += y * y;
+        }
+    }
+    double det = ss * cc - sc * sc;
+    double a = (sy * cc - cy * sc) / det;
+    double b = (cy * ss - sy * sc) / det;
+    double signal = a * sy + b * cy;
+    int snr_db = signal < yy ? (int)(10 * log10(signal / (yy - signal))) : 999;
+    int cycles_per_sample = (int)(total_cycles / in_samples);
+    int kcycles_per_s = (int)(total_cycles / SR_BENCH_RESAMPLE_MS);
+    printf("sr_bench_resample,%d,%d,%d,%d,%d,%d\n", in_rate, out_rate, rs.taps, cycles_per_sample, kcycles_per_s,
+           snr_db);
+
+    esp_err_t ret = ESP_OK;
+    int max_cycles = config->max_resample_cycles > 0 ? config->max_resample_cycles : SR_BENCH_RESAMPLE_MAX_CYCLES;
+    if (cycles_per_sample > max_cycles) {
+        printf("sr_bench_result,%s,FAIL,%d cycles per sample over %d\n", name, cycles_per_sample, max_cycles);
+        ret = ESP_FAIL;
+    }
+    if (snr_db < SR_BENCH_RESAMPLE_MIN_SNR_DB) {
+        printf("sr_bench_result,%s,FAIL,SNR %d dB under %d\n", name, snr_db, SR_BENCH_RESAMPLE_MIN_SNR_DB);
+        ret = ESP_FAIL;
+    }
+    if (ret == ESP_OK) {
+        printf("sr_bench_result,%s,PASS,\n", name);
+    }
+    free(out);
+    sr_resample_deinit(&rs);
+    return ret;
+}
+
+static esp_err_t _sr_bench_downmix(const sr_bench_config_t *config, sr_downmix_mode_t mode, int sample_rate, char *buffer)
+{
+    static const char *mode_names[] = { "average", "delay_sum", "adaptive" };
+    char name[32];
+    snprintf(name, sizeof(name), "downmix_%s", mode_names[mode]);
+    int delay = (int)(((int64_t)SR_BENCH_DOWNMIX_DELAY_US * sample_rate + 500000) / 1000000);
+    sr_downmix_cfg_t cfg = {
+        .mode = mode,
+        .delay_us = SR_BENCH_DOWNMIX_DELAY_US,
+    };
+    sr_downmix_t dm;
+    int block = config->buffer_size / 4;
+    /* The clean speech with the `delay` samples before the block, then the downmix output */
+    int16_t *speech = calloc(block + delay, sizeof(int16_t));
+    int16_t *out = malloc(block * sizeof(int16_t));
+    if (speech == NULL || out == NULL || sr_downmix_init(&dm, &cfg, sample_rate, block) != 0) {
+        free(speech);
+        free(out);
+        printf("sr_bench_result,%s,FAIL,did not run\n", name);
+        return ESP_FAIL;
+    }
+
+    int16_t *in = (int16_t *)buffer;
+    int frames = (int)((int64_t)SR_BENCH_DOWNMIX_MS * sample_rate / 1000);
+    int warmup = (int)((int64_t)SR_BENCH_DOWNMIX_WARMUP_MS * sample_rate / 1000);
+    int64_t total_cycles = 0;
+    double noise_in = 0, noise_out = 0;
+    uint32_t seed = 1, noise_seed = 2;
+    for (int offset = 0; offset < frames; offset += block) {
+        int len = frames - offset < block ? frames - offset : block;
+        _sr_bench_synth(SR_BENCH_SPEECH, speech + delay, len, offset, sample_rate, &seed);
+        for (int n = 0; n < len; n++) {
+            /* White at -26 dBFS on each microphone */
+            noise_seed = noise_seed * 1664525 + 1013904223;
+            int noise_l = (int16_t)(noise_seed >> 16) / 20;
+            noise_seed = noise_seed * 1664525 + 1013904223;
+            int noise_r = (int16_t)(noise_seed >> 16) / 20;
+            int l = speech[delay + n] + noise_l;
+            int r = speech[n] + noise_r;
+            in[2 * n] = (int16_t)(l > 32767 ? 32767 : l < -32768 ? -32768 : l);
+            in[2 * n + 1] = (int16_t)(r > 32767 ? 32767 : r < -32768 ? -32768 : r);
+            if (offset + n >= warmup) {
+                noise_in += (double)noise_l * noise_l;
+            }
+        }
+        uint32_t start = xthal_get_ccount();
+        sr_downmix_process(&dm, in, len, out);
+        total_cycles += _sr_bench_cycles(start);
+        /* Aligned to the later microphone, so the reference is the speech `delay` samples back */
+        for (int n = 0; n < len; n++) {
+            if (offset + n >= warmup) {
+                double e = out[n] - speech[n];
+                noise_out += e * e;
+            }
+        }
+        memmove(speech, speech + len, delay * sizeof(int16_t));
+    }
+    int gain_db = noise_out > 0 ? (int)lround(10 * log10(noise_in / noise_out)) : 999;
+    int cycles_per_frame = (int)(total_cycles / frames);
+    int kcycles_per_s = (int)(total_cycles / SR_BENCH_DOWNMIX_MS);
+    printf("sr_bench_downmix,%s,%d,%d,%d,%d,%d\n", mode_names[mode], sample_rate, dm.delay, cycles_per_frame,
+           kcycles_per_s, gain_db);
+
+    esp_err_t ret = ESP_OK;
+    int max_cycles = config->max_downmix_cycles > 0 ? config->max_downmix_cycles : SR_BENCH_DOWNMIX_MAX_CYCLES;
+    if (cycles_per_frame > max_cycles) {
+        printf("sr_bench_result,%s,FAIL,%d cycles per frame over %d\n", name, cycles_per_frame, max_cycles);
+        ret = ESP_FAIL;
+    }
+    if (mode != SR_DOWNMIX_AVERAGE && dm.delay != delay) {
+        printf("sr_bench_result,%s,FAIL,delay %d instead of %d\n", name, dm.delay, delay);
+        ret = ESP_FAIL;
+    }
+    if (mode != SR_DOWNMIX_AVERAGE && gain_db < SR_BENCH_DOWNMIX_MIN_GAIN_DB) {
+        printf("sr_bench_result,%s,FAIL,SNR gain %d dB under %d\n", name, gain_db, SR_BENCH_DOWNMIX_MIN_GAIN_DB);
+        ret = ESP_FAIL;
+    }
+    if (ret == ESP_OK) {
+        printf("sr_bench_result,%s,PASS,\n", name);
+    }
+    sr_downmix_deinit(&dm);
+    free(speech);
+    free(out);
+    return ret;
+}
+
+esp_err_t sr_bench_run(const sr_bench_config_t *config)
+{
+    sr_bench_config_t cfg = *config;
+    if (cfg.cases == NULL) {
+        cfg.cases = sr_bench_default_cases;
+        cfg.case_count = sizeof(sr_bench_default_cases) / sizeof(sr_bench_default_cases[0]);
+    }
+    cfg.sample_rate = cfg.sample_rate > 0 ? cfg.sample_rate : SR_BENCH_DEFAULT_SAMPLE_RATE;
+    cfg.buffer_size = cfg.buffer_size > 0 ? cfg.buffer_size : DEFAULT_SR_BUFFER_SIZE;
+    cfg.repeats = cfg.repeats > 0 ? cfg.repeats : 1;
+
+#if CONFIG_HEAP_TRACING_STANDALONE
+    heap_trace_init_standalone(sr_bench_heap_records, SR_BENCH_HEAP_RECORDS);
+#endif
+    char *buffer = malloc(cfg.buffer_size);
+    sr_result_t result = {
+        .size = DEFAULT_SR_RESULT_SIZE,
+        .text = calloc(1, DEFAULT_SR_RESULT_SIZE),
+    };
+    esp_err_t ret = ESP_FAIL;
+    AUDIO_MEM_CHECK(TAG, buffer, goto exit_bench);
+    AUDIO_MEM_CHECK(TAG, result.text, goto exit_bench);
+
+    ESP_LOGI(TAG, "%d cases, %d runs of the corpus each, %d Hz in %d byte blocks", cfg.case_count, cfg.repeats,
+             cfg.sample_rate, cfg.buffer_size);
+    printf("sr_bench,case,clip,audio_ms,kcycles_per_s,wire_bytes,wire_bytes_per_s,allocs,heap_retained\n");
+    ret = ESP_OK;
+    for (int i = 0; i < cfg.case_count; i++) {
+        if (_sr_bench_case(&cfg, &cfg.cases[i], buffer, &result) != ESP_OK) {
+            ret = ESP_FAIL;
+        }
+    }
+    printf("sr_bench_resample,in_rate,out_rate,taps,cycles_per_sample,kcycles_per_s,snr_db\n");
+    bool capture_done = cfg.capture_rate <= 0 || cfg.capture_rate == cfg.sample_rate;
+    for (int i = 0; i < sizeof(sr_bench_resample_default) / sizeof(sr_bench_resample_default[0]); i++) {
+        if (_sr_bench_resample(&cfg, sr_bench_resample_default[i].in_rate, sr_bench_resample_default[i].out_rate,
+                               buffer) != ESP_OK) {
+            ret = ESP_FAIL;
+        }
+        if (sr_bench_resample_default[i].in_rate == cfg.capture_rate
+                && sr_bench_resample_default[i].out_rate == cfg.sample_rate) {
+            capture_done = true;
+        }
+    }
+    if (!capture_done && _sr_bench_resample(&cfg, cfg.capture_rate, cfg.sample_rate, buffer) != ESP_OK) {
+        ret = ESP_FAIL;
+    }
+    printf("sr_bench_downmix,mode,sample_rate,delay,cycles_per_frame,kcycles_per_s,snr_gain_db\n");
+    for (sr_downmix_mode_t mode = SR_DOWNMIX_AVERAGE; mode <= SR_DOWNMIX_ADAPTIVE; mode++) {
+        if (_sr_bench_downmix(&cfg, mode, cfg.capture_rate > 0 ? cfg.capture_rate : cfg.sample_rate, buffer) != ESP_OK) {
+            ret = ESP_FAIL;
+        }
+    }
+exit_bench:
+    free(buffer);
+    free(result.text);
+    return ret;
+}
@@ -0,0 +1,124 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _SR_BENCH_H_
+#define _SR_BENCH_H_
+
+/*
+ * Benchmark of the upload path, run on the device or in the host build.
+ *
+ * A corpus of 16-bit mono clips is fed through a provider the way the
+ * upload task does it: begin, frame in blocks of `buffer_size`, end. The
+ * corpus is synthetic unless `clips` is given, so it is the same on every
+ * board without a file system. With sr_provider_mock and its `wire` option
+ * this is the encoding and framing of each real provider into a local sink,
+ * without a network, so the numbers only move when the code does.
+ *
+ * Results go to the console UART as CSV lines:
+ *
+ *     sr_bench,case,clip,audio_ms,kcycles_per_s,wire_bytes,wire_bytes_per_s,allocs,heap_retained
+ *     sr_bench_latency,case,count,p50_ms,p95_ms,p99_ms,max_ms
+ *     sr_bench_resample,in_rate,out_rate,taps,cycles_per_sample,kcycles_per_s,snr_db
+ *     sr_bench_downmix,mode,sample_rate,delay,cycles_per_frame,kcycles_per_s,snr_gain_db
+ *     sr_bench_result,case,PASS|FAIL,what failed
+ *
+ * Cycles are read from the CCOUNT register of the calling core around begin
+ * and frame, so call it from a task pinned to one core while nothing else
+ * competes for it. Allocations are counted per utterance with heap tracing,
+ * CONFIG_HEAP_TRACING_STANDALONE; without it they print as -1 and a case
+ * with `max_allocs` set fails. Latency is the time `end` takes to the parsed
+ * result. The resampler is timed per input sample on a tone, and its SNR is
+ * what is left after fitting the tone to the output. The downmix is timed
+ * per stereo frame on the speech clip reaching the right microphone later,
+ * with noise of its own on each microphone; the gain is its SNR against the
+ * left microphone alone.
+ *
+ * The default thresholds of sr_bench.c are a baseline run plus a margin:
+ * bytes on the wire and allocations are the same on every target, cycles
+ * are those of the ESP32 at 160 MHz.
+ */
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "sr_provider.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SR_BENCH_NO_ALLOCS      (-1)
+
+/**
+ * One configuration of the upload path and its regression thresholds, 0 for none
+ */
+typedef struct {
+    const char          *name;
+    const sr_provider_t *provider;
+    const void          *config;                /*!< The provider's configuration */
+    sr_audio_format_t   format;
+    int                 max_kcycles_per_s;      /*!< CPU per second of audio */
+    int                 max_wire_permille;      /*!< Bytes on the wire per 1000 bytes of audio */
+    int                 max_p95_ms;             /*!< End of the utterance to the result */
+    int                 max_allocs;             /*!< Allocations per utterance with heap tracing, SR_BENCH_NO_ALLOCS for none */
+} sr_bench_case_t;
+
+/**
+ * A clip of the corpus, 16-bit mono at the benchmark's `sample_rate`
+ */
+typedef struct {
+    const char          *name;
+    const int16_t       *samples;
+    int                 frames;
+} sr_bench_clip_t;
+
+typedef struct {
+    const sr_bench_case_t *cases;               /*!< NULL runs the mock in each wire format */
+    int                 case_count;
+    const sr_bench_clip_t *clips;               /*!< Recorded corpus, NULL for the synthetic one */
+    int                 clip_count;
+    int                 sample_rate;            /*!< 16000 if 0 */
+    int                 capture_rate;           /*!< Also time the resampler from this rate to `sample_rate`, 0 for none.
+                                                     The downmix runs at this rate, `sample_rate` if 0 */
+    int                 buffer_size;            /*!< Block handed to `frame`, DEFAULT_SR_BUFFER_SIZE if 0 */
+    int                 repeats;                /*!< Runs of the corpus per case, 1 if 0 */
+    int                 max_resample_cycles;    /*!< Per input sample, the ESP32's if 0 */
+    int                 max_downmix_cycles;     /*!< Per stereo frame, the ESP32's if 0 */
+} sr_bench_config_t;
+
+/**
+ * @brief      Run every case over the corpus and print the results
+ *
+ * @param[in]  config  The benchmark configuration
+ *
+ * @return
+ *     - ESP_OK if every case ran within its thresholds
+ *     - ESP_FAIL if one failed or exceeded a threshold
+ */
+esp_err_t sr_bench_run(const sr_bench_config_t *config);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,189 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <sys/time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "esp_log.h"
+#include "esp_sntp.h"
+#include "sr_clock.h"
+
+static const char *TAG = "SR_CLOCK";
+
+#define SR_CLOCK_NTP_SERVER         "cn.ntp.org.cn"
+#define SR_CLOCK_SNTP_GRACE_MS      (3000)      /* Give SNTP this long before probing for a Date header */
+#define SR_CLOCK_PROBE_RETRY_MS     (10000)
+#define SR_CLOCK_PROBE_TIMEOUT_MS   (5000)
+#define SR_CLOCK_TASK_STACK         (4*1024)
+#define SR_CLOCK_TASK_PRIO          (1)
+#define SR_CLOCK_SET_BIT            BIT0
+#define SR_CLOCK_SNTP_BIT           BIT1
+
+static EventGroupHandle_t s_clock_events;
+static const char *s_probe_url;
+
+static void _clock_sntp_synced(struct timeval *tv)
+{
+    if (s_clock_events == NULL) {
+        return;
+    }
+    ESP_LOGI(TAG, "Clock set by SNTP");
+    xEventGroupSetBits(s_clock_events, SR_CLOCK_SET_BIT | SR_CLOCK_SNTP_BIT);
+}
+
+/* Days since 1970-01-01 of a proleptic Gregorian date, newlib has no timegm() */
+static long _days_from_civil(int y, int m, int d)
+{
+    y -= m <= 2;
+    long era = (y >= 0 ? y : y - 399) / 400;
+    long yoe = y - era * 400;
+    long doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+esp_err_t sr_clock_set_from_http_date(const char *date)
+{
+    static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+    char month[4] = { 0 };
+    int day, year, hour, min, sec;
+    if (s_clock_events == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (sscanf(date, "%*[^,], %d %3s %d %d:%d:%d", &day, month, &year, &hour, &min, &sec) != 6) {
+        return ESP_FAIL;
+    }
+    const char *found = strstr(months, month);
+    if (found == NULL || strlen(month) != 3 || (found - months) % 3) {
+        return ESP_FAIL;
+    }
+    if (xEventGroupGetBits(s_clock_events) & SR_CLOCK_SNTP_BIT) {
+        return ESP_OK;
+    }
+    struct timeval tv = {
+        .tv_sec = _days_from_civil(year, (found - months) / 3 + 1, day) * 86400L + hour * 3600 + min * 60 + sec,
+    };
+    if (tv.tv_sec < SR_CLOCK_VALID_SINCE) {
+        return ESP_FAIL;
+    }
+    settimeofday(&tv, NULL);
+    if ((xEventGroupGetBits(s_clock_events) & SR_CLOCK_SET_BIT) == 0) {
+        ESP_LOGI(TAG, "Clock set from HTTP Date: %s", date);
+    }
+    xEventGroupSetBits(s_clock_events, SR_CLOCK_SET_BIT);
+    return ESP_OK;
+}
+
+esp_err_t sr_clock_http_event_handler(esp_http_client_event_t *evt)
+{
+    if (s_clock_events && evt->event_id == HTTP_EVENT_ON_HEADER && strcasecmp(evt->header_key, "Date") == 0) {
+        sr_clock_set_from_http_date(evt->header_value);
+    }
+    return ESP_OK;
+}
+
+esp_err_t sr_clock_probe(const char *url)
+{
+    if (s_clock_events == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_http_client_config_t http_cfg = {
+        .url = url,
+        .method = HTTP_METHOD_HEAD,
+        .timeout_ms = SR_CLOCK_PROBE_TIMEOUT_MS,
+        .event_handler = sr_clock_http_event_handler,
+    };
+    esp_http_client_handle_t http = esp_http_client_init(&http_cfg);
+    if (http == NULL) {
+        return ESP_FAIL;
+    }
+    esp_http_client_perform(http);
+    esp_http_client_cleanup(http);
+    return sr_clock_is_set() ? ESP_OK : ESP_FAIL;
+}
+
+static void _clock_probe_task(void *pv)
+{
+    while ((xEventGroupWaitBits(s_clock_events, SR_CLOCK_SET_BIT, pdFALSE, pdTRUE,
+                                SR_CLOCK_SNTP_GRACE_MS / portTICK_PERIOD_MS) & SR_CLOCK_SET_BIT) == 0) {
+        if (sr_clock_probe(s_probe_url) == ESP_OK) {
+            break;
+        }
+        ESP_LOGW(TAG, "No time from SNTP nor %s yet", s_probe_url);
+        vTaskDelay((SR_CLOCK_PROBE_RETRY_MS - SR_CLOCK_SNTP_GRACE_MS) / portTICK_PERIOD_MS);
+    }
+    vTaskDelete(NULL);
+}
+
+esp_err_t sr_clock_init(const char *probe_url)
+{
+    if (s_clock_events) {
+        return ESP_OK;
+    }
+    s_clock_events = xEventGroupCreate();
+    if (s_clock_events == NULL) {
+        return ESP_FAIL;
+    }
+    // Set timezone to China Standard Time
+    setenv("TZ", "CST-8", 1);
+    tzset();
+    if (time(NULL) >= SR_CLOCK_VALID_SINCE) {
+        ESP_LOGI(TAG, "Clock kept across reset");
+        xEventGroupSetBits(s_clock_events, SR_CLOCK_SET_BIT);
+    }
+
+    // Keep polling even when the clock is already set, the RTC drifts
+    sntp_setoperatingmode(SNTP_OPMODE_POLL);
+    sntp_setservername(0, SR_CLOCK_NTP_SERVER);
+    sntp_set_time_sync_notification_cb(_clock_sntp_synced);
+    sntp_init();
+
+    s_probe_url = probe_url;
+    if (probe_url && !sr_clock_is_set()
+            && xTaskCreate(_clock_probe_task, "sr_clock", SR_CLOCK_TASK_STACK, NULL, SR_CLOCK_TASK_PRIO, NULL) != pdPASS) {
+        ESP_LOGW(TAG, "Error create clock probe task, SNTP only");
+    }
+    return ESP_OK;
+}
+
+bool sr_clock_is_set(void)
+{
+    return s_clock_events && (xEventGroupGetBits(s_clock_events) & SR_CLOCK_SET_BIT);
+}
+
+esp_err_t sr_clock_wait(int timeout_ms)
+{
+    if (s_clock_events == NULL) {
+        return ESP_ERR_TIMEOUT;
+    }
+    if (xEventGroupWaitBits(s_clock_events, SR_CLOCK_SET_BIT, pdFALSE, pdTRUE, timeout_ms / portTICK_PERIOD_MS) & SR_CLOCK_SET_BIT) {
+        return ESP_OK;
+    }
+    return ESP_ERR_TIMEOUT;
+}
@@ -0,0 +1,116 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _SR_CLOCK_H_
+#define _SR_CLOCK_H_
+
+/*
+ * Wall clock for request signing, synchronised in the background.
+ *
+ * The RTC keeps counting across software resets, so a clock set before a
+ * reset is trusted at boot and sessions can start right away. Otherwise
+ * SNTP runs in the background and, if it is slow, the `Date` header of an
+ * HTTP response is used instead. Only a session that needs the clock before
+ * any source answered waits for it.
+ */
+
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_http_client.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SR_CLOCK_VALID_SINCE    (1546300800)    /*!< 2019-01-01, an earlier time() means the clock was never set */
+
+/**
+ * @brief      Start synchronising the clock, does not block
+ *
+ * @param[in]  probe_url   HTTP url whose `Date` header is used if SNTP has not answered in time, NULL to only use SNTP
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_FAIL
+ */
+esp_err_t sr_clock_init(const char *probe_url);
+
+/**
+ * @brief      Whether the clock has been set by any source
+ */
+bool sr_clock_is_set(void);
+
+/**
+ * @brief      Block until the clock is set
+ *
+ * @param[in]  timeout_ms  Maximum time to wait
+ *
+ * @return
+ *     - ESP_OK if the clock is set
+ *     - ESP_ERR_TIMEOUT
+ */
+esp_err_t sr_clock_wait(int timeout_ms);
+
+/**
+ * @brief      Set the clock from an RFC 1123 date, e.g. "Wed, 10 Jul 2019 07:35:43 GMT"
+ *
+ * Ignored once SNTP has set the clock, a `Date` header only has a one second resolution.
+ *
+ * @param[in]  date   Value of a `Date` header
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_FAIL if the date can not be parsed
+ *     - ESP_ERR_INVALID_STATE before sr_clock_init
+ */
+esp_err_t sr_clock_set_from_http_date(const char *date);
+
+/**
+ * @brief      Set the clock from the `Date` header of a HEAD request, blocks for up to 5 s
+ *
+ * For clients that can not install sr_clock_http_event_handler, e.g. a
+ * websocket whose handshake headers are not exposed.
+ *
+ * @param[in]  url    HTTP url to probe
+ *
+ * @return
+ *     - ESP_OK if the clock is set
+ *     - ESP_FAIL
+ *     - ESP_ERR_INVALID_STATE before sr_clock_init
+ */
+esp_err_t sr_clock_probe(const char *url);
+
+/**
+ * @brief      esp_http_client event handler feeding the `Date` header to sr_clock_set_from_http_date
+ *
+ * Can be installed as `event_handler` of any esp_http_client_config_t, it
+ * does nothing before sr_clock_init.
+ */
+esp_err_t sr_clock_http_event_handler(esp_http_client_event_t *evt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
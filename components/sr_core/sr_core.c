@@ -0,0 +1,1126 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <time.h>
+
+#include "audio_element.h"
+#include "audio_pipeline.h"
+#include "audio_event_iface.h"
+#include "audio_common.h"
+#include "i2s_stream.h"
+#include "raw_stream.h"
+#include "amrwb_encoder.h"
+#include "sr_core.h"
+#include "sr_preroll.h"
+#include "sr_upload_stream.h"
+#include "sr_resample_stream.h"
+#include "sr_downmix_stream.h"
+#include "sr_spool.h"
+#include "sr_clock.h"
+
+static const char *TAG = "SR_CORE";
+
+#define SR_CORE_FINISH_TIMEOUT_MS   (10000)
+#define SR_CORE_CAPTURE_RING_BUFFERS (4)    /* The capture task drains the I2S ring continuously */
+#define SR_CORE_STACK_MARGIN        (512)   /* Stack left below which a task is reported as short of it */
+#define SR_CORE_FORWARD_ATTEMPTS    (3)     /* A spooled utterance failing this often in a row is dropped */
+#define SR_CORE_AMRWB_BITRATE       AMRWB_ENC_BITRATE_MD1265  /* 12.65 kbit/s against 256 kbit/s of PCM */
+
+typedef enum {
+    SR_SESSION_IDLE = 0,
+    SR_SESSION_STARTING,        /* Pre-roll still to be sent */
+    SR_SESSION_ACTIVE,
+    SR_SESSION_STOPPING,        /* Warm mode, the upload is finished after the last captured buffer */
+} sr_session_state_t;
+
+typedef struct sr_core {
+    audio_pipeline_handle_t pipeline;
+    const sr_provider_t     *provider;
+    void                    *provider_ctx;
+    SemaphoreHandle_t       provider_lock;      /* Orders sr_core_set_credential against sr_core_set_provider */
+    sr_provider_env_t       env;
+    sr_result_t             result;
+    int                     sr_total_write;
+    bool                    is_begin;
+    audio_element_handle_t  i2s_reader;
+    audio_element_handle_t  downmixer;          /* Follows the I2S reader when recording both microphones */
+    audio_element_handle_t  resampler;          /* Next if the upload rate differs */
+    audio_element_handle_t  encoder;
+    audio_element_handle_t  upload_writer;
+    audio_pipeline_handle_t capture_pipeline;   /* i2s -> raw, always running in pre-roll mode */
+    audio_element_handle_t  raw_reader;
+    audio_element_handle_t  raw_writer;         /* Head of the upload pipeline in pre-roll mode */
+    sr_preroll_t            preroll;
+    int                     preroll_len;        /* Bytes prepended to an upload */
+    char                    *capture_buffer;
+    TaskHandle_t            capture_task;
+    SemaphoreHandle_t       capture_lock;
+    SemaphoreHandle_t       capture_exited;
+    volatile bool           capture_running;
+    sr_session_state_t      session;
+    bool                    warm;               /* Upload pipeline stays running, sessions only flip `session` */
+    bool                    finish_pending;     /* Warm: the last session timed out before the writer finished it */
+    audio_element_handle_t  ring_el;            /* Head of the upload pipeline, its output ring rides out network stalls */
+    int                     ring_size;
+    int                     ring_hwm;
+    int                     capture_ring_size;
+    int                     capture_ring_hwm;
+    int                     i2s_ring_size;
+    int64_t                 start_time;         /* sr_core_start, for the press-to-capture latency */
+    int                     sample_rates;       /* After the resampler, what the provider gets */
+    int                     buffer_size;
+    sr_core_event_handle_t  on_begin;
+    sr_core_result_handle_t on_result;
+    char                    *live_text;         /* `result.text` except while forwarding */
+    bool                    result_valid;       /* Outcome of the last recording, `result` is reused while forwarding */
+    int                     result_len;
+    sr_spool_handle_t       spool;
+    bool                    spooling;           /* The upload of the current utterance failed, it is being stored */
+    bool                    upload_failed;      /* The provider gave up, the rest of the utterance only goes to the spool */
+    SemaphoreHandle_t       forward_lock;       /* Held through a recording or a replay, they share the provider */
+    bool                    forward_locked;     /* By the upload task */
+    TaskHandle_t            forward_task;
+    SemaphoreHandle_t       forward_exited;
+    char                    *forward_buffer;
+    char                    *forward_text;
+    volatile bool           forward_running;
+    volatile bool           forward_abort;      /* A recording wants the provider */
+    volatile bool           forwarding;
+    sr_core_forward_handle_t on_forward;
+    char                    *replay;            /* The utterance so far, resent after a transport error or spooled */
+    int                     replay_size;
+    int                     replay_len;
+    bool                    replay_overflow;    /* The utterance outgrew `replay`, no more retries */
+    int                     max_retries;
+    int                     retries;            /* Of the current utterance */
+    int64_t                 retry_us;
+    sr_latency_t            latency;            /* Marks of the current utterance, shared with the provider */
+    sr_latency_report_t     latency_report;     /* Of the last utterance, sent to the listener */
+    sr_latency_hist_t       *latency_hist;
+    audio_event_iface_handle_t event;           /* SR_CORE_EVENT_SOURCE events */
+    audio_event_iface_handle_t listener;
+    sr_core_placement_t     placement;
+    sr_task_stats_t         *task_stats;        /* Over the last utterance */
+} sr_core_t;
+
+/* The recognizer's own tasks, by the names they run under */
+static const char *sr_task_names[] = {
+    "sr_i2s", "sr_downmix", "sr_resample", "sr_capture", "sr_amrwb", "sr_upload", "sr_forward",
+    "sr_hedge0", "sr_hedge1",
+};
+
+static void _sr_ring_sample(audio_element_handle_t el, int *hwm)
+{
+    ringbuf_handle_t rb = audio_element_get_output_ringbuf(el);
+    int filled = rb ? rb_bytes_filled(rb) : 0;
+    if (filled > *hwm) {
+        *hwm = filled;
+    }
+}
+
+static void _sr_on_result(const char *text, bool is_final, void *user_data)
+{
+    sr_core_t *sr = (sr_core_t *)user_data;
+    if (sr->on_result) {
+        sr->on_result(sr, text, is_final);
+    }
+}
+
+/* A recording has priority: a replay in progress is cancelled, then the provider is the recording's */
+static void _sr_forward_pause(sr_core_t *sr)
+{
+    if (sr->forward_task == NULL || sr->forward_locked) {
+        return;
+    }
+    sr->forward_abort = true;
+    if (sr->forwarding && sr->provider->cancel) {
+        sr->provider->cancel(sr->provider_ctx);
+    }
+    xSemaphoreTake(sr->forward_lock, portMAX_DELAY);
+    sr->forward_abort = false;
+    sr->forward_locked = true;
+}
+
+/* Hand the provider back, `kick` if it just took a recording: a good time to send what is spooled */
+static void _sr_forward_resume(sr_core_t *sr, bool kick)
+{
+    if (!sr->forward_locked) {
+        return;
+    }
+    sr->forward_locked = false;
+    xSemaphoreGive(sr->forward_lock);
+    if (kick && sr_spool_pending(sr->spool) > 0) {
+        xTaskNotifyGive(sr->forward_task);
+    }
+}
+
+/* Replay one spooled utterance through the provider, into `forward_text` */
+static esp_err_t _sr_forward_one(sr_core_t *sr, const sr_spool_meta_t *meta)
+{
+    if (meta->sample_rate != sr->env.sample_rate || meta->format != sr->env.format) {
+        ESP_LOGW(TAG, "Spooled %d Hz format %d, recording %d Hz format %d", meta->sample_rate, meta->format,
+                 sr->env.sample_rate, sr->env.format);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    /* The provider writes to `result`, the text of the last recording stays in `live_text` */
+    sr->result.text = sr->forward_text;
+    sr->result.on_update = NULL;
+    sr_result_reset(&sr->result);
+    sr->forwarding = true;
+    esp_err_t ret = sr->provider->begin(sr->provider_ctx);
+    if (ret == ESP_OK) {
+        int len = 0;
+        while (!sr->forward_abort && (len = sr_spool_read(sr->spool, sr->forward_buffer, sr->buffer_size)) > 0) {
+            if (sr->provider->frame(sr->provider_ctx, sr->forward_buffer, len) <= 0) {
+                break;
+            }
+        }
+        if (len != 0 || sr->forward_abort) {
+            ret = ESP_FAIL;
+            if (sr->provider->cancel) {
+                sr->provider->cancel(sr->provider_ctx);
+            }
+        }
+        if (sr->provider->end(sr->provider_ctx) != ESP_OK || !sr->result.valid || sr->result.len == 0) {
+            ret = ESP_FAIL;
+        }
+    }
+    sr->forwarding = false;
+    sr->result.text = sr->live_text;
+    sr->result.on_update = _sr_on_result;
+    return ret;
+}
+
+static void _sr_forward_task(void *pv)
+{
+    sr_core_t *sr = (sr_core_t *)pv;
+    int failures = 0;
+    while (sr->forward_running) {
+        /* Woken by sr_core_spool_flush, after a recording the provider took, or to retry */
+        ulTaskNotifyTake(pdTRUE, sr_spool_pending(sr->spool) > 0 ? SR_CORE_FORWARD_RETRY_S * 1000 / portTICK_PERIOD_MS
+                                                                 : portMAX_DELAY);
+        sr_spool_meta_t meta;
+        while (sr->forward_running && !sr->forward_abort) {
+            xSemaphoreTake(sr->forward_lock, portMAX_DELAY);
+            if (!sr->forward_running || sr->forward_abort || sr_spool_open(sr->spool, &meta) != ESP_OK) {
+                xSemaphoreGive(sr->forward_lock);
+                break;
+            }
+            int64_t start = esp_timer_get_time();
+            esp_err_t ret = _sr_forward_one(sr, &meta);
+            bool aborted = sr->forward_abort;
+            if (ret == ESP_OK) {
+                failures = 0;
+                sr_spool_done(sr->spool);
+            } else if (!aborted && (ret == ESP_ERR_NOT_SUPPORTED || ++failures >= SR_CORE_FORWARD_ATTEMPTS)) {
+                ESP_LOGW(TAG, "Dropping a spooled utterance after %d attempts", failures);
+                failures = 0;
+                sr_spool_done(sr->spool);
+            } else {
+                sr_spool_close(sr->spool);
+            }
+            xSemaphoreGive(sr->forward_lock);
+            if (ret != ESP_OK) {
+                break;
+            }
+            ESP_LOGI(TAG, "Forwarded a spooled utterance in %d ms, %d left", (int)((esp_timer_get_time() - start) / 1000),
+                     sr_spool_pending(sr->spool));
+            /* `forward_text` is only written by this task */
+            if (sr->on_forward) {
+                sr->on_forward(sr, sr->forward_text, meta.timestamp);
+            }
+        }
+    }
+    xSemaphoreGive(sr->forward_exited);
+    vTaskDelete(NULL);
+}
+
+/* Keep the audio for a resend, as long as the whole utterance fits */
+static void _sr_replay_keep(sr_core_t *sr, const char *audio, int len)
+{
+    if (sr->replay == NULL || sr->replay_overflow) {
+        return;
+    }
+    if (sr->replay_len + len > sr->replay_size) {
+        ESP_LOGW(TAG, "Utterance longer than the %d byte replay buffer, no retry nor spool from here", sr->replay_size);
+        sr->replay_overflow = true;
+        return;
+    }
+    memcpy(sr->replay + sr->replay_len, audio, len);
+    sr->replay_len += len;
+}
+
+/*
+ * The request broke off: open a new one and resend the utterance so far in
+ * one burst. `ended` means the END was reached, the new request is finished
+ * too. Otherwise the recording goes on into the new request.
+ */
+static esp_err_t _sr_retry(sr_core_t *sr, bool ended)
+{
+    esp_err_t ret = ESP_FAIL;
+    bool open = !ended;
+    while (sr->replay && !sr->replay_overflow && sr->retries < sr->max_retries) {
+        int64_t start = esp_timer_get_time();
+        sr->retries++;
+        if (open) {
+            sr->provider->end(sr->provider_ctx);
+        }
+        sr_result_reset(&sr->result);
+        ret = sr->provider->begin(sr->provider_ctx);
+        open = ret == ESP_OK;
+        for (int offset = 0; ret == ESP_OK && offset < sr->replay_len; offset += sr->buffer_size) {
+            int len = sr->replay_len - offset < sr->buffer_size ? sr->replay_len - offset : sr->buffer_size;
+            if (sr->provider->frame(sr->provider_ctx, sr->replay + offset, len) <= 0) {
+                ret = ESP_FAIL;
+            }
+        }
+        if (ret == ESP_OK && ended) {
+            ret = sr->provider->end(sr->provider_ctx);
+            open = false;
+        }
+        sr->retry_us += esp_timer_get_time() - start;
+        ESP_LOGW(TAG, "Retry %d of %d resent %d bytes in %d ms, %s", sr->retries, sr->max_retries, sr->replay_len,
+                 (int)((esp_timer_get_time() - start) / 1000), ret == ESP_OK ? "ok" : "failed");
+        if (ret == ESP_OK) {
+            return ESP_OK;
+        }
+    }
+    return ret;
+}
+
+/*
+ * The provider gave up on the utterance: store what was recorded so far,
+ * which is all in the replay buffer, the rest is appended as it comes. An
+ * utterance that outgrew the buffer has lost its beginning and is not kept.
+ */
+static bool _sr_spool_start(sr_core_t *sr)
+{
+    if (sr->spool == NULL || sr->replay == NULL) {
+        return false;
+    }
+    if (sr->replay_overflow) {
+        ESP_LOGW(TAG, "Utterance longer than the %d byte replay buffer, not spooled", sr->replay_size);
+        return false;
+    }
+    sr_spool_meta_t meta = {
+        .sample_rate = sr->env.sample_rate,
+        .format = sr->env.format,
+        .timestamp = sr_clock_is_set() ? (uint32_t)time(NULL) : 0,
+    };
+    if (sr_spool_begin(sr->spool, &meta) != ESP_OK
+            || (sr->replay_len > 0 && sr_spool_append(sr->spool, sr->replay, sr->replay_len) != ESP_OK)) {
+        ESP_LOGW(TAG, "Spool full, the utterance is not kept");
+        return false;
+    }
+    return true;
+}
+
+static int _sr_upload_event_handle(sr_upload_event_msg_t *msg)
+{
+    sr_core_t *sr = (sr_core_t *)msg->user_data;
+
+    if (msg->event_id == SR_UPLOAD_BEGIN) {
+        ESP_LOGI(TAG, "[ + ] Utterance begins, provider %s", sr->provider->name);
+        sr->sr_total_write = 0;
+        sr->is_begin = true;
+        sr->upload_failed = false;
+        sr->replay_len = 0;
+        sr->replay_overflow = false;
+        sr->retries = 0;
+        sr->retry_us = 0;
+        _sr_forward_pause(sr);
+        /* A replay of the spool may have marked them since the press */
+        sr->latency.at[SR_LATENCY_CONNECTED] = 0;
+        sr->latency.at[SR_LATENCY_FIRST_REPLY] = 0;
+        sr_result_reset(&sr->result);
+        esp_err_t ret = sr->provider->begin(sr->provider_ctx);
+        sr->upload_failed = ret != ESP_OK;
+        sr->spooling = sr->upload_failed && _sr_spool_start(sr);
+        if (sr->spooling) {
+            ESP_LOGW(TAG, "Provider %s not reachable, spooling the utterance", sr->provider->name);
+            return ESP_OK;
+        }
+        if (ret != ESP_OK) {
+            /* No END follows */
+            _sr_forward_resume(sr, false);
+        }
+        return ret;
+    }
+
+    if (msg->event_id == SR_UPLOAD_DATA) {
+        /* What is left in the ring after this block is the backlog the network has not taken yet */
+        _sr_ring_sample(sr->ring_el, &sr->ring_hwm);
+        if (sr->is_begin) {
+            sr->is_begin = false;
+            ESP_LOGI(TAG, "Press to first upload %d ms", (int)((esp_timer_get_time() - sr->start_time) / 1000));
+            if (sr->on_begin) {
+                sr->on_begin(sr);
+            }
+        }
+        if (sr->upload_failed) {
+            if (sr->spooling && sr_spool_append(sr->spool, msg->buffer, msg->buffer_len) != ESP_OK) {
+                ESP_LOGW(TAG, "Spool full, the utterance is not kept");
+                sr->spooling = false;
+            }
+            return sr->spooling ? msg->buffer_len : ESP_FAIL;
+        }
+        _sr_replay_keep(sr, msg->buffer, msg->buffer_len);
+        int write_len = sr->provider->frame(sr->provider_ctx, msg->buffer, msg->buffer_len);
+        if (write_len <= 0 && _sr_retry(sr, false) == ESP_OK) {
+            /* The resend included this block */
+            write_len = msg->buffer_len;
+        }
+        if (write_len > 0) {
+            sr_latency_mark(&sr->latency, SR_LATENCY_FIRST_SENT);
+            sr->sr_total_write += write_len;
+            return write_len;
+        }
+        sr->upload_failed = true;
+        /* The replay buffer already holds this block */
+        sr->spooling = _sr_spool_start(sr);
+        if (sr->spooling) {
+            ESP_LOGW(TAG, "Upload failed after %d bytes, spooling the utterance", sr->sr_total_write);
+            return msg->buffer_len;
+        }
+        return write_len;
+    }
+
+    if (msg->event_id == SR_UPLOAD_END) {
+        ESP_LOGI(TAG, "[ + ] Utterance ends, total:%d", sr->sr_total_write);
+        sr_latency_mark(&sr->latency, SR_LATENCY_LAST_SENT);
+        /* A failed upload still needs its connection torn down */
+        esp_err_t ret = sr->provider->end(sr->provider_ctx);
+        if (ret != ESP_OK && !sr->upload_failed) {
+            ret = _sr_retry(sr, true);
+            if (ret != ESP_OK) {
+                sr->upload_failed = true;
+                sr->spooling = _sr_spool_start(sr);
+            }
+        }
+        if (ret == ESP_OK && sr->result.valid) {
+            sr_latency_mark(&sr->latency, SR_LATENCY_RESULT);
+        }
+        sr_latency_close(&sr->latency);
+        if (sr->retries > 0) {
+            ESP_LOGW(TAG, "Utterance took %d retries, %d ms added", sr->retries, (int)(sr->retry_us / 1000));
+        }
+        bool recognized = ret == ESP_OK && !sr->upload_failed && sr->result.valid;
+        sr->result_valid = sr->result.valid;
+        sr->result_len = sr->result.len;
+        if (sr->spooling) {
+            sr->spooling = false;
+            if (sr_spool_end(sr->spool, true) == ESP_OK) {
+                ESP_LOGW(TAG, "Utterance spooled, %d waiting to be forwarded", sr_spool_pending(sr->spool));
+            }
+        }
+        _sr_forward_resume(sr, recognized);
+        return sr->upload_failed ? ESP_FAIL : ret;
+    }
+    return ESP_OK;
+}
+
+/*
+ * Pre-roll mode: everything the microphone hears goes through the pre-roll
+ * buffer, and while a session is active also into the upload pipeline, led
+ * by the newest `preroll_len` bytes recorded before the session started.
+ */
+static void _sr_capture_task(void *pv)
+{
+    sr_core_t *sr = (sr_core_t *)pv;
+    while (sr->capture_running) {
+        _sr_ring_sample(sr->i2s_reader, &sr->capture_ring_hwm);
+        int len = raw_stream_read(sr->raw_reader, sr->capture_buffer, sr->buffer_size);
+        if (len <= 0) {
+            continue;
+        }
+        xSemaphoreTake(sr->capture_lock, portMAX_DELAY);
+        sr_session_state_t session = sr->session;
+        if (session == SR_SESSION_STARTING) {
+            sr->session = SR_SESSION_ACTIVE;
+        } else if (session == SR_SESSION_STOPPING) {
+            sr->session = SR_SESSION_IDLE;
+        }
+        xSemaphoreGive(sr->capture_lock);
+
+        if (session == SR_SESSION_STOPPING) {
+            /* Everything of the session is in the upload pipeline by now */
+            sr_upload_stream_finish(sr->upload_writer);
+        }
+        if (session == SR_SESSION_STARTING) {
+            sr_latency_mark(&sr->latency, SR_LATENCY_RUN);
+            ESP_LOGI(TAG, "Press to capture %d ms", (int)((esp_timer_get_time() - sr->start_time) / 1000));
+            const uint8_t *first, *second;
+            int first_len, second_len;
+            int preroll_len = sr_preroll_peek(&sr->preroll, sr->preroll_len, &first, &first_len, &second, &second_len);
+            ESP_LOGI(TAG, "Prepend %d ms of pre-roll", preroll_len * 1000 / (sr->sample_rates * 2));
+            raw_stream_write(sr->raw_writer, (char *)first, first_len);
+            if (second_len > 0) {
+                raw_stream_write(sr->raw_writer, (char *)second, second_len);
+            }
+        }
+        if (session == SR_SESSION_STARTING || session == SR_SESSION_ACTIVE) {
+            raw_stream_write(sr->raw_writer, sr->capture_buffer, len);
+        }
+        sr_preroll_write(&sr->preroll, (const uint8_t *)sr->capture_buffer, len);
+    }
+    xSemaphoreGive(sr->capture_exited);
+    vTaskDelete(NULL);
+}
+
+/*
+ * Size the ring in front of the uploader for `max_stall_ms` of audio, or for
+ * what the memory budget leaves after the `fixed` buffers if that is less.
+ */
+static int _sr_plan_ring(sr_core_t *sr, sr_core_config_t *config, int fixed)
+{
+    int budget = config->memory_budget > 0 ? config->memory_budget : DEFAULT_SR_MEMORY_BUDGET;
+    int max_stall_ms = config->max_stall_ms > 0 ? config->max_stall_ms : DEFAULT_SR_MAX_STALL_MS;
+    int bytes_per_ms = sr->sample_rates * 2 / 1000;
+    int ring_size = max_stall_ms * bytes_per_ms;
+    if (ring_size > budget - fixed) {
+        ring_size = budget - fixed;
+    }
+    ring_size -= ring_size % sr->buffer_size;
+    if (ring_size < 2 * sr->buffer_size) {
+        ring_size = 2 * sr->buffer_size;
+    }
+    if (ring_size < max_stall_ms * bytes_per_ms) {
+        ESP_LOGW(TAG, "Memory budget of %d bytes rides out %d ms of network stall, %d ms asked",
+                 budget, ring_size / bytes_per_ms, max_stall_ms);
+    }
+    if (fixed + ring_size > budget) {
+        ESP_LOGW(TAG, "Memory budget of %d bytes exceeded, %d bytes needed", budget, fixed + ring_size);
+    }
+    ESP_LOGI(TAG, "Memory plan: %d bytes of buffers, %d bytes of audio ring (%d ms), budget %d",
+             fixed, ring_size, ring_size / bytes_per_ms, budget);
+    return ring_size;
+}
+
+sr_core_handle_t sr_core_init(sr_core_config_t *config)
+{
+    audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
+    sr_core_t *sr = calloc(1, sizeof(sr_core_t));
+    AUDIO_MEM_CHECK(TAG, sr, return NULL);
+    sr->pipeline = audio_pipeline_init(&pipeline_cfg);
+    AUDIO_MEM_CHECK(TAG, sr->pipeline, goto exit_sr_init);
+
+    sr->buffer_size = config->buffer_size;
+    if (sr->buffer_size <= 0) {
+        sr->buffer_size = DEFAULT_SR_BUFFER_SIZE;
+    }
+    sr->sample_rates = config->upload_sample_rate > 0 ? config->upload_sample_rate : config->record_sample_rates;
+    sr->on_begin = config->on_begin;
+    sr->on_result = config->on_result;
+    if (config->placement) {
+        sr->placement = *config->placement;
+    } else {
+        sr->placement = (sr_core_placement_t)SR_CORE_DEFAULT_PLACEMENT();
+    }
+
+    sr->result.size = config->result_size > 0 ? config->result_size : DEFAULT_SR_RESULT_SIZE;
+    sr->result.text = calloc(1, sr->result.size);
+    AUDIO_MEM_CHECK(TAG, sr->result.text, goto exit_sr_init);
+    sr->result.on_update = _sr_on_result;
+    sr->result.user_data = sr;
+    sr->env.sample_rate = sr->sample_rates;
+    sr->env.format = config->encoding;
+    sr->env.frame_max = sr->buffer_size;
+    sr->env.result = &sr->result;
+    sr->env.latency = &sr->latency;
+    sr->env.task = &sr->placement.hedge;
+    sr->provider_lock = xSemaphoreCreateMutex();
+    AUDIO_MEM_CHECK(TAG, sr->provider_lock, goto exit_sr_init);
+    sr->provider = config->provider;
+    sr->provider_ctx = sr->provider->create(config->provider_config, &sr->env);
+    if (sr->provider_ctx == NULL) {
+        ESP_LOGE(TAG, "Error create provider %s", sr->provider->name);
+        goto exit_sr_init;
+    }
+
+    sr->live_text = sr->result.text;
+    sr->latency_hist = calloc(1, sizeof(sr_latency_hist_t));
+    AUDIO_MEM_CHECK(TAG, sr->latency_hist, goto exit_sr_init);
+    audio_event_iface_cfg_t evt_cfg = AUDIO_EVENT_IFACE_DEFAULT_CFG();
+    sr->event = audio_event_iface_init(&evt_cfg);
+    AUDIO_MEM_CHECK(TAG, sr->event, goto exit_sr_init);
+    if (config->spool_partition) {
+        sr->spool = sr_spool_init(config->spool_partition);
+        if (sr->spool == NULL) {
+            ESP_LOGW(TAG, "Recording without a spool");
+        }
+    }
+    sr->replay_size = config->replay_size ? config->replay_size : DEFAULT_SR_REPLAY_SIZE;
+    sr->max_retries = config->max_retries ? config->max_retries : DEFAULT_SR_MAX_RETRIES;
+    /* The spool is only written once the upload failed, from this buffer */
+    if (sr->replay_size > 0 && (sr->max_retries > 0 || sr->spool)) {
+        sr->replay = malloc(sr->replay_size);
+        AUDIO_MEM_CHECK(TAG, sr->replay, goto exit_sr_init);
+    }
+    if (sr->spool) {
+        sr->on_forward = config->on_forward;
+        sr->forward_buffer = malloc(sr->buffer_size);
+        AUDIO_MEM_CHECK(TAG, sr->forward_buffer, goto exit_sr_init);
+        sr->forward_text = calloc(1, sr->result.size);
+        AUDIO_MEM_CHECK(TAG, sr->forward_text, goto exit_sr_init);
+        sr->forward_lock = xSemaphoreCreateMutex();
+        AUDIO_MEM_CHECK(TAG, sr->forward_lock, goto exit_sr_init);
+        sr->forward_exited = xSemaphoreCreateBinary();
+        AUDIO_MEM_CHECK(TAG, sr->forward_exited, goto exit_sr_init);
+    }
+    if (config->task_stats) {
+        sr->task_stats = calloc(1, sizeof(sr_task_stats_t));
+        AUDIO_MEM_CHECK(TAG, sr->task_stats, goto exit_sr_init);
+    }
+
+    sr->warm = config->warm_pipeline;
+    if (sr->warm && config->encoding == SR_AUDIO_AMR_WB) {
+        /* The encoder writes the AMR-WB file header only once per run */
+        ESP_LOGW(TAG, "Warm pipeline does not support AMR-WB, using a cold pipeline");
+        sr->warm = false;
+    }
+    bool split = config->preroll_ms > 0 || sr->warm;
+    if (split) {
+        sr->preroll_len = SR_PREROLL_SIZE(config->preroll_ms, sr->sample_rates, 1);
+        sr->capture_ring_size = SR_CORE_CAPTURE_RING_BUFFERS * sr->buffer_size;
+    }
+    /* Result, provider buffers and latency histograms, capture buffer, pre-roll and capture ring in split mode,
+       the audio ring gets what is left */
+    int fixed = sr->result.size + sr->provider->memory(sr->provider_ctx) + sizeof(sr_latency_hist_t);
+    if (split) {
+        fixed += sr->buffer_size + sr->preroll_len + sr->capture_ring_size;
+    }
+    if (sr->spool) {
+        fixed += sr->buffer_size + sr->result.size + sr->placement.forward.stack;
+    }
+    if (sr->task_stats) {
+        fixed += sizeof(sr_task_stats_t);
+    }
+    if (sr->replay) {
+        fixed += sr->replay_size;
+    }
+    /* The downmix and resampler get a capture ring of their own in front, the audio ring holds what is uploaded */
+    int front_ring_size = SR_CORE_CAPTURE_RING_BUFFERS * sr->buffer_size;
+    sr_downmix_stream_cfg_t downmix_cfg = {
+        .sample_rate = config->record_sample_rates,
+        .task_stack = sr->placement.downmix.stack,
+        .task_core = sr->placement.downmix.core,
+        .task_prio = sr->placement.downmix.prio,
+        .buffer_len = 2 * sr->buffer_size,
+    };
+    if (config->downmix) {
+        downmix_cfg.downmix = *config->downmix;
+        fixed += sr_downmix_stream_memory(&downmix_cfg) + 2 * front_ring_size + sr->placement.downmix.stack;
+    }
+    bool resample = sr->sample_rates != config->record_sample_rates;
+    sr_resample_stream_cfg_t resample_cfg = {
+        .in_rate = config->record_sample_rates,
+        .out_rate = sr->sample_rates,
+        .task_stack = sr->placement.resample.stack,
+        .task_core = sr->placement.resample.core,
+        .task_prio = sr->placement.resample.prio,
+        .buffer_len = sr->buffer_size,
+    };
+    if (resample) {
+        fixed += sr_resample_stream_memory(&resample_cfg) + front_ring_size + sr->placement.resample.stack;
+    }
+    sr->ring_size = _sr_plan_ring(sr, config, fixed);
+
+    /* The last of I2S, downmix and resampler feeds the capture ring, or the audio ring in a single pipeline */
+    int head_ring_size = split ? sr->capture_ring_size : sr->ring_size;
+    i2s_stream_cfg_t i2s_cfg = I2S_STREAM_CFG_DEFAULT();
+    i2s_cfg.type = AUDIO_STREAM_READER;
+    i2s_cfg.task_stack = sr->placement.i2s.stack;
+    i2s_cfg.task_core = sr->placement.i2s.core;
+    i2s_cfg.task_prio = sr->placement.i2s.prio;
+    i2s_cfg.out_rb_size = config->downmix ? 2 * front_ring_size : resample ? front_ring_size : head_ring_size;
+    sr->i2s_ring_size = i2s_cfg.out_rb_size;
+    sr->i2s_reader = i2s_stream_init(&i2s_cfg);
+    AUDIO_MEM_CHECK(TAG, sr->i2s_reader, goto exit_sr_init);
+    if (config->downmix) {
+        downmix_cfg.out_rb_size = resample ? front_ring_size : head_ring_size;
+        sr->downmixer = sr_downmix_stream_init(&downmix_cfg);
+        AUDIO_MEM_CHECK(TAG, sr->downmixer, goto exit_sr_init);
+    }
+    if (resample) {
+        resample_cfg.out_rb_size = head_ring_size;
+        sr->resampler = sr_resample_stream_init(&resample_cfg);
+        AUDIO_MEM_CHECK(TAG, sr->resampler, goto exit_sr_init);
+    }
+    sr_upload_stream_cfg_t upload_cfg = {
+        .event_handle = _sr_upload_event_handle,
+        .user_data = sr,
+        .task_stack = sr->placement.upload.stack,
+        .task_core = sr->placement.upload.core,
+        .task_prio = sr->placement.upload.prio,
+        .buffer_len = sr->buffer_size,
+        .warm = sr->warm,
+    };
+    sr->upload_writer = sr_upload_stream_init(&upload_cfg);
+    AUDIO_MEM_CHECK(TAG, sr->upload_writer, goto exit_sr_init);
+
+    audio_pipeline_register(sr->pipeline, sr->upload_writer, "sr_upload");
+    /* I2S, downmix and resampler, then the encoder and uploader, in one pipeline or split at the raw streams */
+    const char *link[5];
+    int link_len = 0;
+    link[link_len++] = "sr_i2s";
+    if (sr->downmixer) {
+        link[link_len++] = "sr_downmix";
+    }
+    if (sr->resampler) {
+        link[link_len++] = "sr_resample";
+    }
+    if (split) {
+        /* The microphone gets a pipeline of its own that is never stopped */
+        if (sr->preroll_len > 0) {
+            AUDIO_MEM_CHECK(TAG, sr_preroll_init(&sr->preroll, sr->preroll_len) == 0, goto exit_sr_init);
+        }
+        sr->capture_buffer = malloc(sr->buffer_size);
+        AUDIO_MEM_CHECK(TAG, sr->capture_buffer, goto exit_sr_init);
+        sr->capture_lock = xSemaphoreCreateMutex();
+        AUDIO_MEM_CHECK(TAG, sr->capture_lock, goto exit_sr_init);
+        sr->capture_exited = xSemaphoreCreateBinary();
+        AUDIO_MEM_CHECK(TAG, sr->capture_exited, goto exit_sr_init);
+
+        sr->capture_pipeline = audio_pipeline_init(&pipeline_cfg);
+        AUDIO_MEM_CHECK(TAG, sr->capture_pipeline, goto exit_sr_init);
+        raw_stream_cfg_t raw_cfg = RAW_STREAM_CFG_DEFAULT();
+        raw_cfg.type = AUDIO_STREAM_READER;
+        sr->raw_reader = raw_stream_init(&raw_cfg);
+        AUDIO_MEM_CHECK(TAG, sr->raw_reader, goto exit_sr_init);
+        raw_cfg.type = AUDIO_STREAM_WRITER;
+        raw_cfg.out_rb_size = sr->ring_size;
+        sr->raw_writer = raw_stream_init(&raw_cfg);
+        AUDIO_MEM_CHECK(TAG, sr->raw_writer, goto exit_sr_init);
+        audio_pipeline_register(sr->capture_pipeline, sr->i2s_reader, "sr_i2s");
+        if (sr->downmixer) {
+            audio_pipeline_register(sr->capture_pipeline, sr->downmixer, "sr_downmix");
+        }
+        if (sr->resampler) {
+            audio_pipeline_register(sr->capture_pipeline, sr->resampler, "sr_resample");
+        }
+        audio_pipeline_register(sr->capture_pipeline, sr->raw_reader, "sr_raw_in");
+        link[link_len++] = "sr_raw_in";
+        audio_pipeline_link(sr->capture_pipeline, link, link_len);
+        audio_pipeline_register(sr->pipeline, sr->raw_writer, "sr_raw_out");
+        link_len = 0;
+        link[link_len++] = "sr_raw_out";
+        sr->ring_el = sr->raw_writer;
+    } else {
+        audio_pipeline_register(sr->pipeline, sr->i2s_reader,         "sr_i2s");
+        sr->ring_el = sr->i2s_reader;
+        if (sr->downmixer) {
+            audio_pipeline_register(sr->pipeline, sr->downmixer,      "sr_downmix");
+            sr->ring_el = sr->downmixer;
+        }
+        if (sr->resampler) {
+            audio_pipeline_register(sr->pipeline, sr->resampler,      "sr_resample");
+            sr->ring_el = sr->resampler;
+        }
+    }
+    if (config->encoding == SR_AUDIO_AMR_WB) {
+        if (sr->sample_rates != 16000) {
+            ESP_LOGW(TAG, "AMR-WB needs 16000Hz audio, got %d", sr->sample_rates);
+        }
+        amrwb_encoder_cfg_t amrwb_cfg = DEFAULT_AMRWB_ENCODER_CONFIG();
+        amrwb_cfg.bitrate_mode = SR_CORE_AMRWB_BITRATE;
+        amrwb_cfg.contain_amrwb_header = true;
+        amrwb_cfg.task_stack = sr->placement.encoder.stack;
+        amrwb_cfg.task_core = sr->placement.encoder.core;
+        amrwb_cfg.task_prio = sr->placement.encoder.prio;
+        sr->encoder = amrwb_encoder_init(&amrwb_cfg);
+        AUDIO_MEM_CHECK(TAG, sr->encoder, goto exit_sr_init);
+        audio_pipeline_register(sr->pipeline, sr->encoder,    "sr_amrwb");
+        link[link_len++] = "sr_amrwb";
+    }
+    link[link_len++] = "sr_upload";
+    audio_pipeline_link(sr->pipeline, link, link_len);
+    i2s_stream_set_clk(sr->i2s_reader, config->record_sample_rates, 16, config->downmix ? 2 : 1);
+    if (sr->capture_pipeline) {
+        sr->capture_running = true;
+        if (xTaskCreatePinnedToCore(_sr_capture_task, "sr_capture", sr->placement.capture.stack, sr,
+                                    sr->placement.capture.prio, &sr->capture_task,
+                                    sr->placement.capture.core) != pdPASS) {
+            ESP_LOGE(TAG, "Error create capture task");
+            sr->capture_running = false;
+            sr->capture_task = NULL;
+            goto exit_sr_init;
+        }
+        audio_pipeline_run(sr->capture_pipeline);
+        ESP_LOGI(TAG, "Capturing with %d bytes of pre-roll", sr->preroll_len);
+    }
+    if (sr->spool) {
+        sr->forward_running = true;
+        if (xTaskCreatePinnedToCore(_sr_forward_task, "sr_forward", sr->placement.forward.stack, sr,
+                                    sr->placement.forward.prio, &sr->forward_task,
+                                    sr->placement.forward.core) != pdPASS) {
+            ESP_LOGE(TAG, "Error create forward task");
+            sr->forward_running = false;
+            sr->forward_task = NULL;
+            goto exit_sr_init;
+        }
+        /* Left over from before the reset */
+        if (sr_spool_pending(sr->spool) > 0) {
+            xTaskNotifyGive(sr->forward_task);
+        }
+    }
+    if (sr->warm) {
+        audio_pipeline_run(sr->pipeline);
+    }
+    ESP_LOGI(TAG, "Recognizing with %s", sr->provider->name);
+
+    return sr;
+exit_sr_init:
+    sr_core_destroy(sr);
+    return NULL;
+}
+
+esp_err_t sr_core_destroy(sr_core_handle_t sr)
+{
+    if (sr == NULL) {
+        return ESP_FAIL;
+    }
+    if (sr->forward_task) {
+        sr->forward_running = false;
+        sr->forward_abort = true;
+        if (sr->forwarding && sr->provider->cancel) {
+            sr->provider->cancel(sr->provider_ctx);
+        }
+        xTaskNotifyGive(sr->forward_task);
+        xSemaphoreTake(sr->forward_exited, portMAX_DELAY);
+    }
+    if (sr->capture_pipeline) {
+        if (sr->capture_task) {
+            sr->capture_running = false;
+            audio_pipeline_stop(sr->capture_pipeline);
+            audio_pipeline_wait_for_stop(sr->capture_pipeline);
+            xSemaphoreTake(sr->capture_exited, portMAX_DELAY);
+        }
+        audio_pipeline_terminate(sr->capture_pipeline);
+        audio_pipeline_deinit(sr->capture_pipeline);
+    }
+    if (sr->pipeline) {
+        audio_pipeline_terminate(sr->pipeline);
+        audio_pipeline_remove_listener(sr->pipeline);
+        audio_pipeline_deinit(sr->pipeline);
+    }
+    if (sr->i2s_reader) {
+        audio_element_deinit(sr->i2s_reader);
+    }
+    if (sr->downmixer) {
+        audio_element_deinit(sr->downmixer);
+    }
+    if (sr->resampler) {
+        audio_element_deinit(sr->resampler);
+    }
+    if (sr->raw_reader) {
+        audio_element_deinit(sr->raw_reader);
+    }
+    if (sr->raw_writer) {
+        audio_element_deinit(sr->raw_writer);
+    }
+    if (sr->capture_lock) {
+        vSemaphoreDelete(sr->capture_lock);
+    }
+    if (sr->capture_exited) {
+        vSemaphoreDelete(sr->capture_exited);
+    }
+    sr_preroll_deinit(&sr->preroll);
+    free(sr->capture_buffer);
+    if (sr->encoder) {
+        audio_element_deinit(sr->encoder);
+    }
+    if (sr->upload_writer) {
+        audio_element_deinit(sr->upload_writer);
+    }
+    if (sr->provider_ctx) {
+        sr->provider->destroy(sr->provider_ctx);
+    }
+    if (sr->provider_lock) {
+        vSemaphoreDelete(sr->provider_lock);
+    }
+    if (sr->forward_lock) {
+        vSemaphoreDelete(sr->forward_lock);
+    }
+    if (sr->forward_exited) {
+        vSemaphoreDelete(sr->forward_exited);
+    }
+    if (sr->spool) {
+        sr_spool_destroy(sr->spool);
+    }
+    if (sr->event) {
+        if (sr->listener) {
+            audio_event_iface_remove_listener(sr->listener, sr->event);
+        }
+        audio_event_iface_destroy(sr->event);
+    }
+    free(sr->latency_hist);
+    free(sr->task_stats);
+    free(sr->replay);
+    free(sr->forward_buffer);
+    free(sr->forward_text);
+    free(sr->result.text);
+    free(sr);
+    return ESP_OK;
+}
+
+esp_err_t sr_core_set_listener(sr_core_handle_t sr, audio_event_iface_handle_t listener)
+{
+    if (listener) {
+        audio_pipeline_set_listener(sr->pipeline, listener);
+        audio_event_iface_set_listener(sr->event, listener);
+        sr->listener = listener;
+    }
+    return ESP_OK;
+}
+
+esp_err_t sr_core_set_provider(sr_core_handle_t sr, const sr_provider_t *provider, const void *config)
+{
+    void *ctx = provider->create(config, &sr->env);
+    if (ctx == NULL) {
+        ESP_LOGE(TAG, "Error create provider %s, keeping %s", provider->name, sr->provider->name);
+        return ESP_FAIL;
+    }
+    int memory = provider->memory(ctx);
+    _sr_forward_pause(sr);
+    xSemaphoreTake(sr->provider_lock, portMAX_DELAY);
+    sr->provider->destroy(sr->provider_ctx);
+    sr->provider = provider;
+    sr->provider_ctx = ctx;
+    xSemaphoreGive(sr->provider_lock);
+    _sr_forward_resume(sr, true);
+    ESP_LOGI(TAG, "Recognizing with %s, %d bytes of provider buffers", provider->name, memory);
+    return ESP_OK;
+}
+
+const char *sr_core_get_provider_name(sr_core_handle_t sr)
+{
+    return sr->provider->name;
+}
+
+esp_err_t sr_core_set_credential(sr_core_handle_t sr, const char *credential)
+{
+    esp_err_t ret = ESP_ERR_NOT_SUPPORTED;
+    xSemaphoreTake(sr->provider_lock, portMAX_DELAY);
+    if (sr->provider->set_credential) {
+        ret = sr->provider->set_credential(sr->provider_ctx, credential);
+    }
+    xSemaphoreGive(sr->provider_lock);
+    return ret;
+}
+
+esp_err_t sr_core_preconnect(sr_core_handle_t sr)
+{
+    if (sr->provider->connect == NULL) {
+        return ESP_OK;
+    }
+    /* A replay in progress has the connection open anyway */
+    if (sr->forward_lock && xSemaphoreTake(sr->forward_lock, 0) != pdTRUE) {
+        return ESP_OK;
+    }
+    esp_err_t ret = sr->provider->connect(sr->provider_ctx);
+    if (sr->forward_lock) {
+        xSemaphoreGive(sr->forward_lock);
+    }
+    return ret;
+}
+
+esp_err_t sr_core_get_result_info(sr_core_handle_t sr, sr_core_result_info_t *info)
+{
+    info->retries = sr->retries;
+    info->retry_ms = (int)(sr->retry_us / 1000);
+    return ESP_OK;
+}
+
+esp_err_t sr_core_get_latency(sr_core_handle_t sr, sr_latency_stage_t stage, sr_latency_stats_t *stats)
+{
+    sr_latency_hist_stats(sr->latency_hist, stage, stats);
+    return ESP_OK;
+}
+
+esp_err_t sr_core_latency_dump(sr_core_handle_t sr)
+{
+    sr_latency_hist_dump(sr->latency_hist, sr->provider->name);
+    return ESP_OK;
+}
+
+esp_err_t sr_core_latency_reset(sr_core_handle_t sr)
+{
+    memset(sr->latency_hist, 0, sizeof(sr_latency_hist_t));
+    return ESP_OK;
+}
+
+const sr_task_stats_t *sr_core_get_task_stats(sr_core_handle_t sr)
+{
+    return sr->task_stats && sr->task_stats->count > 0 ? sr->task_stats : NULL;
+}
+
+esp_err_t sr_core_task_stats_dump(sr_core_handle_t sr)
+{
+    if (sr_core_get_task_stats(sr) == NULL) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    sr_task_stats_dump(sr->task_stats, sr->provider->name);
+    return ESP_OK;
+}
+
+esp_err_t sr_core_spool_flush(sr_core_handle_t sr)
+{
+    if (sr->forward_task == NULL) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    xTaskNotifyGive(sr->forward_task);
+    return ESP_OK;
+}
+
+esp_err_t sr_core_start(sr_core_handle_t sr)
+{
+    if (sr->finish_pending) {
+        /* Audio of this session would otherwise be appended to the unfinished one */
+        if (sr_upload_stream_wait_finished(sr->upload_writer, SR_CORE_FINISH_TIMEOUT_MS) != ESP_OK) {
+            ESP_LOGE(TAG, "Previous utterance still uploading");
+            return ESP_FAIL;
+        }
+        sr->finish_pending = false;
+    }
+    sr->start_time = esp_timer_get_time();
+    sr->result_valid = false;
+    sr_latency_open(&sr->latency);
+    sr_latency_mark(&sr->latency, SR_LATENCY_PRESS);
+    if (sr->task_stats) {
+        sr_task_stats_begin(sr->task_stats);
+    }
+    /* A warm pipeline is already running, the utterance begins with the first audio */
+    if (!sr->warm) {
+        audio_pipeline_reset_items_state(sr->pipeline);
+        audio_pipeline_reset_ringbuffer(sr->pipeline);
+        audio_pipeline_run(sr->pipeline);
+        sr_latency_mark(&sr->latency, SR_LATENCY_RUN);
+    }
+    if (sr->capture_pipeline) {
+        xSemaphoreTake(sr->capture_lock, portMAX_DELAY);
+        sr->session = SR_SESSION_STARTING;
+        xSemaphoreGive(sr->capture_lock);
+    }
+    return ESP_OK;
+}
+
+/* Stack and CPU of the recognizer's tasks over the utterance, the others are in sr_core_task_stats_dump */
+static void _sr_task_stats_done(sr_core_t *sr)
+{
+    if (sr_task_stats_end(sr->task_stats) == 0) {
+        return;
+    }
+    for (int i = 0; i < sizeof(sr_task_names) / sizeof(sr_task_names[0]); i++) {
+        const sr_task_stat_t *task = sr_task_stats_find(sr->task_stats, sr_task_names[i]);
+        if (task == NULL) {
+            continue;
+        }
+        if (task->cpu_permille >= 0) {
+            ESP_LOGI(TAG, "Task %s: core %d, prio %d, %d bytes of stack free, %d.%d%% CPU", task->name, task->core,
+                     task->prio, task->stack_free, task->cpu_permille / 10, task->cpu_permille % 10);
+        } else {
+            ESP_LOGI(TAG, "Task %s: core %d, prio %d, %d bytes of stack free", task->name, task->core,
+                     task->prio, task->stack_free);
+        }
+        if (task->stack_free < SR_CORE_STACK_MARGIN) {
+            ESP_LOGW(TAG, "Task %s is down to %d bytes of stack", task->name, task->stack_free);
+        }
+    }
+}
+
+/* The utterance is over, add it to the histograms and tell the listener */
+static void _sr_latency_done(sr_core_t *sr)
+{
+    sr_latency_close(&sr->latency);
+    sr_latency_report(&sr->latency, &sr->latency_report);
+    sr_latency_hist_add(sr->latency_hist, &sr->latency_report);
+    const int *stage_ms = sr->latency_report.stage_ms;
+    ESP_LOGI(TAG, "Latency ms: start %d, connect %d, capture %d, drain %d, reply %d, final %d, total %d",
+             stage_ms[SR_LATENCY_STAGE_START], stage_ms[SR_LATENCY_STAGE_CONNECT], stage_ms[SR_LATENCY_STAGE_CAPTURE],
+             stage_ms[SR_LATENCY_STAGE_DRAIN], stage_ms[SR_LATENCY_STAGE_REPLY], stage_ms[SR_LATENCY_STAGE_FINAL],
+             stage_ms[SR_LATENCY_STAGE_TOTAL]);
+    if (sr->listener == NULL) {
+        return;
+    }
+    audio_event_iface_msg_t msg = {
+        .source_type = SR_CORE_EVENT_SOURCE,
+        .source = sr,
+        .cmd = SR_CORE_EVENT_LATENCY,
+        .data = &sr->latency_report,
+        .data_len = sizeof(sr_latency_report_t),
+        .need_free_data = false,
+    };
+    if (audio_event_iface_sendout(sr->event, &msg) != ESP_OK) {
+        ESP_LOGW(TAG, "Listener queue full, latency event dropped");
+    }
+}
+
+char *sr_core_stop(sr_core_handle_t sr)
+{
+    sr_latency_mark(&sr->latency, SR_LATENCY_RELEASE);
+    if (sr->warm) {
+        /* The capture task hands over the end of the session, then the writer drains and finishes */
+        xSemaphoreTake(sr->capture_lock, portMAX_DELAY);
+        bool active = sr->session != SR_SESSION_IDLE;
+        if (active) {
+            sr->session = SR_SESSION_STOPPING;
+        }
+        xSemaphoreGive(sr->capture_lock);
+        if (active && sr_upload_stream_wait_finished(sr->upload_writer, SR_CORE_FINISH_TIMEOUT_MS) != ESP_OK) {
+            ESP_LOGE(TAG, "No response within %d ms", SR_CORE_FINISH_TIMEOUT_MS);
+            sr->finish_pending = true;
+        }
+    } else {
+        if (sr->capture_pipeline) {
+            xSemaphoreTake(sr->capture_lock, portMAX_DELAY);
+            sr->session = SR_SESSION_IDLE;
+            xSemaphoreGive(sr->capture_lock);
+        }
+        audio_pipeline_stop(sr->pipeline);
+        audio_pipeline_wait_for_stop(sr->pipeline);
+        ESP_LOGD(TAG, "Pipeline stopped");
+    }
+    if (sr->provider->report) {
+        sr->provider->report(sr->provider_ctx);
+    }
+    ESP_LOGI(TAG, "High-water marks: audio ring %d/%d (%d ms stall), result %d/%d, capture ring %d/%d",
+             sr->ring_hwm, sr->ring_size, sr->ring_hwm / (sr->sample_rates * 2 / 1000),
+             sr->result_len, sr->result.size, sr->capture_ring_hwm, sr->i2s_ring_size);
+    if (sr->downmixer) {
+        ESP_LOGI(TAG, "Microphone delay %d samples", sr_downmix_stream_get_delay(sr->downmixer));
+    }
+    sr->ring_hwm = 0;
+    sr->capture_ring_hwm = 0;
+    if (sr->task_stats) {
+        _sr_task_stats_done(sr);
+    }
+    _sr_latency_done(sr);
+    return sr->result_valid ? sr->live_text : NULL;
+}
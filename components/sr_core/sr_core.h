@@ -0,0 +1,320 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _SR_CORE_H_
+#define _SR_CORE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "audio_event_iface.h"
+#include "sr_provider.h"
+#include "sr_downmix.h"
+#include "sr_task_stats.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DEFAULT_SR_BUFFER_SIZE (2048)
+#define DEFAULT_SR_MEMORY_BUDGET (112*1024)
+#define DEFAULT_SR_MAX_STALL_MS (1000)
+#define DEFAULT_SR_RESULT_SIZE (1024)
+#define DEFAULT_SR_REPLAY_SIZE (64*1024)
+#define DEFAULT_SR_MAX_RETRIES (2)
+#define SR_CORE_FORWARD_RETRY_S (30)
+#define SR_CORE_EVENT_SOURCE (0x5352)  /*!< `source_type` of the events sent to the listener, `source` is the recognizer */
+
+/**
+ * `cmd` of the events sent to the listener
+ */
+typedef enum {
+    SR_CORE_EVENT_LATENCY = 1,          /*!< An utterance is over, `data` is its sr_latency_report_t, valid until the next sr_core_stop */
+} sr_core_event_t;
+
+typedef struct sr_core* sr_core_handle_t;
+typedef void (*sr_core_event_handle_t)(sr_core_handle_t sr);
+typedef void (*sr_core_result_handle_t)(sr_core_handle_t sr, const char *text, bool is_final);
+typedef void (*sr_core_forward_handle_t)(sr_core_handle_t sr, const char *text, uint32_t timestamp);
+
+/**
+ * How the last utterance went, besides its text
+ */
+typedef struct {
+   int retries;                        /*!< Requests reopened and the utterance resent after a transport error */
+   int retry_ms;                       /*!< Time spent on that, added to the latency */
+} sr_core_result_info_t;
+
+/**
+ * Task placement of the recognizer, start from SR_CORE_DEFAULT_PLACEMENT
+ */
+typedef struct {
+   sr_task_place_t i2s;                /*!< I2S reader, overruns when it cannot drain the DMA buffers in time */
+   sr_task_place_t downmix;            /*!< Downmix element, when recording both microphones */
+   sr_task_place_t resample;           /*!< Resampler element, when the upload rate differs */
+   sr_task_place_t capture;            /*!< Drains the capture pipeline in pre-roll and warm mode */
+   sr_task_place_t encoder;            /*!< AMR-WB encoder element */
+   sr_task_place_t upload;             /*!< Uploader element, runs the provider and its HTTP or WebSocket client */
+   sr_task_place_t forward;            /*!< Forwards the spooled utterances */
+   sr_task_place_t hedge;              /*!< Sender task of each hedge leg, sr_hedge0 and sr_hedge1 */
+} sr_core_placement_t;
+
+/* The I2S reader and encoder as in I2S_STREAM_CFG_DEFAULT and DEFAULT_AMRWB_ENCODER_CONFIG */
+#define SR_CORE_DEFAULT_PLACEMENT() {                               \
+    .i2s      = { .stack = 3*1024,  .core = 0,  .prio = 23 },       \
+    .downmix  = { .stack = 3*1024,  .core = 0,  .prio = 10 },       \
+    .resample = { .stack = 3*1024,  .core = 0,  .prio = 10 },       \
+    .capture  = { .stack = 3*1024,  .core = tskNO_AFFINITY, .prio = 10 }, \
+    .encoder  = { .stack = 15*1024, .core = 0,  .prio = 5 },        \
+    .upload   = { .stack = 8*1024,  .core = 1,  .prio = 5 },        \
+    .forward  = { .stack = 8*1024,  .core = tskNO_AFFINITY, .prio = 3 }, \
+    .hedge    = { .stack = 6*1024,  .core = 1,  .prio = 5 },        \
+}
+
+/**
+ * Speech recognizer configuration
+ */
+typedef struct {
+   const sr_provider_t *provider;      /*!< Recognizer service, see sr_core_set_provider */
+   const void *provider_config;        /*!< The provider's configuration, only used during sr_core_init */
+   int record_sample_rates;            /*!< Audio recording sample rate, the I2S clock */
+   int upload_sample_rate;             /*!< Sample rate the provider gets, a resampler follows the I2S reader if it
+                                            differs from the recording rate. record_sample_rates if 0 */
+   const sr_downmix_cfg_t *downmix;    /*!< Record both microphones and downmix them to mono ahead of the resampler,
+                                            NULL records mono. Only used during sr_core_init */
+   sr_audio_format_t encoding;         /*!< Audio handed to the provider, SR_AUDIO_AMR_WB inserts an encoder */
+   int buffer_size;                    /*!< Processing buffer size */
+   int preroll_ms;                     /*!< Keep capturing between utterances and prepend this much audio, 0 disables, costs 32 bytes/ms at 16kHz */
+   bool warm_pipeline;                 /*!< Keep both pipelines running, start and stop only flip a session flag */
+   int memory_budget;                  /*!< Bytes for the recognizer's buffers and audio ring, DEFAULT_SR_MEMORY_BUDGET if 0 */
+   int max_stall_ms;                   /*!< Network stall the audio ring should ride out, DEFAULT_SR_MAX_STALL_MS if 0 */
+   int result_size;                    /*!< Recognized text buffer, DEFAULT_SR_RESULT_SIZE if 0 */
+   int replay_size;                    /*!< Audio kept to resend an utterance whose request broke off, counted in the
+                                            memory budget. DEFAULT_SR_REPLAY_SIZE if 0, < 0 disables retries and the spool */
+   int max_retries;                    /*!< Resends per utterance, DEFAULT_SR_MAX_RETRIES if 0, < 0 disables retries */
+   sr_core_event_handle_t on_begin;    /*!< Begin send audio data to server */
+   sr_core_result_handle_t on_result;  /*!< Partial and final text, as far as the provider reports them */
+   const char *spool_partition;        /*!< Label of a spool partition, see sr_spool.h. Utterances the provider fails on
+                                            are kept there and forwarded later, NULL disables. Only written after a
+                                            failure, from the replay buffer: longer utterances are not kept */
+   sr_core_forward_handle_t on_forward;/*!< Text of a spooled utterance and the Unix time it was recorded at (0 if unknown),
+                                            called from the forwarding task */
+   const sr_core_placement_t *placement;/*!< Core, priority and stack of each task, SR_CORE_DEFAULT_PLACEMENT if NULL.
+                                            Only used during sr_core_init */
+   bool task_stats;                    /*!< Measure the stack and CPU use of every task over each utterance, see
+                                            sr_core_get_task_stats */
+} sr_core_config_t;
+
+/**
+ * @brief      Initialize the speech recognizer, this function will return a recognizer context
+ *
+ * @param      config  The recognizer configuration
+ *
+ * @return     The recognizer context
+ */
+sr_core_handle_t sr_core_init(sr_core_config_t *config);
+
+/**
+ * @brief      Cleanup the recognizer object
+ *
+ * @param[in]  sr   The recognizer context
+ *
+ * @return
+ *  - ESP_OK
+ *  - ESP_FAIL
+ */
+esp_err_t sr_core_destroy(sr_core_handle_t sr);
+
+/**
+ * @brief      Register listener for the recognizer context
+ *
+ * It gets the pipeline events and the SR_CORE_EVENT_SOURCE events.
+ *
+ * @param[in]  sr        The recognizer context
+ * @param[in]  listener  The listener
+ *
+ * @return
+ *  - ESP_OK
+ *  - ESP_FAIL
+ */
+esp_err_t sr_core_set_listener(sr_core_handle_t sr, audio_event_iface_handle_t listener);
+
+/**
+ * @brief      Switch to another recognizer service
+ *
+ * The audio ring keeps the size planned at sr_core_init. Only call it while no recording is in progress.
+ *
+ * @param[in]  sr        The recognizer context
+ * @param[in]  provider  The provider
+ * @param[in]  config    The provider's configuration
+ *
+ * @return
+ *  - ESP_OK
+ *  - ESP_FAIL, the previous provider is kept
+ */
+esp_err_t sr_core_set_provider(sr_core_handle_t sr, const sr_provider_t *provider, const void *config);
+
+/**
+ * @brief      Name of the provider in use
+ *
+ * @param[in]  sr   The recognizer context
+ *
+ * @return     The provider name
+ */
+const char *sr_core_get_provider_name(sr_core_handle_t sr);
+
+/**
+ * @brief      Pass a new credential to the provider in use, safe to call from any task
+ *
+ * @param[in]  sr          The recognizer context
+ * @param[in]  credential  The credential, copied
+ *
+ * @return
+ *  - ESP_OK
+ *  - ESP_ERR_NOT_SUPPORTED if the provider takes none
+ *  - ESP_FAIL
+ */
+esp_err_t sr_core_set_credential(sr_core_handle_t sr, const char *credential);
+
+/**
+ * @brief      Let the provider connect ahead of the next recording
+ *
+ * Only call it while no recording is in progress.
+ *
+ * @param[in]  sr   The recognizer context
+ *
+ * @return
+ *     - ESP_OK, also if the provider has nothing to prepare
+ *     - ESP_FAIL
+ */
+esp_err_t sr_core_preconnect(sr_core_handle_t sr);
+
+/**
+ * @brief      Retries of the last utterance, valid after sr_core_stop
+ *
+ * @param[in]  sr    The recognizer context
+ * @param[out] info  The retry count and added latency
+ *
+ * @return
+ *     - ESP_OK
+ */
+esp_err_t sr_core_get_result_info(sr_core_handle_t sr, sr_core_result_info_t *info);
+
+/**
+ * @brief      Latency percentiles of a stage over the utterances so far
+ *
+ * Only call it from the task calling sr_core_stop, which adds to the histograms.
+ *
+ * @param[in]  sr     The recognizer context
+ * @param[in]  stage  The stage
+ * @param[out] stats  Count and percentiles
+ *
+ * @return
+ *     - ESP_OK
+ */
+esp_err_t sr_core_get_latency(sr_core_handle_t sr, sr_latency_stage_t stage, sr_latency_stats_t *stats);
+
+/**
+ * @brief      Print the latency percentiles of all stages to the console UART, labelled with the provider name
+ *
+ * @param[in]  sr     The recognizer context
+ *
+ * @return
+ *     - ESP_OK
+ */
+esp_err_t sr_core_latency_dump(sr_core_handle_t sr);
+
+/**
+ * @brief      Empty the latency histograms, for example after switching providers
+ *
+ * @param[in]  sr     The recognizer context
+ *
+ * @return
+ *     - ESP_OK
+ */
+esp_err_t sr_core_latency_reset(sr_core_handle_t sr);
+
+/**
+ * @brief      Stack and CPU use of every task over the last utterance, valid after sr_core_stop
+ *
+ * Needs `task_stats` in the configuration and CONFIG_FREERTOS_USE_TRACE_FACILITY.
+ *
+ * @param[in]  sr   The recognizer context
+ *
+ * @return     The stats, NULL if not measured
+ */
+const sr_task_stats_t *sr_core_get_task_stats(sr_core_handle_t sr);
+
+/**
+ * @brief      Print the stack and CPU use of the last utterance to the console UART, labelled with the provider name
+ *
+ * @param[in]  sr     The recognizer context
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_ERR_NOT_SUPPORTED if not measured
+ */
+esp_err_t sr_core_task_stats_dump(sr_core_handle_t sr);
+
+/**
+ * @brief      Forward the spooled utterances now, for example when the network is back
+ *
+ * Without a call they are retried every SR_CORE_FORWARD_RETRY_S, and after every recording the provider took.
+ * A recording pauses the forwarding.
+ *
+ * @param[in]  sr   The recognizer context
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_ERR_NOT_SUPPORTED if there is no spool
+ */
+esp_err_t sr_core_spool_flush(sr_core_handle_t sr);
+
+/**
+ * @brief      Start recording and sending audio
+ *
+ * Warm: if the previous stop timed out, first waits for that utterance to finish.
+ *
+ * @param[in]  sr   The recognizer context
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_FAIL
+ */
+esp_err_t sr_core_start(sr_core_handle_t sr);
+
+/**
+ * @brief      Stop sending audio and get the result text
+ *
+ * @param[in]  sr   The recognizer context
+ *
+ * @return     The recognized text, NULL if none. Owned by `sr`, valid until the next sr_core_start
+ */
+char *sr_core_stop(sr_core_handle_t sr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
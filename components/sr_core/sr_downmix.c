@@ -0,0 +1,135 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "sr_downmix.h"
+
+#define SR_DOWNMIX_SPEECH_FLOOR     (100)   /* RMS below which a block is not used to find the delay, about -50 dBFS */
+#define SR_DOWNMIX_COHERENCE_PCT    (50)    /* Normalized correlation a block needs to move the delay */
+
+static int _sr_downmix_max_delay(const sr_downmix_cfg_t *config, int sample_rate, int *delay)
+{
+    int spacing_mm = config->spacing_mm > 0 ? config->spacing_mm : SR_DOWNMIX_DEFAULT_SPACING_MM;
+    int max_delay = (int)(((int64_t)spacing_mm * sample_rate + SR_DOWNMIX_SPEED_OF_SOUND_MM_S - 1)
+                          / SR_DOWNMIX_SPEED_OF_SOUND_MM_S);
+    *delay = 0;
+    switch (config->mode) {
+    case SR_DOWNMIX_DELAY_SUM:
+        *delay = (int)(((int64_t)config->delay_us * sample_rate + (config->delay_us < 0 ? -500000 : 500000)) / 1000000);
+        return abs(*delay) > max_delay ? abs(*delay) : max_delay;
+    case SR_DOWNMIX_ADAPTIVE:
+        return max_delay;
+    default:
+        return 0;
+    }
+}
+
+int sr_downmix_memory(const sr_downmix_cfg_t *config, int sample_rate, int block)
+{
+    int delay;
+    return (_sr_downmix_max_delay(config, sample_rate, &delay) + block) * 2 * sizeof(int16_t);
+}
+
+int sr_downmix_init(sr_downmix_t *dm, const sr_downmix_cfg_t *config, int sample_rate, int block)
+{
+    memset(dm, 0, sizeof(sr_downmix_t));
+    dm->mode = config->mode;
+    dm->max_delay = _sr_downmix_max_delay(config, sample_rate, &dm->delay);
+    dm->target = dm->delay;
+    dm->candidate = dm->delay;
+    dm->block = block;
+    dm->work = calloc((dm->max_delay + block) * 2, sizeof(int16_t));
+    return dm->work ? 0 : -1;
+}
+
+void sr_downmix_deinit(sr_downmix_t *dm)
+{
+    free(dm->work);
+    memset(dm, 0, sizeof(sr_downmix_t));
+}
+
+void sr_downmix_reset(sr_downmix_t *dm)
+{
+    memset(dm->work, 0, dm->max_delay * 2 * sizeof(int16_t));
+}
+
+/* Lag of the largest cross-correlation of the block, on every other frame */
+static void _sr_downmix_track(sr_downmix_t *dm, int frames)
+{
+    const int16_t *cur = dm->work + dm->max_delay * 2;
+    int64_t energy_l = 0, energy_r = 0;
+    for (int n = 0; n < frames; n += 2) {
+        energy_l += cur[2 * n] * cur[2 * n];
+        energy_r += cur[2 * n + 1] * cur[2 * n + 1];
+    }
+    int64_t floor = (int64_t)SR_DOWNMIX_SPEECH_FLOOR * SR_DOWNMIX_SPEECH_FLOOR * ((frames + 1) / 2);
+    if (energy_l < floor || energy_r < floor) {
+        return;
+    }
+    int64_t best = 0;
+    int best_delay = dm->target;
+    for (int k = -dm->max_delay; k <= dm->max_delay; k++) {
+        const int16_t *l = cur - 2 * (k > 0 ? k : 0);
+        const int16_t *r = cur - 2 * (k < 0 ? -k : 0) + 1;
+        int64_t corr = 0;
+        for (int n = 0; n < frames; n += 2) {
+            corr += l[2 * n] * r[2 * n];
+        }
+        if (corr > best) {
+            best = corr;
+            best_delay = k;
+        }
+    }
+    /* Only coherent blocks, mostly the talker and not the noise of each microphone */
+    float coherence = (float)best * best / ((float)energy_l * energy_r);
+    if (coherence * 100 * 100 <= SR_DOWNMIX_COHERENCE_PCT * SR_DOWNMIX_COHERENCE_PCT) {
+        return;
+    }
+    if (best_delay == dm->candidate) {
+        dm->target = best_delay;
+    }
+    dm->candidate = best_delay;
+}
+
+int sr_downmix_process(sr_downmix_t *dm, const int16_t *in, int frames, int16_t *out)
+{
+    if (frames > dm->block) {
+        frames = dm->block;
+    }
+    int16_t *work = dm->work;
+    memcpy(work + dm->max_delay * 2, in, frames * 2 * sizeof(int16_t));
+    if (dm->mode == SR_DOWNMIX_ADAPTIVE) {
+        _sr_downmix_track(dm, frames);
+        /* A sample per block, a jump would click */
+        dm->delay += dm->target > dm->delay ? 1 : dm->target < dm->delay ? -1 : 0;
+    }
+    const int16_t *l = work + 2 * (dm->max_delay - (dm->delay > 0 ? dm->delay : 0));
+    const int16_t *r = work + 2 * (dm->max_delay - (dm->delay < 0 ? -dm->delay : 0)) + 1;
+    for (int n = 0; n < frames; n++) {
+        out[n] = (int16_t)((l[2 * n] + r[2 * n] + 1) >> 1);
+    }
+    memmove(work, work + frames * 2, dm->max_delay * 2 * sizeof(int16_t));
+    return frames;
+}
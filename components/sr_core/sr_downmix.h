@@ -0,0 +1,118 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _SR_DOWNMIX_H_
+#define _SR_DOWNMIX_H_
+
+/*
+ * Fixed-point downmix of two microphones to one channel.
+ *
+ * Delay and sum: the channel the talker reaches first is delayed by the
+ * difference in arrival, then both are averaged. Speech adds up in phase
+ * while the noise of each microphone does not, up to 3 dB better SNR
+ * than either microphone alone. The adaptive mode finds the delay as the
+ * lag of the largest cross-correlation of each block of speech, searched
+ * within what the microphone spacing allows. A lag found in two blocks in
+ * a row becomes the target, the delay moves toward it by one sample per block.
+ *
+ * Nothing in here depends on FreeRTOS or the audio pipeline, so it can be
+ * compiled and measured on a host as well as on target.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SR_DOWNMIX_DEFAULT_SPACING_MM   (60)
+#define SR_DOWNMIX_SPEED_OF_SOUND_MM_S  (343000)
+
+typedef enum {
+    SR_DOWNMIX_AVERAGE = 0,     /*!< Average both channels, for a talker in front */
+    SR_DOWNMIX_DELAY_SUM,       /*!< Delay and sum with the fixed `delay_us` */
+    SR_DOWNMIX_ADAPTIVE,        /*!< Delay and sum, tracking the talker */
+} sr_downmix_mode_t;
+
+typedef struct {
+    sr_downmix_mode_t mode;
+    int delay_us;               /*!< SR_DOWNMIX_DELAY_SUM: how much later the talker reaches the right
+                                     microphone than the left, negative if it reaches the right first */
+    int spacing_mm;             /*!< Distance between the microphones, bounds the delay. SR_DOWNMIX_DEFAULT_SPACING_MM if 0 */
+} sr_downmix_cfg_t;
+
+typedef struct {
+    sr_downmix_mode_t mode;
+    int     delay;              /*!< Samples the right channel lags the left, the one in use */
+    int     target;             /*!< Adaptive mode, where `delay` is moving to */
+    int     candidate;          /*!< Adaptive mode, lag of the last coherent block, the target once seen twice in a row */
+    int     max_delay;
+    int     block;              /*!< Most frames per sr_downmix_process */
+    int16_t *work;              /*!< The last `max_delay` stereo frames, then room for `block` more */
+} sr_downmix_t;
+
+/**
+ * @brief      Allocate the buffers
+ *
+ * @param[in]  dm           The downmix
+ * @param[in]  config       The downmix configuration
+ * @param[in]  sample_rate  Sample rate in Hz
+ * @param[in]  block        Most frames per sr_downmix_process
+ *
+ * @return     0 on success, -1 if out of memory
+ */
+int sr_downmix_init(sr_downmix_t *dm, const sr_downmix_cfg_t *config, int sample_rate, int block);
+
+/**
+ * @brief      Free the buffers
+ */
+void sr_downmix_deinit(sr_downmix_t *dm);
+
+/**
+ * @brief      Forget the input so far, the adaptive delay is kept
+ */
+void sr_downmix_reset(sr_downmix_t *dm);
+
+/**
+ * @brief      Bytes allocated by sr_downmix_init with these parameters
+ */
+int sr_downmix_memory(const sr_downmix_cfg_t *config, int sample_rate, int block);
+
+/**
+ * @brief      Downmix one block
+ *
+ * @param[in]  dm       The downmix
+ * @param[in]  in       Interleaved left and right samples
+ * @param[in]  frames   Number of stereo frames, at most `block`
+ * @param[out] out      Room for `frames` mono samples, may not overlap `in`
+ *
+ * @return     Number of mono samples
+ */
+int sr_downmix_process(sr_downmix_t *dm, const int16_t *in, int frames, int16_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,143 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+#include "esp_log.h"
+#include "audio_error.h"
+#include "sr_downmix_stream.h"
+
+static const char *TAG = "SR_DOWNMIX_STREAM";
+
+#define SR_DOWNMIX_STREAM_TASK_STACK    (3*1024)
+#define SR_DOWNMIX_STREAM_BUFFER_LEN    (2048)
+#define SR_DOWNMIX_FRAME_BYTES          (4)
+
+typedef struct sr_downmix_stream {
+    sr_downmix_t    dm;
+    char            *in;            /* A partial frame left from the last read, then the new input */
+    int16_t         *out;
+    int             carry_len;
+} sr_downmix_stream_t;
+
+static esp_err_t _sr_downmix_open(audio_element_handle_t self)
+{
+    sr_downmix_stream_t *stream = (sr_downmix_stream_t *)audio_element_getdata(self);
+    sr_downmix_reset(&stream->dm);
+    stream->carry_len = 0;
+    return ESP_OK;
+}
+
+static int _sr_downmix_process(audio_element_handle_t self, char *in_buffer, int in_len)
+{
+    sr_downmix_stream_t *stream = (sr_downmix_stream_t *)audio_element_getdata(self);
+    int r_size = audio_element_input(self, stream->in + stream->carry_len, in_len);
+    if (r_size <= 0) {
+        return r_size;
+    }
+    int len = stream->carry_len + r_size;
+    int frames = len / SR_DOWNMIX_FRAME_BYTES;
+    sr_downmix_process(&stream->dm, (const int16_t *)stream->in, frames, stream->out);
+    stream->carry_len = len % SR_DOWNMIX_FRAME_BYTES;
+    memmove(stream->in, stream->in + len - stream->carry_len, stream->carry_len);
+    if (frames == 0) {
+        return r_size;
+    }
+    int w_size = audio_element_output(self, (char *)stream->out, frames * sizeof(int16_t));
+    return w_size > 0 ? r_size : w_size;
+}
+
+static esp_err_t _sr_downmix_close(audio_element_handle_t self)
+{
+    return ESP_OK;
+}
+
+static esp_err_t _sr_downmix_destroy(audio_element_handle_t self)
+{
+    sr_downmix_stream_t *stream = (sr_downmix_stream_t *)audio_element_getdata(self);
+    sr_downmix_deinit(&stream->dm);
+    free(stream->in);
+    free(stream->out);
+    free(stream);
+    return ESP_OK;
+}
+
+static int _sr_downmix_buffer_len(const sr_downmix_stream_cfg_t *config)
+{
+    return config->buffer_len > 0 ? config->buffer_len : SR_DOWNMIX_STREAM_BUFFER_LEN;
+}
+
+int sr_downmix_stream_memory(const sr_downmix_stream_cfg_t *config)
+{
+    int buffer_len = _sr_downmix_buffer_len(config);
+    int block = buffer_len / SR_DOWNMIX_FRAME_BYTES + 1;
+    /* The element's own read buffer, the input with its carry and the output */
+    return buffer_len + block * (SR_DOWNMIX_FRAME_BYTES + sizeof(int16_t))
+           + sr_downmix_memory(&config->downmix, config->sample_rate, block);
+}
+
+audio_element_handle_t sr_downmix_stream_init(sr_downmix_stream_cfg_t *config)
+{
+    int buffer_len = _sr_downmix_buffer_len(config);
+    int block = buffer_len / SR_DOWNMIX_FRAME_BYTES + 1;
+    sr_downmix_stream_t *stream = calloc(1, sizeof(sr_downmix_stream_t));
+    AUDIO_MEM_CHECK(TAG, stream, return NULL);
+    AUDIO_MEM_CHECK(TAG, sr_downmix_init(&stream->dm, &config->downmix, config->sample_rate, block) == 0,
+                    goto exit_downmix_init);
+    stream->in = malloc(block * SR_DOWNMIX_FRAME_BYTES);
+    AUDIO_MEM_CHECK(TAG, stream->in, goto exit_downmix_init);
+    stream->out = malloc(block * sizeof(int16_t));
+    AUDIO_MEM_CHECK(TAG, stream->out, goto exit_downmix_init);
+
+    audio_element_cfg_t cfg = DEFAULT_AUDIO_ELEMENT_CONFIG();
+    cfg.open = _sr_downmix_open;
+    cfg.process = _sr_downmix_process;
+    cfg.close = _sr_downmix_close;
+    cfg.destroy = _sr_downmix_destroy;
+    cfg.task_stack = config->task_stack > 0 ? config->task_stack : SR_DOWNMIX_STREAM_TASK_STACK;
+    cfg.task_core = config->task_core;
+    cfg.task_prio = config->task_prio;
+    cfg.tag = "sr_downmix";
+    cfg.buffer_len = buffer_len;
+    if (config->out_rb_size > 0) {
+        cfg.out_rb_size = config->out_rb_size;
+    }
+    audio_element_handle_t el = audio_element_init(&cfg);
+    AUDIO_MEM_CHECK(TAG, el, goto exit_downmix_init);
+    audio_element_setdata(el, stream);
+    ESP_LOGI(TAG, "Downmix mode %d, delay %d of at most %d samples", stream->dm.mode, stream->dm.delay,
+             stream->dm.max_delay);
+    return el;
+exit_downmix_init:
+    sr_downmix_deinit(&stream->dm);
+    free(stream->in);
+    free(stream->out);
+    free(stream);
+    return NULL;
+}
+
+int sr_downmix_stream_get_delay(audio_element_handle_t el)
+{
+    sr_downmix_stream_t *stream = (sr_downmix_stream_t *)audio_element_getdata(el);
+    return stream->dm.delay;
+}
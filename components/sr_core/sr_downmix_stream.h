@@ -0,0 +1,77 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _SR_DOWNMIX_STREAM_H_
+#define _SR_DOWNMIX_STREAM_H_
+
+/*
+ * Filter element turning the stereo I2S capture of two microphones into
+ * mono with sr_downmix, ahead of the resampler and the upload.
+ */
+
+#include "audio_element.h"
+#include "sr_downmix.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    sr_downmix_cfg_t downmix;
+    int sample_rate;        /*!< Sample rate in Hz */
+    int task_stack;         /*!< Element default if 0 */
+    int task_core;
+    int task_prio;
+    int buffer_len;         /*!< Stereo input read per process call, element default if 0 */
+    int out_rb_size;        /*!< Output ring, element default if 0 */
+} sr_downmix_stream_cfg_t;
+
+/**
+ * @brief      Create the downmix element
+ *
+ * @param      config  The element configuration
+ *
+ * @return     The audio element handle
+ */
+audio_element_handle_t sr_downmix_stream_init(sr_downmix_stream_cfg_t *config);
+
+/**
+ * @brief      Bytes the element allocates besides its task stack and output ring
+ *
+ * @param[in]  config  The element configuration
+ */
+int sr_downmix_stream_memory(const sr_downmix_stream_cfg_t *config);
+
+/**
+ * @brief      Delay in use, in samples the right microphone lags the left
+ *
+ * @param[in]  el   The element
+ */
+int sr_downmix_stream_get_delay(audio_element_handle_t el);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
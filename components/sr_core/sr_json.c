@@ -0,0 +1,362 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "sr_json.h"
+
+enum {
+    SR_JSON_S_VALUE = 0,        /* A value is expected */
+    SR_JSON_S_VALUE_OR_END,     /* After '[' */
+    SR_JSON_S_KEY_OR_END,       /* After '{' */
+    SR_JSON_S_KEY,              /* After ',' in an object */
+    SR_JSON_S_COLON,
+    SR_JSON_S_AFTER,            /* After a value, ',' or the end of the container */
+    SR_JSON_S_STRING,
+    SR_JSON_S_ESCAPE,
+    SR_JSON_S_UNICODE,
+    SR_JSON_S_SCALAR,
+    SR_JSON_S_DONE,
+    SR_JSON_S_ERROR,
+};
+
+static inline bool _json_is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static void _json_flush(sr_json_t *json, sr_json_type_t type, bool done)
+{
+    json->buf[json->buf_len] = 0;
+    if (json->on_value) {
+        json->on_value(json, type, json->buf, json->buf_len, done, json->user_data);
+    }
+    json->buf_len = 0;
+}
+
+static void _json_string_byte(sr_json_t *json, char c)
+{
+    if (json->in_key) {
+        sr_json_level_t *level = &json->level[json->depth - 1];
+        if (json->key_len < SR_JSON_KEY_MAX - 1) {
+            level->key[json->key_len++] = c;
+            level->key[json->key_len] = 0;
+        }
+        return;
+    }
+    json->buf[json->buf_len++] = c;
+    if (json->buf_len == SR_JSON_CHUNK_MAX) {
+        _json_flush(json, SR_JSON_STRING, false);
+    }
+}
+
+static void _json_string_utf8(sr_json_t *json, uint32_t code)
+{
+    if (code < 0x80) {
+        _json_string_byte(json, code);
+    } else if (code < 0x800) {
+        _json_string_byte(json, 0xc0 | (code >> 6));
+        _json_string_byte(json, 0x80 | (code & 0x3f));
+    } else if (code < 0x10000) {
+        _json_string_byte(json, 0xe0 | (code >> 12));
+        _json_string_byte(json, 0x80 | ((code >> 6) & 0x3f));
+        _json_string_byte(json, 0x80 | (code & 0x3f));
+    } else {
+        _json_string_byte(json, 0xf0 | (code >> 18));
+        _json_string_byte(json, 0x80 | ((code >> 12) & 0x3f));
+        _json_string_byte(json, 0x80 | ((code >> 6) & 0x3f));
+        _json_string_byte(json, 0x80 | (code & 0x3f));
+    }
+}
+
+/* A first half of a surrogate pair not followed by the second one stands for U+FFFD */
+static void _json_string_unpaired(sr_json_t *json)
+{
+    if (json->high_surrogate) {
+        json->high_surrogate = 0;
+        _json_string_utf8(json, 0xfffd);
+    }
+}
+
+static int _json_push(sr_json_t *json, int index)
+{
+    if (json->depth == SR_JSON_DEPTH_MAX) {
+        return SR_JSON_ERROR;
+    }
+    sr_json_level_t *level = &json->level[json->depth++];
+    level->key[0] = 0;
+    level->index = index;
+    return SR_JSON_MORE;
+}
+
+/* A value is complete, the document too if it was the outermost one */
+static void _json_value_end(sr_json_t *json)
+{
+    json->state = json->depth == 0 ? SR_JSON_S_DONE : SR_JSON_S_AFTER;
+}
+
+/* One character, returns false if it has to be looked at again in the new state */
+static bool _json_step(sr_json_t *json, char c)
+{
+    switch (json->state) {
+    case SR_JSON_S_VALUE_OR_END:
+        if (c == ']') {
+            json->depth--;
+            _json_value_end(json);
+            return true;
+        }
+    /* fall through */
+    case SR_JSON_S_VALUE:
+        if (_json_is_space(c)) {
+            return true;
+        }
+        if (c == '{') {
+            json->state = _json_push(json, -1) == SR_JSON_MORE ? SR_JSON_S_KEY_OR_END : SR_JSON_S_ERROR;
+        } else if (c == '[') {
+            json->state = _json_push(json, 0) == SR_JSON_MORE ? SR_JSON_S_VALUE_OR_END : SR_JSON_S_ERROR;
+        } else if (c == '"') {
+            json->in_key = false;
+            json->buf_len = 0;
+            json->high_surrogate = 0;
+            json->state = SR_JSON_S_STRING;
+        } else if (c == '-' || (c >= '0' && c <= '9') || c == 't' || c == 'f' || c == 'n') {
+            json->buf[0] = c;
+            json->buf_len = 1;
+            json->state = SR_JSON_S_SCALAR;
+        } else {
+            json->state = SR_JSON_S_ERROR;
+        }
+        return true;
+    case SR_JSON_S_KEY_OR_END:
+        if (c == '}') {
+            json->depth--;
+            _json_value_end(json);
+            return true;
+        }
+    /* fall through */
+    case SR_JSON_S_KEY:
+        if (_json_is_space(c)) {
+            return true;
+        }
+        if (c == '"') {
+            json->in_key = true;
+            json->key_len = 0;
+            json->level[json->depth - 1].key[0] = 0;
+            json->high_surrogate = 0;
+            json->state = SR_JSON_S_STRING;
+        } else {
+            json->state = SR_JSON_S_ERROR;
+        }
+        return true;
+    case SR_JSON_S_COLON:
+        if (c == ':') {
+            json->state = SR_JSON_S_VALUE;
+        } else if (!_json_is_space(c)) {
+            json->state = SR_JSON_S_ERROR;
+        }
+        return true;
+    case SR_JSON_S_AFTER: {
+        if (_json_is_space(c)) {
+            return true;
+        }
+        sr_json_level_t *level = &json->level[json->depth - 1];
+        if (c == ',') {
+            if (level->index < 0) {
+                json->state = SR_JSON_S_KEY;
+            } else {
+                level->index++;
+                json->state = SR_JSON_S_VALUE;
+            }
+        } else if ((c == '}' && level->index < 0) || (c == ']' && level->index >= 0)) {
+            json->depth--;
+            _json_value_end(json);
+        } else {
+            json->state = SR_JSON_S_ERROR;
+        }
+        return true;
+    }
+    case SR_JSON_S_STRING:
+        if (c != '\\') {
+            _json_string_unpaired(json);
+        }
+        if (c == '"') {
+            if (json->in_key) {
+                json->state = SR_JSON_S_COLON;
+            } else {
+                _json_flush(json, SR_JSON_STRING, true);
+                _json_value_end(json);
+            }
+        } else if (c == '\\') {
+            json->state = SR_JSON_S_ESCAPE;
+        } else {
+            _json_string_byte(json, c);
+        }
+        return true;
+    case SR_JSON_S_ESCAPE:
+        json->state = SR_JSON_S_STRING;
+        if (c != 'u') {
+            _json_string_unpaired(json);
+        }
+        switch (c) {
+        case 'b': _json_string_byte(json, '\b'); break;
+        case 'f': _json_string_byte(json, '\f'); break;
+        case 'n': _json_string_byte(json, '\n'); break;
+        case 'r': _json_string_byte(json, '\r'); break;
+        case 't': _json_string_byte(json, '\t'); break;
+        case 'u':
+            json->code = 0;
+            json->hex_left = 4;
+            json->state = SR_JSON_S_UNICODE;
+            break;
+        default:
+            /* '"', '\\' and '/' stand for themselves */
+            _json_string_byte(json, c);
+            break;
+        }
+        return true;
+    case SR_JSON_S_UNICODE:
+        if (c >= '0' && c <= '9') {
+            json->code = (json->code << 4) | (c - '0');
+        } else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f') {
+            json->code = (json->code << 4) | ((c | 0x20) - 'a' + 10);
+        } else {
+            json->state = SR_JSON_S_ERROR;
+            return true;
+        }
+        if (--json->hex_left > 0) {
+            return true;
+        }
+        json->state = SR_JSON_S_STRING;
+        if (json->code >= 0xdc00 && json->code < 0xe000 && json->high_surrogate) {
+            json->code = 0x10000 + ((json->high_surrogate - 0xd800) << 10) + (json->code - 0xdc00);
+            json->high_surrogate = 0;
+        } else if (json->code >= 0xd800 && json->code < 0xe000) {
+            _json_string_unpaired(json);
+            if (json->code < 0xdc00) {
+                /* First half of a surrogate pair, the second one follows as another \uXXXX */
+                json->high_surrogate = json->code;
+                return true;
+            }
+            json->code = 0xfffd;
+        } else {
+            _json_string_unpaired(json);
+        }
+        _json_string_utf8(json, json->code);
+        return true;
+    case SR_JSON_S_SCALAR:
+        if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+                || c == '-' || c == '+' || c == '.') {
+            if (json->buf_len == SR_JSON_CHUNK_MAX) {
+                json->state = SR_JSON_S_ERROR;
+            } else {
+                json->buf[json->buf_len++] = c;
+            }
+            return true;
+        }
+        _json_flush(json, (json->buf[0] == '-' || (json->buf[0] >= '0' && json->buf[0] <= '9'))
+                    ? SR_JSON_NUMBER : SR_JSON_LITERAL, true);
+        _json_value_end(json);
+        return false;
+    default:
+        return true;
+    }
+}
+
+void sr_json_init(sr_json_t *json, sr_json_value_cb_t on_value, void *user_data)
+{
+    json->on_value = on_value;
+    json->user_data = user_data;
+    sr_json_reset(json);
+}
+
+void sr_json_reset(sr_json_t *json)
+{
+    json->state = SR_JSON_S_VALUE;
+    json->depth = 0;
+    json->in_key = false;
+    json->buf_len = 0;
+    json->high_surrogate = 0;
+}
+
+int sr_json_feed(sr_json_t *json, const char *data, int len)
+{
+    for (int i = 0; i < len && json->state < SR_JSON_S_DONE; i++) {
+        if (!_json_step(json, data[i])) {
+            i--;
+        }
+    }
+    if (json->state == SR_JSON_S_DONE) {
+        return SR_JSON_DONE;
+    }
+    return json->state == SR_JSON_S_ERROR ? SR_JSON_ERROR : SR_JSON_MORE;
+}
+
+bool sr_json_path_is(const sr_json_t *json, const char *path)
+{
+    for (int i = 0; i < json->depth; i++) {
+        const sr_json_level_t *level = &json->level[i];
+        if (level->index < 0) {
+            if (i > 0 && *path++ != '.') {
+                return false;
+            }
+            int len = strlen(level->key);
+            if (strncmp(path, level->key, len) != 0) {
+                return false;
+            }
+            path += len;
+        } else {
+            if (*path++ != '[') {
+                return false;
+            }
+            if (*path == ']') {
+                path++;
+                continue;
+            }
+            char *end;
+            long index = strtol(path, &end, 10);
+            if (end == path || *end != ']' || index != level->index) {
+                return false;
+            }
+            path = end + 1;
+        }
+    }
+    return *path == 0;
+}
+
+int sr_json_append(char *out, int size, int *out_len, const char *data, int len)
+{
+    if (*out_len + len > size - 1) {
+        len = size - 1 - *out_len;
+        /* Do not leave half a UTF-8 character behind */
+        while (len > 0 && (data[len] & 0xc0) == 0x80) {
+            len--;
+        }
+    }
+    if (len > 0) {
+        memcpy(out + *out_len, data, len);
+        *out_len += len;
+    }
+    out[*out_len] = 0;
+    return len;
+}
@@ -0,0 +1,148 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _SR_JSON_H_
+#define _SR_JSON_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SR_JSON_DEPTH_MAX   (10)    /*!< Nested objects and arrays */
+#define SR_JSON_KEY_MAX     (16)    /*!< Longer keys are truncated */
+#define SR_JSON_CHUNK_MAX   (32)    /*!< Strings are handed over in pieces of at most this, numbers must fit */
+
+#define SR_JSON_MORE        (0)
+#define SR_JSON_DONE        (1)
+#define SR_JSON_ERROR       (-1)
+
+typedef enum {
+    SR_JSON_STRING = 0,     /*!< Unescaped string value, UTF-8, unpaired surrogates become U+FFFD */
+    SR_JSON_NUMBER,         /*!< Number as written */
+    SR_JSON_LITERAL,        /*!< true, false or null */
+} sr_json_type_t;
+
+typedef struct sr_json sr_json_t;
+
+/**
+ * Called for every scalar value. A string may come in several calls, the
+ * last one with `done` set; numbers and literals always come in one.
+ * `data` is NUL terminated. sr_json_path_is() tells where the value is.
+ */
+typedef void (*sr_json_value_cb_t)(sr_json_t *json, sr_json_type_t type, const char *data, int len, bool done, void *user_data);
+
+typedef struct {
+    char    key[SR_JSON_KEY_MAX];   /* Current member of an object */
+    int     index;                  /* Current element of an array, -1 for an object */
+} sr_json_level_t;
+
+/**
+ * Incremental JSON tokenizer
+ *
+ * The document may be fed in any number of pieces, split anywhere, e.g. as
+ * it is read from the socket. Nothing is allocated: values are passed to the
+ * callback straight out of a small staging buffer and the caller copies what
+ * it wants to keep.
+ */
+struct sr_json {
+    sr_json_value_cb_t  on_value;
+    void                *user_data;
+    int                 state;
+    int                 depth;
+    sr_json_level_t     level[SR_JSON_DEPTH_MAX];
+    bool                in_key;
+    int                 key_len;
+    char                buf[SR_JSON_CHUNK_MAX + 1];
+    int                 buf_len;
+    uint32_t            code;           /* \uXXXX being read */
+    int                 hex_left;
+    uint32_t            high_surrogate;
+};
+
+/**
+ * @brief      Set the callback and prepare for a document
+ *
+ * @param[in]  json       The tokenizer
+ * @param[in]  on_value   Value callback
+ * @param[in]  user_data  Passed to the callback
+ */
+void sr_json_init(sr_json_t *json, sr_json_value_cb_t on_value, void *user_data);
+
+/**
+ * @brief      Drop any partial document and prepare for the next one
+ *
+ * @param[in]  json   The tokenizer
+ */
+void sr_json_reset(sr_json_t *json);
+
+/**
+ * @brief      Consume the next piece of the document
+ *
+ * Input after the end of the document is ignored.
+ *
+ * @param[in]  json   The tokenizer
+ * @param[in]  data   Document bytes
+ * @param[in]  len    Number of bytes
+ *
+ * @return
+ *     - SR_JSON_MORE   The document is not complete yet
+ *     - SR_JSON_DONE   The document is complete
+ *     - SR_JSON_ERROR  Malformed, or nested deeper than SR_JSON_DEPTH_MAX
+ */
+int sr_json_feed(sr_json_t *json, const char *data, int len);
+
+/**
+ * @brief      Check where the value passed to the callback is
+ *
+ * Members are joined by `.` and array elements are written `[N]`, or `[]`
+ * for any element, e.g. "data.result.ws[].cw[0].w".
+ *
+ * @param[in]  json   The tokenizer
+ * @param[in]  path   The path to compare with
+ *
+ * @return     true if the current value is at `path`
+ */
+bool sr_json_path_is(const sr_json_t *json, const char *path);
+
+/**
+ * @brief      Append a piece of a string value to a fixed buffer, truncating if it is full
+ *
+ * @param[out] out      Output buffer, kept NUL terminated
+ * @param[in]  size     Size of the output buffer
+ * @param      out_len  Length in `out`, updated
+ * @param[in]  data     Piece to append
+ * @param[in]  len      Length of the piece
+ *
+ * @return     Number of bytes appended
+ */
+int sr_json_append(char *out, int size, int *out_len, const char *data, int len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
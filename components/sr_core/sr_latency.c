@@ -0,0 +1,157 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "esp_timer.h"
+#include "sr_latency.h"
+
+static const struct {
+    sr_latency_mark_t from;
+    sr_latency_mark_t to;
+    const char        *name;
+} sr_latency_stages[SR_LATENCY_STAGES] = {
+    [SR_LATENCY_STAGE_START]   = { SR_LATENCY_PRESS,     SR_LATENCY_RUN,         "start" },
+    [SR_LATENCY_STAGE_CONNECT] = { SR_LATENCY_RUN,       SR_LATENCY_CONNECTED,   "connect" },
+    [SR_LATENCY_STAGE_CAPTURE] = { SR_LATENCY_RUN,       SR_LATENCY_FIRST_SENT,  "capture" },
+    [SR_LATENCY_STAGE_DRAIN]   = { SR_LATENCY_RELEASE,   SR_LATENCY_LAST_SENT,   "drain" },
+    [SR_LATENCY_STAGE_REPLY]   = { SR_LATENCY_LAST_SENT, SR_LATENCY_FIRST_REPLY, "reply" },
+    [SR_LATENCY_STAGE_FINAL]   = { SR_LATENCY_LAST_SENT, SR_LATENCY_RESULT,      "final" },
+    [SR_LATENCY_STAGE_TOTAL]   = { SR_LATENCY_RELEASE,   SR_LATENCY_RESULT,      "total" },
+};
+
+void sr_latency_open(sr_latency_t *latency)
+{
+    memset(latency->at, 0, sizeof(latency->at));
+    latency->open = true;
+}
+
+void sr_latency_close(sr_latency_t *latency)
+{
+    latency->open = false;
+}
+
+void sr_latency_mark(sr_latency_t *latency, sr_latency_mark_t mark)
+{
+    if (latency == NULL || !latency->open || latency->at[mark] != 0) {
+        return;
+    }
+    latency->at[mark] = esp_timer_get_time();
+}
+
+void sr_latency_report(const sr_latency_t *latency, sr_latency_report_t *report)
+{
+    int64_t press = latency->at[SR_LATENCY_PRESS];
+    for (int i = 0; i < SR_LATENCY_MARKS; i++) {
+        report->at_ms[i] = latency->at[i] && press ? (int)((latency->at[i] - press) / 1000) : -1;
+    }
+    for (int i = 0; i < SR_LATENCY_STAGES; i++) {
+        int64_t from = latency->at[sr_latency_stages[i].from];
+        int64_t to = latency->at[sr_latency_stages[i].to];
+        report->stage_ms[i] = -1;
+        if (from && to) {
+            /* Steps may overlap, partial results for instance come before the last audio */
+            report->stage_ms[i] = to > from ? (int)((to - from) / 1000) : 0;
+        }
+    }
+}
+
+const char *sr_latency_stage_name(sr_latency_stage_t stage)
+{
+    return sr_latency_stages[stage].name;
+}
+
+/* 0..7 ms get a bin each, above that an octave is split in four */
+static int _sr_latency_bin(int ms)
+{
+    if (ms < 8) {
+        return ms;
+    }
+    int octave = 31 - __builtin_clz(ms);
+    int bin = 8 + (octave - 3) * 4 + ((ms >> (octave - 2)) & 3);
+    return bin < SR_LATENCY_BINS ? bin : SR_LATENCY_BINS - 1;
+}
+
+static int _sr_latency_bin_top(int bin)
+{
+    if (bin < 8) {
+        return bin;
+    }
+    int octave = 3 + (bin - 8) / 4;
+    int step = 1 << (octave - 2);
+    return (4 + (bin - 8) % 4) * step + step - 1;
+}
+
+void sr_latency_hist_add(sr_latency_hist_t *hist, const sr_latency_report_t *report)
+{
+    for (int i = 0; i < SR_LATENCY_STAGES; i++) {
+        int ms = report->stage_ms[i];
+        if (ms < 0) {
+            continue;
+        }
+        hist->bins[i][_sr_latency_bin(ms)]++;
+        hist->count[i]++;
+        if (ms > hist->max_ms[i]) {
+            hist->max_ms[i] = ms;
+        }
+    }
+}
+
+static int _sr_latency_percentile(const sr_latency_hist_t *hist, int stage, int percent)
+{
+    uint32_t rank = ((uint32_t)hist->count[stage] * percent + 99) / 100;
+    uint32_t seen = 0;
+    for (int bin = 0; bin < SR_LATENCY_BINS; bin++) {
+        seen += hist->bins[stage][bin];
+        if (seen >= rank) {
+            int top = _sr_latency_bin_top(bin);
+            return top < hist->max_ms[stage] ? top : hist->max_ms[stage];
+        }
+    }
+    return hist->max_ms[stage];
+}
+
+void sr_latency_hist_stats(const sr_latency_hist_t *hist, sr_latency_stage_t stage, sr_latency_stats_t *stats)
+{
+    memset(stats, 0, sizeof(sr_latency_stats_t));
+    if (hist->count[stage] == 0) {
+        return;
+    }
+    stats->count = hist->count[stage];
+    stats->p50_ms = _sr_latency_percentile(hist, stage, 50);
+    stats->p95_ms = _sr_latency_percentile(hist, stage, 95);
+    stats->p99_ms = _sr_latency_percentile(hist, stage, 99);
+    stats->max_ms = hist->max_ms[stage];
+}
+
+void sr_latency_hist_dump(const sr_latency_hist_t *hist, const char *label)
+{
+    printf("sr_latency,label,stage,count,p50_ms,p95_ms,p99_ms,max_ms\n");
+    for (int i = 0; i < SR_LATENCY_STAGES; i++) {
+        sr_latency_stats_t stats;
+        sr_latency_hist_stats(hist, i, &stats);
+        printf("sr_latency,%s,%s,%d,%d,%d,%d,%d\n", label, sr_latency_stages[i].name, stats.count,
+               stats.p50_ms, stats.p95_ms, stats.p99_ms, stats.max_ms);
+    }
+}
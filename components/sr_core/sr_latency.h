@@ -0,0 +1,167 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _SR_LATENCY_H_
+#define _SR_LATENCY_H_
+
+/*
+ * Where the time of an utterance goes.
+ *
+ * The SR core and the provider mark the steps of an utterance as they
+ * happen, the first mark of a step counts. After the utterance the marks
+ * become a report of stage durations, which is added to a histogram per
+ * stage. The histograms have four bins per octave, so a percentile read
+ * from them is at most 25% high, in constant memory however many
+ * utterances went in.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SR_LATENCY_BINS     (64)    /*!< 0..7 ms exact, then 4 per octave up to 131 s */
+
+/**
+ * Steps of an utterance
+ */
+typedef enum {
+    SR_LATENCY_PRESS = 0,       /*!< sr_core_start */
+    SR_LATENCY_RUN,             /*!< Upload pipeline running, in split mode the capture task handed over the session */
+    SR_LATENCY_CONNECTED,       /*!< The provider's connection is ready for the utterance, marked by the provider */
+    SR_LATENCY_FIRST_SENT,      /*!< First audio taken by the provider */
+    SR_LATENCY_RELEASE,         /*!< sr_core_stop */
+    SR_LATENCY_LAST_SENT,       /*!< All audio handed to the provider */
+    SR_LATENCY_FIRST_REPLY,     /*!< First reply bytes received, marked by the provider */
+    SR_LATENCY_RESULT,          /*!< Final result parsed */
+    SR_LATENCY_MARKS,
+} sr_latency_mark_t;
+
+/**
+ * Durations between two steps
+ */
+typedef enum {
+    SR_LATENCY_STAGE_START = 0, /*!< Press to run: pipeline start */
+    SR_LATENCY_STAGE_CONNECT,   /*!< Run to connected: DNS, TCP and TLS, near 0 on a kept connection */
+    SR_LATENCY_STAGE_CAPTURE,   /*!< Run to first sent: I2S and encoder */
+    SR_LATENCY_STAGE_DRAIN,     /*!< Release to last sent: backlog the uplink had not taken yet */
+    SR_LATENCY_STAGE_REPLY,     /*!< Last sent to first reply: server and round trip, 0 if the service streams partials */
+    SR_LATENCY_STAGE_FINAL,     /*!< Last sent to result: server, round trip and parsing */
+    SR_LATENCY_STAGE_TOTAL,     /*!< Release to result: what the speaker waits for */
+    SR_LATENCY_STAGES,
+} sr_latency_stage_t;
+
+/**
+ * Marks of the current utterance
+ */
+typedef struct {
+    volatile bool   open;                       /*!< Marks are taken between sr_latency_open and sr_latency_close */
+    int64_t         at[SR_LATENCY_MARKS];       /*!< esp_timer time in us, 0 if not reached */
+} sr_latency_t;
+
+/**
+ * One utterance, as sent with SR_CORE_EVENT_LATENCY
+ */
+typedef struct {
+    int at_ms[SR_LATENCY_MARKS];                /*!< Since the press, -1 if not reached */
+    int stage_ms[SR_LATENCY_STAGES];            /*!< -1 if a step is missing */
+} sr_latency_report_t;
+
+/**
+ * Percentiles of one stage
+ */
+typedef struct {
+    int count;                                  /*!< Utterances with this stage */
+    int p50_ms;
+    int p95_ms;
+    int p99_ms;
+    int max_ms;
+} sr_latency_stats_t;
+
+typedef struct {
+    uint32_t    bins[SR_LATENCY_STAGES][SR_LATENCY_BINS];
+    int         count[SR_LATENCY_STAGES];
+    int         max_ms[SR_LATENCY_STAGES];
+} sr_latency_hist_t;
+
+/**
+ * @brief      Forget the marks and take new ones
+ */
+void sr_latency_open(sr_latency_t *latency);
+
+/**
+ * @brief      Ignore marks from now on, a replay of the spool must not count for the last utterance
+ */
+void sr_latency_close(sr_latency_t *latency);
+
+/**
+ * @brief      Mark a step now, unless it was marked already. Safe to call from any task
+ *
+ * @param[in]  latency  The marks, NULL is ignored
+ * @param[in]  mark     The step
+ */
+void sr_latency_mark(sr_latency_t *latency, sr_latency_mark_t mark);
+
+/**
+ * @brief      Turn the marks into stage durations
+ *
+ * @param[in]  latency  The marks
+ * @param[out] report   The report
+ */
+void sr_latency_report(const sr_latency_t *latency, sr_latency_report_t *report);
+
+/**
+ * @brief      Name of a stage, as printed by sr_latency_hist_dump
+ */
+const char *sr_latency_stage_name(sr_latency_stage_t stage);
+
+/**
+ * @brief      Add the stages of a report to the histograms
+ */
+void sr_latency_hist_add(sr_latency_hist_t *hist, const sr_latency_report_t *report);
+
+/**
+ * @brief      Percentiles of a stage, each one the upper edge of its bin
+ *
+ * @param[in]  hist     The histograms
+ * @param[in]  stage    The stage
+ * @param[out] stats    Count, percentiles and maximum, all 0 if there is nothing yet
+ */
+void sr_latency_hist_stats(const sr_latency_hist_t *hist, sr_latency_stage_t stage, sr_latency_stats_t *stats);
+
+/**
+ * @brief      Print the percentiles of every stage to stdout, one CSV line per stage
+ *
+ * @param[in]  hist     The histograms
+ * @param[in]  label    First column of each line, for example the provider name
+ */
+void sr_latency_hist_dump(const sr_latency_hist_t *hist, const char *label);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,92 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "sr_preroll.h"
+
+int sr_preroll_init(sr_preroll_t *preroll, int size)
+{
+    memset(preroll, 0, sizeof(sr_preroll_t));
+    preroll->data = malloc(size);
+    if (preroll->data == NULL) {
+        return -1;
+    }
+    preroll->size = size;
+    return 0;
+}
+
+void sr_preroll_deinit(sr_preroll_t *preroll)
+{
+    free(preroll->data);
+    memset(preroll, 0, sizeof(sr_preroll_t));
+}
+
+void sr_preroll_reset(sr_preroll_t *preroll)
+{
+    preroll->head = 0;
+    preroll->len = 0;
+}
+
+void sr_preroll_write(sr_preroll_t *preroll, const uint8_t *data, int len)
+{
+    if (preroll->size == 0) {
+        return;
+    }
+    /* Only the tail of a write bigger than the buffer survives */
+    if (len > preroll->size) {
+        data += len - preroll->size;
+        len = preroll->size;
+    }
+    int tail_room = preroll->size - preroll->head;
+    int n = len < tail_room ? len : tail_room;
+    memcpy(preroll->data + preroll->head, data, n);
+    memcpy(preroll->data, data + n, len - n);
+    preroll->head = (preroll->head + len) % preroll->size;
+    preroll->len += len;
+    if (preroll->len > preroll->size) {
+        preroll->len = preroll->size;
+    }
+}
+
+int sr_preroll_peek(const sr_preroll_t *preroll, int len, const uint8_t **first, int *first_len,
+                    const uint8_t **second, int *second_len)
+{
+    if (len > preroll->len) {
+        len = preroll->len;
+    }
+    int start = preroll->head - len;
+    if (start >= 0) {
+        *first = preroll->data + start;
+        *first_len = len;
+        *second = NULL;
+        *second_len = 0;
+    } else {
+        *first = preroll->data + preroll->size + start;
+        *first_len = -start;
+        *second = preroll->data;
+        *second_len = preroll->head;
+    }
+    return len;
+}
@@ -0,0 +1,101 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _SR_PREROLL_H_
+#define _SR_PREROLL_H_
+
+/*
+ * Circular buffer holding the last few hundred milliseconds of audio, so
+ * that speech starting together with the button press is not cut off.
+ *
+ * Nothing in here depends on FreeRTOS or the audio pipeline.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint8_t *data;
+    int     size;
+    int     head;       /*!< Next write position */
+    int     len;        /*!< Valid bytes, at most `size` */
+} sr_preroll_t;
+
+/**
+ * @brief      Bytes needed to hold `ms` of 16-bit audio, rounded to whole samples
+ */
+#define SR_PREROLL_SIZE(ms, sample_rate, channels)  ((int)((int64_t)(ms) * (sample_rate) / 1000) * 2 * (channels))
+
+/**
+ * @brief      Allocate the buffer
+ *
+ * @param[in]  preroll   The buffer
+ * @param[in]  size      Capacity in bytes, a multiple of the frame size
+ *
+ * @return     0 on success, -1 if out of memory
+ */
+int sr_preroll_init(sr_preroll_t *preroll, int size);
+
+/**
+ * @brief      Free the buffer
+ */
+void sr_preroll_deinit(sr_preroll_t *preroll);
+
+/**
+ * @brief      Drop everything held
+ */
+void sr_preroll_reset(sr_preroll_t *preroll);
+
+/**
+ * @brief      Append audio, overwriting the oldest bytes once full
+ *
+ * @param[in]  preroll   The buffer
+ * @param[in]  data      Audio data
+ * @param[in]  len       Data length
+ */
+void sr_preroll_write(sr_preroll_t *preroll, const uint8_t *data, int len);
+
+/**
+ * @brief      Get the newest `len` bytes in place, as at most two spans in time order
+ *
+ * @param[in]  preroll     The buffer
+ * @param[in]  len         Wanted length, clamped to what is held
+ * @param[out] first       Oldest span
+ * @param[out] first_len   Its length
+ * @param[out] second      Continuation after the wrap, NULL if none
+ * @param[out] second_len  Its length
+ *
+ * @return     Total length of the two spans
+ */
+int sr_preroll_peek(const sr_preroll_t *preroll, int len, const uint8_t **first, int *first_len,
+                    const uint8_t **second, int *second_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
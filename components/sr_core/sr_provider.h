@@ -0,0 +1,171 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _SR_PROVIDER_H_
+#define _SR_PROVIDER_H_
+
+/*
+ * Recognizer provider interface.
+ *
+ * The SR core records the audio, runs the pipelines and owns the result
+ * buffer. A provider only speaks the wire protocol of one service: it opens
+ * an utterance, takes the audio as it is recorded, ends the utterance and
+ * writes what it parsed out of the replies into the result. All calls except
+ * create, destroy, connect, cancel and set_credential come from the task
+ * running the utterance: the upload task, or a sender of sr_provider_hedge.
+ */
+
+#include <stdbool.h>
+#include "esp_err.h"
+#include "sr_latency.h"
+#include "sr_task_stats.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Audio handed to the provider
+ */
+typedef enum {
+    SR_AUDIO_PCM = 0,       /*!< PCM 16-bit mono */
+    SR_AUDIO_AMR_WB,        /*!< AMR-WB with its file header */
+} sr_audio_format_t;
+
+typedef void (*sr_result_handle_t)(const char *text, bool is_final, void *user_data);
+
+/**
+ * Recognized text of the current utterance, owned by the SR core
+ */
+typedef struct {
+    char                *text;          /*!< Always NUL terminated */
+    int                 size;           /*!< Capacity of `text`, NUL included */
+    int                 len;
+    bool                valid;          /*!< Set by sr_result_publish, cleared by sr_result_reset */
+    sr_result_handle_t  on_update;      /*!< Called by sr_result_publish, may be NULL */
+    void                *user_data;
+} sr_result_t;
+
+/**
+ * What the SR core tells a provider about the audio and where the text goes
+ */
+typedef struct {
+    int                 sample_rate;
+    sr_audio_format_t   format;
+    int                 frame_max;      /*!< Largest block passed to `frame` */
+    sr_result_t         *result;
+    sr_latency_t        *latency;       /*!< The provider marks SR_LATENCY_CONNECTED and SR_LATENCY_FIRST_REPLY */
+    const sr_task_place_t *task;        /*!< Where tasks the provider starts run, needed by the hedge */
+} sr_provider_env_t;
+
+typedef struct {
+    const char *name;
+
+    /**
+     * Allocate the provider context, `config` is the provider's own configuration type. NULL on failure
+     */
+    void *(*create)(const void *config, const sr_provider_env_t *env);
+    void (*destroy)(void *ctx);
+
+    /**
+     * Bytes allocated by the provider, for the SR core's memory plan
+     */
+    int (*memory)(void *ctx);
+
+    /**
+     * Optional, get the connection ready before the next utterance. Not called during one
+     */
+    esp_err_t (*connect)(void *ctx);
+
+    /**
+     * An utterance starts, the result has been reset
+     */
+    esp_err_t (*begin)(void *ctx);
+
+    /**
+     * Send or queue `len` bytes of audio. Returns `len`, <= 0 drops the rest of the utterance
+     */
+    int (*frame)(void *ctx, const char *audio, int len);
+
+    /**
+     * All audio of the utterance has been passed to `frame`: finish it and wait for the final result.
+     * ESP_OK once the service answered, with or without text. An error means the request broke off,
+     * the SR core may then `begin` again and resend the utterance. Also called after `frame` failed
+     */
+    esp_err_t (*end)(void *ctx);
+
+    /**
+     * Feed reply bytes to the provider's parser, `first` starts a new reply.
+     * Returns SR_JSON_MORE until the reply is complete, then SR_JSON_DONE or SR_JSON_ERROR
+     */
+    int (*parse)(void *ctx, const char *data, int len, bool first);
+
+    /**
+     * Optional, abort the utterance from another task: `frame` fails from now on and a pending `end` returns soon
+     */
+    void (*cancel)(void *ctx);
+
+    /**
+     * Optional, replace the credential, taken at the next `begin`. Safe to call from any task
+     */
+    esp_err_t (*set_credential)(void *ctx, const char *credential);
+
+    /**
+     * Optional, log the counters and high-water marks of the last utterances, then reset them
+     */
+    void (*report)(void *ctx);
+
+    /**
+     * Optional, bytes the last utterance put on the wire: HTTP body or websocket payload, without the
+     * transport's own headers
+     */
+    int (*wire_bytes)(void *ctx);
+} sr_provider_t;
+
+extern const sr_provider_t sr_provider_baidu;
+extern const sr_provider_t sr_provider_xunfei;
+extern const sr_provider_t sr_provider_mock;
+extern const sr_provider_t sr_provider_hedge;
+extern const sr_provider_t sr_provider_netem;
+
+/**
+ * @brief      Empty the result before an utterance
+ *
+ * @param[in]  result  The result
+ */
+void sr_result_reset(sr_result_t *result);
+
+/**
+ * @brief      Mark the text as recognized and hand it to `on_update`
+ *
+ * @param[in]  result    The result
+ * @param[in]  is_final  No more updates follow for this utterance
+ */
+void sr_result_publish(sr_result_t *result, bool is_final);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
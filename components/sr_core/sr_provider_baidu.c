@@ -0,0 +1,619 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_http_client.h"
+#include "audio_error.h"
+#include "sr_provider_baidu.h"
+#include "baidu_sr_proto.h"
+#include "sr_base64.h"
+#include "sr_json.h"
+#include "sr_clock.h"
+
+static const char *TAG = "SR_BAIDU";
+
+#define BAIDU_SR_HTTP_BUFFER_SIZE   (2048)
+#define BAIDU_SR_HTTP_TIMEOUT_MS    (5000)
+#define BAIDU_SR_ERR_MSG_MAX        (64)
+
+typedef struct {
+    int requests;           /* Requests opened */
+    int reused;             /* Requests sent over a kept connection, each one a DNS lookup and a handshake saved */
+    int reconnects;         /* Kept connections found closed by the server */
+} baidu_sr_stats_t;
+
+typedef struct {
+    esp_http_client_handle_t http;
+    sr_result_t             *result;
+    sr_latency_t            *latency;
+    sr_base64_t             b64;
+    int                     sr_total_write;
+    int                     wire_bytes;         /* Request body sent for the utterance */
+    bool                    is_begin;
+    bool                    is_open;            /* A request is in flight */
+    bool                    failed;             /* The request broke off, `end` only drops the connection */
+    volatile bool           cancelled;          /* Set by `cancel` from another task */
+    bool                    connected;          /* A connection is kept from the last request */
+    int64_t                 last_used;
+    int64_t                 connect_us;         /* Time spent opening requests on new connections */
+    int                     keep_alive_ms;
+    baidu_sr_stats_t        stats;
+    char                    *buffer;            /* Request header, request URI and response */
+    int                     buffer_size;
+    char                    *tx_buffer;
+    int                     tx_size;
+    int                     tx_len;
+    int64_t                 tx_first_time;
+    int                     coalesce_size;
+    int                     coalesce_ms;
+    int                     tx_hwm;
+    int                     rx_hwm;
+    int                     dev_pid;
+    char                    *cuid;
+    char                    *endpoint;
+    const char              *format;
+    int                     sample_rates;
+    char                    *token;
+    char                    *next_token;        /* Set by sr_core_set_credential, taken at the next begin */
+    SemaphoreHandle_t       token_lock;
+    baidu_sr_upload_mode_t  upload_mode;
+    sr_json_t               json;               /* Response tokenizer */
+    int                     err_no;
+    char                    err_msg[BAIDU_SR_ERR_MSG_MAX];
+    int                     err_msg_len;
+    char                    drain[64];
+} baidu_sr_t;
+
+static void _baidu_disconnect(baidu_sr_t *sr)
+{
+    esp_http_client_close(sr->http);
+    sr->connected = false;
+}
+
+/* Create the client on first use, drop a kept connection the server has most likely closed by now */
+static esp_err_t _baidu_prepare(baidu_sr_t *sr, const char *uri)
+{
+    if (sr->http == NULL) {
+        esp_http_client_config_t http_cfg = {
+            .url = uri,
+            .timeout_ms = BAIDU_SR_HTTP_TIMEOUT_MS,
+            .buffer_size = BAIDU_SR_HTTP_BUFFER_SIZE,
+            /* Keeps the clock of a device without SNTP close enough for signing */
+            .event_handler = sr_clock_http_event_handler,
+        };
+        sr->http = esp_http_client_init(&http_cfg);
+        AUDIO_MEM_CHECK(TAG, sr->http, return ESP_FAIL);
+        return ESP_OK;
+    }
+    /* Same host and port keep the connection */
+    if (esp_http_client_set_url(sr->http, uri) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    if (sr->connected && (sr->keep_alive_ms < 0
+                          || esp_timer_get_time() - sr->last_used > sr->keep_alive_ms * 1000LL)) {
+        _baidu_disconnect(sr);
+    }
+    return ESP_OK;
+}
+
+static int _http_flush(baidu_sr_t *sr)
+{
+    int offset = 0;
+    if (sr->tx_len > sr->tx_hwm) {
+        sr->tx_hwm = sr->tx_len;
+    }
+    while (offset < sr->tx_len) {
+        int write_len = esp_http_client_write(sr->http, sr->tx_buffer + offset, sr->tx_len - offset);
+        if (write_len <= 0) {
+            ESP_LOGE(TAG, "Error write chunked content");
+            return ESP_FAIL;
+        }
+        offset += write_len;
+    }
+    sr->wire_bytes += offset;
+    sr->tx_len = 0;
+    return offset;
+}
+
+/*
+ * Queue the size line of a `len` byte chunk and return where its payload goes.
+ * Header, payload and CRLF are assembled back to back in tx_buffer so that a
+ * chunk, or several of them, leave in a single esp_http_client_write.
+ */
+static char *_http_chunk_begin(baidu_sr_t *sr, int len)
+{
+    if (sr->tx_len + len + BAIDU_SR_PROTO_CHUNK_OVERHEAD + BAIDU_SR_PROTO_LAST_CHUNK_LEN > sr->tx_size) {
+        if (_http_flush(sr) < 0) {
+            return NULL;
+        }
+        if (len + BAIDU_SR_PROTO_CHUNK_OVERHEAD + BAIDU_SR_PROTO_LAST_CHUNK_LEN > sr->tx_size) {
+            ESP_LOGE(TAG, "Chunk of %d bytes does not fit the %d bytes TX buffer", len, sr->tx_size);
+            return NULL;
+        }
+    }
+    if (sr->tx_len == 0) {
+        sr->tx_first_time = esp_timer_get_time();
+    }
+    sr->tx_len += baidu_sr_proto_chunk_header(sr->tx_buffer + sr->tx_len, len);
+    return sr->tx_buffer + sr->tx_len;
+}
+
+/* Close the chunk opened by _http_chunk_begin once `len` payload bytes are in place */
+static void _http_chunk_end(baidu_sr_t *sr, int len)
+{
+    sr->tx_len += len;
+    memcpy(sr->tx_buffer + sr->tx_len, BAIDU_SR_PROTO_CHUNK_TRAILER, BAIDU_SR_PROTO_CHUNK_TRAILER_LEN);
+    sr->tx_len += BAIDU_SR_PROTO_CHUNK_TRAILER_LEN;
+}
+
+/* Send everything queued once the coalescing size or deadline is reached */
+static int _http_flush_if_due(baidu_sr_t *sr)
+{
+    if (sr->tx_len >= sr->coalesce_size
+            || esp_timer_get_time() - sr->tx_first_time >= sr->coalesce_ms * 1000LL) {
+        return _http_flush(sr);
+    }
+    return 0;
+}
+
+static int _http_write_chunk(baidu_sr_t *sr, const char *buffer, int len)
+{
+    char *payload = _http_chunk_begin(sr, len);
+    if (payload == NULL) {
+        return ESP_FAIL;
+    }
+    memcpy(payload, buffer, len);
+    _http_chunk_end(sr, len);
+    if (_http_flush_if_due(sr) < 0) {
+        return ESP_FAIL;
+    }
+    return len;
+}
+
+/* Append the `0\r\n\r\n` terminator and send all that is still queued */
+static int _http_write_last_chunk(baidu_sr_t *sr)
+{
+    memcpy(sr->tx_buffer + sr->tx_len, BAIDU_SR_PROTO_LAST_CHUNK, BAIDU_SR_PROTO_LAST_CHUNK_LEN);
+    sr->tx_len += BAIDU_SR_PROTO_LAST_CHUNK_LEN;
+    return _http_flush(sr);
+}
+
+static void _baidu_on_response_value(sr_json_t *json, sr_json_type_t type, const char *data, int len, bool done, void *user_data)
+{
+    baidu_sr_t *sr = (baidu_sr_t *)user_data;
+    if (type == SR_JSON_STRING && sr_json_path_is(json, "result[0]")) {
+        sr_json_append(sr->result->text, sr->result->size, &sr->result->len, data, len);
+    } else if (type == SR_JSON_NUMBER && sr_json_path_is(json, "err_no")) {
+        sr->err_no = atoi(data);
+    } else if (type == SR_JSON_STRING && sr_json_path_is(json, "err_msg")) {
+        sr_json_append(sr->err_msg, sizeof(sr->err_msg), &sr->err_msg_len, data, len);
+    }
+}
+
+static int _baidu_parse(void *ctx, const char *data, int len, bool first)
+{
+    baidu_sr_t *sr = (baidu_sr_t *)ctx;
+    if (first) {
+        sr_json_reset(&sr->json);
+        sr->err_no = -1;
+        sr->err_msg_len = 0;
+        sr->err_msg[0] = 0;
+    }
+    return sr_json_feed(&sr->json, data, len);
+}
+
+/* Method, body layout and URI of the next request, with the token current at this point */
+static const char *_baidu_request_uri(baidu_sr_t *sr)
+{
+    /* Only swap between requests, a request in flight keeps the token it started with */
+    xSemaphoreTake(sr->token_lock, portMAX_DELAY);
+    if (sr->next_token) {
+        free(sr->token);
+        sr->token = sr->next_token;
+        sr->next_token = NULL;
+        ESP_LOGI(TAG, "Switched to the refreshed access token");
+    }
+    xSemaphoreGive(sr->token_lock);
+    if (sr->upload_mode == BAIDU_SR_UPLOAD_RAW) {
+        if (baidu_sr_proto_raw_uri(sr->buffer, sr->buffer_size, sr->endpoint, sr->dev_pid, sr->cuid, sr->token) < 0) {
+            ESP_LOGE(TAG, "SR Buffer too small for request URI");
+            return NULL;
+        }
+        return sr->buffer;
+    }
+    return sr->endpoint;
+}
+
+static esp_err_t _baidu_set_headers(baidu_sr_t *sr)
+{
+    esp_http_client_set_method(sr->http, HTTP_METHOD_POST);
+    esp_http_client_set_post_field(sr->http, NULL, -1); // Chunk content
+    if (sr->upload_mode == BAIDU_SR_UPLOAD_RAW) {
+        char content_type[32];
+        if (baidu_sr_proto_raw_content_type(content_type, sizeof(content_type), sr->format, sr->sample_rates) < 0) {
+            return ESP_FAIL;
+        }
+        esp_http_client_set_header(sr->http, "Content-Type", content_type);
+    } else {
+        esp_http_client_set_header(sr->http, "Content-Type", "application/json");
+    }
+    return ESP_OK;
+}
+
+static esp_err_t _baidu_begin(void *ctx)
+{
+    baidu_sr_t *sr = (baidu_sr_t *)ctx;
+    sr->sr_total_write = 0;
+    sr->wire_bytes = 0;
+    sr->is_begin = true;
+    sr->failed = false;
+    sr->cancelled = false;
+    sr->tx_len = 0;
+    sr_base64_reset(&sr->b64);
+    const char *uri = _baidu_request_uri(sr);
+    if (uri == NULL || _baidu_prepare(sr, uri) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    for (;;) {
+        bool reused = sr->connected;
+        int64_t start = esp_timer_get_time();
+        if (_baidu_set_headers(sr) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        // Chunked body
+        if (esp_http_client_open(sr->http, -1) == ESP_OK) {
+            sr->stats.requests++;
+            if (reused) {
+                sr->stats.reused++;
+            } else {
+                sr->connect_us += esp_timer_get_time() - start;
+            }
+            ESP_LOGI(TAG, "%s connection, %d of %d requests reused one", reused ? "Kept" : "New",
+                     sr->stats.reused, sr->stats.requests);
+            sr->connected = true;
+            sr->is_open = true;
+            sr_latency_mark(sr->latency, SR_LATENCY_CONNECTED);
+            return ESP_OK;
+        }
+        _baidu_disconnect(sr);
+        if (!reused) {
+            ESP_LOGE(TAG, "Failed to open http connection");
+            return ESP_FAIL;
+        }
+        /* The server closed the kept connection, it goes unnoticed until the next write */
+        ESP_LOGW(TAG, "Kept connection closed by the server, reconnecting");
+        sr->stats.reconnects++;
+    }
+}
+
+static int _baidu_frame(void *ctx, const char *audio, int len)
+{
+    baidu_sr_t *sr = (baidu_sr_t *)ctx;
+    if (sr->cancelled) {
+        sr->failed = true;
+        return ESP_FAIL;
+    }
+    if (sr->upload_mode == BAIDU_SR_UPLOAD_RAW) {
+        /* Pipeline frames go out as they are, no base64 */
+        int write_len = _http_write_chunk(sr, audio, len);
+        if (write_len <= 0) {
+            sr->failed = true;
+            return write_len;
+        }
+        sr->sr_total_write += write_len;
+        return write_len;
+    }
+
+    /* Queue first chunk, it leaves together with the first audio */
+    if (sr->is_begin) {
+        sr->is_begin = false;
+        int sr_begin_len = baidu_sr_proto_json_begin(sr->buffer, sr->buffer_size, sr->dev_pid, sr->cuid, sr->format,
+                                                      sr->sample_rates, sr->token);
+        if (sr_begin_len < 0) {
+            ESP_LOGE(TAG, "SR Buffer too small for request header");
+            sr->failed = true;
+            return ESP_FAIL;
+        }
+        char *payload = _http_chunk_begin(sr, sr_begin_len);
+        if (payload == NULL) {
+            sr->failed = true;
+            return ESP_FAIL;
+        }
+        memcpy(payload, sr->buffer, sr_begin_len);
+        _http_chunk_end(sr, sr_begin_len);
+    }
+
+    /* Write b64 audio data straight into the TX buffer, the 0-2 bytes left over are carried by the encoder */
+    int need_write = sr_base64_encode_len(&sr->b64, len);
+    sr->sr_total_write += len;
+    ESP_LOGD(TAG, "Total bytes written: %d", sr->sr_total_write);
+    if (need_write > 0) {
+        char *payload = _http_chunk_begin(sr, need_write);
+        if (payload == NULL) {
+            sr->failed = true;
+            return ESP_FAIL;
+        }
+        sr_base64_encode_update(&sr->b64, payload, (const uint8_t *)audio, len);
+        _http_chunk_end(sr, need_write);
+        if (_http_flush_if_due(sr) < 0) {
+            sr->failed = true;
+            return ESP_FAIL;
+        }
+    } else {
+        /* Less than one base64 group, it only goes into the carry */
+        sr_base64_encode_update(&sr->b64, sr->tx_buffer + sr->tx_len, (const uint8_t *)audio, len);
+    }
+    /* Never return 0 here, the writer takes it as a failed write */
+    return len;
+}
+
+/* Write End chunk, the tail of the audio, the JSON trailer and the terminator leave in one write */
+static esp_err_t _baidu_send_end(baidu_sr_t *sr)
+{
+    if (sr->upload_mode == BAIDU_SR_UPLOAD_JSON) {
+        char tail[4];
+        int need_write = sr_base64_encode_finish(&sr->b64, tail);
+        int sr_end_len = baidu_sr_proto_json_end(sr->buffer, sr->buffer_size, sr->sr_total_write);
+        if (sr_end_len < 0) {
+            return ESP_FAIL;
+        }
+        char *payload = _http_chunk_begin(sr, need_write + sr_end_len);
+        if (payload == NULL) {
+            return ESP_FAIL;
+        }
+        memcpy(payload, tail, need_write);
+        memcpy(payload + need_write, sr->buffer, sr_end_len);
+        _http_chunk_end(sr, need_write + sr_end_len);
+    }
+    /* Finish chunked */
+    if (_http_write_last_chunk(sr) < 0) {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+/* Parse the response as it is read, it may be longer than the buffer */
+static esp_err_t _baidu_read_response(baidu_sr_t *sr)
+{
+    int ret = SR_JSON_MORE;
+    int total_len = 0;
+    /* The headers are in */
+    sr_latency_mark(sr->latency, SR_LATENCY_FIRST_REPLY);
+    while (ret == SR_JSON_MORE && !sr->cancelled) {
+        int read_len = esp_http_client_read(sr->http, sr->buffer, sr->buffer_size);
+        if (read_len <= 0) {
+            break;
+        }
+        if (read_len > sr->rx_hwm) {
+            sr->rx_hwm = read_len;
+        }
+        ESP_LOGD(TAG, "Got HTTP Response = %.*s", read_len, sr->buffer);
+        ret = _baidu_parse(sr, sr->buffer, read_len, total_len == 0);
+        total_len += read_len;
+    }
+    ESP_LOGI(TAG, "[ + ] Response read, read_len=%d", total_len);
+    if (ret != SR_JSON_DONE) {
+        ESP_LOGE(TAG, "Invalid response");
+        return ESP_FAIL;
+    }
+    if (sr->err_no != 0) {
+        ESP_LOGE(TAG, "Recognition failed, err_no=%d, err_msg=%s", sr->err_no, sr->err_msg);
+    }
+    if (sr->result->len > 0) {
+        sr_result_publish(sr->result, true);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t _baidu_end(void *ctx)
+{
+    baidu_sr_t *sr = (baidu_sr_t *)ctx;
+    if (!sr->is_open) {
+        return ESP_OK;
+    }
+    sr->is_open = false;
+    ESP_LOGI(TAG, "[ + ] Write end chunked marker, total:%d", sr->sr_total_write);
+    bool keep = false;
+    if (!sr->failed && !sr->cancelled && _baidu_send_end(sr) == ESP_OK && esp_http_client_fetch_headers(sr->http) >= 0) {
+        keep = _baidu_read_response(sr) == ESP_OK;
+        /* Whatever was left unread would be taken for the next response */
+        while (esp_http_client_read(sr->http, sr->drain, sizeof(sr->drain)) > 0);
+    }
+    if (!keep || sr->keep_alive_ms < 0) {
+        _baidu_disconnect(sr);
+    }
+    sr->last_used = esp_timer_get_time();
+    return keep ? ESP_OK : ESP_FAIL;
+}
+
+static esp_err_t _baidu_connect(void *ctx)
+{
+    baidu_sr_t *sr = (baidu_sr_t *)ctx;
+    if (sr->keep_alive_ms < 0) {
+        return ESP_FAIL;
+    }
+    if (_baidu_prepare(sr, sr->endpoint) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    if (sr->connected) {
+        return ESP_OK;
+    }
+    int64_t start = esp_timer_get_time();
+    esp_http_client_set_method(sr->http, HTTP_METHOD_HEAD);
+    if (esp_http_client_perform(sr->http) != ESP_OK) {
+        ESP_LOGW(TAG, "Pre-connect failed, the next request connects itself");
+        _baidu_disconnect(sr);
+        return ESP_FAIL;
+    }
+    sr->connected = true;
+    sr->last_used = esp_timer_get_time();
+    ESP_LOGI(TAG, "Pre-connected in %d ms", (int)((sr->last_used - start) / 1000));
+    return ESP_OK;
+}
+
+/* The response read stops at the next block, or after the HTTP timeout at worst */
+static void _baidu_cancel(void *ctx)
+{
+    baidu_sr_t *sr = (baidu_sr_t *)ctx;
+    sr->cancelled = true;
+}
+
+static esp_err_t _baidu_set_credential(void *ctx, const char *credential)
+{
+    baidu_sr_t *sr = (baidu_sr_t *)ctx;
+    if (strlen(credential) > BAIDU_SR_PROTO_TOKEN_MAX) {
+        ESP_LOGW(TAG, "Token longer than %d bytes, the request header may not fit", BAIDU_SR_PROTO_TOKEN_MAX);
+    }
+    char *next_token = strdup(credential);
+    AUDIO_MEM_CHECK(TAG, next_token, return ESP_FAIL);
+    xSemaphoreTake(sr->token_lock, portMAX_DELAY);
+    free(sr->next_token);
+    sr->next_token = next_token;
+    xSemaphoreGive(sr->token_lock);
+    return ESP_OK;
+}
+
+static int _baidu_wire_bytes(void *ctx)
+{
+    baidu_sr_t *sr = (baidu_sr_t *)ctx;
+    return sr->wire_bytes;
+}
+
+static void _baidu_report(void *ctx)
+{
+    baidu_sr_t *sr = (baidu_sr_t *)ctx;
+    int connects = sr->stats.requests - sr->stats.reused;
+    ESP_LOGI(TAG, "Connection kept for %d of %d requests: %d DNS lookups and handshakes saved, ~%d ms each, %d dropped by the server",
+             sr->stats.reused, sr->stats.requests, sr->stats.reused,
+             connects > 0 ? (int)(sr->connect_us / connects / 1000) : 0, sr->stats.reconnects);
+    ESP_LOGI(TAG, "High-water marks: tx %d/%d, response %d/%d", sr->tx_hwm, sr->tx_size, sr->rx_hwm, sr->buffer_size);
+    sr->tx_hwm = 0;
+    sr->rx_hwm = 0;
+}
+
+static int _baidu_memory(void *ctx)
+{
+    baidu_sr_t *sr = (baidu_sr_t *)ctx;
+    return sr->buffer_size + sr->tx_size;
+}
+
+static void _baidu_destroy(void *ctx)
+{
+    baidu_sr_t *sr = (baidu_sr_t *)ctx;
+    if (sr->http) {
+        esp_http_client_cleanup(sr->http);
+    }
+    free(sr->buffer);
+    free(sr->tx_buffer);
+    free(sr->cuid);
+    free(sr->endpoint);
+    free(sr->token);
+    free(sr->next_token);
+    if (sr->token_lock) {
+        vSemaphoreDelete(sr->token_lock);
+    }
+    free(sr);
+}
+
+static void *_baidu_create(const void *config, const sr_provider_env_t *env)
+{
+    const sr_provider_baidu_config_t *cfg = (const sr_provider_baidu_config_t *)config;
+    if (env->sample_rate != 8000 && env->sample_rate != 16000) {
+        ESP_LOGE(TAG, "Only 8000 and 16000 Hz audio is supported, got %d", env->sample_rate);
+        return NULL;
+    }
+    baidu_sr_t *sr = calloc(1, sizeof(baidu_sr_t));
+    AUDIO_MEM_CHECK(TAG, sr, return NULL);
+    sr->result = env->result;
+    sr->latency = env->latency;
+    sr->sample_rates = env->sample_rate;
+    /* Compressed audio is announced by the encoder, not by the caller */
+    sr->format = env->format == SR_AUDIO_AMR_WB ? "amr" : "pcm";
+    sr->upload_mode = cfg->upload_mode;
+    sr->dev_pid = cfg->dev_pid > 0 ? cfg->dev_pid : BAIDU_SR_PROTO_DEFAULT_DEV_PID;
+    sr->keep_alive_ms = cfg->keep_alive_ms;
+    if (sr->keep_alive_ms == 0) {
+        sr->keep_alive_ms = SR_PROVIDER_BAIDU_DEFAULT_KEEP_ALIVE_MS;
+    }
+
+    sr->endpoint = strdup(cfg->endpoint ? cfg->endpoint : SR_PROVIDER_BAIDU_ENDPOINT);
+    AUDIO_MEM_CHECK(TAG, sr->endpoint, goto exit_baidu_create);
+
+    /* The request header or URI is formatted into `buffer`, the response is read through it */
+    sr->buffer_size = env->frame_max;
+    int buffer_min = sr->upload_mode == BAIDU_SR_UPLOAD_RAW ? BAIDU_SR_PROTO_RAW_URI_MAX(strlen(sr->endpoint))
+                     : BAIDU_SR_PROTO_JSON_BEGIN_MAX;
+    if (sr->buffer_size < buffer_min) {
+        ESP_LOGW(TAG, "Buffer size %d too small for the request header, using %d", sr->buffer_size, buffer_min);
+        sr->buffer_size = buffer_min;
+    }
+    if (strlen(cfg->token) > BAIDU_SR_PROTO_TOKEN_MAX || strlen(cfg->cuid) > BAIDU_SR_PROTO_CUID_MAX) {
+        ESP_LOGW(TAG, "Token or cuid longer than %d/%d bytes, the request header may not fit",
+                 BAIDU_SR_PROTO_TOKEN_MAX, BAIDU_SR_PROTO_CUID_MAX);
+    }
+    sr->buffer = malloc(sr->buffer_size);
+    AUDIO_MEM_CHECK(TAG, sr->buffer, goto exit_baidu_create);
+    /* Room for the pending chunks, one more full chunk (the writer hands over at most frame_max bytes) and the terminator */
+    sr->coalesce_size = cfg->coalesce_size;
+    sr->coalesce_ms = cfg->coalesce_ms;
+    sr->tx_size = sr->coalesce_size + SR_BASE64_ENCODE_MAX(env->frame_max)
+                  + BAIDU_SR_PROTO_CHUNK_OVERHEAD + BAIDU_SR_PROTO_LAST_CHUNK_LEN;
+    if (sr->upload_mode == BAIDU_SR_UPLOAD_JSON) {
+        /* So that the JSON header leaves together with the first audio */
+        sr->tx_size += BAIDU_SR_PROTO_JSON_BEGIN_MAX + BAIDU_SR_PROTO_CHUNK_OVERHEAD;
+    }
+    sr->tx_buffer = malloc(sr->tx_size);
+    AUDIO_MEM_CHECK(TAG, sr->tx_buffer, goto exit_baidu_create);
+    sr_json_init(&sr->json, _baidu_on_response_value, sr);
+    sr->token = strdup(cfg->token);
+    AUDIO_MEM_CHECK(TAG, sr->token, goto exit_baidu_create);
+    sr->token_lock = xSemaphoreCreateMutex();
+    AUDIO_MEM_CHECK(TAG, sr->token_lock, goto exit_baidu_create);
+    sr->cuid = strdup(cfg->cuid);
+    AUDIO_MEM_CHECK(TAG, sr->cuid, goto exit_baidu_create);
+    return sr;
+exit_baidu_create:
+    _baidu_destroy(sr);
+    return NULL;
+}
+
+const sr_provider_t sr_provider_baidu = {
+    .name = "baidu",
+    .create = _baidu_create,
+    .destroy = _baidu_destroy,
+    .memory = _baidu_memory,
+    .connect = _baidu_connect,
+    .begin = _baidu_begin,
+    .frame = _baidu_frame,
+    .end = _baidu_end,
+    .parse = _baidu_parse,
+    .cancel = _baidu_cancel,
+    .set_credential = _baidu_set_credential,
+    .report = _baidu_report,
+    .wire_bytes = _baidu_wire_bytes,
+};
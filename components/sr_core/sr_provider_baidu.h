@@ -0,0 +1,63 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _SR_PROVIDER_BAIDU_H_
+#define _SR_PROVIDER_BAIDU_H_
+
+#include "sr_provider.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SR_PROVIDER_BAIDU_DEFAULT_KEEP_ALIVE_MS (15000)
+#define SR_PROVIDER_BAIDU_ENDPOINT "http://vop.baidu.com/server_api"
+
+/**
+ * Baidu request body layout
+ */
+typedef enum {
+    BAIDU_SR_UPLOAD_JSON = 0,   /*!< JSON body, audio as base64 `speech` value */
+    BAIDU_SR_UPLOAD_RAW,        /*!< Bare audio body, `dev_pid/cuid/token` in the query string */
+} baidu_sr_upload_mode_t;
+
+/**
+ * Configuration of sr_provider_baidu, the vop.baidu.com HTTP API
+ */
+typedef struct {
+   const char *token;                  /*!< Access token, copied, replaced by sr_core_set_credential */
+   const char *cuid;
+   int dev_pid;                        /*!< Language model, 1537 (Mandarin) if 0 */
+   baidu_sr_upload_mode_t upload_mode; /*!< Request body layout, JSON by default */
+   int coalesce_size;                  /*!< Hold chunks until this many bytes are queued, 0 sends each chunk in one write */
+   int coalesce_ms;                    /*!< Send queued chunks no later than this after the first one, checked as audio arrives */
+   int keep_alive_ms;                  /*!< Reuse the connection if idle less than this, SR_PROVIDER_BAIDU_DEFAULT_KEEP_ALIVE_MS if 0, always reconnect if < 0 */
+   const char *endpoint;               /*!< Recognizer URL without query string, copied, SR_PROVIDER_BAIDU_ENDPOINT if NULL */
+} sr_provider_baidu_config_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
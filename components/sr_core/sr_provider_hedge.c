@@ -0,0 +1,624 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "audio_error.h"
+#include "sr_provider_hedge.h"
+
+static const char *TAG = "SR_HEDGE";
+
+#define HEDGE_SR_LEGS               (2)
+#define HEDGE_SR_PRIMARY            (0)
+#define HEDGE_SR_BACKUP             (1)
+#define HEDGE_SR_POLL_MS            (20)
+#define HEDGE_SR_RESULT_TIMEOUT_MS  (15000)
+#define HEDGE_SR_LATENCY_SAMPLES    (32)    /* Primary latencies kept for the p95 */
+#define HEDGE_SR_LATENCY_MIN        (8)     /* Fewer samples use SR_PROVIDER_HEDGE_DEFAULT_DELAY_MS */
+#define HEDGE_WIN_BIT               BIT0
+#define HEDGE_DONE_BIT(i)           (BIT1 << (i))
+#define HEDGE_EXITED_BIT(i)         (BIT3 << (i))
+
+typedef struct hedge_sr hedge_sr_t;
+
+/*
+ * One recognizer and its sender. The sender passes the store to `frame`
+ * from `offset` on, in place, so the upload task never overwrites a byte at
+ * or after the `offset` of a leg that is still reading it. A leg that falls
+ * a whole store behind is dropped; if its `frame` is still blocked in a
+ * write, the upload task goes on without waiting, and the bytes that write
+ * still sends belong to a request nobody listens to any more.
+ */
+typedef struct {
+    hedge_sr_t              *hedge;
+    int                     index;
+    const sr_provider_t     *provider;
+    void                    *ctx;
+    sr_result_t             result;
+    TaskHandle_t            task;
+    SemaphoreHandle_t       start;              /* Given to run one utterance */
+    SemaphoreHandle_t       kick;               /* Given when audio arrives or the utterance ends */
+    SemaphoreHandle_t       span_lock;          /* Held by the sender while `frame` reads the store */
+    volatile bool           joined;             /* Takes part in the current utterance */
+    volatile bool           running;            /* Between start and the return of `end` */
+    volatile bool           dropped;            /* Gets no more audio, the sender stops at the next frame */
+    volatile bool           fenced;             /* Dropped and no longer reading the store */
+    volatile bool           answered;           /* `end` returned ESP_OK, with or without text */
+    volatile int            offset;             /* Absolute store position sent so far */
+    int64_t                 final_time;
+    int                     wins;
+} hedge_leg_t;
+
+struct hedge_sr {
+    sr_result_t             *result;
+    int                     frame_max;
+    sr_task_place_t         task;               /* Sender task of each leg */
+    char                    *buffer;
+    int                     buffer_size;
+    volatile int            written;            /* Absolute store position, reset when no sender is running */
+    int                     base;               /* `written` at the start of the utterance */
+    volatile bool           finished;
+    volatile bool           exit;
+    bool                    backup_pending;     /* The backup waits for the delay */
+    int                     delay_ms;
+    int64_t                 end_time;
+    hedge_leg_t             leg[HEDGE_SR_LEGS];
+    SemaphoreHandle_t       lock;               /* Guards winner, leader and the forwarding to `result` */
+    EventGroupHandle_t      events;
+    int                     winner;
+    int                     leader;             /* Leg whose partial results are forwarded */
+    int                     latency[HEDGE_SR_LATENCY_SAMPLES];
+    int                     latency_count;
+    int                     latency_next;
+    int                     backups_started;
+    int                     backups_skipped;
+    int                     backups_saved;
+};
+
+static void _hedge_copy_result(sr_result_t *to, const sr_result_t *from)
+{
+    int len = from->len < to->size - 1 ? from->len : to->size - 1;
+    memcpy(to->text, from->text, len);
+    to->text[len] = 0;
+    to->len = len;
+}
+
+static void _hedge_on_update(const char *text, bool is_final, void *user_data)
+{
+    hedge_leg_t *leg = (hedge_leg_t *)user_data;
+    hedge_sr_t *hedge = leg->hedge;
+    xSemaphoreTake(hedge->lock, portMAX_DELAY);
+    if (hedge->winner < 0 && leg->joined && !leg->dropped) {
+        if (is_final && leg->result.len > 0) {
+            leg->final_time = esp_timer_get_time();
+            hedge->winner = leg->index;
+            xEventGroupSetBits(hedge->events, HEDGE_WIN_BIT);
+        } else if (!is_final && (hedge->leader < 0 || hedge->leader == leg->index)) {
+            hedge->leader = leg->index;
+            _hedge_copy_result(hedge->result, &leg->result);
+            sr_result_publish(hedge->result, false);
+        }
+    }
+    xSemaphoreGive(hedge->lock);
+}
+
+static void _hedge_leg_task(void *pv)
+{
+    hedge_leg_t *leg = (hedge_leg_t *)pv;
+    hedge_sr_t *hedge = leg->hedge;
+    while (1) {
+        xSemaphoreTake(leg->start, portMAX_DELAY);
+        if (hedge->exit) {
+            break;
+        }
+        bool ok = leg->provider->begin(leg->ctx) == ESP_OK;
+        while (ok && !hedge->exit) {
+            xSemaphoreTake(leg->span_lock, portMAX_DELAY);
+            if (leg->dropped) {
+                xSemaphoreGive(leg->span_lock);
+                ok = false;
+                break;
+            }
+            /* Read before `written`, so audio framed just before the end is not missed */
+            bool finished = hedge->finished;
+            int available = hedge->written - leg->offset;
+            if (available <= 0) {
+                xSemaphoreGive(leg->span_lock);
+                if (finished) {
+                    break;
+                }
+                xSemaphoreTake(leg->kick, HEDGE_SR_POLL_MS / portTICK_PERIOD_MS);
+                continue;
+            }
+            int pos = leg->offset % hedge->buffer_size;
+            int len = available < hedge->frame_max ? available : hedge->frame_max;
+            if (len > hedge->buffer_size - pos) {
+                len = hedge->buffer_size - pos;
+            }
+            ok = leg->provider->frame(leg->ctx, hedge->buffer + pos, len) > 0;
+            if (ok) {
+                leg->offset += len;
+            }
+            xSemaphoreGive(leg->span_lock);
+        }
+        /* `end` also tears down what a failed `frame` left behind */
+        if (leg->provider->end(leg->ctx) != ESP_OK) {
+            ok = false;
+        }
+        leg->answered = ok && !leg->dropped;
+        if (!ok && !leg->dropped) {
+            ESP_LOGW(TAG, "%s failed", leg->provider->name);
+        }
+        leg->running = false;
+        xEventGroupSetBits(hedge->events, HEDGE_DONE_BIT(leg->index));
+    }
+    xEventGroupSetBits(hedge->events, HEDGE_EXITED_BIT(leg->index));
+    vTaskDelete(NULL);
+}
+
+static void _hedge_leg_start(hedge_sr_t *hedge, hedge_leg_t *leg)
+{
+    sr_result_reset(&leg->result);
+    leg->offset = hedge->base;
+    leg->dropped = false;
+    leg->fenced = false;
+    leg->answered = false;
+    leg->final_time = 0;
+    xEventGroupClearBits(hedge->events, HEDGE_DONE_BIT(leg->index));
+    xSemaphoreTake(leg->kick, 0);
+    leg->running = true;
+    leg->joined = true;
+    xSemaphoreGive(leg->start);
+}
+
+/* Stop feeding a leg, `frame` or `end` in its sender return soon */
+static void _hedge_leg_drop(hedge_leg_t *leg)
+{
+    leg->dropped = true;
+    if (leg->provider->cancel) {
+        leg->provider->cancel(leg->ctx);
+    }
+}
+
+static void _hedge_backup_start(hedge_sr_t *hedge)
+{
+    hedge->backup_pending = false;
+    hedge->backups_started++;
+    ESP_LOGI(TAG, "Backup %s started %d ms after the utterance ended", hedge->leg[HEDGE_SR_BACKUP].provider->name,
+             hedge->finished ? (int)((esp_timer_get_time() - hedge->end_time) / 1000) : 0);
+    _hedge_leg_start(hedge, &hedge->leg[HEDGE_SR_BACKUP]);
+}
+
+/* A joined leg that may still deliver a result */
+static bool _hedge_leg_live(hedge_leg_t *leg)
+{
+    return leg->joined && leg->running && !leg->dropped;
+}
+
+static int _hedge_delay(hedge_sr_t *hedge)
+{
+    if (hedge->delay_ms > 0) {
+        return hedge->delay_ms;
+    }
+    if (hedge->latency_count < HEDGE_SR_LATENCY_MIN) {
+        return SR_PROVIDER_HEDGE_DEFAULT_DELAY_MS;
+    }
+    int sorted[HEDGE_SR_LATENCY_SAMPLES];
+    int count = hedge->latency_count;
+    for (int i = 0; i < count; i++) {
+        int j = i;
+        for (; j > 0 && sorted[j - 1] > hedge->latency[i]; j--) {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = hedge->latency[i];
+    }
+    return sorted[(count * 95 + 99) / 100 - 1];
+}
+
+static void _hedge_latency_add(hedge_sr_t *hedge, int latency_ms)
+{
+    hedge->latency[hedge->latency_next] = latency_ms;
+    hedge->latency_next = (hedge->latency_next + 1) % HEDGE_SR_LATENCY_SAMPLES;
+    if (hedge->latency_count < HEDGE_SR_LATENCY_SAMPLES) {
+        hedge->latency_count++;
+    }
+}
+
+static esp_err_t _hedge_begin(void *ctx)
+{
+    hedge_sr_t *hedge = (hedge_sr_t *)ctx;
+    hedge_leg_t *primary = &hedge->leg[HEDGE_SR_PRIMARY];
+    hedge_leg_t *backup = &hedge->leg[HEDGE_SR_BACKUP];
+    hedge->finished = false;
+    hedge->winner = -1;
+    hedge->leader = -1;
+    hedge->backup_pending = false;
+    xEventGroupClearBits(hedge->events, HEDGE_WIN_BIT);
+    if (!primary->running && !backup->running) {
+        hedge->written = 0;
+    }
+    hedge->base = hedge->written;
+    primary->joined = false;
+    backup->joined = false;
+
+    /* A loser of the last utterance may still be closing its request */
+    if (primary->running) {
+        ESP_LOGW(TAG, "%s still busy, skipped", primary->provider->name);
+    } else {
+        _hedge_leg_start(hedge, primary);
+    }
+    if (backup->running) {
+        ESP_LOGW(TAG, "%s still busy, skipped", backup->provider->name);
+    } else if (hedge->delay_ms == 0 || !primary->joined) {
+        _hedge_leg_start(hedge, backup);
+    } else {
+        hedge->backup_pending = true;
+    }
+    return primary->joined || backup->joined ? ESP_OK : ESP_FAIL;
+}
+
+static int _hedge_frame(void *ctx, const char *audio, int len)
+{
+    hedge_sr_t *hedge = (hedge_sr_t *)ctx;
+    hedge_leg_t *primary = &hedge->leg[HEDGE_SR_PRIMARY];
+    for (int i = 0; i < HEDGE_SR_LEGS; i++) {
+        hedge_leg_t *leg = &hedge->leg[i];
+        if (leg->running && !leg->fenced && hedge->written + len - leg->offset > hedge->buffer_size) {
+            if (leg->joined && !leg->dropped) {
+                ESP_LOGW(TAG, "%s is %d bytes behind, dropped", leg->provider->name, hedge->written - leg->offset);
+            }
+            _hedge_leg_drop(leg);
+            /*
+             * A `frame` still reading the bytes about to be overwritten may be
+             * stuck in a write for as long as its transport times out. Never
+             * make the healthy leg wait for it, the sender stops reading the
+             * store once that `frame` returns.
+             */
+            if (xSemaphoreTake(leg->span_lock, 0) == pdTRUE) {
+                leg->fenced = true;
+                xSemaphoreGive(leg->span_lock);
+            }
+        }
+    }
+    if (hedge->backup_pending && hedge->written + len - hedge->base > hedge->buffer_size) {
+        ESP_LOGW(TAG, "Utterance longer than %d bytes, no backup", hedge->buffer_size);
+        hedge->backup_pending = false;
+        hedge->backups_skipped++;
+    }
+
+    int pos = hedge->written % hedge->buffer_size;
+    int first = len < hedge->buffer_size - pos ? len : hedge->buffer_size - pos;
+    memcpy(hedge->buffer + pos, audio, first);
+    memcpy(hedge->buffer, audio + first, len - first);
+    hedge->written += len;
+    for (int i = 0; i < HEDGE_SR_LEGS; i++) {
+        if (_hedge_leg_live(&hedge->leg[i])) {
+            xSemaphoreGive(hedge->leg[i].kick);
+        }
+    }
+
+    /* The primary gave up early, do not wait for the delay */
+    if (hedge->backup_pending && !_hedge_leg_live(primary)) {
+        _hedge_backup_start(hedge);
+    }
+    if (!_hedge_leg_live(primary) && !_hedge_leg_live(&hedge->leg[HEDGE_SR_BACKUP]) && !hedge->backup_pending) {
+        return ESP_FAIL;
+    }
+    return len;
+}
+
+static esp_err_t _hedge_end(void *ctx)
+{
+    hedge_sr_t *hedge = (hedge_sr_t *)ctx;
+    hedge_leg_t *primary = &hedge->leg[HEDGE_SR_PRIMARY];
+    hedge->end_time = esp_timer_get_time();
+    hedge->finished = true;
+    for (int i = 0; i < HEDGE_SR_LEGS; i++) {
+        if (hedge->leg[i].joined) {
+            xSemaphoreGive(hedge->leg[i].kick);
+        }
+    }
+    if (hedge->backup_pending) {
+        EventBits_t bits = xEventGroupWaitBits(hedge->events, HEDGE_WIN_BIT | HEDGE_DONE_BIT(HEDGE_SR_PRIMARY),
+                                               pdFALSE, pdFALSE, _hedge_delay(hedge) / portTICK_PERIOD_MS);
+        if ((bits & HEDGE_WIN_BIT) || primary->answered) {
+            /* A primary that heard nothing answered as well, the backup would hear nothing either */
+            hedge->backup_pending = false;
+            hedge->backups_saved++;
+        } else {
+            _hedge_backup_start(hedge);
+        }
+    }
+
+    EventBits_t done = 0;
+    for (int i = 0; i < HEDGE_SR_LEGS; i++) {
+        if (hedge->leg[i].joined) {
+            done |= HEDGE_DONE_BIT(i);
+        }
+    }
+    EventBits_t bits = xEventGroupGetBits(hedge->events);
+    while ((bits & HEDGE_WIN_BIT) == 0 && (bits & done) != done
+           && esp_timer_get_time() - hedge->end_time < HEDGE_SR_RESULT_TIMEOUT_MS * 1000LL) {
+        bits = xEventGroupWaitBits(hedge->events, HEDGE_WIN_BIT | done, pdFALSE, pdFALSE,
+                                   HEDGE_SR_POLL_MS / portTICK_PERIOD_MS);
+    }
+
+    xSemaphoreTake(hedge->lock, portMAX_DELAY);
+    int winner = hedge->winner;
+    bool primary_late = winner != HEDGE_SR_PRIMARY && _hedge_leg_live(primary);
+    bool answered = false;
+    if (winner < 0) {
+        hedge->winner = HEDGE_SR_LEGS;    /* Late results are ignored */
+        for (int i = 0; i < HEDGE_SR_LEGS; i++) {
+            answered |= hedge->leg[i].joined && hedge->leg[i].answered;
+        }
+    }
+    for (int i = 0; i < HEDGE_SR_LEGS; i++) {
+        if (i != winner && _hedge_leg_live(&hedge->leg[i])) {
+            ESP_LOGI(TAG, "Cancel %s", hedge->leg[i].provider->name);
+            _hedge_leg_drop(&hedge->leg[i]);
+        }
+    }
+    if (winner >= 0) {
+        _hedge_copy_result(hedge->result, &hedge->leg[winner].result);
+    } else if (answered) {
+        /* Forwarded partial results of the leader are not the final text */
+        hedge->result->text[0] = 0;
+        hedge->result->len = 0;
+    }
+    xSemaphoreGive(hedge->lock);
+
+    /* A cancelled primary was at least this slow, which is what the delay needs to know */
+    if (winner == HEDGE_SR_PRIMARY || primary_late) {
+        int64_t done_time = winner == HEDGE_SR_PRIMARY ? primary->final_time : esp_timer_get_time();
+        _hedge_latency_add(hedge, (int)((done_time - hedge->end_time) / 1000));
+    }
+    if (winner < 0 && answered) {
+        ESP_LOGI(TAG, "No text from either recognizer");
+        sr_result_publish(hedge->result, true);
+        return ESP_OK;
+    }
+    if (winner < 0) {
+        ESP_LOGE(TAG, "No recognizer returned a result");
+        return ESP_FAIL;
+    }
+    hedge->leg[winner].wins++;
+    ESP_LOGI(TAG, "%s won, %d ms after the utterance ended", hedge->leg[winner].provider->name,
+             (int)((hedge->leg[winner].final_time - hedge->end_time) / 1000));
+    sr_result_publish(hedge->result, true);
+    return ESP_OK;
+}
+
+static int _hedge_parse(void *ctx, const char *data, int len, bool first)
+{
+    hedge_sr_t *hedge = (hedge_sr_t *)ctx;
+    hedge_leg_t *primary = &hedge->leg[HEDGE_SR_PRIMARY];
+    return primary->provider->parse(primary->ctx, data, len, first);
+}
+
+static void _hedge_cancel(void *ctx)
+{
+    hedge_sr_t *hedge = (hedge_sr_t *)ctx;
+    for (int i = 0; i < HEDGE_SR_LEGS; i++) {
+        if (hedge->leg[i].running) {
+            _hedge_leg_drop(&hedge->leg[i]);
+        }
+    }
+}
+
+static esp_err_t _hedge_connect(void *ctx)
+{
+    hedge_sr_t *hedge = (hedge_sr_t *)ctx;
+    for (int i = 0; i < HEDGE_SR_LEGS; i++) {
+        hedge_leg_t *leg = &hedge->leg[i];
+        if (leg->provider->connect && !leg->running) {
+            leg->provider->connect(leg->ctx);
+        }
+    }
+    return ESP_OK;
+}
+
+static esp_err_t _hedge_set_credential(void *ctx, const char *credential)
+{
+    hedge_sr_t *hedge = (hedge_sr_t *)ctx;
+    esp_err_t ret = ESP_ERR_NOT_SUPPORTED;
+    for (int i = 0; i < HEDGE_SR_LEGS; i++) {
+        hedge_leg_t *leg = &hedge->leg[i];
+        if (leg->provider->set_credential) {
+            if (leg->provider->set_credential(leg->ctx, credential) != ESP_OK) {
+                return ESP_FAIL;
+            }
+            ret = ESP_OK;
+        }
+    }
+    return ret;
+}
+
+static void _hedge_report(void *ctx)
+{
+    hedge_sr_t *hedge = (hedge_sr_t *)ctx;
+    for (int i = 0; i < HEDGE_SR_LEGS; i++) {
+        hedge_leg_t *leg = &hedge->leg[i];
+        if (leg->provider->report) {
+            leg->provider->report(leg->ctx);
+        }
+    }
+    ESP_LOGI(TAG, "Wins %s:%d %s:%d, backups started:%d saved:%d skipped:%d, delay %d ms",
+             hedge->leg[HEDGE_SR_PRIMARY].provider->name, hedge->leg[HEDGE_SR_PRIMARY].wins,
+             hedge->leg[HEDGE_SR_BACKUP].provider->name, hedge->leg[HEDGE_SR_BACKUP].wins,
+             hedge->backups_started, hedge->backups_saved, hedge->backups_skipped,
+             hedge->delay_ms == 0 ? 0 : _hedge_delay(hedge));
+    hedge->leg[HEDGE_SR_PRIMARY].wins = 0;
+    hedge->leg[HEDGE_SR_BACKUP].wins = 0;
+    hedge->backups_started = 0;
+    hedge->backups_saved = 0;
+    hedge->backups_skipped = 0;
+}
+
+static int _hedge_memory(void *ctx)
+{
+    hedge_sr_t *hedge = (hedge_sr_t *)ctx;
+    int memory = hedge->buffer_size;
+    for (int i = 0; i < HEDGE_SR_LEGS; i++) {
+        hedge_leg_t *leg = &hedge->leg[i];
+        memory += leg->result.size + hedge->task.stack + leg->provider->memory(leg->ctx);
+    }
+    return memory;
+}
+
+static void _hedge_destroy(void *ctx)
+{
+    hedge_sr_t *hedge = (hedge_sr_t *)ctx;
+    hedge->exit = true;
+    for (int i = 0; i < HEDGE_SR_LEGS; i++) {
+        hedge_leg_t *leg = &hedge->leg[i];
+        if (leg->task) {
+            if (leg->running) {
+                _hedge_leg_drop(leg);
+            }
+            xSemaphoreGive(leg->start);
+            xSemaphoreGive(leg->kick);
+            xEventGroupWaitBits(hedge->events, HEDGE_EXITED_BIT(i), pdFALSE, pdTRUE, portMAX_DELAY);
+        }
+    }
+    for (int i = 0; i < HEDGE_SR_LEGS; i++) {
+        hedge_leg_t *leg = &hedge->leg[i];
+        if (leg->ctx) {
+            leg->provider->destroy(leg->ctx);
+        }
+        if (leg->start) {
+            vSemaphoreDelete(leg->start);
+        }
+        if (leg->kick) {
+            vSemaphoreDelete(leg->kick);
+        }
+        if (leg->span_lock) {
+            vSemaphoreDelete(leg->span_lock);
+        }
+        free(leg->result.text);
+    }
+    if (hedge->events) {
+        vEventGroupDelete(hedge->events);
+    }
+    if (hedge->lock) {
+        vSemaphoreDelete(hedge->lock);
+    }
+    free(hedge->buffer);
+    free(hedge);
+}
+
+static esp_err_t _hedge_leg_create(hedge_sr_t *hedge, int index, const sr_provider_hedge_leg_t *cfg,
+                                   const sr_provider_env_t *env)
+{
+    hedge_leg_t *leg = &hedge->leg[index];
+    leg->hedge = hedge;
+    leg->index = index;
+    leg->provider = cfg->provider;
+    leg->result.size = env->result->size;
+    leg->result.text = calloc(1, leg->result.size);
+    AUDIO_MEM_CHECK(TAG, leg->result.text, return ESP_FAIL);
+    leg->result.on_update = _hedge_on_update;
+    leg->result.user_data = leg;
+    leg->start = xSemaphoreCreateBinary();
+    AUDIO_MEM_CHECK(TAG, leg->start, return ESP_FAIL);
+    leg->kick = xSemaphoreCreateBinary();
+    AUDIO_MEM_CHECK(TAG, leg->kick, return ESP_FAIL);
+    leg->span_lock = xSemaphoreCreateMutex();
+    AUDIO_MEM_CHECK(TAG, leg->span_lock, return ESP_FAIL);
+
+    /* Both legs share the latency marks, the first connection and the first reply count */
+    sr_provider_env_t leg_env = *env;
+    leg_env.result = &leg->result;
+    leg->ctx = leg->provider->create(cfg->config, &leg_env);
+    if (leg->ctx == NULL) {
+        ESP_LOGE(TAG, "Error create %s", leg->provider->name);
+        return ESP_FAIL;
+    }
+    if (xTaskCreatePinnedToCore(_hedge_leg_task, index == HEDGE_SR_PRIMARY ? "sr_hedge0" : "sr_hedge1",
+                                hedge->task.stack, leg, hedge->task.prio, &leg->task, hedge->task.core) != pdPASS) {
+        ESP_LOGE(TAG, "Error create %s sender task", leg->provider->name);
+        leg->task = NULL;
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static void *_hedge_create(const void *config, const sr_provider_env_t *env)
+{
+    const sr_provider_hedge_config_t *cfg = (const sr_provider_hedge_config_t *)config;
+    if (cfg == NULL || cfg->primary.provider == NULL || cfg->backup.provider == NULL) {
+        ESP_LOGE(TAG, "Hedge needs a primary and a backup");
+        return NULL;
+    }
+    if (env->task == NULL) {
+        ESP_LOGE(TAG, "Hedge needs a placement for its sender tasks");
+        return NULL;
+    }
+    hedge_sr_t *hedge = calloc(1, sizeof(hedge_sr_t));
+    AUDIO_MEM_CHECK(TAG, hedge, return NULL);
+    hedge->result = env->result;
+    hedge->frame_max = env->frame_max;
+    hedge->task = *env->task;
+    hedge->delay_ms = cfg->delay_ms;
+    hedge->buffer_size = cfg->buffer_size > 0 ? cfg->buffer_size : SR_PROVIDER_HEDGE_DEFAULT_BUFFER_SIZE;
+    if (hedge->buffer_size < 4 * hedge->frame_max) {
+        hedge->buffer_size = 4 * hedge->frame_max;
+    }
+    hedge->buffer = malloc(hedge->buffer_size);
+    AUDIO_MEM_CHECK(TAG, hedge->buffer, goto exit_hedge_create);
+    hedge->lock = xSemaphoreCreateMutex();
+    AUDIO_MEM_CHECK(TAG, hedge->lock, goto exit_hedge_create);
+    hedge->events = xEventGroupCreate();
+    AUDIO_MEM_CHECK(TAG, hedge->events, goto exit_hedge_create);
+    if (_hedge_leg_create(hedge, HEDGE_SR_PRIMARY, &cfg->primary, env) != ESP_OK
+        || _hedge_leg_create(hedge, HEDGE_SR_BACKUP, &cfg->backup, env) != ESP_OK) {
+        goto exit_hedge_create;
+    }
+    ESP_LOGI(TAG, "Hedging %s with %s, %d bytes of shared audio", cfg->primary.provider->name,
+             cfg->backup.provider->name, hedge->buffer_size);
+    return hedge;
+exit_hedge_create:
+    _hedge_destroy(hedge);
+    return NULL;
+}
+
+const sr_provider_t sr_provider_hedge = {
+    .name = "hedge",
+    .create = _hedge_create,
+    .destroy = _hedge_destroy,
+    .memory = _hedge_memory,
+    .connect = _hedge_connect,
+    .begin = _hedge_begin,
+    .frame = _hedge_frame,
+    .end = _hedge_end,
+    .parse = _hedge_parse,
+    .cancel = _hedge_cancel,
+    .set_credential = _hedge_set_credential,
+    .report = _hedge_report,
+};
@@ -0,0 +1,68 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _SR_PROVIDER_HEDGE_H_
+#define _SR_PROVIDER_HEDGE_H_
+
+#include "sr_provider.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SR_PROVIDER_HEDGE_DEFAULT_BUFFER_SIZE (64*1024)
+#define SR_PROVIDER_HEDGE_DEFAULT_DELAY_MS    (500)
+
+/**
+ * One recognizer of the hedge
+ */
+typedef struct {
+   const sr_provider_t *provider;
+   const void *config;                 /*!< The provider's own configuration, only used during create */
+} sr_provider_hedge_leg_t;
+
+/**
+ * Configuration of sr_provider_hedge
+ *
+ * Every utterance goes to the primary, and to the backup either at once or
+ * when the primary is late. Each recognizer has its own sender task, both
+ * read the audio from one shared store. The first non-empty final result
+ * wins and the other request is cancelled. A recognizer that falls more than
+ * the store behind the recording is dropped for the rest of the utterance,
+ * and a delayed backup is skipped for utterances longer than the store.
+ */
+typedef struct {
+   sr_provider_hedge_leg_t primary;
+   sr_provider_hedge_leg_t backup;     /*!< May be the same provider as the primary with another configuration */
+   int delay_ms;                       /*!< 0 races both from the start. > 0 starts the backup this long after the end of
+                                            the utterance if the primary has no result yet, < 0 uses the p95 latency of
+                                            the primary, SR_PROVIDER_HEDGE_DEFAULT_DELAY_MS until it is known */
+   int buffer_size;                    /*!< Audio store shared by both, SR_PROVIDER_HEDGE_DEFAULT_BUFFER_SIZE if 0, at least 4 frames */
+} sr_provider_hedge_config_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
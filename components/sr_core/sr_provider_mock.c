@@ -0,0 +1,315 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "audio_error.h"
+#include "sr_provider_mock.h"
+#include "sr_json.h"
+#include "sr_base64.h"
+#include "baidu_sr_proto.h"
+#include "xunfei_sr_proto.h"
+
+static const char *TAG = "SR_MOCK";
+
+#define MOCK_SR_REPLY           "{\"err_no\":0,\"err_msg\":\"success.\",\"sn\":\"mock\",\"result\":[\"%s\"]}"
+#define MOCK_SR_REPLY_MAX       (128)
+#define MOCK_SR_READ_SIZE       (16)    /* The reply is fed in pieces, like a network read */
+#define MOCK_SR_POLL_MS         (10)    /* How often the reply delay looks for a cancel */
+/* Credentials as long as the real ones, the framing is what is measured */
+#define MOCK_SR_TOKEN           "24.00000000000000000000000000000000.2592000.1563181441.282335-16147548"
+#define MOCK_SR_CUID            "esp32"
+#define MOCK_SR_APP_ID          "00000000"
+
+typedef struct {
+    sr_result_t             *result;
+    sr_latency_t            *latency;
+    int                     sample_rates;
+    int                     latency_ms;
+    volatile bool           cancelled;
+    char                    *text;
+    int                     sr_total_write;
+    int                     frames;
+    int64_t                 begin_time;
+    sr_json_t               json;
+    int                     err_no;
+    sr_mock_wire_t          wire;
+    char                    *wire_buffer;       /* One frame or chunk in the emulated wire format */
+    int                     wire_size;
+    int                     wire_bytes;
+    int                     frame_audio_max;    /* Audio bytes in one xunfei frame */
+    sr_base64_t             b64;
+} mock_sr_t;
+
+static void _mock_on_response_value(sr_json_t *json, sr_json_type_t type, const char *data, int len, bool done, void *user_data)
+{
+    mock_sr_t *sr = (mock_sr_t *)user_data;
+    if (type == SR_JSON_STRING && sr_json_path_is(json, "result[0]")) {
+        sr_json_append(sr->result->text, sr->result->size, &sr->result->len, data, len);
+    } else if (type == SR_JSON_NUMBER && sr_json_path_is(json, "err_no")) {
+        sr->err_no = atoi(data);
+    }
+}
+
+static int _mock_parse(void *ctx, const char *data, int len, bool first)
+{
+    mock_sr_t *sr = (mock_sr_t *)ctx;
+    if (first) {
+        sr_json_reset(&sr->json);
+        sr->err_no = -1;
+    }
+    return sr_json_feed(&sr->json, data, len);
+}
+
+/* The chunk payload is in place after room for the size line, count what the chunk would put on the wire */
+static void _mock_wire_chunk(mock_sr_t *sr, int payload_len)
+{
+    char header[BAIDU_SR_PROTO_CHUNK_HEADER_MAX];
+    int header_len = baidu_sr_proto_chunk_header(header, payload_len);
+    memcpy(sr->wire_buffer + BAIDU_SR_PROTO_CHUNK_HEADER_MAX + payload_len, BAIDU_SR_PROTO_CHUNK_TRAILER,
+           BAIDU_SR_PROTO_CHUNK_TRAILER_LEN);
+    sr->wire_bytes += header_len + payload_len + BAIDU_SR_PROTO_CHUNK_TRAILER_LEN;
+}
+
+static esp_err_t _mock_wire_frame(mock_sr_t *sr, const char *audio, int len)
+{
+    char *payload = sr->wire_buffer + BAIDU_SR_PROTO_CHUNK_HEADER_MAX;
+    int payload_max = sr->wire_size - BAIDU_SR_PROTO_CHUNK_OVERHEAD;
+    int payload_len;
+    switch (sr->wire) {
+    case SR_MOCK_WIRE_BAIDU_RAW:
+        memcpy(payload, audio, len);
+        _mock_wire_chunk(sr, len);
+        break;
+    case SR_MOCK_WIRE_BAIDU_JSON:
+        if (sr->frames == 0) {
+            payload_len = baidu_sr_proto_json_begin(payload, payload_max, BAIDU_SR_PROTO_DEFAULT_DEV_PID, MOCK_SR_CUID,
+                                                    "pcm", sr->sample_rates, MOCK_SR_TOKEN);
+            if (payload_len < 0) {
+                return ESP_FAIL;
+            }
+            _mock_wire_chunk(sr, payload_len);
+        }
+        payload_len = sr_base64_encode_update(&sr->b64, payload, (const uint8_t *)audio, len);
+        if (payload_len > 0) {
+            _mock_wire_chunk(sr, payload_len);
+        }
+        break;
+    case SR_MOCK_WIRE_XUNFEI:
+        for (int offset = 0; offset < len; offset += sr->frame_audio_max) {
+            int audio_len = len - offset < sr->frame_audio_max ? len - offset : sr->frame_audio_max;
+            xunfei_sr_frame_status_t status = sr->frames == 0 && offset == 0 ? XUNFEI_SR_FRAME_FIRST
+                                              : XUNFEI_SR_FRAME_CONTINUE;
+            int frame_len = xunfei_sr_proto_frame(sr->wire_buffer, sr->wire_size, status, MOCK_SR_APP_ID, sr->sample_rates,
+                                                  &sr->b64, (const unsigned char *)audio + offset, audio_len);
+            if (frame_len < 0) {
+                return ESP_FAIL;
+            }
+            sr->wire_bytes += frame_len;
+        }
+        break;
+    default:
+        break;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t _mock_wire_end(mock_sr_t *sr)
+{
+    char *payload = sr->wire_buffer + BAIDU_SR_PROTO_CHUNK_HEADER_MAX;
+    int payload_max = sr->wire_size - BAIDU_SR_PROTO_CHUNK_OVERHEAD;
+    switch (sr->wire) {
+    case SR_MOCK_WIRE_BAIDU_JSON: {
+        int tail_len = sr_base64_encode_finish(&sr->b64, payload);
+        int end_len = baidu_sr_proto_json_end(payload + tail_len, payload_max - tail_len, sr->sr_total_write);
+        if (end_len < 0) {
+            return ESP_FAIL;
+        }
+        _mock_wire_chunk(sr, tail_len + end_len);
+    }
+    /* Fall through */
+    case SR_MOCK_WIRE_BAIDU_RAW:
+        sr->wire_bytes += BAIDU_SR_PROTO_LAST_CHUNK_LEN;
+        break;
+    case SR_MOCK_WIRE_XUNFEI: {
+        int frame_len = xunfei_sr_proto_frame(sr->wire_buffer, sr->wire_size, XUNFEI_SR_FRAME_LAST, MOCK_SR_APP_ID,
+                                              sr->sample_rates, &sr->b64, NULL, 0);
+        if (frame_len < 0) {
+            return ESP_FAIL;
+        }
+        sr->wire_bytes += frame_len;
+        break;
+    }
+    default:
+        break;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t _mock_begin(void *ctx)
+{
+    mock_sr_t *sr = (mock_sr_t *)ctx;
+    sr->sr_total_write = 0;
+    sr->frames = 0;
+    sr->wire_bytes = 0;
+    sr_base64_reset(&sr->b64);
+    sr->cancelled = false;
+    sr->begin_time = esp_timer_get_time();
+    /* Nothing to connect to */
+    sr_latency_mark(sr->latency, SR_LATENCY_CONNECTED);
+    return ESP_OK;
+}
+
+static int _mock_frame(void *ctx, const char *audio, int len)
+{
+    mock_sr_t *sr = (mock_sr_t *)ctx;
+    if (sr->wire_buffer && _mock_wire_frame(sr, audio, len) != ESP_OK) {
+        ESP_LOGE(TAG, "Error frame %d bytes", len);
+        return ESP_FAIL;
+    }
+    sr->sr_total_write += len;
+    sr->frames++;
+    return len;
+}
+
+static esp_err_t _mock_end(void *ctx)
+{
+    mock_sr_t *sr = (mock_sr_t *)ctx;
+    char reply[MOCK_SR_REPLY_MAX];
+    int reply_len = snprintf(reply, sizeof(reply), MOCK_SR_REPLY, sr->text);
+    if (reply_len < 0 || reply_len >= sizeof(reply)) {
+        ESP_LOGE(TAG, "Mock text too long");
+        return ESP_FAIL;
+    }
+    if (sr->wire_buffer && _mock_wire_end(sr) != ESP_OK) {
+        ESP_LOGE(TAG, "Error frame the end of the utterance");
+        return ESP_FAIL;
+    }
+    for (int waited = 0; waited < sr->latency_ms && !sr->cancelled; waited += MOCK_SR_POLL_MS) {
+        vTaskDelay(MOCK_SR_POLL_MS / portTICK_PERIOD_MS);
+    }
+    if (sr->cancelled) {
+        return ESP_FAIL;
+    }
+    sr_latency_mark(sr->latency, SR_LATENCY_FIRST_REPLY);
+    int ret = SR_JSON_MORE;
+    for (int offset = 0; offset < reply_len && ret == SR_JSON_MORE; offset += MOCK_SR_READ_SIZE) {
+        int len = reply_len - offset < MOCK_SR_READ_SIZE ? reply_len - offset : MOCK_SR_READ_SIZE;
+        ret = _mock_parse(sr, reply + offset, len, offset == 0);
+    }
+    if (ret != SR_JSON_DONE || sr->err_no != 0) {
+        ESP_LOGE(TAG, "Invalid response");
+        return ESP_FAIL;
+    }
+    sr_result_publish(sr->result, true);
+    return ESP_OK;
+}
+
+static void _mock_cancel(void *ctx)
+{
+    mock_sr_t *sr = (mock_sr_t *)ctx;
+    sr->cancelled = true;
+}
+
+static void _mock_report(void *ctx)
+{
+    mock_sr_t *sr = (mock_sr_t *)ctx;
+    int bytes_per_ms = sr->sample_rates * 2 / 1000;
+    ESP_LOGI(TAG, "Took %d bytes (%d ms of audio) in %d frames, %d ms after the utterance began",
+             sr->sr_total_write, bytes_per_ms > 0 ? sr->sr_total_write / bytes_per_ms : 0, sr->frames,
+             (int)((esp_timer_get_time() - sr->begin_time) / 1000));
+}
+
+static int _mock_memory(void *ctx)
+{
+    mock_sr_t *sr = (mock_sr_t *)ctx;
+    return sr->wire_size;
+}
+
+static int _mock_wire_bytes(void *ctx)
+{
+    mock_sr_t *sr = (mock_sr_t *)ctx;
+    return sr->wire_buffer ? sr->wire_bytes : sr->sr_total_write;
+}
+
+static void _mock_destroy(void *ctx)
+{
+    mock_sr_t *sr = (mock_sr_t *)ctx;
+    free(sr->wire_buffer);
+    free(sr->text);
+    free(sr);
+}
+
+static void *_mock_create(const void *config, const sr_provider_env_t *env)
+{
+    const sr_provider_mock_config_t *cfg = (const sr_provider_mock_config_t *)config;
+    mock_sr_t *sr = calloc(1, sizeof(mock_sr_t));
+    AUDIO_MEM_CHECK(TAG, sr, return NULL);
+    sr->result = env->result;
+    sr->latency = env->latency;
+    sr->sample_rates = env->sample_rate;
+    sr->latency_ms = cfg ? cfg->latency_ms : 0;
+    sr->text = strdup(cfg && cfg->text ? cfg->text : "mock");
+    AUDIO_MEM_CHECK(TAG, sr->text, {
+        free(sr);
+        return NULL;
+    });
+    sr_json_init(&sr->json, _mock_on_response_value, sr);
+
+    sr->wire = cfg ? cfg->wire : SR_MOCK_WIRE_NONE;
+    if (sr->wire != SR_MOCK_WIRE_NONE) {
+        /* Largest of a raw chunk, a base64 chunk, the JSON prefix and a xunfei frame, sized as the real providers do */
+        sr->frame_audio_max = env->frame_max / 4 * 3;
+        int payload_max = SR_BASE64_ENCODE_MAX(env->frame_max) > BAIDU_SR_PROTO_JSON_BEGIN_MAX
+                          ? SR_BASE64_ENCODE_MAX(env->frame_max) : BAIDU_SR_PROTO_JSON_BEGIN_MAX;
+        sr->wire_size = payload_max + BAIDU_SR_PROTO_CHUNK_OVERHEAD;
+        if (sr->wire_size < XUNFEI_SR_PROTO_FRAME_MAX(sr->frame_audio_max)) {
+            sr->wire_size = XUNFEI_SR_PROTO_FRAME_MAX(sr->frame_audio_max);
+        }
+        sr->wire_buffer = malloc(sr->wire_size);
+        AUDIO_MEM_CHECK(TAG, sr->wire_buffer, {
+            _mock_destroy(sr);
+            return NULL;
+        });
+    }
+    return sr;
+}
+
+const sr_provider_t sr_provider_mock = {
+    .name = "mock",
+    .create = _mock_create,
+    .destroy = _mock_destroy,
+    .memory = _mock_memory,
+    .begin = _mock_begin,
+    .frame = _mock_frame,
+    .end = _mock_end,
+    .parse = _mock_parse,
+    .cancel = _mock_cancel,
+    .report = _mock_report,
+    .wire_bytes = _mock_wire_bytes,
+};
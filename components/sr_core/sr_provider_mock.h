@@ -0,0 +1,64 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _SR_PROVIDER_MOCK_H_
+#define _SR_PROVIDER_MOCK_H_
+
+#include "sr_provider.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * What the mock does with the audio before dropping it
+ */
+typedef enum {
+    SR_MOCK_WIRE_NONE = 0,              /*!< Only count it */
+    SR_MOCK_WIRE_BAIDU_RAW,             /*!< Frame it like sr_provider_baidu in raw mode, chunked PCM */
+    SR_MOCK_WIRE_BAIDU_JSON,            /*!< Like sr_provider_baidu in JSON mode, chunked JSON with base64 `speech` */
+    SR_MOCK_WIRE_XUNFEI,                /*!< Like sr_provider_xunfei, JSON text frames with base64 audio */
+} sr_mock_wire_t;
+
+/**
+ * Configuration of sr_provider_mock
+ *
+ * Nothing leaves the device: the audio is counted and dropped, and every
+ * utterance is answered with `text` after `latency_ms`, parsed from a
+ * Baidu-style reply. Gives the recording side a baseline without network
+ * jitter, against which the real providers can be compared. With `wire`
+ * set, the audio is first framed with the real providers' wire format, so
+ * the encoding cost and the bytes on the wire can be measured offline.
+ */
+typedef struct {
+   int latency_ms;                     /*!< Time between the end of the utterance and the reply */
+   const char *text;                   /*!< Recognized text of every utterance, "mock" if NULL. No quotes or backslashes */
+   sr_mock_wire_t wire;                /*!< Wire format to emulate */
+} sr_provider_mock_config_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
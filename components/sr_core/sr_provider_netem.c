@@ -0,0 +1,327 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "audio_error.h"
+#include "sr_provider_netem.h"
+
+static const char *TAG = "SR_NETEM";
+
+#define NETEM_SR_POLL_MS    (10)    /* Delays are slept in slices, to notice a cancel */
+
+static const sr_netem_step_t netem_good[] = {
+    { 60000, 2000, 30, 5, 0 },
+};
+
+/* Below the 256 kbit/s of 16 kHz PCM, the backlog grows while speaking */
+static const sr_netem_step_t netem_slow[] = {
+    { 60000, 200, 200, 50, 0 },
+};
+
+static const sr_netem_step_t netem_lossy[] = {
+    { 60000, 1000, 80, 40, 5 },
+};
+
+/* Wi-Fi with a neighbour: mostly fine, then a stall, then a lossy spell */
+static const sr_netem_step_t netem_bursty[] = {
+    { 8000, 2000, 40, 20, 0 },
+    { 1500, -1, 40, 20, 0 },
+    { 4000, 500, 150, 100, 10 },
+    { 3000, 2000, 40, 20, 0 },
+};
+
+#define NETEM_SCENARIO(name, steps) { name, steps, sizeof(steps) / sizeof(steps[0]) }
+
+static const sr_netem_scenario_t netem_scenarios[] = {
+    NETEM_SCENARIO("good", netem_good),
+    NETEM_SCENARIO("slow", netem_slow),
+    NETEM_SCENARIO("lossy", netem_lossy),
+    NETEM_SCENARIO("bursty", netem_bursty),
+};
+
+typedef struct {
+    int dropped;            /* Requests broken off */
+    int stalls;
+    int64_t delay_us;       /* Added by the emulation */
+} netem_sr_stats_t;
+
+typedef struct {
+    const sr_provider_t     *provider;
+    void                    *ctx;
+    const sr_netem_scenario_t *scenario;
+    int                     script_ms;          /* One round of the script */
+    int64_t                 script_start;
+    uint32_t                seed;
+    int64_t                 tx_free_time;       /* The emulated uplink is busy until then */
+    int                     wire_bytes;         /* Of the wrapped provider, as far as paced */
+    volatile bool           cancelled;
+    netem_sr_stats_t        stats;
+} netem_sr_t;
+
+const sr_netem_scenario_t *sr_netem_scenario_find(const char *name)
+{
+    for (int i = 0; i < sizeof(netem_scenarios) / sizeof(netem_scenarios[0]); i++) {
+        if (strcmp(netem_scenarios[i].name, name) == 0) {
+            return &netem_scenarios[i];
+        }
+    }
+    return NULL;
+}
+
+static uint32_t _netem_random(netem_sr_t *sr)
+{
+    sr->seed = sr->seed * 1664525 + 1013904223;
+    return sr->seed >> 8;
+}
+
+/* The step the script is at, and when it ends */
+static const sr_netem_step_t *_netem_step(netem_sr_t *sr, int64_t *step_end)
+{
+    int64_t now = esp_timer_get_time();
+    int t = (int)((now - sr->script_start) / 1000 % sr->script_ms);
+    int64_t round_start = now - t * 1000LL;
+    int offset = 0;
+    for (int i = 0; i < sr->scenario->step_count; i++) {
+        const sr_netem_step_t *step = &sr->scenario->steps[i];
+        offset += step->duration_ms;
+        if (t < offset) {
+            *step_end = round_start + offset * 1000LL;
+            return step;
+        }
+    }
+    *step_end = now;
+    return &sr->scenario->steps[sr->scenario->step_count - 1];
+}
+
+static void _netem_sleep_until(netem_sr_t *sr, int64_t until)
+{
+    int64_t start = esp_timer_get_time();
+    for (int64_t now = start; now < until && !sr->cancelled; now = esp_timer_get_time()) {
+        int ms = (int)((until - now) / 1000) + 1;
+        int ticks = (ms < NETEM_SR_POLL_MS ? ms : NETEM_SR_POLL_MS) / portTICK_PERIOD_MS;
+        vTaskDelay(ticks > 0 ? ticks : 1);
+    }
+    sr->stats.delay_us += esp_timer_get_time() - start;
+}
+
+/* A round trip, give or take the jitter */
+static void _netem_round_trip(netem_sr_t *sr, const sr_netem_step_t *step)
+{
+    int ms = step->rtt_ms;
+    if (step->jitter_ms > 0) {
+        ms += (int)(_netem_random(sr) % (2 * step->jitter_ms + 1)) - step->jitter_ms;
+    }
+    if (ms > 0) {
+        _netem_sleep_until(sr, esp_timer_get_time() + ms * 1000LL);
+    }
+}
+
+static bool _netem_lost(netem_sr_t *sr, const sr_netem_step_t *step)
+{
+    if (step->loss_permille <= 0 || _netem_random(sr) % 1000 >= step->loss_permille) {
+        return false;
+    }
+    sr->stats.dropped++;
+    return true;
+}
+
+static esp_err_t _netem_connect(void *ctx)
+{
+    netem_sr_t *sr = (netem_sr_t *)ctx;
+    if (sr->provider->connect == NULL) {
+        return ESP_OK;
+    }
+    int64_t step_end;
+    _netem_round_trip(sr, _netem_step(sr, &step_end));
+    return sr->provider->connect(sr->ctx);
+}
+
+static esp_err_t _netem_begin(void *ctx)
+{
+    netem_sr_t *sr = (netem_sr_t *)ctx;
+    sr->cancelled = false;
+    int64_t step_end;
+    const sr_netem_step_t *step = _netem_step(sr, &step_end);
+    _netem_round_trip(sr, step);
+    if (_netem_lost(sr, step)) {
+        ESP_LOGW(TAG, "Connection lost");
+        return ESP_FAIL;
+    }
+    esp_err_t ret = sr->provider->begin(sr->ctx);
+    sr->tx_free_time = esp_timer_get_time();
+    sr->wire_bytes = sr->provider->wire_bytes ? sr->provider->wire_bytes(sr->ctx) : 0;
+    return ret;
+}
+
+static int _netem_frame(void *ctx, const char *audio, int len)
+{
+    netem_sr_t *sr = (netem_sr_t *)ctx;
+    int64_t step_end;
+    const sr_netem_step_t *step = _netem_step(sr, &step_end);
+    if (step->bandwidth_kbps < 0) {
+        sr->stats.stalls++;
+        ESP_LOGW(TAG, "Uplink stalled for %d ms", (int)((step_end - esp_timer_get_time()) / 1000));
+        _netem_sleep_until(sr, step_end);
+        step = _netem_step(sr, &step_end);
+    }
+    if (sr->cancelled) {
+        return ESP_FAIL;
+    }
+    if (_netem_lost(sr, step)) {
+        ESP_LOGW(TAG, "Request broken off");
+        return ESP_FAIL;
+    }
+    int ret = sr->provider->frame(sr->ctx, audio, len);
+    /* What the frame put on the wire takes its time at the bandwidth of the step */
+    int wire_bytes = sr->provider->wire_bytes ? sr->provider->wire_bytes(sr->ctx) : sr->wire_bytes + len;
+    int sent = wire_bytes - sr->wire_bytes;
+    sr->wire_bytes = wire_bytes;
+    if (step->bandwidth_kbps > 0 && sent > 0) {
+        int64_t now = esp_timer_get_time();
+        if (sr->tx_free_time < now) {
+            sr->tx_free_time = now;
+        }
+        sr->tx_free_time += sent * 8000LL / step->bandwidth_kbps;
+        _netem_sleep_until(sr, sr->tx_free_time);
+    }
+    return ret;
+}
+
+static esp_err_t _netem_end(void *ctx)
+{
+    netem_sr_t *sr = (netem_sr_t *)ctx;
+    /* The uplink drains, then the reply takes a round trip */
+    _netem_sleep_until(sr, sr->tx_free_time);
+    int64_t step_end;
+    _netem_round_trip(sr, _netem_step(sr, &step_end));
+    return sr->provider->end(sr->ctx);
+}
+
+static int _netem_parse(void *ctx, const char *data, int len, bool first)
+{
+    netem_sr_t *sr = (netem_sr_t *)ctx;
+    return sr->provider->parse(sr->ctx, data, len, first);
+}
+
+static void _netem_cancel(void *ctx)
+{
+    netem_sr_t *sr = (netem_sr_t *)ctx;
+    sr->cancelled = true;
+    if (sr->provider->cancel) {
+        sr->provider->cancel(sr->ctx);
+    }
+}
+
+static esp_err_t _netem_set_credential(void *ctx, const char *credential)
+{
+    netem_sr_t *sr = (netem_sr_t *)ctx;
+    if (sr->provider->set_credential == NULL) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    return sr->provider->set_credential(sr->ctx, credential);
+}
+
+static void _netem_report(void *ctx)
+{
+    netem_sr_t *sr = (netem_sr_t *)ctx;
+    ESP_LOGI(TAG, "Scenario %s over %s: %d requests broken off, %d stalls, %d ms of delay added",
+             sr->scenario->name, sr->provider->name, sr->stats.dropped, sr->stats.stalls,
+             (int)(sr->stats.delay_us / 1000));
+    memset(&sr->stats, 0, sizeof(sr->stats));
+    if (sr->provider->report) {
+        sr->provider->report(sr->ctx);
+    }
+}
+
+static int _netem_wire_bytes(void *ctx)
+{
+    netem_sr_t *sr = (netem_sr_t *)ctx;
+    return sr->provider->wire_bytes ? sr->provider->wire_bytes(sr->ctx) : 0;
+}
+
+static int _netem_memory(void *ctx)
+{
+    netem_sr_t *sr = (netem_sr_t *)ctx;
+    return sr->provider->memory(sr->ctx);
+}
+
+static void _netem_destroy(void *ctx)
+{
+    netem_sr_t *sr = (netem_sr_t *)ctx;
+    if (sr->ctx) {
+        sr->provider->destroy(sr->ctx);
+    }
+    free(sr);
+}
+
+static void *_netem_create(const void *config, const sr_provider_env_t *env)
+{
+    const sr_provider_netem_config_t *cfg = (const sr_provider_netem_config_t *)config;
+    if (cfg->scenario == NULL || cfg->scenario->step_count <= 0) {
+        ESP_LOGE(TAG, "No scenario");
+        return NULL;
+    }
+    netem_sr_t *sr = calloc(1, sizeof(netem_sr_t));
+    AUDIO_MEM_CHECK(TAG, sr, return NULL);
+    sr->provider = cfg->provider;
+    sr->scenario = cfg->scenario;
+    for (int i = 0; i < sr->scenario->step_count; i++) {
+        sr->script_ms += sr->scenario->steps[i].duration_ms;
+    }
+    if (sr->script_ms <= 0) {
+        ESP_LOGE(TAG, "Scenario %s has no duration", sr->scenario->name);
+        free(sr);
+        return NULL;
+    }
+    sr->seed = cfg->seed ? cfg->seed : 1;
+    sr->ctx = sr->provider->create(cfg->config, env);
+    if (sr->ctx == NULL) {
+        ESP_LOGE(TAG, "Error create %s", sr->provider->name);
+        free(sr);
+        return NULL;
+    }
+    sr->script_start = esp_timer_get_time();
+    ESP_LOGI(TAG, "%s over a %s network", sr->provider->name, sr->scenario->name);
+    return sr;
+}
+
+const sr_provider_t sr_provider_netem = {
+    .name = "netem",
+    .create = _netem_create,
+    .destroy = _netem_destroy,
+    .memory = _netem_memory,
+    .connect = _netem_connect,
+    .begin = _netem_begin,
+    .frame = _netem_frame,
+    .end = _netem_end,
+    .parse = _netem_parse,
+    .cancel = _netem_cancel,
+    .set_credential = _netem_set_credential,
+    .report = _netem_report,
+    .wire_bytes = _netem_wire_bytes,
+};
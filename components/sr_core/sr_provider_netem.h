@@ -0,0 +1,84 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _SR_PROVIDER_NETEM_H_
+#define _SR_PROVIDER_NETEM_H_
+
+#include "sr_provider.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Network conditions for a while
+ */
+typedef struct {
+   int duration_ms;                    /*!< Of this step, the script loops */
+   int bandwidth_kbps;                 /*!< Uplink, 0 unlimited, < 0 stalled: `frame` blocks until the step is over */
+   int rtt_ms;                         /*!< Added before connecting and before the reply */
+   int jitter_ms;                      /*!< Spread of the added RTT, uniform */
+   int loss_permille;                  /*!< Chance that connecting or a frame breaks the request off */
+} sr_netem_step_t;
+
+/**
+ * A script of network conditions
+ */
+typedef struct {
+   const char *name;
+   const sr_netem_step_t *steps;
+   int step_count;
+} sr_netem_scenario_t;
+
+/**
+ * Configuration of sr_provider_netem
+ *
+ * Wraps another provider, usually sr_provider_mock with a `wire` format, and
+ * runs it as if over a bad network: the wire bytes of each frame are paced to
+ * the bandwidth, connecting and the reply wait for the round trip, stalls
+ * block the upload and lost frames break the request off. The script runs on
+ * from create, so its steps hit utterances at different points. Loss and
+ * jitter come from `seed`, the same seed gives the same run.
+ */
+typedef struct {
+   const sr_provider_t *provider;
+   const void *config;                 /*!< The provider's own configuration, only used during create */
+   const sr_netem_scenario_t *scenario;
+   uint32_t seed;                      /*!< 1 if 0 */
+} sr_provider_netem_config_t;
+
+/**
+ * @brief      Find a built-in scenario: "good", "slow", "lossy" or "bursty"
+ *
+ * @param[in]  name  The scenario name
+ *
+ * @return     The scenario, NULL if there is none of that name
+ */
+const sr_netem_scenario_t *sr_netem_scenario_find(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
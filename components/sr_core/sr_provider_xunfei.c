@@ -0,0 +1,641 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_idf_version.h"
+#include "esp_websocket_client.h"
+#include "audio_error.h"
+#include "sr_provider_xunfei.h"
+#include "xunfei_sr_proto.h"
+#include "xunfei_sr_auth.h"
+#include "sr_clock.h"
+#include "sr_json.h"
+
+static const char *TAG = "SR_XUNFEI";
+
+#define XUNFEI_SR_MAX_SENTENCES  (64)
+#define XUNFEI_SR_MESSAGE_MAX    (64)
+#define XUNFEI_SR_CONNECT_TIMEOUT_MS  (5000)
+#define XUNFEI_SR_SEND_TIMEOUT_MS     (2000)
+#define XUNFEI_SR_RESULT_TIMEOUT_MS   (5000)
+#define XUNFEI_SR_PROBE_URL_MAX       (128)
+#define WS_CONNECTED_BIT    BIT0
+#define WS_FINAL_BIT        BIT1
+#define WS_OPCODE_CONT      (0x00)
+#define WS_OPCODE_TEXT      (0x01)
+
+typedef struct {
+    sr_result_t             *result;            /* Transcript, the sentences kept so far in `sn` order */
+    sr_latency_t            *latency;
+    int                     sample_rates;
+    sr_base64_t             b64;
+    int                     sr_total_write;
+    int                     wire_bytes;         /* Frame payloads sent for the utterance */
+    bool                    is_begin;
+    volatile bool           cancelled;          /* Set by `cancel` from another task */
+    volatile bool           answered;           /* The status 2 reply or an error code came, WS_FINAL_BIT is also
+                                                   set on transport errors */
+    char                    *b64_buffer;
+    int                     frame_size;         /* b64_buffer, also the websocket buffer so a frame is never split */
+    int                     frame_audio_max;    /* Audio bytes that fit one frame */
+    char                    *app_id;
+    char                    *api_key;
+    char                    *api_secret;
+    char                    *endpoint;
+    esp_websocket_client_handle_t ws;
+    EventGroupHandle_t      ws_events;
+    SemaphoreHandle_t       ws_lock;            /* Orders the connect buffer flush against the writer */
+    char                    *pending;           /* Audio recorded while the websocket connects */
+    int                     pending_size;
+    int                     pending_len;
+    int64_t                 connect_start_time;
+    int                     connect_time_ms;
+    xunfei_sr_auth_t        auth;
+    int                     pending_hwm;
+    int                     frame_hwm;
+    int                     reply_hwm;
+    int                     sentence_offset[XUNFEI_SR_MAX_SENTENCES];   /* Indexed by `sn`, replaced on `pgs: rpl` */
+    int                     sentence_len[XUNFEI_SR_MAX_SENTENCES];
+    sr_json_t               json;               /* Reply tokenizer */
+    struct {
+        int                 code;
+        int                 status;
+        int                 sn;
+        int                 rg_from;
+        int                 rg_to;
+        char                pgs[4];
+        int                 pgs_len;
+        char                message[XUNFEI_SR_MESSAGE_MAX];
+        int                 message_len;
+    } reply;                                    /* Fields of the reply being received */
+    char                    *reply_text;        /* Words of the reply being received */
+    int                     reply_len;
+} xunfei_sr_t;
+
+/* Cut sentence `sn` out of the transcript */
+static void _ws_remove_sentence(xunfei_sr_t *sr, int sn)
+{
+    sr_result_t *result = sr->result;
+    int offset = sr->sentence_offset[sn];
+    int len = sr->sentence_len[sn];
+    if (len == 0) {
+        return;
+    }
+    memmove(result->text + offset, result->text + offset + len, result->len - offset - len + 1);
+    result->len -= len;
+    sr->sentence_len[sn] = 0;
+    for (int i = sn + 1; i < XUNFEI_SR_MAX_SENTENCES; i++) {
+        sr->sentence_offset[i] -= len;
+    }
+}
+
+/* Insert sentence `sn` after the sentences before it, the transcript stays in `sn` order */
+static void _ws_insert_sentence(xunfei_sr_t *sr, int sn, const char *text, int len)
+{
+    sr_result_t *result = sr->result;
+    int offset = 0;
+    for (int i = sn - 1; i >= 0; i--) {
+        if (sr->sentence_len[i]) {
+            offset = sr->sentence_offset[i] + sr->sentence_len[i];
+            break;
+        }
+    }
+    if (result->len + len > result->size - 1) {
+        ESP_LOGW(TAG, "Transcript longer than %d bytes, sentence %d dropped", result->size - 1, sn);
+        return;
+    }
+    memmove(result->text + offset + len, result->text + offset, result->len - offset + 1);
+    memcpy(result->text + offset, text, len);
+    result->len += len;
+    sr->sentence_offset[sn] = offset;
+    sr->sentence_len[sn] = len;
+    for (int i = sn + 1; i < XUNFEI_SR_MAX_SENTENCES; i++) {
+        sr->sentence_offset[i] += len;
+    }
+}
+
+/*
+ * One `/v2/iat` reply, tokenized as its fragments arrive:
+ * {"code":0,"data":{"status":1,"result":{"sn":2,"pgs":"rpl","rg":[1,1],"ws":[{"cw":[{"w":"..."}]}]}}}
+ * `ws` may come before `sn` and `pgs`, so the words are collected in reply_text first.
+ */
+static void _ws_on_reply_value(sr_json_t *json, sr_json_type_t type, const char *data, int len, bool done, void *user_data)
+{
+    xunfei_sr_t *sr = (xunfei_sr_t *)user_data;
+    if (type == SR_JSON_STRING) {
+        if (sr_json_path_is(json, "data.result.ws[].cw[0].w")) {
+            sr_json_append(sr->reply_text, sr->result->size, &sr->reply_len, data, len);
+        } else if (sr_json_path_is(json, "data.result.pgs")) {
+            sr_json_append(sr->reply.pgs, sizeof(sr->reply.pgs), &sr->reply.pgs_len, data, len);
+        } else if (sr_json_path_is(json, "message")) {
+            sr_json_append(sr->reply.message, sizeof(sr->reply.message), &sr->reply.message_len, data, len);
+        }
+    } else if (type == SR_JSON_NUMBER) {
+        if (sr_json_path_is(json, "code")) {
+            sr->reply.code = atoi(data);
+        } else if (sr_json_path_is(json, "data.status")) {
+            sr->reply.status = atoi(data);
+        } else if (sr_json_path_is(json, "data.result.sn")) {
+            sr->reply.sn = atoi(data);
+        } else if (sr_json_path_is(json, "data.result.rg[0]")) {
+            sr->reply.rg_from = atoi(data);
+        } else if (sr_json_path_is(json, "data.result.rg[1]")) {
+            sr->reply.rg_to = atoi(data);
+        }
+    }
+}
+
+static int _xunfei_parse(void *ctx, const char *data, int len, bool first)
+{
+    xunfei_sr_t *sr = (xunfei_sr_t *)ctx;
+    if (first) {
+        sr_json_reset(&sr->json);
+        memset(&sr->reply, 0, sizeof(sr->reply));
+        sr->reply.code = -1;
+        sr->reply.status = -1;
+        sr->reply.sn = -1;
+        sr->reply.rg_from = -1;
+        sr->reply.rg_to = -1;
+        sr->reply_len = 0;
+        sr->reply_text[0] = 0;
+    }
+    return sr_json_feed(&sr->json, data, len);
+}
+
+static void _ws_handle_reply(xunfei_sr_t *sr)
+{
+    if (sr->reply.code != 0) {
+        ESP_LOGE(TAG, "Recognition failed, code=%d, message=%s", sr->reply.code, sr->reply.message);
+        /* The service rejected the request, sending it again would not help */
+        sr->answered = true;
+        xEventGroupSetBits(sr->ws_events, WS_FINAL_BIT);
+        return;
+    }
+    bool is_final = sr->reply.status == XUNFEI_SR_FRAME_LAST;
+    int sn = sr->reply.sn;
+    if (sn >= 0 && sn < XUNFEI_SR_MAX_SENTENCES) {
+        if (strcmp(sr->reply.pgs, "rpl") == 0) {
+            for (int i = sr->reply.rg_from < 0 ? 0 : sr->reply.rg_from; i <= sr->reply.rg_to && i < XUNFEI_SR_MAX_SENTENCES; i++) {
+                _ws_remove_sentence(sr, i);
+            }
+        }
+        _ws_remove_sentence(sr, sn);
+        _ws_insert_sentence(sr, sn, sr->reply_text, sr->reply_len);
+        sr_result_publish(sr->result, is_final);
+    } else if (is_final && sr->result->valid) {
+        sr_result_publish(sr->result, true);
+    }
+    if (is_final) {
+        sr->answered = true;
+        xEventGroupSetBits(sr->ws_events, WS_FINAL_BIT);
+    }
+}
+
+static int _ws_send(xunfei_sr_t *sr, const char *data, int len)
+{
+#if defined(ESP_IDF_VERSION) && ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 2, 0)
+    int ret = esp_websocket_client_send_text(sr->ws, data, len, XUNFEI_SR_SEND_TIMEOUT_MS / portTICK_PERIOD_MS);
+#else
+    int ret = esp_websocket_client_send(sr->ws, data, len, XUNFEI_SR_SEND_TIMEOUT_MS / portTICK_PERIOD_MS);
+#endif
+    if (ret > 0) {
+        sr->wire_bytes += ret;
+    }
+    return ret;
+}
+
+/* Frame and send audio, split so that every frame fits b64_buffer. Called with ws_lock held */
+static esp_err_t _ws_send_audio(xunfei_sr_t *sr, const unsigned char *data, int len)
+{
+    while (len > 0) {
+        int frame_audio_len = len > sr->frame_audio_max ? sr->frame_audio_max : len;
+        //开始，中间和结束的数据包不一样
+        xunfei_sr_frame_status_t status = XUNFEI_SR_FRAME_CONTINUE;
+        if (sr->is_begin) {
+            sr->is_begin = false;
+            status = XUNFEI_SR_FRAME_FIRST;
+        }
+        //base64把3字节切成4份，每份6bit，余下的1-2个字节由编码器保留到下一次
+        int frame_len = xunfei_sr_proto_frame(sr->b64_buffer, sr->frame_size, status,
+                                              sr->app_id, sr->sample_rates, &sr->b64, data, frame_audio_len);
+        if (frame_len < 0) {
+            ESP_LOGE(TAG, "Error encode b64");
+            return ESP_FAIL;
+        }
+        if (frame_len > sr->frame_hwm) {
+            sr->frame_hwm = frame_len;
+        }
+        ESP_LOGD(TAG, "sr->b64_buffer1: %.*s", frame_len, sr->b64_buffer);
+        if (_ws_send(sr, sr->b64_buffer, frame_len) != frame_len) {
+            ESP_LOGE(TAG, "Error send audio frame");
+            return ESP_FAIL;
+        }
+        sr->sr_total_write += frame_audio_len;
+        data += frame_audio_len;
+        len -= frame_audio_len;
+    }
+    ESP_LOGD(TAG, "Total bytes written: %d", sr->sr_total_write);
+    return ESP_OK;
+}
+
+/* Send the audio captured during the handshake. Called with ws_lock held */
+static esp_err_t _ws_flush_pending(xunfei_sr_t *sr)
+{
+    if (sr->pending_len == 0) {
+        return ESP_OK;
+    }
+    ESP_LOGI(TAG, "Sending %d bytes recorded while connecting", sr->pending_len);
+    esp_err_t ret = _ws_send_audio(sr, (const unsigned char *)sr->pending, sr->pending_len);
+    sr->pending_len = 0;
+    return ret;
+}
+
+static void websocket_event_handler(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data)
+{
+    xunfei_sr_t *sr = (xunfei_sr_t *)handler_args;
+    esp_websocket_event_data_t *data = (esp_websocket_event_data_t *)event_data;
+    switch (event_id) {
+    case WEBSOCKET_EVENT_CONNECTED:
+        sr->connect_time_ms = (esp_timer_get_time() - sr->connect_start_time) / 1000;
+        ESP_LOGI(TAG, "WEBSOCKET_EVENT_CONNECTED, connect time %d ms", sr->connect_time_ms);
+        sr_latency_mark(sr->latency, SR_LATENCY_CONNECTED);
+        /* Flush before the bit is set, so the writer can not overtake the buffered audio */
+        xSemaphoreTake(sr->ws_lock, portMAX_DELAY);
+        if (_ws_flush_pending(sr) == ESP_OK) {
+            xEventGroupSetBits(sr->ws_events, WS_CONNECTED_BIT);
+        } else {
+            xEventGroupSetBits(sr->ws_events, WS_FINAL_BIT);
+        }
+        xSemaphoreGive(sr->ws_lock);
+        break;
+    case WEBSOCKET_EVENT_DISCONNECTED:
+        ESP_LOGI(TAG, "WEBSOCKET_EVENT_DISCONNECTED");
+        xEventGroupClearBits(sr->ws_events, WS_CONNECTED_BIT);
+        /* Nothing more will arrive for this utterance */
+        xEventGroupSetBits(sr->ws_events, WS_FINAL_BIT);
+        break;
+    case WEBSOCKET_EVENT_DATA:
+        ESP_LOGD(TAG, "Received opcode=%d, payload length=%d, data_len=%d, payload offset=%d",
+                 data->op_code, data->payload_len, data->data_len, data->payload_offset);
+        if ((data->op_code != WS_OPCODE_TEXT && data->op_code != WS_OPCODE_CONT) || data->data_len <= 0) {
+            break;
+        }
+        sr_latency_mark(sr->latency, SR_LATENCY_FIRST_REPLY);
+        /* A reply may come in several pieces, each one is tokenized as it arrives */
+        if (data->payload_len > sr->reply_hwm) {
+            sr->reply_hwm = data->payload_len;
+        }
+        ESP_LOGD(TAG, "Received=%.*s", data->data_len, data->data_ptr);
+        int ret = _xunfei_parse(sr, data->data_ptr, data->data_len, data->payload_offset == 0);
+        if (data->payload_offset + data->data_len < data->payload_len) {
+            break;
+        }
+        if (ret == SR_JSON_DONE) {
+            _ws_handle_reply(sr);
+        } else {
+            ESP_LOGE(TAG, "Invalid reply of %d bytes", data->payload_len);
+        }
+        break;
+    case WEBSOCKET_EVENT_ERROR:
+        ESP_LOGI(TAG, "WEBSOCKET_EVENT_ERROR");
+        break;
+    }
+}
+
+static void _ws_close(xunfei_sr_t *sr)
+{
+    if (sr->ws) {
+        esp_websocket_client_stop(sr->ws);
+        esp_websocket_client_destroy(sr->ws);
+        sr->ws = NULL;
+    }
+}
+
+/*
+ * The websocket client hides the handshake headers, so the `Date` of the
+ * endpoint host is read with a HEAD request over plain HTTP(S) instead.
+ */
+static void _xunfei_probe_clock(xunfei_sr_t *sr)
+{
+    const char *endpoint = sr->auth.endpoint;
+    const char *host = strstr(endpoint, "://");
+    char url[XUNFEI_SR_PROBE_URL_MAX];
+    if (host == NULL || strncmp(endpoint, "ws", 2) != 0) {
+        return;
+    }
+    host += 3;
+    snprintf(url, sizeof(url), "http%.*s%.*s/", (int)(host - endpoint - 2), endpoint + 2, (int)strcspn(host, "/"), host);
+    if (sr_clock_probe(url) == ESP_OK) {
+        ESP_LOGI(TAG, "Clock set from %s", url);
+    }
+}
+
+static esp_err_t _xunfei_begin(void *ctx)
+{
+    xunfei_sr_t *sr = (xunfei_sr_t *)ctx;
+    sr->sr_total_write = 0;
+    sr->wire_bytes = 0;
+    sr->is_begin = true;
+    sr->cancelled = false;
+    sr->answered = false;
+    sr_base64_reset(&sr->b64);
+    memset(sr->sentence_len, 0, sizeof(sr->sentence_len));
+    xEventGroupClearBits(sr->ws_events, WS_CONNECTED_BIT | WS_FINAL_BIT);
+    /* A session that ended on an error may have left it open */
+    _ws_close(sr);
+
+    if (!sr_clock_is_set()) {
+        _xunfei_probe_clock(sr);
+    }
+    if (sr_clock_wait(XUNFEI_SR_CONNECT_TIMEOUT_MS) != ESP_OK) {
+        ESP_LOGE(TAG, "Clock not set, can not sign the url");
+        return ESP_FAIL;
+    }
+    esp_websocket_client_config_t websocket_cfg = {
+        .uri = xunfei_sr_auth_url(&sr->auth, time(NULL)),
+        /* A frame bigger than this would be split into several websocket frames */
+        .buffer_size = sr->frame_size,
+    };
+    if (websocket_cfg.uri == NULL) {
+        ESP_LOGE(TAG, "Error sign url, APIKey too long");
+        return ESP_FAIL;
+    }
+    ESP_LOGD(TAG, "websocket_cfg.uri:%s", websocket_cfg.uri);
+    sr->ws = esp_websocket_client_init(&websocket_cfg);
+    AUDIO_MEM_CHECK(TAG, sr->ws, return ESP_FAIL);
+    esp_websocket_register_events(sr->ws, WEBSOCKET_EVENT_ANY, websocket_event_handler, (void *)sr);
+    sr->pending_len = 0;
+    sr->connect_time_ms = -1;
+    sr->connect_start_time = esp_timer_get_time();
+    /* Do not wait for the handshake, audio recorded meanwhile goes to the connect buffer */
+    if (esp_websocket_client_start(sr->ws) != ESP_OK) {
+        _ws_close(sr);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+/*
+ * The socket went away under a send: a reply the server sent before closing
+ * is handled ahead of the disconnect, so wait for that and see if it was
+ * the answer, a rejection most likely.
+ */
+static bool _xunfei_answered_on_close(xunfei_sr_t *sr)
+{
+    xEventGroupWaitBits(sr->ws_events, WS_FINAL_BIT, pdFALSE, pdTRUE, XUNFEI_SR_SEND_TIMEOUT_MS / portTICK_PERIOD_MS);
+    return sr->answered;
+}
+
+/*
+ * Send audio once the websocket is up, keep it in the connect buffer before.
+ * When that buffer is full, block until the handshake completes: the rest
+ * of the audio then waits in the audio ring instead of being dropped.
+ */
+static int _xunfei_frame(void *ctx, const char *audio, int len)
+{
+    xunfei_sr_t *sr = (xunfei_sr_t *)ctx;
+    if (sr->cancelled) {
+        return ESP_FAIL;
+    }
+    if (sr->answered) {
+        /* Rejected, the rest of the utterance goes nowhere */
+        return len;
+    }
+    xSemaphoreTake(sr->ws_lock, portMAX_DELAY);
+    EventBits_t bits = xEventGroupGetBits(sr->ws_events);
+    if ((bits & WS_CONNECTED_BIT) == 0) {
+        if (bits & WS_FINAL_BIT) {
+            xSemaphoreGive(sr->ws_lock);
+            if (sr->answered) {
+                return len;
+            }
+            ESP_LOGE(TAG, "Websocket closed before the end of the utterance");
+            return ESP_FAIL;
+        }
+        if (sr->pending_len + len <= sr->pending_size) {
+            memcpy(sr->pending + sr->pending_len, audio, len);
+            sr->pending_len += len;
+            if (sr->pending_len > sr->pending_hwm) {
+                sr->pending_hwm = sr->pending_len;
+            }
+            xSemaphoreGive(sr->ws_lock);
+            return len;
+        }
+        xSemaphoreGive(sr->ws_lock);
+        bits = xEventGroupWaitBits(sr->ws_events, WS_CONNECTED_BIT | WS_FINAL_BIT, pdFALSE, pdFALSE,
+                                   XUNFEI_SR_CONNECT_TIMEOUT_MS / portTICK_PERIOD_MS);
+        if ((bits & WS_CONNECTED_BIT) == 0) {
+            ESP_LOGE(TAG, "Websocket connect timeout");
+            return ESP_FAIL;
+        }
+        xSemaphoreTake(sr->ws_lock, portMAX_DELAY);
+    }
+    esp_err_t ret = _ws_send_audio(sr, (const unsigned char *)audio, len);
+    xSemaphoreGive(sr->ws_lock);
+    if (ret != ESP_OK && _xunfei_answered_on_close(sr)) {
+        return len;
+    }
+    return ret == ESP_OK ? len : ESP_FAIL;
+}
+
+static esp_err_t _xunfei_end(void *ctx)
+{
+    xunfei_sr_t *sr = (xunfei_sr_t *)ctx;
+    if (sr->ws == NULL) {
+        return ESP_OK;
+    }
+    /* A short utterance may be over before the handshake */
+    EventBits_t bits = xEventGroupWaitBits(sr->ws_events, WS_CONNECTED_BIT | WS_FINAL_BIT, pdFALSE, pdFALSE,
+                                           XUNFEI_SR_CONNECT_TIMEOUT_MS / portTICK_PERIOD_MS);
+    if (sr->answered) {
+        _ws_close(sr);
+        return ESP_OK;
+    }
+    if ((bits & WS_CONNECTED_BIT) == 0 || sr->cancelled) {
+        if (!sr->cancelled) {
+            ESP_LOGE(TAG, "Websocket connect timeout");
+        }
+        _ws_close(sr);
+        return ESP_FAIL;
+    }
+    xSemaphoreTake(sr->ws_lock, portMAX_DELAY);
+    if (_ws_flush_pending(sr) != ESP_OK || sr->is_begin) {
+        xSemaphoreGive(sr->ws_lock);
+        _ws_close(sr);
+        return sr->is_begin ? ESP_OK : ESP_FAIL;
+    }
+    int need_write = xunfei_sr_proto_frame(sr->b64_buffer, sr->frame_size, XUNFEI_SR_FRAME_LAST,
+                                           sr->app_id, sr->sample_rates, &sr->b64, NULL, 0);
+    if (need_write > 0) {
+        ESP_LOGD(TAG, "sr->b64_buffer2: %.*s", need_write, sr->b64_buffer);
+        if (_ws_send(sr, sr->b64_buffer, need_write) != need_write) {
+            need_write = ESP_FAIL;
+        }
+    }
+    xSemaphoreGive(sr->ws_lock);
+    if (need_write < 0) {
+        ESP_LOGE(TAG, "Error send last frame");
+        _ws_close(sr);
+        return ESP_FAIL;
+    }
+    /* Partial results keep arriving through sr_result_publish, wait for the last one */
+    if ((xEventGroupWaitBits(sr->ws_events, WS_FINAL_BIT, pdFALSE, pdTRUE,
+                             XUNFEI_SR_RESULT_TIMEOUT_MS / portTICK_PERIOD_MS) & WS_FINAL_BIT) == 0) {
+        ESP_LOGE(TAG, "No final result after %d ms", XUNFEI_SR_RESULT_TIMEOUT_MS);
+    } else if (!sr->answered && !sr->cancelled) {
+        ESP_LOGE(TAG, "Websocket closed before the final result");
+    }
+    _ws_close(sr);
+    /* A disconnect or a timeout is a transport error, the SR core may resend the utterance */
+    return sr->answered ? ESP_OK : ESP_FAIL;
+}
+
+/* Wakes up whatever `end` is waiting for, it then closes the websocket */
+static void _xunfei_cancel(void *ctx)
+{
+    xunfei_sr_t *sr = (xunfei_sr_t *)ctx;
+    sr->cancelled = true;
+    xEventGroupSetBits(sr->ws_events, WS_FINAL_BIT);
+}
+
+static int _xunfei_wire_bytes(void *ctx)
+{
+    xunfei_sr_t *sr = (xunfei_sr_t *)ctx;
+    return sr->wire_bytes;
+}
+
+static void _xunfei_report(void *ctx)
+{
+    xunfei_sr_t *sr = (xunfei_sr_t *)ctx;
+    ESP_LOGI(TAG, "Connect time %d ms", sr->connect_time_ms);
+    ESP_LOGI(TAG, "High-water marks: connect buffer %d/%d, frame %d/%d, largest reply %d bytes",
+             sr->pending_hwm, sr->pending_size, sr->frame_hwm, sr->frame_size, sr->reply_hwm);
+    sr->pending_hwm = 0;
+    sr->frame_hwm = 0;
+    sr->reply_hwm = 0;
+}
+
+static int _xunfei_memory(void *ctx)
+{
+    xunfei_sr_t *sr = (xunfei_sr_t *)ctx;
+    /* Reply, frame and connect buffers, plus the websocket client's own RX and TX buffers */
+    return sr->result->size + sr->frame_size + sr->pending_size + 2 * sr->frame_size;
+}
+
+static void _xunfei_destroy(void *ctx)
+{
+    xunfei_sr_t *sr = (xunfei_sr_t *)ctx;
+    _ws_close(sr);
+    if (sr->ws_events) {
+        vEventGroupDelete(sr->ws_events);
+    }
+    if (sr->ws_lock) {
+        vSemaphoreDelete(sr->ws_lock);
+    }
+    free(sr->pending);
+    free(sr->reply_text);
+    free(sr->b64_buffer);
+    free(sr->app_id);
+    free(sr->api_key);
+    free(sr->api_secret);
+    free(sr->endpoint);
+    free(sr);
+}
+
+static void *_xunfei_create(const void *config, const sr_provider_env_t *env)
+{
+    const sr_provider_xunfei_config_t *cfg = (const sr_provider_xunfei_config_t *)config;
+    if (env->format != SR_AUDIO_PCM) {
+        ESP_LOGE(TAG, "Only PCM audio is supported");
+        return NULL;
+    }
+    if (env->sample_rate != 8000 && env->sample_rate != 16000) {
+        ESP_LOGE(TAG, "Only 8000 and 16000 Hz audio is supported, got %d", env->sample_rate);
+        return NULL;
+    }
+    xunfei_sr_t *sr = calloc(1, sizeof(xunfei_sr_t));
+    AUDIO_MEM_CHECK(TAG, sr, return NULL);
+    sr->result = env->result;
+    sr->latency = env->latency;
+    sr->sample_rates = env->sample_rate;
+
+    if (strlen(cfg->app_id) > XUNFEI_SR_PROTO_APPID_MAX) {
+        ESP_LOGW(TAG, "APPID longer than %d bytes, the first frame may not fit", XUNFEI_SR_PROTO_APPID_MAX);
+    }
+    sr->app_id = strdup(cfg->app_id);
+    AUDIO_MEM_CHECK(TAG, sr->app_id, goto exit_xunfei_create);
+    sr->api_key = strdup(cfg->api_key);
+    AUDIO_MEM_CHECK(TAG, sr->api_key, goto exit_xunfei_create);
+    sr->api_secret = strdup(cfg->api_secret);
+    AUDIO_MEM_CHECK(TAG, sr->api_secret, goto exit_xunfei_create);
+    if (cfg->endpoint) {
+        sr->endpoint = strdup(cfg->endpoint);
+        AUDIO_MEM_CHECK(TAG, sr->endpoint, goto exit_xunfei_create);
+    }
+
+    sr->reply_text = calloc(1, sr->result->size);
+    AUDIO_MEM_CHECK(TAG, sr->reply_text, goto exit_xunfei_create);
+    sr_json_init(&sr->json, _ws_on_reply_value, sr);
+    sr->frame_audio_max = env->frame_max / 4 * 3;
+    sr->frame_size = XUNFEI_SR_PROTO_FRAME_MAX(sr->frame_audio_max);
+    sr->b64_buffer = malloc(sr->frame_size);//要添加附加的参数
+    AUDIO_MEM_CHECK(TAG, sr->b64_buffer, goto exit_xunfei_create);
+    sr->pending_size = cfg->connect_buffer_size;
+    if (sr->pending_size <= 0) {
+        sr->pending_size = SR_PROVIDER_XUNFEI_DEFAULT_CONNECT_BUFFER_SIZE;
+    }
+    sr->pending = malloc(sr->pending_size);
+    AUDIO_MEM_CHECK(TAG, sr->pending, goto exit_xunfei_create);
+    sr->ws_events = xEventGroupCreate();
+    AUDIO_MEM_CHECK(TAG, sr->ws_events, goto exit_xunfei_create);
+    sr->ws_lock = xSemaphoreCreateMutex();
+    AUDIO_MEM_CHECK(TAG, sr->ws_lock, goto exit_xunfei_create);
+    sr->connect_time_ms = -1;
+    xunfei_sr_auth_init(&sr->auth, sr->api_key, sr->api_secret);
+    xunfei_sr_auth_set_endpoint(&sr->auth, sr->endpoint);
+    return sr;
+exit_xunfei_create:
+    _xunfei_destroy(sr);
+    return NULL;
+}
+
+const sr_provider_t sr_provider_xunfei = {
+    .name = "xunfei",
+    .create = _xunfei_create,
+    .destroy = _xunfei_destroy,
+    .memory = _xunfei_memory,
+    .begin = _xunfei_begin,
+    .frame = _xunfei_frame,
+    .end = _xunfei_end,
+    .parse = _xunfei_parse,
+    .cancel = _xunfei_cancel,
+    .report = _xunfei_report,
+    .wire_bytes = _xunfei_wire_bytes,
+};
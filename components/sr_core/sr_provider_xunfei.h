@@ -0,0 +1,53 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _SR_PROVIDER_XUNFEI_H_
+#define _SR_PROVIDER_XUNFEI_H_
+
+#include "sr_provider.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SR_PROVIDER_XUNFEI_DEFAULT_CONNECT_BUFFER_SIZE (16*1024)
+
+/**
+ * Configuration of sr_provider_xunfei, the xfyun.cn `/v2/iat` websocket API
+ *
+ * The signed URL needs the wall clock, see sr_clock_init.
+ */
+typedef struct {
+   const char *app_id;
+   const char *api_key;
+   const char *api_secret;
+   const char *endpoint;               /*!< Websocket URL without query string, copied, the public `/v2/iat` endpoint if NULL */
+   int connect_buffer_size;            /*!< Audio kept while the websocket connects, SR_PROVIDER_XUNFEI_DEFAULT_CONNECT_BUFFER_SIZE if 0 */
+} sr_provider_xunfei_config_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
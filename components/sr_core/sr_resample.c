@@ -0,0 +1,179 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "sr_resample.h"
+
+#define SR_RESAMPLE_KAISER_BETA     (6.0)   /* About 60 dB of stopband */
+#define SR_RESAMPLE_TAPS_MIN        (8)
+
+static int _gcd(int a, int b)
+{
+    while (b) {
+        int r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+/* Phases, decimation and taps per phase, -1 for rates it can not convert */
+static int _sr_resample_shape(int in_rate, int out_rate, int *up, int *down, int *taps)
+{
+    if (in_rate <= 0 || out_rate <= 0) {
+        return -1;
+    }
+    int g = _gcd(in_rate, out_rate);
+    *up = out_rate / g;
+    *down = in_rate / g;
+    /* The filter spans the same time at the lower rate whatever the ratio */
+    *taps = SR_RESAMPLE_TAPS * ((*down + *up - 1) / *up);
+    if (*up * *taps > SR_RESAMPLE_COEFFS_MAX) {
+        *taps = SR_RESAMPLE_COEFFS_MAX / *up;
+    }
+    return *taps < SR_RESAMPLE_TAPS_MIN ? -1 : 0;
+}
+
+/* Modified Bessel function of the first kind, order 0 */
+static double _bessel_i0(double x)
+{
+    double sum = 1, term = 1;
+    for (int k = 1; k < 32 && term > 1e-10 * sum; k++) {
+        double f = x / (2 * k);
+        term *= f * f;
+        sum += term;
+    }
+    return sum;
+}
+
+/* Tap `k` of the prototype low-pass, `n` taps long */
+static double _sr_resample_tap(int k, int n, double cutoff, double i0_beta)
+{
+    double center = (n - 1) / 2.0;
+    double t = k - center;
+    double r = t / center;
+    double sinc = t == 0 ? 2 * cutoff : sin(2 * M_PI * cutoff * t) / (M_PI * t);
+    return sinc * _bessel_i0(SR_RESAMPLE_KAISER_BETA * sqrt(r * r < 1 ? 1 - r * r : 0)) / i0_beta;
+}
+
+/* Kaiser windowed sinc split into the phases, each scaled to unity gain in Q15 */
+static void _sr_resample_design(sr_resample_t *rs)
+{
+    int n = rs->up * rs->taps;
+    double nyquist = 0.5 / (rs->up > rs->down ? rs->up : rs->down);
+    /* Kaiser's estimate of the transition width, placed so the stopband starts at the lower Nyquist frequency */
+    double attenuation_db = SR_RESAMPLE_KAISER_BETA / 0.1102 + 8.7;
+    double cutoff = nyquist - (attenuation_db - 8) / 14.36 / n / 2;
+    double i0_beta = _bessel_i0(SR_RESAMPLE_KAISER_BETA);
+    if (cutoff < nyquist / 2) {
+        cutoff = nyquist / 2;
+    }
+    for (int p = 0; p < rs->up; p++) {
+        int16_t *c = rs->coeffs + p * rs->taps;
+        double sum = 0;
+        for (int j = 0; j < rs->taps; j++) {
+            sum += _sr_resample_tap(p + (rs->taps - 1 - j) * rs->up, n, cutoff, i0_beta);
+        }
+        int total = 0, peak = 0;
+        for (int j = 0; j < rs->taps; j++) {
+            long v = lround(_sr_resample_tap(p + (rs->taps - 1 - j) * rs->up, n, cutoff, i0_beta) / sum * 32768);
+            c[j] = (int16_t)(v > 32767 ? 32767 : v < -32768 ? -32768 : v);
+            total += c[j];
+            if (abs(c[j]) > abs(c[peak])) {
+                peak = j;
+            }
+        }
+        /* Rounding leftovers go to the largest tap, so DC passes at exactly unity */
+        int fixed = c[peak] + 32768 - total;
+        c[peak] = (int16_t)(fixed > 32767 ? 32767 : fixed);
+    }
+}
+
+int sr_resample_memory(int in_rate, int out_rate, int block)
+{
+    int up, down, taps;
+    if (_sr_resample_shape(in_rate, out_rate, &up, &down, &taps) != 0) {
+        return 0;
+    }
+    return (up * taps + taps - 1 + block) * sizeof(int16_t);
+}
+
+int sr_resample_init(sr_resample_t *rs, int in_rate, int out_rate, int block)
+{
+    memset(rs, 0, sizeof(sr_resample_t));
+    if (block <= 0 || _sr_resample_shape(in_rate, out_rate, &rs->up, &rs->down, &rs->taps) != 0) {
+        return -1;
+    }
+    rs->block = block;
+    rs->coeffs = malloc(rs->up * rs->taps * sizeof(int16_t));
+    rs->work = calloc(rs->taps - 1 + block, sizeof(int16_t));
+    if (rs->coeffs == NULL || rs->work == NULL) {
+        sr_resample_deinit(rs);
+        return -1;
+    }
+    _sr_resample_design(rs);
+    return 0;
+}
+
+void sr_resample_deinit(sr_resample_t *rs)
+{
+    free(rs->coeffs);
+    free(rs->work);
+    memset(rs, 0, sizeof(sr_resample_t));
+}
+
+void sr_resample_reset(sr_resample_t *rs)
+{
+    memset(rs->work, 0, (rs->taps - 1) * sizeof(int16_t));
+    rs->pos = 0;
+}
+
+int sr_resample_process(sr_resample_t *rs, const int16_t *in, int in_samples, int16_t *out)
+{
+    if (in_samples > rs->block) {
+        in_samples = rs->block;
+    }
+    int16_t *work = rs->work;
+    memcpy(work + rs->taps - 1, in, in_samples * sizeof(int16_t));
+    int end = in_samples * rs->up;
+    int count = 0;
+    int pos = rs->pos;
+    for (; pos < end; pos += rs->down) {
+        int i = pos / rs->up;
+        const int16_t *c = rs->coeffs + (pos - i * rs->up) * rs->taps;
+        const int16_t *x = work + i;
+        /* Each phase sums to 1.0, well within 32 bits for full scale input */
+        int32_t acc = 1 << 14;
+        for (int j = 0; j < rs->taps; j++) {
+            acc += c[j] * x[j];
+        }
+        acc >>= 15;
+        out[count++] = (int16_t)(acc > 32767 ? 32767 : acc < -32768 ? -32768 : acc);
+    }
+    rs->pos = pos - end;
+    memmove(work, work + in_samples, (rs->taps - 1) * sizeof(int16_t));
+    return count;
+}
@@ -0,0 +1,109 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _SR_RESAMPLE_H_
+#define _SR_RESAMPLE_H_
+
+/*
+ * Fixed-point polyphase resampler for 16-bit mono audio.
+ *
+ * The rates are reduced to a ratio up/down, and a Kaiser windowed sinc
+ * low-pass at the lower of the two Nyquist frequencies is split into `up`
+ * phases of `taps` Q15 coefficients each. Every output sample is one phase
+ * run over the newest `taps` input samples, so the cost is `taps` multiply
+ * adds per output sample whatever the ratio. The filter is designed once in
+ * floating point at init, the stream itself only uses integer arithmetic.
+ *
+ * Nothing in here depends on FreeRTOS or the audio pipeline, so it can be
+ * compiled and measured on a host as well as on target.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SR_RESAMPLE_TAPS            (32)    /*!< Taps per phase for a ratio of 2 or less, scaled with the decimation */
+#define SR_RESAMPLE_COEFFS_MAX      (8192)  /*!< Fewer taps for ratios with many phases, 44.1 to 16 kHz has 160 */
+
+typedef struct {
+    int16_t *coeffs;    /*!< `up` phases of `taps` coefficients, each in the order of the input it multiplies */
+    int16_t *work;      /*!< The last `taps - 1` input samples, then room for `block` more */
+    int     up;
+    int     down;
+    int     taps;
+    int     block;      /*!< Most input samples per sr_resample_process */
+    int     pos;        /*!< Next output in input samples times `up`, from the start of the next block */
+} sr_resample_t;
+
+/**
+ * @brief      Worst case output samples for `in_samples` input samples
+ */
+#define SR_RESAMPLE_OUT_MAX(rs, in_samples)  ((int)(((int64_t)(in_samples) * (rs)->up + (rs)->down - 1) / (rs)->down) + 1)
+
+/**
+ * @brief      Design the filter and allocate the buffers
+ *
+ * @param[in]  rs        The resampler
+ * @param[in]  in_rate   Input sample rate in Hz
+ * @param[in]  out_rate  Output sample rate in Hz
+ * @param[in]  block     Most input samples per sr_resample_process
+ *
+ * @return     0 on success, -1 if out of memory or the rates are invalid
+ */
+int sr_resample_init(sr_resample_t *rs, int in_rate, int out_rate, int block);
+
+/**
+ * @brief      Free the buffers
+ */
+void sr_resample_deinit(sr_resample_t *rs);
+
+/**
+ * @brief      Forget the input so far, the next output starts from silence
+ */
+void sr_resample_reset(sr_resample_t *rs);
+
+/**
+ * @brief      Bytes allocated by sr_resample_init with these parameters
+ */
+int sr_resample_memory(int in_rate, int out_rate, int block);
+
+/**
+ * @brief      Convert one block
+ *
+ * @param[in]  rs          The resampler
+ * @param[in]  in          Input samples
+ * @param[in]  in_samples  Number of input samples, at most `block`
+ * @param[out] out         Output, room for SR_RESAMPLE_OUT_MAX(rs, in_samples) samples
+ *
+ * @return     Number of output samples
+ */
+int sr_resample_process(sr_resample_t *rs, const int16_t *in, int in_samples, int16_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
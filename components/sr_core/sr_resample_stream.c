@@ -0,0 +1,144 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+#include "esp_log.h"
+#include "audio_error.h"
+#include "sr_resample.h"
+#include "sr_resample_stream.h"
+
+static const char *TAG = "SR_RESAMPLE_STREAM";
+
+#define SR_RESAMPLE_STREAM_TASK_STACK   (3*1024)
+#define SR_RESAMPLE_STREAM_BUFFER_LEN   (1024)
+
+typedef struct sr_resample_stream {
+    sr_resample_t   rs;
+    int16_t         *in;            /* An odd byte left from the last read, then the new input */
+    int16_t         *out;
+    int             carry_len;
+} sr_resample_stream_t;
+
+static esp_err_t _sr_resample_open(audio_element_handle_t self)
+{
+    sr_resample_stream_t *stream = (sr_resample_stream_t *)audio_element_getdata(self);
+    sr_resample_reset(&stream->rs);
+    stream->carry_len = 0;
+    return ESP_OK;
+}
+
+static int _sr_resample_process(audio_element_handle_t self, char *in_buffer, int in_len)
+{
+    sr_resample_stream_t *stream = (sr_resample_stream_t *)audio_element_getdata(self);
+    char *in = (char *)stream->in;
+    int r_size = audio_element_input(self, in + stream->carry_len, in_len);
+    if (r_size <= 0) {
+        return r_size;
+    }
+    int len = stream->carry_len + r_size;
+    int samples = len / 2;
+    int out_samples = sr_resample_process(&stream->rs, stream->in, samples, stream->out);
+    stream->carry_len = len % 2;
+    if (stream->carry_len) {
+        in[0] = in[len - 1];
+    }
+    if (out_samples == 0) {
+        return r_size;
+    }
+    int w_size = audio_element_output(self, (char *)stream->out, out_samples * 2);
+    return w_size > 0 ? r_size : w_size;
+}
+
+static esp_err_t _sr_resample_close(audio_element_handle_t self)
+{
+    return ESP_OK;
+}
+
+static esp_err_t _sr_resample_destroy(audio_element_handle_t self)
+{
+    sr_resample_stream_t *stream = (sr_resample_stream_t *)audio_element_getdata(self);
+    sr_resample_deinit(&stream->rs);
+    free(stream->in);
+    free(stream->out);
+    free(stream);
+    return ESP_OK;
+}
+
+static int _sr_resample_buffer_len(const sr_resample_stream_cfg_t *config)
+{
+    return config->buffer_len > 0 ? config->buffer_len : SR_RESAMPLE_STREAM_BUFFER_LEN;
+}
+
+int sr_resample_stream_memory(const sr_resample_stream_cfg_t *config)
+{
+    int buffer_len = _sr_resample_buffer_len(config);
+    int block = buffer_len / 2 + 1;
+    int out_max = ((int64_t)block * config->out_rate + config->in_rate - 1) / config->in_rate + 1;
+    /* The element's own read buffer, the input with its carry and the output */
+    return buffer_len + (block + out_max) * sizeof(int16_t)
+           + sr_resample_memory(config->in_rate, config->out_rate, block);
+}
+
+audio_element_handle_t sr_resample_stream_init(sr_resample_stream_cfg_t *config)
+{
+    int buffer_len = _sr_resample_buffer_len(config);
+    int block = buffer_len / 2 + 1;
+    sr_resample_stream_t *stream = calloc(1, sizeof(sr_resample_stream_t));
+    AUDIO_MEM_CHECK(TAG, stream, return NULL);
+    if (sr_resample_init(&stream->rs, config->in_rate, config->out_rate, block) != 0) {
+        ESP_LOGE(TAG, "Can not resample %d Hz to %d Hz", config->in_rate, config->out_rate);
+        free(stream);
+        return NULL;
+    }
+    stream->in = malloc(block * sizeof(int16_t));
+    AUDIO_MEM_CHECK(TAG, stream->in, goto exit_resample_init);
+    stream->out = malloc(SR_RESAMPLE_OUT_MAX(&stream->rs, block) * sizeof(int16_t));
+    AUDIO_MEM_CHECK(TAG, stream->out, goto exit_resample_init);
+
+    audio_element_cfg_t cfg = DEFAULT_AUDIO_ELEMENT_CONFIG();
+    cfg.open = _sr_resample_open;
+    cfg.process = _sr_resample_process;
+    cfg.close = _sr_resample_close;
+    cfg.destroy = _sr_resample_destroy;
+    cfg.task_stack = config->task_stack > 0 ? config->task_stack : SR_RESAMPLE_STREAM_TASK_STACK;
+    cfg.task_core = config->task_core;
+    cfg.task_prio = config->task_prio;
+    cfg.tag = "sr_resample";
+    cfg.buffer_len = buffer_len;
+    if (config->out_rb_size > 0) {
+        cfg.out_rb_size = config->out_rb_size;
+    }
+    audio_element_handle_t el = audio_element_init(&cfg);
+    AUDIO_MEM_CHECK(TAG, el, goto exit_resample_init);
+    audio_element_setdata(el, stream);
+    ESP_LOGI(TAG, "%d Hz to %d Hz, %d phases of %d taps", config->in_rate, config->out_rate, stream->rs.up,
+             stream->rs.taps);
+    return el;
+exit_resample_init:
+    sr_resample_deinit(&stream->rs);
+    free(stream->in);
+    free(stream->out);
+    free(stream);
+    return NULL;
+}
@@ -0,0 +1,70 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _SR_RESAMPLE_STREAM_H_
+#define _SR_RESAMPLE_STREAM_H_
+
+/*
+ * Filter element converting 16-bit mono audio between sample rates with
+ * sr_resample, so the codec can run at the rate it works best at while
+ * the recognizer gets the rate its service takes.
+ */
+
+#include "audio_element.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    int in_rate;            /*!< Input sample rate in Hz */
+    int out_rate;           /*!< Output sample rate in Hz */
+    int task_stack;         /*!< Element default if 0 */
+    int task_core;
+    int task_prio;
+    int buffer_len;         /*!< Input read per process call, element default if 0 */
+    int out_rb_size;        /*!< Output ring, element default if 0 */
+} sr_resample_stream_cfg_t;
+
+/**
+ * @brief      Create the resampler element
+ *
+ * @param      config  The element configuration
+ *
+ * @return     The audio element handle, NULL if out of memory or the rates can not be converted
+ */
+audio_element_handle_t sr_resample_stream_init(sr_resample_stream_cfg_t *config);
+
+/**
+ * @brief      Bytes the element allocates besides its task stack and output ring
+ *
+ * @param[in]  config  The element configuration
+ */
+int sr_resample_stream_memory(const sr_resample_stream_cfg_t *config);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
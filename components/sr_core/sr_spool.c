@@ -0,0 +1,463 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "audio_error.h"
+#include "sr_spool.h"
+
+static const char *TAG = "SR_SPOOL";
+
+#define SR_SPOOL_SECTOR_SIZE        (4096)
+#define SR_SPOOL_SECTOR_MAGIC       (0x4C505353)    /* "SSPL" */
+#define SR_SPOOL_RECORD_MAGIC       (0xA5)
+#define SR_SPOOL_PENDING            (0xFF)          /* Erased flash, cleared without an erase */
+#define SR_SPOOL_FORWARDED          (0x00)
+#define SR_SPOOL_PAD(len)           (((len) + 3) & ~3)
+#define SR_SPOOL_RECORD_MAX         (SR_SPOOL_SECTOR_SIZE - sizeof(spool_sector_t) - sizeof(spool_record_t))
+
+typedef enum {
+    SR_SPOOL_BEGIN = 1,
+    SR_SPOOL_DATA,
+    SR_SPOOL_END,
+} spool_record_type_t;
+
+typedef struct {
+    uint32_t    magic;
+    uint32_t    seq;                /* One more than the sector written before */
+} spool_sector_t;
+
+typedef struct {
+    uint8_t     magic;
+    uint8_t     type;
+    uint8_t     state;              /* BEGIN only, SR_SPOOL_PENDING until forwarded or dropped */
+    uint8_t     reserved;
+    uint16_t    len;                /* Payload bytes, padded to 4 in flash */
+    uint16_t    len_check;          /* ~len, tells a header torn by a reset */
+} spool_record_t;
+
+typedef struct sr_spool {
+    const esp_partition_t   *part;
+    int                     sectors;
+    SemaphoreHandle_t       lock;
+    bool                    head_valid;         /* A sector has been written */
+    int                     head_sector;
+    int                     head_offset;        /* Next record, SR_SPOOL_SECTOR_SIZE once the sector is done */
+    uint32_t                head_seq;
+    uint32_t                tail;               /* First record not forwarded yet, the head if none */
+    bool                    writing;
+    uint32_t                write_begin;        /* BEGIN of the utterance being written */
+    bool                    reading;
+    uint32_t                read_begin;
+    uint32_t                read_addr;          /* Record being read */
+    int                     read_offset;        /* Payload bytes of it returned so far */
+    int                     pending;
+} sr_spool_t;
+
+static uint32_t _spool_head(sr_spool_t *spool)
+{
+    return spool->head_valid ? spool->head_sector * SR_SPOOL_SECTOR_SIZE + spool->head_offset : 0;
+}
+
+static bool _spool_read_sector(sr_spool_t *spool, int sector, uint32_t *seq)
+{
+    spool_sector_t header;
+    if (esp_partition_read(spool->part, sector * SR_SPOOL_SECTOR_SIZE, &header, sizeof(header)) != ESP_OK
+        || header.magic != SR_SPOOL_SECTOR_MAGIC) {
+        return false;
+    }
+    *seq = header.seq;
+    return true;
+}
+
+static bool _spool_read_record(sr_spool_t *spool, uint32_t addr, spool_record_t *rec)
+{
+    int offset = addr % SR_SPOOL_SECTOR_SIZE;
+    if (offset == 0 || offset + sizeof(spool_record_t) > SR_SPOOL_SECTOR_SIZE
+        || esp_partition_read(spool->part, addr, rec, sizeof(spool_record_t)) != ESP_OK) {
+        return false;
+    }
+    return rec->magic == SR_SPOOL_RECORD_MAGIC && rec->len_check == (uint16_t)~rec->len
+           && offset + sizeof(spool_record_t) + SR_SPOOL_PAD(rec->len) <= SR_SPOOL_SECTOR_SIZE;
+}
+
+/*
+ * The record at `addr`, or the first one of the following sector if the
+ * sector ends there. `addr` may be the end of a sector, offset 0 of the next.
+ */
+static uint32_t _spool_settle(sr_spool_t *spool, uint32_t addr)
+{
+    uint32_t head = _spool_head(spool);
+    spool_record_t rec;
+    for (int hops = 0; hops <= spool->sectors; hops++) {
+        if (addr == head || _spool_read_record(spool, addr, &rec)) {
+            return addr;
+        }
+        int offset = addr % SR_SPOOL_SECTOR_SIZE;
+        int sector = offset == 0 ? addr / SR_SPOOL_SECTOR_SIZE - 1 : addr / SR_SPOOL_SECTOR_SIZE;
+        uint32_t seq, next_seq;
+        int next = (sector + 1) % spool->sectors;
+        if (!_spool_read_sector(spool, sector, &seq) || !_spool_read_sector(spool, next, &next_seq)
+            || next_seq != seq + 1) {
+            break;
+        }
+        addr = next * SR_SPOOL_SECTOR_SIZE + sizeof(spool_sector_t);
+    }
+    ESP_LOGW(TAG, "Log broken at 0x%x, dropping the rest", addr);
+    return head;
+}
+
+static uint32_t _spool_next(sr_spool_t *spool, uint32_t addr, const spool_record_t *rec)
+{
+    return _spool_settle(spool, addr + sizeof(spool_record_t) + SR_SPOOL_PAD(rec->len));
+}
+
+static esp_err_t _spool_set_state(sr_spool_t *spool, uint32_t addr, uint8_t state)
+{
+    return esp_partition_write(spool->part, addr + offsetof(spool_record_t, state), &state, 1);
+}
+
+/* Move the tail to the first BEGIN not forwarded yet */
+static void _spool_skip(sr_spool_t *spool)
+{
+    uint32_t head = _spool_head(spool);
+    spool_record_t rec;
+    while (spool->tail != head) {
+        if (!_spool_read_record(spool, spool->tail, &rec)) {
+            spool->tail = head;
+            break;
+        }
+        if (rec.type == SR_SPOOL_BEGIN && rec.state == SR_SPOOL_PENDING) {
+            break;
+        }
+        spool->tail = _spool_next(spool, spool->tail, &rec);
+    }
+}
+
+static esp_err_t _spool_next_sector(sr_spool_t *spool)
+{
+    bool empty = spool->tail == _spool_head(spool);
+    int next = spool->head_valid ? (spool->head_sector + 1) % spool->sectors : 0;
+    if (!empty && spool->tail / SR_SPOOL_SECTOR_SIZE == next) {
+        return ESP_ERR_NO_MEM;
+    }
+    spool_sector_t header = {
+        .magic = SR_SPOOL_SECTOR_MAGIC,
+        .seq = spool->head_valid ? spool->head_seq + 1 : 1,
+    };
+    if (esp_partition_erase_range(spool->part, next * SR_SPOOL_SECTOR_SIZE, SR_SPOOL_SECTOR_SIZE) != ESP_OK
+        || esp_partition_write(spool->part, next * SR_SPOOL_SECTOR_SIZE, &header, sizeof(header)) != ESP_OK) {
+        ESP_LOGE(TAG, "Error erase sector %d", next);
+        return ESP_FAIL;
+    }
+    spool->head_valid = true;
+    spool->head_sector = next;
+    spool->head_offset = sizeof(spool_sector_t);
+    spool->head_seq = header.seq;
+    if (empty) {
+        spool->tail = _spool_head(spool);
+    }
+    return ESP_OK;
+}
+
+/* The header goes first, so that a reset in the payload still leaves a record that can be skipped */
+static esp_err_t _spool_write_record(sr_spool_t *spool, uint8_t type, const void *data, int len)
+{
+    int need = sizeof(spool_record_t) + SR_SPOOL_PAD(len);
+    if (!spool->head_valid || spool->head_offset + need > SR_SPOOL_SECTOR_SIZE) {
+        esp_err_t ret = _spool_next_sector(spool);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+    spool_record_t rec = {
+        .magic = SR_SPOOL_RECORD_MAGIC,
+        .type = type,
+        .state = SR_SPOOL_PENDING,
+        .reserved = 0xFF,
+        .len = len,
+        .len_check = ~len,
+    };
+    uint32_t addr = _spool_head(spool);
+    if (esp_partition_write(spool->part, addr, &rec, sizeof(rec)) != ESP_OK
+        || (len > 0 && esp_partition_write(spool->part, addr + sizeof(rec), data, len) != ESP_OK)) {
+        ESP_LOGE(TAG, "Error write at 0x%x", addr);
+        spool->head_offset = SR_SPOOL_SECTOR_SIZE;
+        return ESP_FAIL;
+    }
+    spool->head_offset += need;
+    return ESP_OK;
+}
+
+/* Find the newest sector, walk back to the oldest one of the log, then to the head and the tail */
+static void _spool_mount(sr_spool_t *spool)
+{
+    int newest = -1;
+    uint32_t newest_seq = 0, seq;
+    for (int i = 0; i < spool->sectors; i++) {
+        if (_spool_read_sector(spool, i, &seq) && (newest < 0 || seq > newest_seq)) {
+            newest = i;
+            newest_seq = seq;
+        }
+    }
+    if (newest < 0) {
+        ESP_LOGI(TAG, "Empty, %d sectors", spool->sectors);
+        return;
+    }
+    int oldest = newest;
+    uint32_t oldest_seq = newest_seq;
+    for (int i = 1; i < spool->sectors; i++) {
+        int prev = (oldest + spool->sectors - 1) % spool->sectors;
+        if (!_spool_read_sector(spool, prev, &seq) || seq != oldest_seq - 1) {
+            break;
+        }
+        oldest = prev;
+        oldest_seq = seq;
+    }
+
+    spool_record_t rec;
+    int offset = sizeof(spool_sector_t);
+    while (offset + sizeof(rec) <= SR_SPOOL_SECTOR_SIZE) {
+        uint32_t addr = newest * SR_SPOOL_SECTOR_SIZE + offset;
+        if (_spool_read_record(spool, addr, &rec)) {
+            offset += sizeof(rec) + SR_SPOOL_PAD(rec.len);
+            continue;
+        }
+        /* Anything but erased flash is a torn header, the sector takes no more records */
+        uint8_t erased[sizeof(rec)];
+        memset(erased, 0xFF, sizeof(erased));
+        if (esp_partition_read(spool->part, addr, &rec, sizeof(rec)) != ESP_OK || memcmp(&rec, erased, sizeof(rec))) {
+            offset = SR_SPOOL_SECTOR_SIZE;
+        }
+        break;
+    }
+    spool->head_valid = true;
+    spool->head_sector = newest;
+    spool->head_offset = offset;
+    spool->head_seq = newest_seq;
+
+    spool->tail = _spool_settle(spool, oldest * SR_SPOOL_SECTOR_SIZE + sizeof(spool_sector_t));
+    _spool_skip(spool);
+    bool kept = false;
+    uint32_t head = _spool_head(spool);
+    for (uint32_t addr = spool->tail; addr != head && _spool_read_record(spool, addr, &rec);
+         addr = _spool_next(spool, addr, &rec)) {
+        if (rec.type == SR_SPOOL_BEGIN) {
+            kept = rec.state == SR_SPOOL_PENDING;
+        } else if (rec.type == SR_SPOOL_END && kept) {
+            spool->pending++;
+            kept = false;
+        }
+    }
+    ESP_LOGI(TAG, "Log in sectors %d..%d of %d, %d utterances kept", oldest, newest, spool->sectors, spool->pending);
+}
+
+sr_spool_handle_t sr_spool_init(const char *label)
+{
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, SR_SPOOL_PARTITION_SUBTYPE, label);
+    if (part == NULL) {
+        ESP_LOGE(TAG, "No spool partition \"%s\"", label);
+        return NULL;
+    }
+    if (part->size / SR_SPOOL_SECTOR_SIZE < 2) {
+        ESP_LOGE(TAG, "Partition \"%s\" too small", label);
+        return NULL;
+    }
+    sr_spool_t *spool = calloc(1, sizeof(sr_spool_t));
+    AUDIO_MEM_CHECK(TAG, spool, return NULL);
+    spool->part = part;
+    spool->sectors = part->size / SR_SPOOL_SECTOR_SIZE;
+    spool->lock = xSemaphoreCreateMutex();
+    AUDIO_MEM_CHECK(TAG, spool->lock, {
+        free(spool);
+        return NULL;
+    });
+    _spool_mount(spool);
+    return spool;
+}
+
+esp_err_t sr_spool_destroy(sr_spool_handle_t spool)
+{
+    if (spool == NULL) {
+        return ESP_FAIL;
+    }
+    vSemaphoreDelete(spool->lock);
+    free(spool);
+    return ESP_OK;
+}
+
+esp_err_t sr_spool_begin(sr_spool_handle_t spool, const sr_spool_meta_t *meta)
+{
+    xSemaphoreTake(spool->lock, portMAX_DELAY);
+    spool->writing = false;
+    esp_err_t ret = _spool_write_record(spool, SR_SPOOL_BEGIN, meta, sizeof(*meta));
+    if (ret == ESP_OK) {
+        spool->write_begin = _spool_head(spool) - sizeof(spool_record_t) - SR_SPOOL_PAD(sizeof(*meta));
+        spool->writing = true;
+    }
+    xSemaphoreGive(spool->lock);
+    return ret;
+}
+
+esp_err_t sr_spool_append(sr_spool_handle_t spool, const char *data, int len)
+{
+    esp_err_t ret = ESP_FAIL;
+    xSemaphoreTake(spool->lock, portMAX_DELAY);
+    if (spool->writing) {
+        ret = ESP_OK;
+        while (len > 0 && ret == ESP_OK) {
+            int chunk = len < SR_SPOOL_RECORD_MAX ? len : SR_SPOOL_RECORD_MAX;
+            ret = _spool_write_record(spool, SR_SPOOL_DATA, data, chunk);
+            data += chunk;
+            len -= chunk;
+        }
+        spool->writing = ret == ESP_OK;
+    }
+    xSemaphoreGive(spool->lock);
+    return ret;
+}
+
+esp_err_t sr_spool_end(sr_spool_handle_t spool, bool keep)
+{
+    esp_err_t ret = ESP_FAIL;
+    xSemaphoreTake(spool->lock, portMAX_DELAY);
+    if (spool->writing) {
+        spool->writing = false;
+        ret = _spool_write_record(spool, SR_SPOOL_END, NULL, 0);
+        if (ret == ESP_OK && keep) {
+            spool->pending++;
+        } else if (ret == ESP_OK) {
+            ret = _spool_set_state(spool, spool->write_begin, SR_SPOOL_FORWARDED);
+            _spool_skip(spool);
+        }
+    }
+    xSemaphoreGive(spool->lock);
+    return ret;
+}
+
+int sr_spool_pending(sr_spool_handle_t spool)
+{
+    return spool->pending;
+}
+
+esp_err_t sr_spool_open(sr_spool_handle_t spool, sr_spool_meta_t *meta)
+{
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    spool_record_t rec;
+    xSemaphoreTake(spool->lock, portMAX_DELAY);
+    spool->reading = false;
+    _spool_skip(spool);
+    uint32_t head = _spool_head(spool);
+    while (spool->tail != head && !(spool->writing && spool->tail == spool->write_begin)) {
+        /* Complete if an END comes before the next BEGIN */
+        bool complete = false;
+        uint32_t addr = spool->tail;
+        _spool_read_record(spool, addr, &rec);
+        while (1) {
+            addr = _spool_next(spool, addr, &rec);
+            if (addr == head || !_spool_read_record(spool, addr, &rec) || rec.type == SR_SPOOL_BEGIN) {
+                break;
+            }
+            if (rec.type == SR_SPOOL_END) {
+                complete = true;
+                break;
+            }
+        }
+        if (complete && esp_partition_read(spool->part, spool->tail + sizeof(rec), meta, sizeof(*meta)) == ESP_OK) {
+            spool->reading = true;
+            spool->read_begin = spool->tail;
+            _spool_read_record(spool, spool->tail, &rec);
+            spool->read_addr = _spool_next(spool, spool->tail, &rec);
+            spool->read_offset = 0;
+            ret = ESP_OK;
+            break;
+        }
+        ESP_LOGW(TAG, "Dropping an incomplete utterance");
+        _spool_set_state(spool, spool->tail, SR_SPOOL_FORWARDED);
+        _spool_skip(spool);
+    }
+    xSemaphoreGive(spool->lock);
+    return ret;
+}
+
+int sr_spool_read(sr_spool_handle_t spool, char *buffer, int size)
+{
+    int ret = ESP_FAIL;
+    spool_record_t rec;
+    xSemaphoreTake(spool->lock, portMAX_DELAY);
+    while (spool->reading && spool->read_addr != _spool_head(spool)
+           && _spool_read_record(spool, spool->read_addr, &rec)) {
+        if (rec.type == SR_SPOOL_END) {
+            ret = 0;
+            break;
+        }
+        if (rec.type != SR_SPOOL_DATA) {
+            break;
+        }
+        int len = rec.len - spool->read_offset;
+        if (len > size) {
+            len = size;
+        }
+        if (len > 0 && esp_partition_read(spool->part, spool->read_addr + sizeof(rec) + spool->read_offset,
+                                          buffer, len) != ESP_OK) {
+            break;
+        }
+        spool->read_offset += len;
+        if (spool->read_offset == rec.len) {
+            spool->read_addr = _spool_next(spool, spool->read_addr, &rec);
+            spool->read_offset = 0;
+        }
+        if (len > 0) {
+            ret = len;
+            break;
+        }
+    }
+    xSemaphoreGive(spool->lock);
+    return ret;
+}
+
+void sr_spool_close(sr_spool_handle_t spool)
+{
+    xSemaphoreTake(spool->lock, portMAX_DELAY);
+    spool->reading = false;
+    xSemaphoreGive(spool->lock);
+}
+
+esp_err_t sr_spool_done(sr_spool_handle_t spool)
+{
+    esp_err_t ret = ESP_FAIL;
+    xSemaphoreTake(spool->lock, portMAX_DELAY);
+    if (spool->reading) {
+        spool->reading = false;
+        ret = _spool_set_state(spool, spool->read_begin, SR_SPOOL_FORWARDED);
+        spool->pending--;
+        _spool_skip(spool);
+    }
+    xSemaphoreGive(spool->lock);
+    return ret;
+}
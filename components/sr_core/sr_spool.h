@@ -0,0 +1,180 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _SR_SPOOL_H_
+#define _SR_SPOOL_H_
+
+/*
+ * Utterances kept on a raw flash partition until a recognizer has taken them.
+ *
+ * The partition is a log of 4 KB sectors used round robin. Each sector
+ * starts with a sequence number, followed by length-prefixed records: a
+ * BEGIN record with the audio format, DATA records with the audio as it was
+ * handed to the provider, and an END record once the utterance is complete.
+ * Forwarding an utterance only clears a state byte in its BEGIN record, a
+ * sector is erased when the writer needs it again. After a reset the log is
+ * found again by its sector sequence numbers, utterances without END are
+ * dropped.
+ *
+ * One task may write and another read at the same time.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SR_SPOOL_PARTITION_SUBTYPE  (0x40)  /*!< Data partition subtype, see partitions.csv */
+
+typedef struct sr_spool* sr_spool_handle_t;
+
+/**
+ * Stored with every utterance
+ */
+typedef struct {
+    uint32_t    sample_rate;
+    uint8_t     format;             /*!< sr_audio_format_t */
+    uint8_t     reserved[3];
+    uint32_t    timestamp;          /*!< Unix time of the recording, 0 if the clock was not set */
+} sr_spool_meta_t;
+
+/**
+ * @brief      Open the spool partition and find the log in it
+ *
+ * @param[in]  label   Partition label
+ *
+ * @return     The spool, NULL if there is no such partition or it has fewer than two sectors
+ */
+sr_spool_handle_t sr_spool_init(const char *label);
+
+/**
+ * @brief      Close the spool, what is stored stays
+ *
+ * @param[in]  spool   The spool
+ *
+ * @return
+ *  - ESP_OK
+ *  - ESP_FAIL
+ */
+esp_err_t sr_spool_destroy(sr_spool_handle_t spool);
+
+/**
+ * @brief      Start storing an utterance, one left open is dropped
+ *
+ * @param[in]  spool   The spool
+ * @param[in]  meta    The audio format
+ *
+ * @return
+ *  - ESP_OK
+ *  - ESP_ERR_NO_MEM if the spool is full
+ *  - ESP_FAIL
+ */
+esp_err_t sr_spool_begin(sr_spool_handle_t spool, const sr_spool_meta_t *meta);
+
+/**
+ * @brief      Append audio to the utterance being stored
+ *
+ * After an error the utterance is dropped, later calls fail until the next sr_spool_begin.
+ *
+ * @param[in]  spool   The spool
+ * @param[in]  data    The audio
+ * @param[in]  len     Its length
+ *
+ * @return
+ *  - ESP_OK
+ *  - ESP_ERR_NO_MEM if the spool is full
+ *  - ESP_FAIL
+ */
+esp_err_t sr_spool_append(sr_spool_handle_t spool, const char *data, int len);
+
+/**
+ * @brief      Complete the utterance being stored
+ *
+ * @param[in]  spool   The spool
+ * @param[in]  keep    Keep it for sr_spool_open, false if it was recognized already
+ *
+ * @return
+ *  - ESP_OK
+ *  - ESP_FAIL
+ */
+esp_err_t sr_spool_end(sr_spool_handle_t spool, bool keep);
+
+/**
+ * @brief      Number of complete utterances kept
+ *
+ * @param[in]  spool   The spool
+ *
+ * @return     The count
+ */
+int sr_spool_pending(sr_spool_handle_t spool);
+
+/**
+ * @brief      Open the oldest complete utterance for reading
+ *
+ * @param[in]  spool   The spool
+ * @param[out] meta    Its audio format
+ *
+ * @return
+ *  - ESP_OK
+ *  - ESP_ERR_NOT_FOUND if none is kept
+ */
+esp_err_t sr_spool_open(sr_spool_handle_t spool, sr_spool_meta_t *meta);
+
+/**
+ * @brief      Read the next audio of the open utterance, as it was appended but at most `size` bytes
+ *
+ * @param[in]  spool   The spool
+ * @param[out] buffer  The audio
+ * @param[in]  size    Capacity of `buffer`
+ *
+ * @return     Bytes read, 0 at the end of the utterance, < 0 on error
+ */
+int sr_spool_read(sr_spool_handle_t spool, char *buffer, int size);
+
+/**
+ * @brief      Close the open utterance, the next sr_spool_open returns it again
+ *
+ * @param[in]  spool   The spool
+ */
+void sr_spool_close(sr_spool_handle_t spool);
+
+/**
+ * @brief      Close the open utterance and drop it from the spool
+ *
+ * @param[in]  spool   The spool
+ *
+ * @return
+ *  - ESP_OK
+ *  - ESP_FAIL
+ */
+esp_err_t sr_spool_done(sr_spool_handle_t spool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,143 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "sr_task_stats.h"
+
+static const char *TAG = "SR_TASK_STATS";
+
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+/* Snapshot of all tasks, NULL if out of memory. Sized with some slack for tasks created meanwhile */
+static TaskStatus_t *_sr_task_snapshot(int *count, uint32_t *total)
+{
+    int size = uxTaskGetNumberOfTasks() + 4;
+    TaskStatus_t *status = malloc(size * sizeof(TaskStatus_t));
+    if (status == NULL) {
+        ESP_LOGW(TAG, "No memory for %d task states", size);
+        return NULL;
+    }
+    *count = uxTaskGetSystemState(status, size, total);
+    return status;
+}
+#endif
+
+void sr_task_stats_begin(sr_task_stats_t *stats)
+{
+    stats->begin_count = 0;
+    stats->begin_total = 0;
+    stats->begin_us = esp_timer_get_time();
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+    int count = 0;
+    TaskStatus_t *status = _sr_task_snapshot(&count, &stats->begin_total);
+    if (status == NULL) {
+        return;
+    }
+    for (int i = 0; i < count && i < SR_TASK_STATS_MAX; i++) {
+        stats->begin_task[i] = status[i].xHandle;
+        stats->begin_runtime[i] = status[i].ulRunTimeCounter;
+    }
+    stats->begin_count = count < SR_TASK_STATS_MAX ? count : SR_TASK_STATS_MAX;
+    free(status);
+#endif
+}
+
+int sr_task_stats_end(sr_task_stats_t *stats)
+{
+    stats->count = 0;
+    stats->window_ms = (int)((esp_timer_get_time() - stats->begin_us) / 1000);
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+    int count = 0;
+    uint32_t total = 0;
+    TaskStatus_t *status = _sr_task_snapshot(&count, &total);
+    if (status == NULL) {
+        return 0;
+    }
+    /* Unsigned differences ride out one wrap of the run time counter */
+    uint32_t window = total - stats->begin_total;
+    if (count > SR_TASK_STATS_MAX) {
+        ESP_LOGW(TAG, "%d tasks, reporting %d", count, SR_TASK_STATS_MAX);
+        count = SR_TASK_STATS_MAX;
+    }
+    for (int i = 0; i < count; i++) {
+        sr_task_stat_t task = { 0 };
+        strncpy(task.name, status[i].pcTaskName, SR_TASK_STATS_NAME_LEN - 1);
+        task.core = -1;
+#if configTASKLIST_INCLUDE_COREID
+        if (status[i].xCoreID != tskNO_AFFINITY) {
+            task.core = status[i].xCoreID;
+        }
+#endif
+        task.prio = status[i].uxCurrentPriority;
+        task.stack_free = status[i].usStackHighWaterMark;
+        task.cpu_permille = -1;
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+        uint32_t runtime = status[i].ulRunTimeCounter;
+        for (int j = 0; j < stats->begin_count; j++) {
+            if (stats->begin_task[j] == status[i].xHandle) {
+                runtime -= stats->begin_runtime[j];
+                break;
+            }
+        }
+        task.cpu_permille = window > 0 ? (int)((uint64_t)runtime * 1000 / window) : 0;
+#endif
+        /* Insertion by CPU share, a few dozen tasks */
+        int at = stats->count;
+        while (at > 0 && stats->tasks[at - 1].cpu_permille < task.cpu_permille) {
+            stats->tasks[at] = stats->tasks[at - 1];
+            at--;
+        }
+        stats->tasks[at] = task;
+        stats->count++;
+    }
+    free(status);
+#else
+    ESP_LOGW(TAG, "Task stats need CONFIG_FREERTOS_USE_TRACE_FACILITY");
+#endif
+    return stats->count;
+}
+
+const sr_task_stat_t *sr_task_stats_find(const sr_task_stats_t *stats, const char *name)
+{
+    for (int i = 0; i < stats->count; i++) {
+        if (strncmp(stats->tasks[i].name, name, SR_TASK_STATS_NAME_LEN - 1) == 0) {
+            return &stats->tasks[i];
+        }
+    }
+    return NULL;
+}
+
+void sr_task_stats_dump(const sr_task_stats_t *stats, const char *label)
+{
+    printf("sr_tasks,label,task,core,prio,stack_free,cpu_permille,window_ms\n");
+    for (int i = 0; i < stats->count; i++) {
+        const sr_task_stat_t *task = &stats->tasks[i];
+        printf("sr_tasks,%s,%s,%d,%d,%d,%d,%d\n", label, task->name, task->core, task->prio,
+               task->stack_free, task->cpu_permille, stats->window_ms);
+    }
+}
@@ -0,0 +1,122 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _SR_TASK_STATS_H_
+#define _SR_TASK_STATS_H_
+
+/*
+ * Stack and CPU use of every task over a window, such as an utterance.
+ *
+ * The start of the window records each task's run time counter, its end
+ * reads them again along with the least stack left since the task was
+ * created. Tasks created during the window count from their creation.
+ * Needs CONFIG_FREERTOS_USE_TRACE_FACILITY, and for the CPU share
+ * CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS.
+ */
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SR_TASK_STATS_MAX       (32)    /*!< Tasks beyond this are left out of a report */
+#define SR_TASK_STATS_NAME_LEN  (16)
+
+/**
+ * One task over the window
+ */
+typedef struct {
+    char name[SR_TASK_STATS_NAME_LEN];
+    int core;               /*!< Core the task is pinned to, -1 if it runs on either */
+    int prio;               /*!< Current priority */
+    int stack_free;         /*!< Least stack left since the task was created, in bytes */
+    int cpu_permille;       /*!< Time it ran, in 1/1000 of one core over the window, -1 without run time stats */
+} sr_task_stat_t;
+
+/**
+ * Where one task of the recognizer runs
+ */
+typedef struct {
+    int stack;              /*!< Stack size in bytes */
+    int core;               /*!< Core it is pinned to, 0 or 1, tskNO_AFFINITY for either */
+    int prio;               /*!< FreeRTOS priority */
+} sr_task_place_t;
+
+/**
+ * Window and its last report
+ */
+typedef struct {
+    int count;                                      /*!< Tasks in `tasks` */
+    int window_ms;
+    sr_task_stat_t tasks[SR_TASK_STATS_MAX];
+    /* Taken at the start of the window */
+    int begin_count;
+    TaskHandle_t begin_task[SR_TASK_STATS_MAX];
+    uint32_t begin_runtime[SR_TASK_STATS_MAX];
+    uint32_t begin_total;
+    int64_t begin_us;
+} sr_task_stats_t;
+
+/**
+ * @brief      Start a window
+ *
+ * @param      stats  The stats
+ */
+void sr_task_stats_begin(sr_task_stats_t *stats);
+
+/**
+ * @brief      End the window and fill `tasks`, highest CPU share first
+ *
+ * @param      stats  The stats
+ *
+ * @return     Tasks reported, 0 without CONFIG_FREERTOS_USE_TRACE_FACILITY
+ */
+int sr_task_stats_end(sr_task_stats_t *stats);
+
+/**
+ * @brief      Find a task of the last report
+ *
+ * @param[in]  stats  The stats
+ * @param[in]  name   The task name
+ *
+ * @return     The task, NULL if it was not running
+ */
+const sr_task_stat_t *sr_task_stats_find(const sr_task_stats_t *stats, const char *name);
+
+/**
+ * @brief      Print the last report to the console UART as "sr_tasks" CSV lines
+ *
+ * @param[in]  stats  The stats
+ * @param[in]  label  First column, such as the provider name
+ */
+void sr_task_stats_dump(const sr_task_stats_t *stats, const char *label);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
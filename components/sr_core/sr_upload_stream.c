@@ -0,0 +1,211 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "esp_log.h"
+#include "audio_error.h"
+#include "sr_upload_stream.h"
+
+static const char *TAG = "SR_UPLOAD_STREAM";
+
+#define SR_UPLOAD_STREAM_TASK_STACK   (6*1024)
+#define SR_UPLOAD_STREAM_IDLE_POLL_MS (20)      /* How often an idle warm element looks for a finish request */
+#define SR_UPLOAD_FINISHED_BIT        BIT0
+
+typedef struct sr_upload_stream {
+    sr_upload_event_handle_t    hook;
+    void                        *user_data;
+    bool                        warm;
+    volatile bool               finish_pending;
+    bool                        failed;         /* The current warm utterance failed, its audio is dropped */
+    bool                        is_open;        /* An utterance is in progress */
+    EventGroupHandle_t          events;
+} sr_upload_stream_t;
+
+static int _dispatch_event(audio_element_handle_t el, sr_upload_stream_t *upload, sr_upload_event_id_t type, char *buffer, int buffer_len)
+{
+    sr_upload_event_msg_t msg = {
+        .event_id = type,
+        .buffer = buffer,
+        .buffer_len = buffer_len,
+        .user_data = upload->user_data,
+        .el = el,
+    };
+    if (upload->hook) {
+        return upload->hook(&msg);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t _sr_upload_begin(audio_element_handle_t self, sr_upload_stream_t *upload)
+{
+    if (_dispatch_event(self, upload, SR_UPLOAD_BEGIN, NULL, 0) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to begin the utterance");
+        return ESP_FAIL;
+    }
+    upload->is_open = true;
+    return ESP_OK;
+}
+
+static void _sr_upload_end(audio_element_handle_t self, sr_upload_stream_t *upload)
+{
+    if (!upload->is_open) {
+        return;
+    }
+    upload->is_open = false;
+    _dispatch_event(self, upload, SR_UPLOAD_END, NULL, 0);
+}
+
+static esp_err_t _sr_upload_open(audio_element_handle_t self)
+{
+    sr_upload_stream_t *upload = (sr_upload_stream_t *)audio_element_getdata(self);
+    if (upload->warm) {
+        /* Utterances follow the sessions, not the pipeline */
+        return ESP_OK;
+    }
+    return _sr_upload_begin(self, upload);
+}
+
+/* Warm mode: the utterance begins with its first audio */
+static int _sr_upload_process_warm(audio_element_handle_t self, sr_upload_stream_t *upload, char *in_buffer, int r_size)
+{
+    if (r_size > 0) {
+        if (!upload->is_open && !upload->failed && _sr_upload_begin(self, upload) != ESP_OK) {
+            upload->failed = true;
+        }
+        if (upload->is_open && _dispatch_event(self, upload, SR_UPLOAD_DATA, in_buffer, r_size) <= 0) {
+            ESP_LOGE(TAG, "Failed to write audio data, dropping the rest of the utterance");
+            _sr_upload_end(self, upload);
+            upload->failed = true;
+        }
+        return r_size;
+    }
+    /* Input drained after sr_upload_stream_finish, every byte of the session has been handed over */
+    if (r_size == AEL_IO_TIMEOUT && upload->finish_pending) {
+        _sr_upload_end(self, upload);
+        upload->failed = false;
+        upload->finish_pending = false;
+        xEventGroupSetBits(upload->events, SR_UPLOAD_FINISHED_BIT);
+    }
+    return r_size;
+}
+
+static int _sr_upload_process(audio_element_handle_t self, char *in_buffer, int in_len)
+{
+    sr_upload_stream_t *upload = (sr_upload_stream_t *)audio_element_getdata(self);
+    int r_size = audio_element_input(self, in_buffer, in_len);
+    if (upload->warm) {
+        return _sr_upload_process_warm(self, upload, in_buffer, r_size);
+    }
+    if (r_size <= 0) {
+        return r_size;
+    }
+    if (_dispatch_event(self, upload, SR_UPLOAD_DATA, in_buffer, r_size) <= 0) {
+        ESP_LOGE(TAG, "Failed to write audio data");
+        return AEL_IO_FAIL;
+    }
+    return r_size;
+}
+
+static esp_err_t _sr_upload_close(audio_element_handle_t self)
+{
+    sr_upload_stream_t *upload = (sr_upload_stream_t *)audio_element_getdata(self);
+    _sr_upload_end(self, upload);
+    if (upload->finish_pending) {
+        upload->finish_pending = false;
+        xEventGroupSetBits(upload->events, SR_UPLOAD_FINISHED_BIT);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t _sr_upload_destroy(audio_element_handle_t self)
+{
+    sr_upload_stream_t *upload = (sr_upload_stream_t *)audio_element_getdata(self);
+    if (upload->events) {
+        vEventGroupDelete(upload->events);
+    }
+    free(upload);
+    return ESP_OK;
+}
+
+audio_element_handle_t sr_upload_stream_init(sr_upload_stream_cfg_t *config)
+{
+    sr_upload_stream_t *upload = calloc(1, sizeof(sr_upload_stream_t));
+    AUDIO_MEM_CHECK(TAG, upload, return NULL);
+    upload->hook = config->event_handle;
+    upload->user_data = config->user_data;
+    upload->warm = config->warm;
+    upload->events = xEventGroupCreate();
+    AUDIO_MEM_CHECK(TAG, upload->events, {
+        free(upload);
+        return NULL;
+    });
+
+    audio_element_cfg_t cfg = DEFAULT_AUDIO_ELEMENT_CONFIG();
+    cfg.open = _sr_upload_open;
+    cfg.process = _sr_upload_process;
+    cfg.close = _sr_upload_close;
+    cfg.destroy = _sr_upload_destroy;
+    cfg.task_stack = config->task_stack > 0 ? config->task_stack : SR_UPLOAD_STREAM_TASK_STACK;
+    cfg.task_core = config->task_core;
+    cfg.task_prio = config->task_prio;
+    cfg.tag = "sr_upload";
+    if (config->buffer_len > 0) {
+        cfg.buffer_len = config->buffer_len;
+    }
+    audio_element_handle_t el = audio_element_init(&cfg);
+    AUDIO_MEM_CHECK(TAG, el, {
+        vEventGroupDelete(upload->events);
+        free(upload);
+        return NULL;
+    });
+    audio_element_setdata(el, upload);
+    if (upload->warm) {
+        audio_element_set_input_timeout(el, SR_UPLOAD_STREAM_IDLE_POLL_MS / portTICK_PERIOD_MS);
+    }
+    return el;
+}
+
+esp_err_t sr_upload_stream_finish(audio_element_handle_t el)
+{
+    sr_upload_stream_t *upload = (sr_upload_stream_t *)audio_element_getdata(el);
+    if (!upload->warm) {
+        return ESP_FAIL;
+    }
+    xEventGroupClearBits(upload->events, SR_UPLOAD_FINISHED_BIT);
+    upload->finish_pending = true;
+    return ESP_OK;
+}
+
+esp_err_t sr_upload_stream_wait_finished(audio_element_handle_t el, int timeout_ms)
+{
+    sr_upload_stream_t *upload = (sr_upload_stream_t *)audio_element_getdata(el);
+    if (xEventGroupWaitBits(upload->events, SR_UPLOAD_FINISHED_BIT, pdTRUE, pdTRUE, timeout_ms / portTICK_PERIOD_MS)
+            & SR_UPLOAD_FINISHED_BIT) {
+        return ESP_OK;
+    }
+    return ESP_ERR_TIMEOUT;
+}
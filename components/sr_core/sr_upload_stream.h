@@ -0,0 +1,114 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _SR_UPLOAD_STREAM_H_
+#define _SR_UPLOAD_STREAM_H_
+
+/*
+ * Writer element at the end of the recognizer pipeline.
+ *
+ * It knows nothing about the wire protocol: every utterance is one BEGIN,
+ * any number of DATA and one END event raised to the handler, which passes
+ * them on to the recognizer provider. In warm mode the element keeps running
+ * between utterances; an utterance begins with the first data and ends on
+ * sr_upload_stream_finish once everything written so far has been handed over.
+ */
+
+#include <stdbool.h>
+#include "audio_element.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    SR_UPLOAD_BEGIN = 0,    /*!< An utterance starts, ESP_OK or the utterance is dropped */
+    SR_UPLOAD_DATA,         /*!< Audio in `buffer`, return the bytes consumed, <= 0 drops the rest of the utterance */
+    SR_UPLOAD_END,          /*!< All audio of the utterance has been handed over */
+} sr_upload_event_id_t;
+
+typedef struct {
+    sr_upload_event_id_t    event_id;
+    char                    *buffer;
+    int                     buffer_len;
+    void                    *user_data;
+    audio_element_handle_t  el;
+} sr_upload_event_msg_t;
+
+typedef int (*sr_upload_event_handle_t)(sr_upload_event_msg_t *msg);
+
+typedef struct {
+    sr_upload_event_handle_t    event_handle;
+    void                        *user_data;     /*!< Passed in `msg->user_data` */
+    int                         task_stack;
+    int                         task_core;
+    int                         task_prio;
+    int                         buffer_len;     /*!< Largest block raised with SR_UPLOAD_DATA, element default if 0 */
+    bool                        warm;           /*!< Stay running between utterances, see sr_upload_stream_finish */
+} sr_upload_stream_cfg_t;
+
+/**
+ * @brief      Create the writer element
+ *
+ * @param      config  The element configuration
+ *
+ * @return     The audio element handle
+ */
+audio_element_handle_t sr_upload_stream_init(sr_upload_stream_cfg_t *config);
+
+/**
+ * @brief      Warm mode: end the current utterance once all data written so far has been handed over
+ *
+ * Call it after the last write of the session into the element's input.
+ * Does not block, see sr_upload_stream_wait_finished.
+ *
+ * @param[in]  el   The element
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_FAIL if the element is not warm
+ */
+esp_err_t sr_upload_stream_finish(audio_element_handle_t el);
+
+/**
+ * @brief      Wait until the utterance ended by sr_upload_stream_finish got its SR_UPLOAD_END
+ *
+ * Each finish is reported once: a successful wait consumes it. After a
+ * timeout, wait again before the next session writes, or its audio would
+ * join the unfinished utterance.
+ *
+ * @param[in]  el          The element
+ * @param[in]  timeout_ms  Maximum time to wait
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_ERR_TIMEOUT
+ */
+esp_err_t sr_upload_stream_wait_finished(audio_element_handle_t el, int timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,126 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "crypto/includes.h"
+#include "crypto/common.h"
+#include "crypto/sha256.h"
+#include "sr_base64.h"
+#include "xunfei_sr_proto.h"
+#include "xunfei_sr_auth.h"
+
+#define AUTH_URL_AUTHORIZATION  "?authorization="
+#define AUTH_URL_DATE           "&date="
+#define AUTH_URL_HOST           "&host=" XUNFEI_SR_AUTH_HOST
+#define AUTH_SIGN_HOST          "host: " XUNFEI_SR_AUTH_HOST "\ndate: "
+#define AUTH_SIGN_REQUEST_LINE  "\nGET " XUNFEI_SR_AUTH_PATH " HTTP/1.1"
+#define AUTH_ORIGIN_KEY         "api_key=\""
+#define AUTH_ORIGIN_SIGNATURE   "\", algorithm=\"hmac-sha256\", headers=\"host date request-line\", signature=\""
+#define AUTH_ORIGIN_END         "\""
+#define AUTH_DATE_MAX           (32)
+
+void xunfei_sr_auth_init(xunfei_sr_auth_t *auth, const char *api_key, const char *api_secret)
+{
+    memset(auth, 0, sizeof(xunfei_sr_auth_t));
+    auth->api_key = api_key;
+    auth->api_secret = api_secret;
+    auth->endpoint = XUNFEI_SR_AUTH_ENDPOINT;
+    auth->date = (time_t) -1;
+}
+
+void xunfei_sr_auth_set_endpoint(xunfei_sr_auth_t *auth, const char *endpoint)
+{
+    auth->endpoint = endpoint ? endpoint : XUNFEI_SR_AUTH_ENDPOINT;
+    auth->date = (time_t) -1;
+    auth->url_len = 0;
+}
+
+/* Feed one piece of the authorization origin to the encoder, checking the room left in the url */
+static int _auth_encode(sr_base64_t *b64, char *url, int pos, const void *in, int len)
+{
+    if (pos < 0 || pos + SR_BASE64_ENCODE_MAX(len) > XUNFEI_SR_AUTH_URL_MAX) {
+        return -1;
+    }
+    return pos + sr_base64_encode_update(b64, url + pos, (const uint8_t *)in, len);
+}
+
+const char *xunfei_sr_auth_url(xunfei_sr_auth_t *auth, time_t now)
+{
+    if (auth->date == now && auth->url_len > 0) {
+        return auth->url;
+    }
+    auth->date = (time_t) -1;
+
+    //(Wed,10 Jul 2019 07:35:43 GMT)
+    char date[AUTH_DATE_MAX];
+    struct tm tm;
+    gmtime_r(&now, &tm);
+    int date_len = strftime(date, sizeof(date), "%a,%d %b %Y %H:%M:%S GMT", &tm);
+
+    const u8 *sign_data[] = {
+        (const u8 *)AUTH_SIGN_HOST, (const u8 *)date, (const u8 *)AUTH_SIGN_REQUEST_LINE,
+    };
+    const size_t sign_len[] = {
+        sizeof(AUTH_SIGN_HOST) - 1, date_len, sizeof(AUTH_SIGN_REQUEST_LINE) - 1,
+    };
+    u8 mac[32];
+    hmac_sha256_vector((const u8 *)auth->api_secret, strlen(auth->api_secret), 3, sign_data, sign_len, mac);
+
+    sr_base64_t b64;
+    char signature[SR_BASE64_ENCODE_MAX(sizeof(mac)) + 4];
+    sr_base64_reset(&b64);
+    int signature_len = sr_base64_encode_update(&b64, signature, mac, sizeof(mac));
+    signature_len += sr_base64_encode_finish(&b64, signature + signature_len);
+
+    /* authorization = base64(origin), encoded piece by piece straight into the url */
+    char *url = auth->url;
+    int pos = strlen(auth->endpoint);
+    if (pos + sizeof(AUTH_URL_AUTHORIZATION) > XUNFEI_SR_AUTH_URL_MAX) {
+        auth->url_len = 0;
+        return NULL;
+    }
+    memcpy(url, auth->endpoint, pos);
+    memcpy(url + pos, AUTH_URL_AUTHORIZATION, sizeof(AUTH_URL_AUTHORIZATION) - 1);
+    pos += sizeof(AUTH_URL_AUTHORIZATION) - 1;
+    pos = _auth_encode(&b64, url, pos, AUTH_ORIGIN_KEY, sizeof(AUTH_ORIGIN_KEY) - 1);
+    pos = _auth_encode(&b64, url, pos, auth->api_key, strlen(auth->api_key));
+    pos = _auth_encode(&b64, url, pos, AUTH_ORIGIN_SIGNATURE, sizeof(AUTH_ORIGIN_SIGNATURE) - 1);
+    pos = _auth_encode(&b64, url, pos, signature, signature_len);
+    pos = _auth_encode(&b64, url, pos, AUTH_ORIGIN_END, sizeof(AUTH_ORIGIN_END) - 1);
+    if (pos < 0 || pos + 4 + sizeof(AUTH_URL_DATE) - 1 + date_len * 3 + sizeof(AUTH_URL_HOST) > XUNFEI_SR_AUTH_URL_MAX) {
+        auth->url_len = 0;
+        return NULL;
+    }
+    pos += sr_base64_encode_finish(&b64, url + pos);
+    memcpy(url + pos, AUTH_URL_DATE, sizeof(AUTH_URL_DATE) - 1);
+    pos += sizeof(AUTH_URL_DATE) - 1;
+    pos += xunfei_sr_proto_url_encode_date(url + pos, date);
+    memcpy(url + pos, AUTH_URL_HOST, sizeof(AUTH_URL_HOST));
+    pos += sizeof(AUTH_URL_HOST) - 1;
+
+    auth->url_len = pos;
+    auth->date = now;
+    return url;
+}
@@ -0,0 +1,87 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _XUNFEI_SR_AUTH_H_
+#define _XUNFEI_SR_AUTH_H_
+
+/*
+ * Signed websocket url for the `/v2/iat` endpoint.
+ *
+ * The signer owns all of its storage and keeps the last url, so opening a
+ * session does not touch the heap and two sessions opened within the same
+ * second share one HMAC computation.
+ */
+
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define XUNFEI_SR_AUTH_HOST     "ws-api.xfyun.cn"
+#define XUNFEI_SR_AUTH_PATH     "/v2/iat"
+#define XUNFEI_SR_AUTH_URL_MAX  (512)
+#define XUNFEI_SR_AUTH_ENDPOINT "wss://" XUNFEI_SR_AUTH_HOST XUNFEI_SR_AUTH_PATH
+
+typedef struct {
+    const char  *api_key;
+    const char  *api_secret;
+    const char  *endpoint;                      /*!< Url the query string is appended to, XUNFEI_SR_AUTH_ENDPOINT by default */
+    time_t      date;                           /*!< Second `url` was signed for, -1 if none */
+    int         url_len;
+    char        url[XUNFEI_SR_AUTH_URL_MAX];
+} xunfei_sr_auth_t;
+
+/**
+ * @brief      Set up a signer, the strings are referenced and must outlive it
+ *
+ * @param[in]  auth        The signer
+ * @param[in]  api_key     Xunfei APIKey
+ * @param[in]  api_secret  Xunfei APISecret
+ */
+void xunfei_sr_auth_init(xunfei_sr_auth_t *auth, const char *api_key, const char *api_secret);
+
+/**
+ * @brief      Point the signer at another server, the signature still covers XUNFEI_SR_AUTH_HOST
+ *
+ * @param[in]  auth      The signer
+ * @param[in]  endpoint  Url without query string, referenced, XUNFEI_SR_AUTH_ENDPOINT if NULL
+ */
+void xunfei_sr_auth_set_endpoint(xunfei_sr_auth_t *auth, const char *endpoint);
+
+/**
+ * @brief      Get the url signed for `now`, only re-signed when the second changes
+ *
+ * @param[in]  auth   The signer
+ * @param[in]  now    Current UTC time
+ *
+ * @return     NUL terminated url owned by `auth`, NULL if the key does not fit XUNFEI_SR_AUTH_URL_MAX
+ */
+const char *xunfei_sr_auth_url(xunfei_sr_auth_t *auth, time_t now);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
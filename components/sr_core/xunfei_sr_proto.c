@@ -0,0 +1,83 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+#include "xunfei_sr_proto.h"
+
+#define FIRST_PACKET_PRE_DATA  "{\"common\": {\"app_id\": \"%s\"}, \"business\": {\"domain\": \"iat\", \"language\": \"zh_cn\", \"accent\": \"mandarin\", \"vinfo\": 1, \"dwa\": \"wpgs\", \"vad_eos\": 10000}, \"data\": {\"status\": 0, \"format\": \"audio/L16;rate=%d\", \"audio\":\""
+#define MIDDLE_PACKET_PRE_DATA "{\"data\": {\"status\": 1, \"format\": \"audio/L16;rate=%d\", \"audio\":\""
+#define LAST_PACKET_PRE_DATA   "{\"data\": {\"status\": 2, \"format\": \"audio/L16;rate=%d\", \"audio\":\""
+#define PACKET_END_DATA        "\", \"encoding\": \"raw\"}}"
+
+/* The "%s" and "%d" replaced by the APPID and the rate, one base64 group of carry, one NUL */
+_Static_assert(sizeof(FIRST_PACKET_PRE_DATA) - 5 + XUNFEI_SR_PROTO_APPID_MAX + XUNFEI_SR_PROTO_RATE_DIGITS + sizeof(PACKET_END_DATA) - 1 + 4 + 1
+               <= XUNFEI_SR_PROTO_FRAME_OVERHEAD, "XUNFEI_SR_PROTO_FRAME_OVERHEAD too small");
+
+int xunfei_sr_proto_frame(char *out, int size, xunfei_sr_frame_status_t status, const char *app_id, int rate,
+                          sr_base64_t *b64, const unsigned char *audio, int audio_len)
+{
+    int pre_data_len;
+    int middle_data_len = 0;
+    int end_data_len = strlen(PACKET_END_DATA);
+
+    if (status == XUNFEI_SR_FRAME_FIRST) {
+        pre_data_len = snprintf(out, size, FIRST_PACKET_PRE_DATA, app_id, rate);
+    } else {
+        pre_data_len = snprintf(out, size, status == XUNFEI_SR_FRAME_LAST ? LAST_PACKET_PRE_DATA : MIDDLE_PACKET_PRE_DATA, rate);
+    }
+    /* One extra group for the flushed carry of the last frame, one byte for the NUL */
+    if (pre_data_len < 0 || pre_data_len + SR_BASE64_ENCODE_MAX(audio_len) + 4 + end_data_len >= size) {
+        return -1;
+    }
+    middle_data_len = sr_base64_encode_update(b64, out + pre_data_len, audio, audio_len);
+    if (status == XUNFEI_SR_FRAME_LAST) {
+        middle_data_len += sr_base64_encode_finish(b64, out + pre_data_len + middle_data_len);
+    }
+    memcpy(out + pre_data_len + middle_data_len, PACKET_END_DATA, end_data_len + 1);
+    return pre_data_len + middle_data_len + end_data_len;
+}
+
+int xunfei_sr_proto_url_encode_date(char *out, const char *date)
+{
+    int count = 0;
+    for (; *date; date++) {
+        if (*date == ',') {
+            out[count++] = '%';
+            out[count++] = '2';
+            out[count++] = 'C';
+        } else if (*date == ' ') {
+            out[count++] = '+';
+        } else if (*date == ':') {
+            out[count++] = '%';
+            out[count++] = '3';
+            out[count++] = 'A';
+        } else {
+            out[count++] = *date;
+        }
+    }
+    out[count] = '\0';
+    return count;
+}
@@ -0,0 +1,92 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#ifndef _XUNFEI_SR_PROTO_H_
+#define _XUNFEI_SR_PROTO_H_
+
+/*
+ * Wire format of the xunfei `/v2/iat` websocket frames.
+ *
+ * Nothing in here depends on FreeRTOS, the audio pipeline or the websocket
+ * client, so the framing can be compiled and exercised on a host as well as on target.
+ */
+
+#include "sr_base64.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define XUNFEI_SR_PROTO_APPID_MAX       (32)
+#define XUNFEI_SR_PROTO_RATE_DIGITS     (5)     /*!< `/v2/iat` takes 8000 or 16000 Hz */
+/** Worst case frame length around the audio: prefix with the APPID, suffix, the flushed base64 carry and the NUL */
+#define XUNFEI_SR_PROTO_FRAME_OVERHEAD  (240 + XUNFEI_SR_PROTO_APPID_MAX)
+/** Worst case xunfei_sr_proto_frame() output size for `audio_len` bytes of audio */
+#define XUNFEI_SR_PROTO_FRAME_MAX(audio_len) (XUNFEI_SR_PROTO_FRAME_OVERHEAD + SR_BASE64_ENCODE_MAX(audio_len))
+
+/**
+ * Value of `data.status` in a `/v2/iat` frame
+ */
+typedef enum {
+    XUNFEI_SR_FRAME_FIRST    = 0,   /*!< First frame, carries the `common` and `business` sections */
+    XUNFEI_SR_FRAME_CONTINUE = 1,   /*!< Intermediate audio frame */
+    XUNFEI_SR_FRAME_LAST     = 2,   /*!< Last frame, closes the utterance */
+} xunfei_sr_frame_status_t;
+
+/**
+ * @brief      Build one `/v2/iat` text frame carrying base64 encoded audio
+ *
+ * Up to 2 bytes of `audio` may be held back in `b64` so that every frame
+ * carries complete base64 groups; XUNFEI_SR_FRAME_LAST flushes them.
+ *
+ * @param[out] out        Output buffer
+ * @param[in]  size       Size of the output buffer
+ * @param[in]  status     Position of the frame in the utterance
+ * @param[in]  app_id     Xunfei APPID, only used for XUNFEI_SR_FRAME_FIRST
+ * @param[in]  rate       Sample rate in Hz, at most XUNFEI_SR_PROTO_RATE_DIGITS digits
+ * @param[in]  b64        Base64 encoder of the utterance
+ * @param[in]  audio      Raw audio, may be NULL when `audio_len` is 0
+ * @param[in]  audio_len  Raw audio length
+ *
+ * @return     Frame length, or -1 if `out` is too small
+ */
+int xunfei_sr_proto_frame(char *out, int size, xunfei_sr_frame_status_t status, const char *app_id, int rate,
+                          sr_base64_t *b64, const unsigned char *audio, int audio_len);
+
+/**
+ * @brief      URL-encode an RFC1123 date (`,` `:` and space) for the `date` query parameter
+ *
+ * @param[out] out        Output buffer, at least 3 * strlen(date) + 1 bytes
+ * @param[in]  date       Date string
+ *
+ * @return     Encoded length
+ */
+int xunfei_sr_proto_url_encode_date(char *out, const char *date);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,159 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * Base64 throughput of sr_base64 against the mbedtls_base64_encode it
+ * replaced and OpenSSL's EVP_EncodeBlock, in MB of input per second:
+ *
+ *     bench_base64,impl,chunk,mb_per_s
+ *     bench_base64_result,PASS|FAIL,what failed
+ *
+ * Audio goes through in DEFAULT_SR_BUFFER_SIZE pieces, as the upload task
+ * hands it over. Each figure is the best of several runs. sr_base64 fails
+ * the run if it is slower than mbedtls by more than SR_BASE64_MIN_PERMILLE.
+ * mbedtls is only timed when the build found libmbedcrypto.
+ */
+
+#include <stdlib.h>
+#include <time.h>
+#include <openssl/evp.h>
+#include "sr_base64.h"
+#include "sr_core.h"
+#include "sr_test.h"
+
+#define BENCH_INPUT_SIZE        (64*1024)
+#define BENCH_RUNS              (7)
+#define BENCH_RUN_NS            (100*1000*1000LL)
+#define SR_BASE64_MIN_PERMILLE  (900)
+
+#ifdef SR_HOST_MBEDTLS
+/* From mbedtls/base64.h, the headers are not always installed with the library */
+int mbedtls_base64_encode(unsigned char *dst, size_t dlen, size_t *olen, const unsigned char *src, size_t slen);
+#endif
+
+typedef int (*bench_encode_t)(char *out, const uint8_t *in, int len, int chunk);
+
+static int64_t _now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int _encode_sr_base64(char *out, const uint8_t *in, int len, int chunk)
+{
+    sr_base64_t b64;
+    sr_base64_reset(&b64);
+    int out_len = 0;
+    for (int pos = 0; pos < len; pos += chunk) {
+        out_len += sr_base64_encode_update(&b64, out + out_len, in + pos, len - pos < chunk ? len - pos : chunk);
+    }
+    return out_len + sr_base64_encode_finish(&b64, out + out_len);
+}
+
+#ifdef SR_HOST_MBEDTLS
+/* The former upload path: each block trimmed to whole 3 byte groups, the rest carried over by copying */
+static int _encode_mbedtls(char *out, const uint8_t *in, int len, int chunk)
+{
+    uint8_t block[DEFAULT_SR_BUFFER_SIZE + 2];
+    int carry = 0;
+    int out_len = 0;
+    for (int pos = 0; pos < len; pos += chunk) {
+        int n = len - pos < chunk ? len - pos : chunk;
+        memcpy(block + carry, in + pos, n);
+        n += carry;
+        int whole = pos + chunk >= len ? n : n / 3 * 3;
+        size_t olen = 0;
+        mbedtls_base64_encode((unsigned char *)out + out_len, SR_BASE64_ENCODE_MAX(whole) + 1, &olen, block, whole);
+        out_len += olen;
+        carry = n - whole;
+        memcpy(block, block + whole, carry);
+    }
+    return out_len;
+}
+#endif
+
+static int _encode_openssl(char *out, const uint8_t *in, int len, int chunk)
+{
+    return EVP_EncodeBlock((unsigned char *)out, in, len);
+}
+
+static double _mb_per_s(bench_encode_t encode, char *out, const uint8_t *in, int chunk, int *out_len)
+{
+    int64_t best = 0;
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        int64_t start = _now_ns();
+        int64_t bytes = 0;
+        int64_t elapsed;
+        do {
+            *out_len = encode(out, in, BENCH_INPUT_SIZE, chunk);
+            bytes += BENCH_INPUT_SIZE;
+            elapsed = _now_ns() - start;
+        } while (elapsed < BENCH_RUN_NS);
+        int64_t rate = bytes * 1000000000LL / elapsed;
+        if (rate > best) {
+            best = rate;
+        }
+    }
+    return best / 1e6;
+}
+
+int main(void)
+{
+    static uint8_t in[BENCH_INPUT_SIZE];
+    static char out[SR_BASE64_ENCODE_MAX(BENCH_INPUT_SIZE) + 8];
+    static char ref[SR_BASE64_ENCODE_MAX(BENCH_INPUT_SIZE) + 8];
+    uint32_t seed = 1;
+    for (int i = 0; i < BENCH_INPUT_SIZE; i++) {
+        seed = seed * 1664525 + 1013904223;
+        in[i] = seed >> 24;
+    }
+    const int chunk = DEFAULT_SR_BUFFER_SIZE;
+    int ref_len = 0;
+    int out_len = 0;
+    printf("bench_base64,impl,chunk,mb_per_s\n");
+    double openssl = _mb_per_s(_encode_openssl, ref, in, BENCH_INPUT_SIZE, &ref_len);
+    printf("bench_base64,openssl,%d,%.1f\n", BENCH_INPUT_SIZE, openssl);
+    double sr = _mb_per_s(_encode_sr_base64, out, in, chunk, &out_len);
+    printf("bench_base64,sr_base64,%d,%.1f\n", chunk, sr);
+    TEST_ASSERT(out_len == ref_len && memcmp(out, ref, ref_len) == 0);
+#ifdef SR_HOST_MBEDTLS
+    double mbedtls = _mb_per_s(_encode_mbedtls, out, in, chunk, &out_len);
+    printf("bench_base64,mbedtls,%d,%.1f\n", chunk, mbedtls);
+    TEST_ASSERT(out_len == ref_len && memcmp(out, ref, ref_len) == 0);
+    if (sr * 1000 < mbedtls * SR_BASE64_MIN_PERMILLE) {
+        printf("bench_base64_result,FAIL,sr_base64 %.1f MB/s below %d per mille of mbedtls %.1f MB/s\n",
+               sr, SR_BASE64_MIN_PERMILLE, mbedtls);
+        return 1;
+    }
+#else
+    printf("bench_base64,mbedtls,%d,-1\n", chunk);
+#endif
+    if (sr_test_failures) {
+        printf("bench_base64_result,FAIL,output differs from OpenSSL\n");
+        return 1;
+    }
+    printf("bench_base64_result,PASS,\n");
+    return 0;
+}
@@ -0,0 +1,166 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * Cost and gain of the AMR-WB upload: the encoder element run over a
+ * synthetic speech clip in a pipeline of its own, once per bitrate.
+ *
+ *     bench_codec,codec,kbit_per_s,audio_ms,cpu_ms_per_s,bytes_per_s,upload_permille
+ *     bench_codec_result,PASS|FAIL,what failed
+ *
+ * CPU is the process time spent per second of audio, the encoder task
+ * dominates it. Upload is the encoded bytes per 1000 bytes of 16 kHz PCM.
+ * With vo-amrwbenc installed this is the real encoder, otherwise the shim
+ * that only produces frames of the right size, whose CPU figure means
+ * nothing. A case fails if it produces more than its bitrate allows or
+ * takes more than BENCH_MAX_CPU_MS_PER_S.
+ */
+
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include "audio_pipeline.h"
+#include "raw_stream.h"
+#include "amrwb_encoder.h"
+#include "esp_log.h"
+#include "sr_test.h"
+
+#define BENCH_SAMPLE_RATE       (16000)
+#define BENCH_AUDIO_MS          (20000)
+#define BENCH_BLOCK             (2048)
+#define BENCH_MAX_CPU_MS_PER_S  (100)       /* 10% of a host core */
+
+static const struct {
+    amrwb_encoder_bitrate_t mode;
+    int                     bits_per_s;
+} bench_modes[] = {
+    { AMRWB_ENC_BITRATE_MD66,   6600 },
+    { AMRWB_ENC_BITRATE_MD1265, 12650 },    /* What sr_core uploads */
+    { AMRWB_ENC_BITRATE_MD2385, 23850 },
+};
+
+typedef struct {
+    audio_element_handle_t sink;
+    int64_t bytes;
+} bench_reader_t;
+
+static void *_reader(void *arg)
+{
+    bench_reader_t *reader = (bench_reader_t *)arg;
+    char buf[BENCH_BLOCK];
+    int n;
+    while ((n = raw_stream_read(reader->sink, buf, sizeof(buf))) > 0) {
+        reader->bytes += n;
+    }
+    return NULL;
+}
+
+static int64_t _cpu_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static bool _bench_mode(const sr_test_clip_t *clip, amrwb_encoder_bitrate_t mode, int bits_per_s)
+{
+    audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
+    audio_pipeline_handle_t pipeline = audio_pipeline_init(&pipeline_cfg);
+    raw_stream_cfg_t raw_cfg = RAW_STREAM_CFG_DEFAULT();
+    raw_cfg.type = AUDIO_STREAM_WRITER;
+    audio_element_handle_t src = raw_stream_init(&raw_cfg);
+    raw_cfg.type = AUDIO_STREAM_READER;
+    audio_element_handle_t sink = raw_stream_init(&raw_cfg);
+    amrwb_encoder_cfg_t amrwb_cfg = DEFAULT_AMRWB_ENCODER_CONFIG();
+    amrwb_cfg.bitrate_mode = mode;
+    amrwb_cfg.contain_amrwb_header = true;
+    audio_element_handle_t enc = amrwb_encoder_init(&amrwb_cfg);
+    audio_pipeline_register(pipeline, src, "src");
+    audio_pipeline_register(pipeline, enc, "enc");
+    audio_pipeline_register(pipeline, sink, "sink");
+    const char *link[] = { "src", "enc", "sink" };
+    audio_pipeline_link(pipeline, link, 3);
+
+    bench_reader_t reader = { .sink = sink };
+    pthread_t thread;
+    int64_t cpu_start = _cpu_ns();
+    audio_pipeline_run(pipeline);
+    pthread_create(&thread, NULL, _reader, &reader);
+    const char *pcm = (const char *)clip->samples;
+    int pcm_len = clip->frames * 2;
+    for (int pos = 0; pos < pcm_len; pos += BENCH_BLOCK) {
+        raw_stream_write(src, (char *)pcm + pos, pcm_len - pos < BENCH_BLOCK ? pcm_len - pos : BENCH_BLOCK);
+    }
+    audio_element_set_ringbuf_done(src);
+    pthread_join(thread, NULL);
+    int64_t cpu_ns = _cpu_ns() - cpu_start;
+    audio_pipeline_stop(pipeline);
+    audio_pipeline_wait_for_stop(pipeline);
+    audio_pipeline_terminate(pipeline);
+    audio_pipeline_unregister(pipeline, src);
+    audio_pipeline_unregister(pipeline, enc);
+    audio_pipeline_unregister(pipeline, sink);
+    audio_pipeline_deinit(pipeline);
+    audio_element_deinit(src);
+    audio_element_deinit(enc);
+    audio_element_deinit(sink);
+
+    int audio_ms = (int64_t)clip->frames * 1000 / clip->sample_rate;
+    int cpu_ms_per_s = cpu_ns / 1000 / audio_ms;
+    int bytes_per_s = reader.bytes * 1000 / audio_ms;
+    int upload_permille = reader.bytes * 1000 / pcm_len;
+    printf("bench_codec,amr-wb,%.2f,%d,%d,%d,%d\n", bits_per_s / 1000.0, audio_ms, cpu_ms_per_s, bytes_per_s,
+           upload_permille);
+    /* A 20 ms frame of `bits_per_s` rounded up to whole bytes, plus its table of contents byte */
+    int max_bytes_per_s = ((bits_per_s / 50 + 7) / 8 + 1) * 50 + 1;
+    if (reader.bytes == 0 || bytes_per_s > max_bytes_per_s) {
+        printf("bench_codec_result,FAIL,%d bytes/s at %d bit/s, at most %d\n", bytes_per_s, bits_per_s, max_bytes_per_s);
+        return false;
+    }
+    if (cpu_ms_per_s > BENCH_MAX_CPU_MS_PER_S) {
+        printf("bench_codec_result,FAIL,%d CPU ms per second of audio at %d bit/s\n", cpu_ms_per_s, bits_per_s);
+        return false;
+    }
+    return true;
+}
+
+int main(void)
+{
+    esp_log_level_set("*", ESP_LOG_WARN);
+    sr_test_clip_t clip;
+    if (!sr_test_clip_speech(&clip, BENCH_AUDIO_MS, BENCH_SAMPLE_RATE, 1)) {
+        return 1;
+    }
+    printf("bench_codec,codec,kbit_per_s,audio_ms,cpu_ms_per_s,bytes_per_s,upload_permille\n");
+    printf("bench_codec,pcm,256.00,%d,0,%d,1000\n", BENCH_AUDIO_MS, BENCH_SAMPLE_RATE * 2);
+    bool pass = true;
+    for (int i = 0; i < sizeof(bench_modes) / sizeof(bench_modes[0]); i++) {
+        pass &= _bench_mode(&clip, bench_modes[i].mode, bench_modes[i].bits_per_s);
+    }
+    sr_test_clip_free(&clip);
+    if (pass) {
+        printf("bench_codec_result,PASS,\n");
+    }
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,123 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * Cycles per stereo frame of the two microphone downmix, for each mode,
+ * codec rate and the block sizes the I2S reader hands it.
+ *
+ *     bench_downmix,mode,sample_rate,block,delay,cycles_per_frame,mcycles_per_s
+ *     bench_downmix_result,PASS|FAIL,what failed
+ *
+ * Cycles are xthal_get_ccount's, the host's CPU time at the nominal
+ * 160 MHz, over 10 s of speech per case with the right microphone a
+ * sample behind the left. A case fails above BENCH_MAX_CYCLES_PER_FRAME.
+ * The baseline was under 0.4 for the fixed modes and 0.7 to 2.3 for the
+ * adaptive one, whose cross correlation grows with the rate. The SNR gain
+ * of each mode is sr_bench's, see bench_sr.
+ */
+
+#include <stdlib.h>
+#include "esp_log.h"
+#include "xtensa/hal.h"
+#include "sr_downmix.h"
+#include "sr_test.h"
+
+#define BENCH_AUDIO_MS              (10000)
+#define BENCH_MAX_CYCLES_PER_FRAME  (10)
+
+static const char *bench_modes[] = {
+    [SR_DOWNMIX_AVERAGE] = "average",
+    [SR_DOWNMIX_DELAY_SUM] = "delay_sum",
+    [SR_DOWNMIX_ADAPTIVE] = "adaptive",
+};
+
+static const int bench_rates[] = { 16000, 48000 };
+
+/* Bytes of 16-bit stereo per read of the I2S reader */
+static const int bench_blocks[] = { 1024, 4096, 16384 };
+
+static bool _bench_mode(const sr_test_clip_t *clip, sr_downmix_mode_t mode, int block)
+{
+    sr_downmix_cfg_t cfg = {
+        .mode = mode,
+        .delay_us = 1000000 / clip->sample_rate,
+    };
+    sr_downmix_t dm;
+    if (sr_downmix_init(&dm, &cfg, clip->sample_rate, block) != 0) {
+        printf("bench_downmix_result,FAIL,%s at %d Hz not supported\n", bench_modes[mode], clip->sample_rate);
+        return false;
+    }
+    int16_t *out = malloc(block * sizeof(int16_t));
+    int64_t cycles = 0;
+    for (int offset = 0; offset < clip->frames; offset += block) {
+        int len = clip->frames - offset < block ? clip->frames - offset : block;
+        uint32_t start = xthal_get_ccount();
+        sr_downmix_process(&dm, clip->samples + 2 * offset, len, out);
+        cycles += (uint32_t)(xthal_get_ccount() - start);
+    }
+    int cycles_per_frame = (int)(cycles * 100 / clip->frames);
+    printf("bench_downmix,%s,%d,%d,%d,%d.%02d,%.2f\n", bench_modes[mode], clip->sample_rate, block, dm.delay,
+           cycles_per_frame / 100, cycles_per_frame % 100, cycles / 1000.0 / BENCH_AUDIO_MS);
+    bool pass = true;
+    if (cycles_per_frame > BENCH_MAX_CYCLES_PER_FRAME * 100) {
+        printf("bench_downmix_result,FAIL,%s at %d Hz in %d frames: %d cycles per frame\n",
+               bench_modes[mode], clip->sample_rate, block, cycles_per_frame / 100);
+        pass = false;
+    }
+    free(out);
+    sr_downmix_deinit(&dm);
+    return pass;
+}
+
+int main(void)
+{
+    esp_log_level_set("*", ESP_LOG_WARN);
+    printf("bench_downmix,mode,sample_rate,block,delay,cycles_per_frame,mcycles_per_s\n");
+    bool pass = true;
+    for (int r = 0; r < sizeof(bench_rates) / sizeof(bench_rates[0]); r++) {
+        sr_test_clip_t mono;
+        if (!sr_test_clip_speech(&mono, BENCH_AUDIO_MS, bench_rates[r], 1)) {
+            return 1;
+        }
+        /* The speech on the left microphone, a sample later on the right */
+        sr_test_clip_t clip = mono;
+        clip.channels = 2;
+        clip.samples = calloc(mono.frames * 2, sizeof(int16_t));
+        for (int n = 0; n < mono.frames; n++) {
+            clip.samples[2 * n] = mono.samples[n];
+            clip.samples[2 * n + 1] = n > 0 ? mono.samples[n - 1] : 0;
+        }
+        for (sr_downmix_mode_t mode = SR_DOWNMIX_AVERAGE; mode <= SR_DOWNMIX_ADAPTIVE; mode++) {
+            for (int b = 0; b < sizeof(bench_blocks) / sizeof(bench_blocks[0]); b++) {
+                pass &= _bench_mode(&clip, mode, bench_blocks[b] / 4);
+            }
+        }
+        sr_test_clip_free(&clip);
+        sr_test_clip_free(&mono);
+    }
+    if (pass) {
+        printf("bench_downmix_result,PASS,\n");
+    }
+    return pass ? 0 : 1;
+}
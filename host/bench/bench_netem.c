@@ -0,0 +1,257 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * The Baidu upload over a bad network: the SR core records speech into
+ * sr_provider_baidu, which talks to the mock server through the netem proxy
+ * of sr_netem_proxy.h, once per built-in scenario of sr_provider_netem.h.
+ *
+ *     bench_netem,scenario,case,utterances,recognized,retries,result_p50_ms,result_p95_ms,resets,stalls,wire_permille
+ *     bench_netem_result,scenario,case,PASS|FAIL,what failed
+ *
+ * Recognized counts the utterances that got their own text back, retries
+ * are the resends of sr_core_get_result_info, resets and stalls those of
+ * the proxy. Wire bytes are what reached the server per 1000 bytes of
+ * audio, resends included. Only the good network must recognize every
+ * utterance, the others are measurements to tune the chunk size, the
+ * retries and the buffering against:
+ *
+ *     bench_netem [--scenario name] [--coalesce bytes] [--retries n] [--repeat n] [clip.wav ...]
+ *
+ * The clips must be 16 kHz, synthetic speech of 1, 2 and 3 s if none is
+ * given, played in real time.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "audio_event_iface.h"
+#include "sr_core.h"
+#include "sr_provider_baidu.h"
+#include "sr_host_mic.h"
+#include "sr_mock_server.h"
+#include "sr_netem_proxy.h"
+#include "sr_test.h"
+
+#define NETEM_SAMPLE_RATE       (16000)
+#define NETEM_MAX_UTTERANCES    (64)
+#define NETEM_MAX_CLIPS         (16)
+#define NETEM_PLAY_TIMEOUT_MS   (60*1000)
+#define NETEM_SEED              (7)
+#define NETEM_TOKEN             "24.0123456789abcdef0123456789abcdef.2592000.1600000000.282335-12345678"
+
+static const char *netem_scenarios[] = { "good", "slow", "lossy", "bursty" };
+
+static const struct {
+    const char              *name;
+    baidu_sr_upload_mode_t  upload_mode;
+} netem_cases[] = {
+    { "baidu_raw",  BAIDU_SR_UPLOAD_RAW },
+    { "baidu_json", BAIDU_SR_UPLOAD_JSON },
+};
+
+typedef struct {
+    int coalesce_size;
+    int max_retries;
+    int repeat;
+} netem_options_t;
+
+static int _cmp_int(const void *a, const void *b)
+{
+    return *(const int *)a - *(const int *)b;
+}
+
+static int _percentile(int *values, int count, int pct)
+{
+    if (count == 0) {
+        return -1;
+    }
+    qsort(values, count, sizeof(int), _cmp_int);
+    int i = (count * pct + 99) / 100 - 1;
+    return values[i < 0 ? 0 : i];
+}
+
+static bool _latency_report(audio_event_iface_handle_t listener, sr_latency_report_t *report)
+{
+    audio_event_iface_msg_t msg;
+    bool found = false;
+    while (audio_event_iface_listen(listener, &msg, 0) == ESP_OK) {
+        if (msg.source_type == SR_CORE_EVENT_SOURCE && msg.cmd == SR_CORE_EVENT_LATENCY) {
+            *report = *(sr_latency_report_t *)msg.data;
+            found = true;
+        }
+    }
+    return found;
+}
+
+static bool _netem_case(const char *scenario_name, int case_index, sr_mock_server_t *server, sr_netem_proxy_t *proxy,
+                        const sr_test_clip_t *clips, int clip_count, const netem_options_t *options)
+{
+    const char *name = netem_cases[case_index].name;
+    char reason[128] = "";
+    /* Each utterance gets a text of its own, so a stale result does not pass for one */
+    static char texts[NETEM_MAX_UTTERANCES][8];
+    sr_mock_config_t mock_cfg = { 0 };
+    char url[64];
+    snprintf(url, sizeof(url), "http://127.0.0.1:%d/server_api", sr_netem_proxy_port(proxy));
+    sr_provider_baidu_config_t baidu_cfg = {
+        .token = NETEM_TOKEN,
+        .cuid = "host",
+        .upload_mode = netem_cases[case_index].upload_mode,
+        .coalesce_size = options->coalesce_size,
+        .endpoint = url,
+    };
+    sr_core_config_t sr_cfg = {
+        .provider = &sr_provider_baidu,
+        .provider_config = &baidu_cfg,
+        .record_sample_rates = NETEM_SAMPLE_RATE,
+        .encoding = SR_AUDIO_PCM,
+        .max_retries = options->max_retries,
+    };
+    sr_core_handle_t sr = sr_core_init(&sr_cfg);
+    audio_event_iface_cfg_t evt_cfg = AUDIO_EVENT_IFACE_DEFAULT_CFG();
+    evt_cfg.external_queue_size = 64;
+    audio_event_iface_handle_t listener = audio_event_iface_init(&evt_cfg);
+    if (sr == NULL || listener == NULL) {
+        printf("bench_netem_result,%s,%s,FAIL,init\n", scenario_name, name);
+        sr_core_destroy(sr);
+        audio_event_iface_destroy(listener);
+        return false;
+    }
+    sr_core_set_listener(sr, listener);
+
+    static int result[NETEM_MAX_UTTERANCES];
+    int count = 0, recognized = 0, retries = 0, timed = 0;
+    int64_t audio_bytes = 0;
+    sr_netem_proxy_stats_t stats;
+    sr_netem_proxy_stats(proxy, &stats, true);
+    for (int r = 0; r < options->repeat; r++) {
+        for (int c = 0; c < clip_count && count < NETEM_MAX_UTTERANCES; c++, count++) {
+            snprintf(texts[count], sizeof(texts[count]), "u%d", count);
+            mock_cfg.text = texts[count];
+            sr_mock_server_configure(server, &mock_cfg);
+            if (sr_core_start(sr) != ESP_OK) {
+                continue;
+            }
+            sr_host_mic_play(clips[c].samples, clips[c].frames, clips[c].channels);
+            if (sr_host_mic_wait_played(NETEM_PLAY_TIMEOUT_MS) != ESP_OK) {
+                snprintf(reason, sizeof(reason), "clip %d not recorded", c);
+            }
+            char *text = sr_core_stop(sr);
+            audio_bytes += (int64_t)clips[c].frames * 2;
+            if (text && strcmp(text, texts[count]) == 0) {
+                recognized++;
+            }
+            sr_core_result_info_t info;
+            if (sr_core_get_result_info(sr, &info) == ESP_OK) {
+                retries += info.retries;
+            }
+            sr_latency_report_t report;
+            if (_latency_report(listener, &report)) {
+                result[timed++] = report.stage_ms[SR_LATENCY_STAGE_TOTAL];
+            }
+        }
+    }
+    sr_core_destroy(sr);
+    audio_event_iface_destroy(listener);
+    sr_netem_proxy_stats(proxy, &stats, false);
+
+    printf("bench_netem,%s,%s,%d,%d,%d,%d,%d,%d,%d,%d\n", scenario_name, name, count, recognized, retries,
+           _percentile(result, timed, 50), _percentile(result, timed, 95), stats.resets, stats.stalls,
+           audio_bytes ? (int)(stats.up_bytes * 1000 / audio_bytes) : -1);
+    if (reason[0] == 0 && strcmp(scenario_name, "good") == 0 && recognized < count) {
+        snprintf(reason, sizeof(reason), "%d of %d utterances recognized", recognized, count);
+    }
+    printf("bench_netem_result,%s,%s,%s,%s\n", scenario_name, name, reason[0] ? "FAIL" : "PASS", reason);
+    return reason[0] == 0;
+}
+
+int main(int argc, char **argv)
+{
+    netem_options_t options = { .repeat = 1 };
+    const char *only = NULL;
+    sr_test_clip_t clips[NETEM_MAX_CLIPS];
+    int clip_count = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--scenario") == 0 && i + 1 < argc) {
+            only = argv[++i];
+        } else if (strcmp(argv[i], "--coalesce") == 0 && i + 1 < argc) {
+            options.coalesce_size = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--retries") == 0 && i + 1 < argc) {
+            options.max_retries = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            options.repeat = atoi(argv[++i]);
+        } else if (clip_count < NETEM_MAX_CLIPS) {
+            if (!sr_test_clip_load_wav(&clips[clip_count], argv[i])) {
+                return 2;
+            }
+            if (clips[clip_count].sample_rate != NETEM_SAMPLE_RATE) {
+                fprintf(stderr, "%s: %d Hz, only %d Hz clips are played\n", argv[i], clips[clip_count].sample_rate,
+                        NETEM_SAMPLE_RATE);
+                return 2;
+            }
+            clip_count++;
+        }
+    }
+    if (only && sr_netem_scenario_find(only) == NULL) {
+        fprintf(stderr, "No scenario %s\n", only);
+        return 2;
+    }
+    if (clip_count == 0) {
+        for (; clip_count < 3; clip_count++) {
+            sr_test_clip_speech(&clips[clip_count], 1000 * (clip_count + 1), NETEM_SAMPLE_RATE, 1);
+        }
+    }
+    esp_log_level_set("*", getenv("SR_LOG") ? atoi(getenv("SR_LOG")) : ESP_LOG_ERROR);
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    printf("bench_netem,scenario,case,utterances,recognized,retries,result_p50_ms,result_p95_ms,resets,stalls,wire_permille\n");
+    bool pass = true;
+    for (int s = 0; s < sizeof(netem_scenarios) / sizeof(netem_scenarios[0]); s++) {
+        if (only && strcmp(only, netem_scenarios[s]) != 0) {
+            continue;
+        }
+        /* The cases run one after the other through the same script, the later ones meet its later steps */
+        sr_mock_server_t *server = sr_mock_baidu_start(NULL);
+        sr_netem_proxy_t *proxy = server ? sr_netem_proxy_start(sr_mock_server_port(server),
+                                                                sr_netem_scenario_find(netem_scenarios[s]),
+                                                                NETEM_SEED) : NULL;
+        if (proxy == NULL) {
+            printf("bench_netem_result,%s,,FAIL,no server\n", netem_scenarios[s]);
+            sr_mock_server_stop(server);
+            pass = false;
+            continue;
+        }
+        for (int c = 0; c < sizeof(netem_cases) / sizeof(netem_cases[0]); c++) {
+            pass &= _netem_case(netem_scenarios[s], c, server, proxy, clips, clip_count, &options);
+        }
+        sr_netem_proxy_stop(proxy);
+        sr_mock_server_stop(server);
+    }
+    for (int i = 0; i < clip_count; i++) {
+        sr_test_clip_free(&clips[i]);
+    }
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * Cycles per sample of the polyphase resampler, for each codec rate to
+ * upload rate and the block sizes the I2S reader hands it.
+ *
+ *     bench_resample,in_rate,out_rate,taps,block,cycles_per_in_sample,cycles_per_out_sample,mcycles_per_s
+ *     bench_resample_result,PASS|FAIL,what failed
+ *
+ * Cycles are xthal_get_ccount's, the host's CPU time at the nominal
+ * 160 MHz, over 10 s of speech per case. The cost is `taps` multiply-adds
+ * per output sample whatever the ratio, a case fails above
+ * BENCH_MAX_CYCLES_PER_100_TAPS per 100 of them. The baseline was 12 to 15,
+ * the host vectorizes the multiply-adds, the margin is for slower machines.
+ */
+
+#include <stdlib.h>
+#include "esp_log.h"
+#include "xtensa/hal.h"
+#include "sr_resample.h"
+#include "sr_test.h"
+
+#define BENCH_AUDIO_MS              (10000)
+#define BENCH_MAX_CYCLES_PER_100_TAPS   (50)
+
+static const struct {
+    int in_rate;
+    int out_rate;
+} bench_rates[] = {
+    { 48000, 16000 },
+    { 44100, 16000 },
+    { 48000, 8000 },
+    { 44100, 8000 },
+    { 16000, 8000 },
+    { 32000, 16000 },
+};
+
+/* Bytes of 16-bit mono per read of the I2S reader */
+static const int bench_blocks[] = { 256, 1024, 4096 };
+
+static bool _bench_rate(const sr_test_clip_t *clip, int out_rate, int block)
+{
+    sr_resample_t rs;
+    if (sr_resample_init(&rs, clip->sample_rate, out_rate, block) != 0) {
+        printf("bench_resample_result,FAIL,%d to %d Hz not supported\n", clip->sample_rate, out_rate);
+        return false;
+    }
+    int16_t *out = malloc(SR_RESAMPLE_OUT_MAX(&rs, block) * sizeof(int16_t));
+    int64_t cycles = 0;
+    int64_t out_samples = 0;
+    for (int offset = 0; offset < clip->frames; offset += block) {
+        int len = clip->frames - offset < block ? clip->frames - offset : block;
+        uint32_t start = xthal_get_ccount();
+        out_samples += sr_resample_process(&rs, clip->samples + offset, len, out);
+        cycles += (uint32_t)(xthal_get_ccount() - start);
+    }
+    int cycles_per_in = (int)(cycles * 100 / clip->frames);
+    int cycles_per_out = (int)(cycles * 100 / out_samples);
+    printf("bench_resample,%d,%d,%d,%d,%d.%02d,%d.%02d,%.2f\n", clip->sample_rate, out_rate, rs.taps, block,
+           cycles_per_in / 100, cycles_per_in % 100, cycles_per_out / 100, cycles_per_out % 100,
+           cycles / 1000.0 / BENCH_AUDIO_MS);
+    bool pass = true;
+    if (cycles_per_out > rs.taps * BENCH_MAX_CYCLES_PER_100_TAPS) {
+        printf("bench_resample_result,FAIL,%d to %d Hz in %d samples: %d cycles per output sample, %d taps\n",
+               clip->sample_rate, out_rate, block, cycles_per_out / 100, rs.taps);
+        pass = false;
+    }
+    free(out);
+    sr_resample_deinit(&rs);
+    return pass;
+}
+
+int main(void)
+{
+    esp_log_level_set("*", ESP_LOG_WARN);
+    printf("bench_resample,in_rate,out_rate,taps,block,cycles_per_in_sample,cycles_per_out_sample,mcycles_per_s\n");
+    bool pass = true;
+    for (int r = 0; r < sizeof(bench_rates) / sizeof(bench_rates[0]); r++) {
+        sr_test_clip_t clip;
+        if (!sr_test_clip_speech(&clip, BENCH_AUDIO_MS, bench_rates[r].in_rate, 1)) {
+            return 1;
+        }
+        for (int b = 0; b < sizeof(bench_blocks) / sizeof(bench_blocks[0]); b++) {
+            pass &= _bench_rate(&clip, bench_rates[r].out_rate, bench_blocks[b] / 2);
+        }
+        sr_test_clip_free(&clip);
+    }
+    if (pass) {
+        printf("bench_resample_result,PASS,\n");
+    }
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,100 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * Throughput of the xunfei url signer, in urls per second:
+ *
+ *     bench_signer,case,urls_per_s,us_per_url,allocs
+ *     bench_signer_result,PASS|FAIL,what failed
+ *
+ * `resign` asks for a new second every time, so each url costs the HMAC
+ * and both base64 passes. `cached` asks for the same second, which is what
+ * sessions opened back to back see. Allocations are counted with the
+ * heap tracing of the host shim, the signer must make none.
+ */
+
+#include <stdlib.h>
+#include <time.h>
+#include "esp_heap_trace.h"
+#include "xunfei_sr_auth.h"
+#include "sr_test.h"
+
+#define BENCH_RUN_NS        (300*1000*1000LL)
+#define BENCH_MIN_CACHED    (10)    /* A cached url is at least this many times cheaper than a new one */
+
+static int64_t _now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static double _urls_per_s(xunfei_sr_auth_t *auth, bool resign, int *allocs)
+{
+    time_t now = 1562744143;
+    int64_t count = 0;
+    int64_t start = _now_ns();
+    int64_t elapsed;
+    heap_trace_start(HEAP_TRACE_ALL);
+    do {
+        for (int i = 0; i < 64; i++) {
+            if (xunfei_sr_auth_url(auth, resign ? now++ : now) == NULL) {
+                return -1;
+            }
+        }
+        count += 64;
+        elapsed = _now_ns() - start;
+    } while (elapsed < BENCH_RUN_NS);
+    heap_trace_stop();
+    *allocs = heap_trace_get_count();
+    return count * 1e9 / elapsed;
+}
+
+int main(void)
+{
+    static heap_trace_record_t records[16];
+    heap_trace_init_standalone(records, 16);
+    xunfei_sr_auth_t auth;
+    xunfei_sr_auth_init(&auth, "a2c2b3ae1c3e4b5f9a8d7c6b5a4f3e2d", "0123456789abcdef0123456789abcdef");
+    printf("bench_signer,case,urls_per_s,us_per_url,allocs\n");
+    int resign_allocs, cached_allocs;
+    double resign = _urls_per_s(&auth, true, &resign_allocs);
+    printf("bench_signer,resign,%.0f,%.2f,%d\n", resign, 1e6 / resign, resign_allocs);
+    double cached = _urls_per_s(&auth, false, &cached_allocs);
+    printf("bench_signer,cached,%.0f,%.3f,%d\n", cached, 1e6 / cached, cached_allocs);
+    if (resign <= 0 || cached <= 0) {
+        printf("bench_signer_result,FAIL,no url\n");
+        return 1;
+    }
+    if (resign_allocs || cached_allocs) {
+        printf("bench_signer_result,FAIL,%d allocations\n", resign_allocs + cached_allocs);
+        return 1;
+    }
+    if (cached < resign * BENCH_MIN_CACHED) {
+        printf("bench_signer_result,FAIL,cached url only %.1f times faster\n", cached / resign);
+        return 1;
+    }
+    printf("bench_signer_result,PASS,\n");
+    return 0;
+}
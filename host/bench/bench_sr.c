@@ -0,0 +1,106 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * sr_bench, the upload path benchmark of the device, on the host.
+ *
+ *     bench_sr [--repeat n] [clip.wav ...]
+ *
+ * Runs the mock in each wire format over the corpus, synthetic unless 16 kHz
+ * mono clips are given, then the resampler and the downmix, and prints the
+ * CSV of sr_bench.h. The cases carry the thresholds of a host baseline run:
+ * bytes on the wire and allocations are those of the device, cycles are the
+ * host's CPU time at the nominal 160 MHz with a margin for slower machines.
+ * Any miss exits with 1.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "sr_bench.h"
+#include "sr_provider_mock.h"
+#include "sr_test.h"
+
+#define BENCH_SAMPLE_RATE       (16000)
+#define BENCH_CAPTURE_RATE      (48000)
+#define BENCH_MAX_CLIPS         (16)
+
+static const sr_provider_mock_config_t bench_mock_raw = { .wire = SR_MOCK_WIRE_BAIDU_RAW };
+static const sr_provider_mock_config_t bench_mock_json = { .wire = SR_MOCK_WIRE_BAIDU_JSON };
+static const sr_provider_mock_config_t bench_mock_xunfei = { .wire = SR_MOCK_WIRE_XUNFEI };
+
+/* The baseline was 1, 5 and 6 kcycles/s, 5 cycles per sample resampling and 1 per frame downmixing */
+#define BENCH_MAX_RESAMPLE_CYCLES   (25)
+#define BENCH_MAX_DOWNMIX_CYCLES    (10)
+
+static const sr_bench_case_t bench_cases[] = {
+    { "baidu_raw",  &sr_provider_mock, &bench_mock_raw,    SR_AUDIO_PCM, 10, 1010, 50, SR_BENCH_NO_ALLOCS },
+    { "baidu_json", &sr_provider_mock, &bench_mock_json,   SR_AUDIO_PCM, 40, 1350, 50, SR_BENCH_NO_ALLOCS },
+    { "xunfei",     &sr_provider_mock, &bench_mock_xunfei, SR_AUDIO_PCM, 40, 1435, 50, SR_BENCH_NO_ALLOCS },
+};
+
+int main(int argc, char **argv)
+{
+    esp_log_level_set("*", getenv("SR_LOG") ? atoi(getenv("SR_LOG")) : ESP_LOG_WARN);
+    int repeat = 5;
+    sr_test_clip_t wavs[BENCH_MAX_CLIPS];
+    sr_bench_clip_t clips[BENCH_MAX_CLIPS];
+    int clip_count = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = atoi(argv[++i]);
+        } else if (clip_count < BENCH_MAX_CLIPS) {
+            if (!sr_test_clip_load_wav(&wavs[clip_count], argv[i])) {
+                return 1;
+            }
+            if (wavs[clip_count].sample_rate != BENCH_SAMPLE_RATE || wavs[clip_count].channels != 1
+                    || wavs[clip_count].frames < BENCH_SAMPLE_RATE / 10) {
+                fprintf(stderr, "%s: only %d Hz mono clips of 100 ms or more are benchmarked\n", argv[i],
+                        BENCH_SAMPLE_RATE);
+                return 1;
+            }
+            clips[clip_count].name = argv[i];
+            clips[clip_count].samples = wavs[clip_count].samples;
+            clips[clip_count].frames = wavs[clip_count].frames;
+            clip_count++;
+        }
+    }
+
+    sr_bench_config_t cfg = {
+        .cases = bench_cases,
+        .case_count = sizeof(bench_cases) / sizeof(bench_cases[0]),
+        .clips = clip_count > 0 ? clips : NULL,
+        .clip_count = clip_count,
+        .sample_rate = BENCH_SAMPLE_RATE,
+        .capture_rate = BENCH_CAPTURE_RATE,
+        .repeats = repeat,
+        .max_resample_cycles = BENCH_MAX_RESAMPLE_CYCLES,
+        .max_downmix_cycles = BENCH_MAX_DOWNMIX_CYCLES,
+    };
+    esp_err_t ret = sr_bench_run(&cfg);
+    for (int i = 0; i < clip_count; i++) {
+        sr_test_clip_free(&wavs[i]);
+    }
+    return ret == ESP_OK ? 0 : 1;
+}
@@ -0,0 +1,265 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * Replay benchmark: recorded or synthetic speech through the whole SR core,
+ * I2S reader to provider, against the loopback servers of sr_mock_server.h.
+ *
+ * Every case records each clip `--repeat` times, cold (pipelines started per
+ * utterance) or warm, and prints one CSV line:
+ *
+ *     sr_replay,case,utterances,audio_bytes,wire_bytes,wire_permille,ttfb_p50_ms,ttfb_p95_ms,result_p50_ms,result_p95_ms
+ *     sr_replay_result,case,PASS|FAIL,what failed
+ *
+ * TTFB is the REPLY stage of sr_latency.h, last audio sent to the first
+ * reply byte. Time to result is the TOTAL stage, release to the final text.
+ * Wire bytes are everything the server received, request and frame headers
+ * included, per 1000 bytes of recorded audio. A case fails on a wrong text
+ * or a figure above its threshold, and the program then exits with 1.
+ *
+ *     sr_replay [--speed percent] [--repeat n] [--case name] [clip.wav ...]
+ *
+ * The clips must be 16 kHz, synthetic speech of 1, 2 and 3 s if none is given.
+ * They play in real time by default. Faster, the I2S reader runs ahead of the
+ * uplink and a cold stop drops the backlog, as it would on the device.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "audio_event_iface.h"
+#include "sr_core.h"
+#include "sr_provider_baidu.h"
+#include "sr_provider_xunfei.h"
+#include "sr_clock.h"
+#include "sr_host_mic.h"
+#include "sr_mock_server.h"
+#include "sr_test.h"
+
+#define REPLAY_SAMPLE_RATE      (16000)
+#define REPLAY_MAX_UTTERANCES   (256)
+#define REPLAY_MAX_CLIPS        (16)
+#define REPLAY_PLAY_TIMEOUT_MS  (60*1000)
+#define REPLAY_TEXT             "今天天气怎么样"
+#define REPLAY_XUNFEI_KEY       "a2c2b3ae1c3e4b5f9a8d7c6b5a4f3e2d"
+#define REPLAY_XUNFEI_SECRET    "0123456789abcdef0123456789abcdef"
+
+typedef struct {
+    const char          *name;
+    bool                xunfei;
+    baidu_sr_upload_mode_t upload_mode;
+    sr_audio_format_t   encoding;
+    bool                warm;
+    int                 max_wire_permille;      /*!< Bytes received by the server per 1000 bytes of audio */
+    int                 max_ttfb_p95_ms;
+    int                 max_result_p95_ms;
+} replay_case_t;
+
+/* Base64 is 1333 per mille, AMR-WB at the 12.65 kbit/s of sr_core 52. The times are loopback with the server answering at once */
+static const replay_case_t replay_cases[] = {
+    { "baidu_json_cold", false, BAIDU_SR_UPLOAD_JSON, SR_AUDIO_PCM,    false, 1380, 100, 300 },
+    { "baidu_raw_cold",  false, BAIDU_SR_UPLOAD_RAW,  SR_AUDIO_PCM,    false, 1040, 100, 300 },
+    { "baidu_amr_cold",  false, BAIDU_SR_UPLOAD_RAW,  SR_AUDIO_AMR_WB, false, 70,   100, 300 },
+    { "xunfei_cold",     true,  0,                    SR_AUDIO_PCM,    false, 1480, 100, 300 },
+    { "baidu_json_warm", false, BAIDU_SR_UPLOAD_JSON, SR_AUDIO_PCM,    true,  1380, 100, 300 },
+    { "baidu_raw_warm",  false, BAIDU_SR_UPLOAD_RAW,  SR_AUDIO_PCM,    true,  1040, 100, 300 },
+    { "xunfei_warm",     true,  0,                    SR_AUDIO_PCM,    true,  1480, 100, 300 },
+};
+
+static int _cmp_int(const void *a, const void *b)
+{
+    return *(const int *)a - *(const int *)b;
+}
+
+static int _percentile(int *values, int count, int pct)
+{
+    if (count == 0) {
+        return -1;
+    }
+    qsort(values, count, sizeof(int), _cmp_int);
+    int i = (count * pct + 99) / 100 - 1;
+    return values[i < 0 ? 0 : i];
+}
+
+/* The latency report of the utterance just stopped, other events are dropped */
+static bool _latency_report(audio_event_iface_handle_t listener, sr_latency_report_t *report)
+{
+    audio_event_iface_msg_t msg;
+    bool found = false;
+    while (audio_event_iface_listen(listener, &msg, 0) == ESP_OK) {
+        if (msg.source_type == SR_CORE_EVENT_SOURCE && msg.cmd == SR_CORE_EVENT_LATENCY) {
+            *report = *(sr_latency_report_t *)msg.data;
+            found = true;
+        }
+    }
+    return found;
+}
+
+static bool _replay_case(const replay_case_t *rc, const sr_test_clip_t *clips, int clip_count, int repeat)
+{
+    char reason[128] = "";
+    sr_mock_config_t mock_cfg = {
+        .text = REPLAY_TEXT,
+        .partial_every = 8,
+        .api_key = REPLAY_XUNFEI_KEY,
+        .api_secret = REPLAY_XUNFEI_SECRET,
+    };
+    sr_mock_server_t *server = rc->xunfei ? sr_mock_xunfei_start(&mock_cfg) : sr_mock_baidu_start(&mock_cfg);
+    if (server == NULL) {
+        printf("sr_replay_result,%s,FAIL,no server\n", rc->name);
+        return false;
+    }
+    sr_provider_baidu_config_t baidu_cfg = {
+        .token = "24.0123456789abcdef0123456789abcdef.2592000.1600000000.282335-12345678",
+        .cuid = "host",
+        .upload_mode = rc->upload_mode,
+        .endpoint = sr_mock_server_url(server),
+    };
+    sr_provider_xunfei_config_t xunfei_cfg = {
+        .app_id = "5d2f27d3",
+        .api_key = REPLAY_XUNFEI_KEY,
+        .api_secret = REPLAY_XUNFEI_SECRET,
+        .endpoint = sr_mock_server_url(server),
+    };
+    sr_core_config_t sr_cfg = {
+        .provider = rc->xunfei ? &sr_provider_xunfei : &sr_provider_baidu,
+        .provider_config = rc->xunfei ? (const void *)&xunfei_cfg : (const void *)&baidu_cfg,
+        .record_sample_rates = REPLAY_SAMPLE_RATE,
+        .encoding = rc->encoding,
+        .warm_pipeline = rc->warm,
+    };
+    sr_core_handle_t sr = sr_core_init(&sr_cfg);
+    audio_event_iface_cfg_t evt_cfg = AUDIO_EVENT_IFACE_DEFAULT_CFG();
+    evt_cfg.external_queue_size = 64;
+    audio_event_iface_handle_t listener = audio_event_iface_init(&evt_cfg);
+    if (sr == NULL || listener == NULL) {
+        printf("sr_replay_result,%s,FAIL,init\n", rc->name);
+        sr_mock_server_stop(server);
+        return false;
+    }
+    sr_core_set_listener(sr, listener);
+
+    static int ttfb[REPLAY_MAX_UTTERANCES];
+    static int result[REPLAY_MAX_UTTERANCES];
+    int count = 0;
+    int64_t audio_bytes = 0;
+    sr_mock_stats_t stats;
+    sr_mock_server_stats(server, &stats, true);
+    for (int r = 0; r < repeat; r++) {
+        for (int c = 0; c < clip_count && count < REPLAY_MAX_UTTERANCES; c++) {
+            if (sr_core_start(sr) != ESP_OK) {
+                snprintf(reason, sizeof(reason), "utterance %d: not started", count);
+            }
+            sr_host_mic_play(clips[c].samples, clips[c].frames, clips[c].channels);
+            if (sr_host_mic_wait_played(REPLAY_PLAY_TIMEOUT_MS) != ESP_OK) {
+                snprintf(reason, sizeof(reason), "clip %d not recorded", c);
+            }
+            char *text = sr_core_stop(sr);
+            if (reason[0] == 0 && (text == NULL || strcmp(text, REPLAY_TEXT) != 0)) {
+                snprintf(reason, sizeof(reason), "utterance %d: wrong text \"%s\"", count, text ? text : "(null)");
+            }
+            sr_latency_report_t report;
+            if (!_latency_report(listener, &report)) {
+                snprintf(reason, sizeof(reason), "utterance %d: no latency report", count);
+                continue;
+            }
+            ttfb[count] = report.stage_ms[SR_LATENCY_STAGE_REPLY];
+            result[count] = report.stage_ms[SR_LATENCY_STAGE_TOTAL];
+            audio_bytes += (int64_t)clips[c].frames * 2;
+            count++;
+        }
+    }
+    sr_mock_server_stats(server, &stats, false);
+    sr_core_destroy(sr);
+    audio_event_iface_destroy(listener);
+    sr_mock_server_stop(server);
+
+    int wire_permille = audio_bytes ? (int)(stats.rx_bytes * 1000 / audio_bytes) : -1;
+    int ttfb_p50 = _percentile(ttfb, count, 50), ttfb_p95 = _percentile(ttfb, count, 95);
+    int result_p50 = _percentile(result, count, 50), result_p95 = _percentile(result, count, 95);
+    printf("sr_replay,%s,%d,%lld,%lld,%d,%d,%d,%d,%d\n", rc->name, count, (long long)audio_bytes,
+           (long long)stats.rx_bytes, wire_permille, ttfb_p50, ttfb_p95, result_p50, result_p95);
+    if (reason[0] == 0 && stats.failed + stats.rejected) {
+        snprintf(reason, sizeof(reason), "%d requests rejected", stats.rejected);
+    } else if (reason[0] == 0 && wire_permille > rc->max_wire_permille) {
+        snprintf(reason, sizeof(reason), "wire %d > %d per mille", wire_permille, rc->max_wire_permille);
+    } else if (reason[0] == 0 && (ttfb_p95 < 0 || ttfb_p95 > rc->max_ttfb_p95_ms)) {
+        snprintf(reason, sizeof(reason), "ttfb p95 %d > %d ms", ttfb_p95, rc->max_ttfb_p95_ms);
+    } else if (reason[0] == 0 && (result_p95 < 0 || result_p95 > rc->max_result_p95_ms)) {
+        snprintf(reason, sizeof(reason), "result p95 %d > %d ms", result_p95, rc->max_result_p95_ms);
+    }
+    printf("sr_replay_result,%s,%s,%s\n", rc->name, reason[0] ? "FAIL" : "PASS", reason);
+    return reason[0] == 0;
+}
+
+int main(int argc, char **argv)
+{
+    int speed = 100;
+    int repeat = 1;
+    const char *only = NULL;
+    sr_test_clip_t clips[REPLAY_MAX_CLIPS];
+    int clip_count = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+            speed = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--case") == 0 && i + 1 < argc) {
+            only = argv[++i];
+        } else if (clip_count < REPLAY_MAX_CLIPS) {
+            if (!sr_test_clip_load_wav(&clips[clip_count], argv[i])) {
+                return 2;
+            }
+            if (clips[clip_count].sample_rate != REPLAY_SAMPLE_RATE) {
+                fprintf(stderr, "%s: %d Hz, only %d Hz clips are replayed\n", argv[i], clips[clip_count].sample_rate,
+                        REPLAY_SAMPLE_RATE);
+                return 2;
+            }
+            clip_count++;
+        }
+    }
+    if (clip_count == 0) {
+        for (; clip_count < 3; clip_count++) {
+            sr_test_clip_speech(&clips[clip_count], 1000 * (clip_count + 1), REPLAY_SAMPLE_RATE, 1);
+        }
+    }
+    esp_log_level_set("*", getenv("SR_LOG") ? atoi(getenv("SR_LOG")) : ESP_LOG_WARN);
+    sr_host_mic_set_speed(speed);
+    /* The host clock is right, xunfei signs with it */
+    sr_clock_init(NULL);
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    printf("sr_replay,case,utterances,audio_bytes,wire_bytes,wire_permille,ttfb_p50_ms,ttfb_p95_ms,result_p50_ms,result_p95_ms\n");
+    bool pass = true;
+    for (int i = 0; i < sizeof(replay_cases) / sizeof(replay_cases[0]); i++) {
+        if (only == NULL || strcmp(only, replay_cases[i].name) == 0) {
+            pass &= _replay_case(&replay_cases[i], clips, clip_count, repeat);
+        }
+    }
+    for (int i = 0; i < clip_count; i++) {
+        sr_test_clip_free(&clips[i]);
+    }
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,176 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include "sr_mock_server_priv.h"
+
+/* Body of one request, de-chunked, returns its length or -1 */
+static int _baidu_read_body(sr_mock_conn_t *conn, int content_length, bool chunked)
+{
+    char buf[1024];
+    int total = 0;
+    if (!chunked) {
+        while (total < content_length) {
+            int n = content_length - total > (int)sizeof(buf) ? (int)sizeof(buf) : content_length - total;
+            if (sr_mock_read(conn, buf, n) < 0) {
+                return -1;
+            }
+            total += n;
+        }
+        return total;
+    }
+    char line[64];
+    for (;;) {
+        if (sr_mock_read_line(conn, line, sizeof(line)) < 0) {
+            return -1;
+        }
+        int size = strtol(line, NULL, 16);
+        if (size == 0) {
+            /* Trailers, then the empty line */
+            do {
+                if (sr_mock_read_line(conn, line, sizeof(line)) < 0) {
+                    return -1;
+                }
+            } while (line[0]);
+            return total;
+        }
+        while (size > 0) {
+            int n = size > (int)sizeof(buf) ? (int)sizeof(buf) : size;
+            if (sr_mock_read(conn, buf, n) < 0) {
+                return -1;
+            }
+            size -= n;
+            total += n;
+        }
+        if (sr_mock_read_line(conn, line, sizeof(line)) != 0) {
+            return -1;
+        }
+    }
+}
+
+static int _baidu_reply(sr_mock_conn_t *conn, int status, const char *body, bool close)
+{
+    char date[40];
+    char header[256];
+    sr_mock_http_date(date, sizeof(date));
+    int len = snprintf(header, sizeof(header),
+                       "HTTP/1.1 %d %s\r\nContent-Type: application/json\r\nDate: %s\r\nContent-Length: %d\r\n%s\r\n",
+                       status, status == 200 ? "OK" : "Bad Request", date, (int)strlen(body),
+                       close ? "Connection: close\r\n" : "");
+    if (sr_mock_write(conn, header, len) < 0 || sr_mock_write(conn, body, strlen(body)) < 0) {
+        return -1;
+    }
+    return 0;
+}
+
+static void _baidu_serve(sr_mock_conn_t *conn)
+{
+    sr_mock_server_t *server = conn->server;
+    char line[SR_MOCK_LINE_MAX];
+    char body[512];
+    for (;;) {
+        if (sr_mock_read_line(conn, line, sizeof(line)) <= 0) {
+            return;
+        }
+        char method[8] = { 0 };
+        char path[64] = { 0 };
+        sscanf(line, "%7s %63s", method, path);
+        int content_length = 0;
+        bool chunked = false;
+        bool close = false;
+        int rate = 0;
+        for (;;) {
+            if (sr_mock_read_line(conn, line, sizeof(line)) < 0) {
+                return;
+            }
+            if (line[0] == 0) {
+                break;
+            }
+            if (strncasecmp(line, "Content-Length:", 15) == 0) {
+                content_length = atoi(line + 15);
+            } else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0 && strcasestr(line, "chunked")) {
+                chunked = true;
+            } else if (strncasecmp(line, "Connection:", 11) == 0 && strcasestr(line, "close")) {
+                close = true;
+            } else if (strncasecmp(line, "Content-Type:", 13) == 0 && strstr(line, "rate=")) {
+                rate = atoi(strstr(line, "rate=") + 5);
+            }
+        }
+        sr_mock_config_t config;
+        sr_mock_config_get(server, &config);
+        int len = _baidu_read_body(conn, content_length, chunked);
+        if (len < 0) {
+            return;
+        }
+        sr_mock_count(server, &server->stats.body_bytes, len);
+        /* Clock probe of sr_clock */
+        if (strcmp(method, "HEAD") == 0) {
+            if (_baidu_reply(conn, 200, "", close) < 0 || close) {
+                return;
+            }
+            continue;
+        }
+        /* OAuth token of baidu_sr_token, "24.<hash>.<expires_in>.<issued>.<id>" */
+        if (strcmp(method, "GET") == 0 && strncmp(path, "/oauth/2.0/token?", 17) == 0) {
+            snprintf(body, sizeof(body), "{\"access_token\":\"24.6c5e1ff107f0e8bcef8c46d3424a0e78.2592000.%ld.282335-1\","
+                     "\"expires_in\":2592000,\"scope\":\"audio_voice_assistant_get\"}", (long)time(NULL));
+            if (_baidu_reply(conn, 200, body, close) < 0 || close) {
+                return;
+            }
+            continue;
+        }
+        if (strcmp(method, "POST") != 0 || len == 0) {
+            pthread_mutex_lock(&server->lock);
+            server->stats.rejected++;
+            pthread_mutex_unlock(&server->lock);
+            _baidu_reply(conn, 400, "{\"err_no\":3300,\"err_msg\":\"speech param error\"}", true);
+            return;
+        }
+        if (rate) {
+            pthread_mutex_lock(&server->lock);
+            server->stats.rate = rate;
+            pthread_mutex_unlock(&server->lock);
+        }
+        if (sr_mock_request(server)) {
+            return;
+        }
+        conn->requests++;
+        sr_mock_sleep_ms(config.reply_delay_ms);
+        close |= config.close_after > 0 && conn->requests >= config.close_after;
+        snprintf(body, sizeof(body), "{\"corpus_no\":\"1\",\"err_msg\":\"success.\",\"err_no\":0,\"result\":[\"%s\"],\"sn\":\"%d\"}",
+                 config.text, conn->requests);
+        if (_baidu_reply(conn, 200, body, close) < 0 || close) {
+            return;
+        }
+    }
+}
+
+sr_mock_server_t *sr_mock_baidu_start(const sr_mock_config_t *config)
+{
+    return sr_mock_server_start(config, "http://127.0.0.1:%d/server_api", _baidu_serve);
+}
@@ -0,0 +1,302 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "sr_mock_server_priv.h"
+
+static void *_conn_thread(void *arg)
+{
+    sr_mock_conn_t *conn = (sr_mock_conn_t *)arg;
+    conn->server->serve(conn);
+    shutdown(conn->fd, SHUT_RDWR);
+    conn->done = true;
+    return NULL;
+}
+
+/* Join the connections that are over, called with the lock held unless the acceptor is gone */
+static void _reap(sr_mock_server_t *server, bool all)
+{
+    sr_mock_conn_t **link = &server->conns;
+    while (*link) {
+        sr_mock_conn_t *conn = *link;
+        if (!all && !conn->done) {
+            link = &conn->next;
+            continue;
+        }
+        shutdown(conn->fd, SHUT_RDWR);
+        pthread_join(conn->thread, NULL);
+        close(conn->fd);
+        *link = conn->next;
+        free(conn);
+    }
+}
+
+static void *_accept_thread(void *arg)
+{
+    sr_mock_server_t *server = (sr_mock_server_t *)arg;
+    while (!server->stopping) {
+        int fd = accept(server->fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            break;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        sr_mock_conn_t *conn = calloc(1, sizeof(sr_mock_conn_t));
+        if (conn == NULL) {
+            close(fd);
+            continue;
+        }
+        conn->server = server;
+        conn->fd = fd;
+        pthread_mutex_lock(&server->lock);
+        _reap(server, false);
+        if (server->stopping || pthread_create(&conn->thread, NULL, _conn_thread, conn) != 0) {
+            pthread_mutex_unlock(&server->lock);
+            close(fd);
+            free(conn);
+            continue;
+        }
+        server->stats.connections++;
+        conn->next = server->conns;
+        server->conns = conn;
+        pthread_mutex_unlock(&server->lock);
+    }
+    return NULL;
+}
+
+sr_mock_server_t *sr_mock_server_start(const sr_mock_config_t *config, const char *url_format,
+                                       void (*serve)(sr_mock_conn_t *conn))
+{
+    sr_mock_server_t *server = calloc(1, sizeof(sr_mock_server_t));
+    if (server == NULL) {
+        return NULL;
+    }
+    pthread_mutex_init(&server->lock, NULL);
+    server->serve = serve;
+    if (config) {
+        server->config = *config;
+    }
+    server->fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    socklen_t addr_len = sizeof(addr);
+    int one = 1;
+    setsockopt(server->fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (server->fd < 0
+            || bind(server->fd, (struct sockaddr *)&addr, sizeof(addr)) != 0
+            || listen(server->fd, 16) != 0
+            || getsockname(server->fd, (struct sockaddr *)&addr, &addr_len) != 0) {
+        fprintf(stderr, "mock server: cannot listen: %s\n", strerror(errno));
+        if (server->fd >= 0) {
+            close(server->fd);
+        }
+        free(server);
+        return NULL;
+    }
+    server->port = ntohs(addr.sin_port);
+    snprintf(server->url, sizeof(server->url), url_format, server->port);
+    if (pthread_create(&server->acceptor, NULL, _accept_thread, server) != 0) {
+        close(server->fd);
+        free(server);
+        return NULL;
+    }
+    return server;
+}
+
+const char *sr_mock_server_url(sr_mock_server_t *server)
+{
+    return server->url;
+}
+
+int sr_mock_server_port(sr_mock_server_t *server)
+{
+    return server->port;
+}
+
+void sr_mock_server_configure(sr_mock_server_t *server, const sr_mock_config_t *config)
+{
+    pthread_mutex_lock(&server->lock);
+    server->config = *config;
+    pthread_mutex_unlock(&server->lock);
+}
+
+void sr_mock_server_stats(sr_mock_server_t *server, sr_mock_stats_t *stats, bool reset)
+{
+    pthread_mutex_lock(&server->lock);
+    *stats = server->stats;
+    if (reset) {
+        memset(&server->stats, 0, sizeof(server->stats));
+    }
+    pthread_mutex_unlock(&server->lock);
+}
+
+void sr_mock_server_stop(sr_mock_server_t *server)
+{
+    if (server == NULL) {
+        return;
+    }
+    server->stopping = true;
+    shutdown(server->fd, SHUT_RDWR);
+    pthread_join(server->acceptor, NULL);
+    close(server->fd);
+    /* No more connections come in, the lock is free for the ones still serving */
+    _reap(server, true);
+    pthread_mutex_destroy(&server->lock);
+    free(server);
+}
+
+void sr_mock_config_get(sr_mock_server_t *server, sr_mock_config_t *config)
+{
+    pthread_mutex_lock(&server->lock);
+    *config = server->config;
+    pthread_mutex_unlock(&server->lock);
+    if (config->text == NULL) {
+        config->text = "ok";
+    }
+}
+
+bool sr_mock_request(sr_mock_server_t *server)
+{
+    pthread_mutex_lock(&server->lock);
+    int n = ++server->stats.requests;
+    bool fail = n == server->config.fail_request;
+    if (fail) {
+        server->stats.failed++;
+    }
+    pthread_mutex_unlock(&server->lock);
+    return fail;
+}
+
+void sr_mock_count(sr_mock_server_t *server, int64_t *counter, int64_t n)
+{
+    pthread_mutex_lock(&server->lock);
+    *counter += n;
+    pthread_mutex_unlock(&server->lock);
+}
+
+static int _fill(sr_mock_conn_t *conn)
+{
+    if (conn->rx_pos == conn->rx_len) {
+        conn->rx_pos = conn->rx_len = 0;
+    }
+    int n;
+    do {
+        n = recv(conn->fd, conn->rx + conn->rx_len, sizeof(conn->rx) - conn->rx_len, 0);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) {
+        return -1;
+    }
+    conn->rx_len += n;
+    sr_mock_count(conn->server, &conn->server->stats.rx_bytes, n);
+    return n;
+}
+
+int sr_mock_read(sr_mock_conn_t *conn, void *buf, int len)
+{
+    char *out = (char *)buf;
+    int got = 0;
+    while (got < len) {
+        if (conn->rx_pos == conn->rx_len && _fill(conn) < 0) {
+            return -1;
+        }
+        int n = conn->rx_len - conn->rx_pos;
+        if (n > len - got) {
+            n = len - got;
+        }
+        memcpy(out + got, conn->rx + conn->rx_pos, n);
+        conn->rx_pos += n;
+        got += n;
+    }
+    return got;
+}
+
+int sr_mock_read_line(sr_mock_conn_t *conn, char *line, int size)
+{
+    int len = 0;
+    for (;;) {
+        if (conn->rx_pos == conn->rx_len && _fill(conn) < 0) {
+            return -1;
+        }
+        char c = conn->rx[conn->rx_pos++];
+        if (c == '\n') {
+            break;
+        }
+        if (len >= size - 1) {
+            return -1;
+        }
+        line[len++] = c;
+    }
+    if (len > 0 && line[len - 1] == '\r') {
+        len--;
+    }
+    line[len] = 0;
+    return len;
+}
+
+int sr_mock_write(sr_mock_conn_t *conn, const void *data, int len)
+{
+    const char *p = (const char *)data;
+    int sent = 0;
+    while (sent < len) {
+        int n = send(conn->fd, p + sent, len - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        sent += n;
+    }
+    sr_mock_count(conn->server, &conn->server->stats.tx_bytes, len);
+    return len;
+}
+
+void sr_mock_http_date(char *out, int size)
+{
+    time_t now = time(NULL);
+    struct tm tm;
+    gmtime_r(&now, &tm);
+    strftime(out, size, "%a, %d %b %Y %H:%M:%S GMT", &tm);
+}
+
+void sr_mock_sleep_ms(int ms)
+{
+    if (ms > 0) {
+        usleep(ms * 1000);
+    }
+}
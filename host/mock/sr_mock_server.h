@@ -0,0 +1,117 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _SR_MOCK_SERVER_H_
+#define _SR_MOCK_SERVER_H_
+
+/*
+ * Loopback stand-ins of both recognizers, for the host tests and benchmarks.
+ *
+ * Each server listens on 127.0.0.1 on a port of its own and serves every
+ * connection in a thread of its own. Baidu is the `server_api` upload over
+ * kept HTTP/1.1 connections, xunfei the `/v2/iat` websocket. Both answer
+ * with `text` and can be told to break a request off, so the retry paths of
+ * the providers get exercised as well.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    const char  *text;              /*!< Text of every result, "ok" if NULL. The strings are referenced */
+    int         reply_delay_ms;     /*!< From the end of a request to its reply */
+    int         fail_request;       /*!< Close the connection instead of answering this request, counted from 1, 0 for none */
+    int         close_after;        /*!< Baidu: close a connection after this many requests, 0 keeps it open */
+    int         partial_every;      /*!< xunfei: interim result every this many audio frames, 0 for none */
+    bool        fail_at_end;        /*!< xunfei: drop the failed session at its last frame instead of its first */
+    int         error_code;         /*!< xunfei: answer the first frame with this code and hang up, 0 for none */
+    const char  *api_key;           /*!< xunfei: check the signed url against these, NULL accepts any */
+    const char  *api_secret;
+} sr_mock_config_t;
+
+typedef struct {
+    int         connections;
+    int         requests;           /*!< Baidu requests or xunfei sessions, those broken off included */
+    int         failed;             /*!< Requests broken off by `fail_request` */
+    int         rejected;           /*!< Malformed requests and bad signatures */
+    int64_t     rx_bytes;           /*!< Everything received: request lines, headers, chunk sizes, websocket frames */
+    int64_t     body_bytes;         /*!< Request bodies or websocket payloads */
+    int64_t     tx_bytes;
+    int         rate;               /*!< Baidu: `rate=` of the last raw upload's Content-Type, 0 if none yet */
+} sr_mock_stats_t;
+
+typedef struct sr_mock_server sr_mock_server_t;
+
+/**
+ * @brief      Start a Baidu `server_api` server, which also answers the OAuth token url and HEAD
+ *
+ * @param[in]  config  The behaviour
+ *
+ * @return     The server, NULL if it could not listen
+ */
+sr_mock_server_t *sr_mock_baidu_start(const sr_mock_config_t *config);
+
+/**
+ * @brief      Start a xunfei `/v2/iat` websocket server
+ *
+ * @param[in]  config  The behaviour
+ *
+ * @return     The server, NULL if it could not listen
+ */
+sr_mock_server_t *sr_mock_xunfei_start(const sr_mock_config_t *config);
+
+/**
+ * @brief      Url of the recognizer, e.g. "http://127.0.0.1:40000/server_api"
+ */
+const char *sr_mock_server_url(sr_mock_server_t *server);
+
+/**
+ * @brief      Port the server listens on
+ */
+int sr_mock_server_port(sr_mock_server_t *server);
+
+/**
+ * @brief      Change the behaviour for the requests to come
+ */
+void sr_mock_server_configure(sr_mock_server_t *server, const sr_mock_config_t *config);
+
+/**
+ * @brief      Counters since the start or the last reset
+ */
+void sr_mock_server_stats(sr_mock_server_t *server, sr_mock_stats_t *stats, bool reset);
+
+/**
+ * @brief      Close every connection and free the server
+ */
+void sr_mock_server_stop(sr_mock_server_t *server);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,87 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _SR_MOCK_SERVER_PRIV_H_
+#define _SR_MOCK_SERVER_PRIV_H_
+
+/* The listener and connection plumbing both servers share */
+
+#include <pthread.h>
+#include "sr_mock_server.h"
+
+#define SR_MOCK_RX_BUFFER   (8*1024)
+#define SR_MOCK_LINE_MAX    (2048)
+
+typedef struct sr_mock_conn sr_mock_conn_t;
+
+struct sr_mock_conn {
+    sr_mock_server_t    *server;
+    int                 fd;
+    pthread_t           thread;
+    volatile bool       done;
+    int                 requests;               /* Served on this connection */
+    char                rx[SR_MOCK_RX_BUFFER];
+    int                 rx_pos;
+    int                 rx_len;
+    sr_mock_conn_t      *next;
+};
+
+struct sr_mock_server {
+    int                 fd;
+    int                 port;
+    char                url[64];
+    pthread_t           acceptor;
+    pthread_mutex_t     lock;
+    volatile bool       stopping;
+    sr_mock_config_t    config;
+    sr_mock_stats_t     stats;
+    sr_mock_conn_t      *conns;
+    void                (*serve)(sr_mock_conn_t *conn);
+};
+
+sr_mock_server_t *sr_mock_server_start(const sr_mock_config_t *config, const char *url_format,
+                                       void (*serve)(sr_mock_conn_t *conn));
+
+/* Snapshot of the configuration, `text` never NULL */
+void sr_mock_config_get(sr_mock_server_t *server, sr_mock_config_t *config);
+
+/* Count a request, returns true if it is the one to break off */
+bool sr_mock_request(sr_mock_server_t *server);
+
+void sr_mock_count(sr_mock_server_t *server, int64_t *counter, int64_t n);
+
+/* Exactly `len` bytes, -1 once the peer closed */
+int sr_mock_read(sr_mock_conn_t *conn, void *buf, int len);
+
+/* One line without its CRLF, NUL terminated, -1 once the peer closed or on an overlong line */
+int sr_mock_read_line(sr_mock_conn_t *conn, char *line, int size);
+
+int sr_mock_write(sr_mock_conn_t *conn, const void *data, int len);
+
+/* Date header value of now */
+void sr_mock_http_date(char *out, int size);
+
+void sr_mock_sleep_ms(int ms);
+
+#endif
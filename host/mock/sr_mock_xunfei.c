@@ -0,0 +1,331 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/sha.h>
+#include "sr_mock_server_priv.h"
+
+#define WS_GUID             "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+#define WS_OPCODE_CONT      (0x00)
+#define WS_OPCODE_TEXT      (0x01)
+#define WS_OPCODE_BINARY    (0x02)
+#define WS_OPCODE_CLOSE     (0x08)
+#define WS_OPCODE_PING      (0x09)
+#define WS_OPCODE_PONG      (0x0A)
+#define WS_MESSAGE_MAX      (64*1024)
+#define IAT_HOST            "ws-api.xfyun.cn"
+#define IAT_PATH            "/v2/iat"
+
+/* Value of query parameter `name`, percent-decoded */
+static bool _query_param(const char *query, const char *name, char *out, int size)
+{
+    int name_len = strlen(name);
+    for (const char *p = query; p && *p; p = strchr(p, '&') ? strchr(p, '&') + 1 : NULL) {
+        if (strncmp(p, name, name_len) != 0 || p[name_len] != '=') {
+            continue;
+        }
+        p += name_len + 1;
+        int len = 0;
+        while (*p && *p != '&' && len < size - 1) {
+            if (*p == '%' && p[1] && p[2]) {
+                char hex[3] = { p[1], p[2], 0 };
+                out[len++] = (char)strtol(hex, NULL, 16);
+                p += 3;
+            } else {
+                out[len++] = *p == '+' ? ' ' : *p;
+                p++;
+            }
+        }
+        out[len] = 0;
+        return true;
+    }
+    return false;
+}
+
+/* The url as xunfei_sr_auth signs it: HMAC-SHA256 over host, date and request line, in a base64 authorization */
+static bool _check_signature(const char *query, const sr_mock_config_t *config)
+{
+    if (config->api_key == NULL) {
+        return true;
+    }
+    char authorization[512], date[64], host[64];
+    if (!_query_param(query, "authorization", authorization, sizeof(authorization))
+            || !_query_param(query, "date", date, sizeof(date))
+            || !_query_param(query, "host", host, sizeof(host))
+            || strcmp(host, IAT_HOST) != 0) {
+        return false;
+    }
+    unsigned char origin[512];
+    int origin_len = EVP_DecodeBlock(origin, (const unsigned char *)authorization, strlen(authorization));
+    if (origin_len < 0) {
+        return false;
+    }
+    origin[origin_len] = 0;
+
+    char sign_data[256];
+    int sign_len = snprintf(sign_data, sizeof(sign_data), "host: %s\ndate: %s\nGET %s HTTP/1.1", host, date, IAT_PATH);
+    unsigned char mac[32];
+    unsigned int mac_len = sizeof(mac);
+    HMAC(EVP_sha256(), config->api_secret, strlen(config->api_secret), (const unsigned char *)sign_data, sign_len,
+         mac, &mac_len);
+    char signature[64];
+    EVP_EncodeBlock((unsigned char *)signature, mac, mac_len);
+
+    char expected[512];
+    snprintf(expected, sizeof(expected),
+             "api_key=\"%s\", algorithm=\"hmac-sha256\", headers=\"host date request-line\", signature=\"%s\"",
+             config->api_key, signature);
+    return strcmp((const char *)origin, expected) == 0;
+}
+
+static bool _handshake(sr_mock_conn_t *conn, const sr_mock_config_t *config)
+{
+    char line[SR_MOCK_LINE_MAX];
+    char target[SR_MOCK_LINE_MAX];
+    char key[64] = { 0 };
+    if (sr_mock_read_line(conn, line, sizeof(line)) <= 0 || sscanf(line, "GET %2047s", target) != 1) {
+        return false;
+    }
+    for (;;) {
+        if (sr_mock_read_line(conn, line, sizeof(line)) < 0) {
+            return false;
+        }
+        if (line[0] == 0) {
+            break;
+        }
+        if (strncasecmp(line, "Sec-WebSocket-Key:", 18) == 0) {
+            sscanf(line + 18, " %63s", key);
+        }
+    }
+    char *query = strchr(target, '?');
+    if (query) {
+        *query++ = 0;
+    }
+    if (strcmp(target, IAT_PATH) != 0 || key[0] == 0 || !_check_signature(query, config)) {
+        const char *reply = "HTTP/1.1 401 Unauthorized\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        sr_mock_write(conn, reply, strlen(reply));
+        pthread_mutex_lock(&conn->server->lock);
+        conn->server->stats.rejected++;
+        pthread_mutex_unlock(&conn->server->lock);
+        return false;
+    }
+    char digest_in[128];
+    unsigned char digest[SHA_DIGEST_LENGTH];
+    char accept[32];
+    snprintf(digest_in, sizeof(digest_in), "%s%s", key, WS_GUID);
+    SHA1((const unsigned char *)digest_in, strlen(digest_in), digest);
+    EVP_EncodeBlock((unsigned char *)accept, digest, sizeof(digest));
+    int len = snprintf(line, sizeof(line),
+                       "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                       "Sec-WebSocket-Accept: %s\r\n\r\n", accept);
+    return sr_mock_write(conn, line, len) == len;
+}
+
+static int _send_frame(sr_mock_conn_t *conn, int opcode, const char *data, int len)
+{
+    unsigned char header[10];
+    int header_len = 2;
+    header[0] = 0x80 | opcode;
+    if (len < 126) {
+        header[1] = len;
+    } else {
+        header[1] = 126;
+        header[2] = len >> 8;
+        header[3] = len & 0xff;
+        header_len = 4;
+    }
+    if (sr_mock_write(conn, header, header_len) < 0 || (len && sr_mock_write(conn, data, len) < 0)) {
+        return -1;
+    }
+    return 0;
+}
+
+/* One whole message, control frames are answered on the way. Returns its opcode, -1 once the connection is gone */
+static int _read_message(sr_mock_conn_t *conn, char *msg, int size, int *msg_len)
+{
+    int opcode = -1;
+    *msg_len = 0;
+    for (;;) {
+        unsigned char header[2];
+        if (sr_mock_read(conn, header, 2) < 0) {
+            return -1;
+        }
+        uint64_t len = header[1] & 0x7f;
+        if (len == 126) {
+            unsigned char ext[2];
+            if (sr_mock_read(conn, ext, 2) < 0) {
+                return -1;
+            }
+            len = (ext[0] << 8) | ext[1];
+        } else if (len == 127) {
+            unsigned char ext[8];
+            if (sr_mock_read(conn, ext, 8) < 0) {
+                return -1;
+            }
+            len = 0;
+            for (int i = 0; i < 8; i++) {
+                len = (len << 8) | ext[i];
+            }
+        }
+        unsigned char mask[4] = { 0 };
+        if ((header[1] & 0x80) && sr_mock_read(conn, mask, 4) < 0) {
+            return -1;
+        }
+        int frame_opcode = header[0] & 0x0f;
+        bool control = frame_opcode & 0x08;
+        char control_data[125];
+        char *payload = control ? control_data : msg + *msg_len;
+        if (len > (uint64_t)(control ? (int)sizeof(control_data) : size - *msg_len)) {
+            return -1;
+        }
+        if (len && sr_mock_read(conn, payload, (int)len) < 0) {
+            return -1;
+        }
+        for (uint64_t i = 0; i < len; i++) {
+            payload[i] ^= mask[i % 4];
+        }
+        sr_mock_count(conn->server, &conn->server->stats.body_bytes, len);
+        if (frame_opcode == WS_OPCODE_PING) {
+            _send_frame(conn, WS_OPCODE_PONG, control_data, (int)len);
+            continue;
+        }
+        if (frame_opcode == WS_OPCODE_CLOSE) {
+            _send_frame(conn, WS_OPCODE_CLOSE, control_data, (int)len);
+            return WS_OPCODE_CLOSE;
+        }
+        if (control) {
+            continue;
+        }
+        if (frame_opcode != WS_OPCODE_CONT) {
+            opcode = frame_opcode;
+        }
+        *msg_len += len;
+        if (header[0] & 0x80) {
+            return opcode;
+        }
+    }
+}
+
+/* `data.status` of an audio frame, -1 if it has none */
+static int _frame_status(const char *msg)
+{
+    const char *data = strstr(msg, "\"data\"");
+    const char *status = data ? strstr(data, "\"status\"") : NULL;
+    if (status == NULL) {
+        return -1;
+    }
+    status = strchr(status + 8, ':');
+    return status ? atoi(status + 1) : -1;
+}
+
+static int _send_result(sr_mock_conn_t *conn, const char *text, int text_len, int status)
+{
+    char reply[1024];
+    int len = snprintf(reply, sizeof(reply),
+                       "{\"code\":0,\"message\":\"success\",\"sid\":\"iat00000001\",\"data\":{\"result\":{\"sn\":1,\"ls\":%s,"
+                       "\"bg\":0,\"ed\":0,\"pgs\":\"rpl\",\"rg\":[1,1],\"ws\":[{\"bg\":0,\"cw\":[{\"sc\":0,\"w\":\"%.*s\"}]}]},"
+                       "\"status\":%d}}",
+                       status == 2 ? "true" : "false", text_len, text, status);
+    return _send_frame(conn, WS_OPCODE_TEXT, reply, len);
+}
+
+static int _send_error(sr_mock_conn_t *conn, int code)
+{
+    char reply[256];
+    int len = snprintf(reply, sizeof(reply), "{\"code\":%d,\"message\":\"rejected\",\"sid\":\"iat00000001\"}", code);
+    return _send_frame(conn, WS_OPCODE_TEXT, reply, len);
+}
+
+static void _xunfei_serve(sr_mock_conn_t *conn)
+{
+    sr_mock_server_t *server = conn->server;
+    sr_mock_config_t config;
+    sr_mock_config_get(server, &config);
+    if (!_handshake(conn, &config)) {
+        return;
+    }
+    bool fail = sr_mock_request(server);
+    char *msg = malloc(WS_MESSAGE_MAX + 1);
+    if (msg == NULL) {
+        return;
+    }
+    int frames = 0;
+    for (;;) {
+        int len;
+        int opcode = _read_message(conn, msg, WS_MESSAGE_MAX, &len);
+        if (opcode < 0 || opcode == WS_OPCODE_CLOSE) {
+            break;
+        }
+        /* The IDF 4.0 client sends the JSON frames as binary messages, the service takes both */
+        if (opcode != WS_OPCODE_TEXT && opcode != WS_OPCODE_BINARY) {
+            continue;
+        }
+        msg[len] = 0;
+        int status = _frame_status(msg);
+        if (status < 0 || (frames == 0 && status != 0)) {
+            pthread_mutex_lock(&server->lock);
+            server->stats.rejected++;
+            pthread_mutex_unlock(&server->lock);
+            break;
+        }
+        frames++;
+        if (fail && (!config.fail_at_end || status == 2)) {
+            /* Dropped without a close frame, in the middle of the utterance or while it waits for the result */
+            break;
+        }
+        if (config.error_code) {
+            /* As for a bad app id or an exhausted quota */
+            _send_error(conn, config.error_code);
+            _send_frame(conn, WS_OPCODE_CLOSE, "\x03\xe8", 2);
+            break;
+        }
+        int text_len = strlen(config.text);
+        if (status == 2) {
+            sr_mock_sleep_ms(config.reply_delay_ms);
+            _send_result(conn, config.text, text_len, 2);
+            /* The service hangs up after the final result */
+            _send_frame(conn, WS_OPCODE_CLOSE, "\x03\xe8", 2);
+            break;
+        }
+        if (config.partial_every > 0 && frames % config.partial_every == 0) {
+            /* The first half of the text, cut at a character boundary */
+            int half = text_len / 2;
+            while (half > 0 && (config.text[half] & 0xc0) == 0x80) {
+                half--;
+            }
+            _send_result(conn, config.text, half, 1);
+        }
+    }
+    free(msg);
+}
+
+sr_mock_server_t *sr_mock_xunfei_start(const sr_mock_config_t *config)
+{
+    return sr_mock_server_start(config, "ws://127.0.0.1:%d" IAT_PATH, _xunfei_serve);
+}
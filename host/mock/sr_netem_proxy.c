@@ -0,0 +1,450 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "sr_netem_proxy.h"
+
+#define NETEM_PROXY_MSS         (1460)
+#define NETEM_PROXY_QUEUE       (64)    /* Segments in flight or queued at the bottleneck, about 90 KB */
+#define NETEM_PROXY_POLL_MS     (10)    /* To notice a reset or the proxy stopping */
+
+typedef struct {
+    int64_t     due_us;                 /* Arrives at the other end then */
+    int         len;
+    char        data[NETEM_PROXY_MSS];
+} netem_segment_t;
+
+typedef struct netem_proxy_conn netem_proxy_conn_t;
+
+struct netem_proxy_conn {
+    sr_netem_proxy_t    *proxy;
+    int                 client_fd;
+    int                 server_fd;
+    pthread_t           thread;
+    volatile bool       broken;         /* Reset, both directions give up */
+    volatile bool       done;
+    netem_proxy_conn_t  *next;
+};
+
+/* One direction of a connection */
+typedef struct {
+    netem_proxy_conn_t  *conn;
+    int                 from;
+    int                 to;
+    bool                uplink;
+    int64_t             link_free_us;   /* The bottleneck is busy until then */
+    int64_t             last_due_us;    /* Segments arrive in order */
+    int64_t             stalled_until;  /* End of the stall last counted, on the uplink */
+    netem_segment_t     queue[NETEM_PROXY_QUEUE];
+    int                 head;
+    int                 count;
+} netem_pump_t;
+
+struct sr_netem_proxy {
+    int                 fd;
+    int                 port;
+    int                 upstream_port;
+    const sr_netem_scenario_t *scenario;
+    int                 script_ms;
+    int64_t             script_start;
+    uint32_t            seed;
+    pthread_t           acceptor;
+    pthread_mutex_t     lock;
+    volatile bool       stopping;
+    sr_netem_proxy_stats_t stats;
+    netem_proxy_conn_t  *conns;
+};
+
+static int64_t _now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint32_t _random(sr_netem_proxy_t *proxy)
+{
+    pthread_mutex_lock(&proxy->lock);
+    proxy->seed = proxy->seed * 1664525 + 1013904223;
+    uint32_t r = proxy->seed >> 8;
+    pthread_mutex_unlock(&proxy->lock);
+    return r;
+}
+
+/* The step the script is at and when it ends, as sr_provider_netem does it */
+static const sr_netem_step_t *_step(sr_netem_proxy_t *proxy, int64_t now, int64_t *step_end)
+{
+    int t = (int)((now - proxy->script_start) / 1000 % proxy->script_ms);
+    int64_t round_start = now - t * 1000LL;
+    int offset = 0;
+    for (int i = 0; i < proxy->scenario->step_count; i++) {
+        const sr_netem_step_t *step = &proxy->scenario->steps[i];
+        offset += step->duration_ms;
+        if (t < offset) {
+            *step_end = round_start + offset * 1000LL;
+            return step;
+        }
+    }
+    *step_end = now;
+    return &proxy->scenario->steps[proxy->scenario->step_count - 1];
+}
+
+/* Half a round trip, give or take half the jitter */
+static int64_t _one_way_us(sr_netem_proxy_t *proxy, const sr_netem_step_t *step)
+{
+    int64_t us = step->rtt_ms * 500LL;
+    if (step->jitter_ms > 0) {
+        us += ((int)(_random(proxy) % (2 * step->jitter_ms + 1)) - step->jitter_ms) * 500LL;
+    }
+    return us > 0 ? us : 0;
+}
+
+static bool _lost(sr_netem_proxy_t *proxy, const sr_netem_step_t *step)
+{
+    return step->loss_permille > 0 && _random(proxy) % 1000 < step->loss_permille;
+}
+
+static void _count(sr_netem_proxy_t *proxy, int *counter, int64_t *bytes, int64_t n)
+{
+    pthread_mutex_lock(&proxy->lock);
+    if (counter) {
+        (*counter)++;
+    }
+    if (bytes) {
+        *bytes += n;
+    }
+    pthread_mutex_unlock(&proxy->lock);
+}
+
+/* RST instead of FIN */
+static void _reset(int fd)
+{
+    struct linger linger = { .l_onoff = 1, .l_linger = 0 };
+    setsockopt(fd, SOL_SOCKET, SO_LINGER, &linger, sizeof(linger));
+    shutdown(fd, SHUT_RDWR);
+}
+
+/* When a segment read now arrives, false if it is lost */
+static bool _schedule(netem_pump_t *pump, int len, int64_t *due)
+{
+    sr_netem_proxy_t *proxy = pump->conn->proxy;
+    int64_t now = _now_us();
+    int64_t step_end;
+    const sr_netem_step_t *step = _step(proxy, now, &step_end);
+    int64_t start = now;
+    if (step->bandwidth_kbps < 0) {
+        start = step_end;
+        if (pump->uplink && now >= pump->stalled_until) {
+            pump->stalled_until = step_end;
+            _count(proxy, &proxy->stats.stalls, NULL, 0);
+        }
+        step = _step(proxy, step_end, &step_end);
+    }
+    if (pump->uplink && _lost(proxy, step)) {
+        return false;
+    }
+    if (pump->uplink && step->bandwidth_kbps > 0) {
+        if (pump->link_free_us > start) {
+            start = pump->link_free_us;
+        }
+        pump->link_free_us = start + len * 8000LL / step->bandwidth_kbps;
+        start = pump->link_free_us;
+    }
+    *due = start + _one_way_us(proxy, step);
+    if (*due < pump->last_due_us) {
+        *due = pump->last_due_us;
+    }
+    pump->last_due_us = *due;
+    return true;
+}
+
+/* Forward until the source closes and its data is delivered, false on a reset or an error */
+static bool _pump(netem_pump_t *pump)
+{
+    netem_proxy_conn_t *conn = pump->conn;
+    sr_netem_proxy_t *proxy = conn->proxy;
+    bool eof = false;
+    while (!conn->broken && !proxy->stopping) {
+        int64_t now = _now_us();
+        while (pump->count > 0 && pump->queue[pump->head].due_us <= now) {
+            netem_segment_t *seg = &pump->queue[pump->head];
+            /* Counted first, the other end may act on the data before send returns */
+            _count(proxy, NULL, pump->uplink ? &proxy->stats.up_bytes : &proxy->stats.down_bytes, seg->len);
+            for (int sent = 0; sent < seg->len;) {
+                int n = send(pump->to, seg->data + sent, seg->len - sent, MSG_NOSIGNAL);
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (n <= 0) {
+                    return false;
+                }
+                sent += n;
+            }
+            pump->head = (pump->head + 1) % NETEM_PROXY_QUEUE;
+            pump->count--;
+        }
+        if (eof && pump->count == 0) {
+            shutdown(pump->to, SHUT_WR);
+            return true;
+        }
+        int timeout = NETEM_PROXY_POLL_MS;
+        if (pump->count > 0) {
+            int64_t wait_ms = (pump->queue[pump->head].due_us - now + 999) / 1000;
+            timeout = wait_ms < timeout ? (int)wait_ms : timeout;
+        }
+        /* A full queue holds the sender back */
+        struct pollfd pfd = {
+            .fd = pump->from,
+            .events = !eof && pump->count < NETEM_PROXY_QUEUE ? POLLIN : 0,
+        };
+        if (poll(&pfd, 1, timeout) <= 0 || (pfd.revents & (POLLIN | POLLHUP | POLLERR)) == 0) {
+            continue;
+        }
+        netem_segment_t *seg = &pump->queue[(pump->head + pump->count) % NETEM_PROXY_QUEUE];
+        int n = recv(pump->from, seg->data, sizeof(seg->data), 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return false;
+        }
+        if (n == 0) {
+            eof = true;
+            continue;
+        }
+        if (!_schedule(pump, n, &seg->due_us)) {
+            return false;
+        }
+        seg->len = n;
+        pump->count++;
+    }
+    return false;
+}
+
+static void *_downlink_thread(void *arg)
+{
+    netem_pump_t *pump = (netem_pump_t *)arg;
+    if (!_pump(pump)) {
+        pump->conn->broken = true;
+    }
+    return NULL;
+}
+
+static void *_conn_thread(void *arg)
+{
+    netem_proxy_conn_t *conn = (netem_proxy_conn_t *)arg;
+    sr_netem_proxy_t *proxy = conn->proxy;
+    int64_t step_end;
+    const sr_netem_step_t *step = _step(proxy, _now_us(), &step_end);
+    bool lost = _lost(proxy, step);
+    /* The handshake takes a round trip, the client's first bytes wait in the socket */
+    usleep(_one_way_us(proxy, step) * 2);
+
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(proxy->upstream_port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    conn->server_fd = lost ? -1 : socket(AF_INET, SOCK_STREAM, 0);
+    if (conn->server_fd < 0 || connect(conn->server_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        if (!lost) {
+            fprintf(stderr, "netem proxy: cannot reach port %d: %s\n", proxy->upstream_port, strerror(errno));
+        }
+        _count(proxy, &proxy->stats.resets, NULL, 0);
+        _reset(conn->client_fd);
+        conn->done = true;
+        return NULL;
+    }
+    int one = 1;
+    setsockopt(conn->server_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    netem_pump_t *up = calloc(1, sizeof(netem_pump_t));
+    netem_pump_t *down = calloc(1, sizeof(netem_pump_t));
+    pthread_t downlink;
+    if (up == NULL || down == NULL) {
+        conn->broken = true;
+    } else {
+        *up = (netem_pump_t) { .conn = conn, .from = conn->client_fd, .to = conn->server_fd, .uplink = true };
+        *down = (netem_pump_t) { .conn = conn, .from = conn->server_fd, .to = conn->client_fd };
+        if (pthread_create(&downlink, NULL, _downlink_thread, down) != 0) {
+            conn->broken = true;
+        } else {
+            if (!_pump(up)) {
+                conn->broken = true;
+            }
+            pthread_join(downlink, NULL);
+        }
+    }
+    if (conn->broken && !proxy->stopping) {
+        _count(proxy, &proxy->stats.resets, NULL, 0);
+        _reset(conn->client_fd);
+        _reset(conn->server_fd);
+    }
+    free(up);
+    free(down);
+    conn->done = true;
+    return NULL;
+}
+
+/* Join the connections that are over, all once the acceptor is gone */
+static void _reap(sr_netem_proxy_t *proxy, bool all)
+{
+    netem_proxy_conn_t **link = &proxy->conns;
+    while (*link) {
+        netem_proxy_conn_t *conn = *link;
+        if (!all && !conn->done) {
+            link = &conn->next;
+            continue;
+        }
+        conn->broken = true;
+        pthread_join(conn->thread, NULL);
+        close(conn->client_fd);
+        if (conn->server_fd >= 0) {
+            close(conn->server_fd);
+        }
+        *link = conn->next;
+        free(conn);
+    }
+}
+
+static void *_accept_thread(void *arg)
+{
+    sr_netem_proxy_t *proxy = (sr_netem_proxy_t *)arg;
+    while (!proxy->stopping) {
+        int fd = accept(proxy->fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            break;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        netem_proxy_conn_t *conn = calloc(1, sizeof(netem_proxy_conn_t));
+        if (conn == NULL) {
+            close(fd);
+            continue;
+        }
+        conn->proxy = proxy;
+        conn->client_fd = fd;
+        conn->server_fd = -1;
+        _reap(proxy, false);
+        if (proxy->stopping || pthread_create(&conn->thread, NULL, _conn_thread, conn) != 0) {
+            close(fd);
+            free(conn);
+            continue;
+        }
+        _count(proxy, &proxy->stats.connections, NULL, 0);
+        conn->next = proxy->conns;
+        proxy->conns = conn;
+    }
+    return NULL;
+}
+
+sr_netem_proxy_t *sr_netem_proxy_start(int upstream_port, const sr_netem_scenario_t *scenario, uint32_t seed)
+{
+    if (scenario == NULL || scenario->step_count <= 0) {
+        return NULL;
+    }
+    sr_netem_proxy_t *proxy = calloc(1, sizeof(sr_netem_proxy_t));
+    if (proxy == NULL) {
+        return NULL;
+    }
+    pthread_mutex_init(&proxy->lock, NULL);
+    proxy->upstream_port = upstream_port;
+    proxy->scenario = scenario;
+    for (int i = 0; i < scenario->step_count; i++) {
+        proxy->script_ms += scenario->steps[i].duration_ms;
+    }
+    proxy->seed = seed ? seed : 1;
+    proxy->fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    socklen_t addr_len = sizeof(addr);
+    int one = 1;
+    setsockopt(proxy->fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (proxy->script_ms <= 0 || proxy->fd < 0
+            || bind(proxy->fd, (struct sockaddr *)&addr, sizeof(addr)) != 0
+            || listen(proxy->fd, 16) != 0
+            || getsockname(proxy->fd, (struct sockaddr *)&addr, &addr_len) != 0) {
+        fprintf(stderr, "netem proxy: cannot listen: %s\n", strerror(errno));
+        if (proxy->fd >= 0) {
+            close(proxy->fd);
+        }
+        pthread_mutex_destroy(&proxy->lock);
+        free(proxy);
+        return NULL;
+    }
+    proxy->port = ntohs(addr.sin_port);
+    proxy->script_start = _now_us();
+    if (pthread_create(&proxy->acceptor, NULL, _accept_thread, proxy) != 0) {
+        close(proxy->fd);
+        pthread_mutex_destroy(&proxy->lock);
+        free(proxy);
+        return NULL;
+    }
+    return proxy;
+}
+
+int sr_netem_proxy_port(sr_netem_proxy_t *proxy)
+{
+    return proxy->port;
+}
+
+void sr_netem_proxy_stats(sr_netem_proxy_t *proxy, sr_netem_proxy_stats_t *stats, bool reset)
+{
+    pthread_mutex_lock(&proxy->lock);
+    *stats = proxy->stats;
+    if (reset) {
+        memset(&proxy->stats, 0, sizeof(proxy->stats));
+    }
+    pthread_mutex_unlock(&proxy->lock);
+}
+
+void sr_netem_proxy_stop(sr_netem_proxy_t *proxy)
+{
+    if (proxy == NULL) {
+        return;
+    }
+    proxy->stopping = true;
+    shutdown(proxy->fd, SHUT_RDWR);
+    pthread_join(proxy->acceptor, NULL);
+    close(proxy->fd);
+    _reap(proxy, true);
+    pthread_mutex_destroy(&proxy->lock);
+    free(proxy);
+}
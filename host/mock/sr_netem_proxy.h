@@ -0,0 +1,96 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _SR_NETEM_PROXY_H_
+#define _SR_NETEM_PROXY_H_
+
+/*
+ * A bad network between the host-built client and the mock servers.
+ *
+ * A TCP proxy on 127.0.0.1 that forwards every connection to a mock server
+ * under the scripted conditions of sr_provider_netem.h, the same scenarios
+ * the device emulates inside the provider:
+ *
+ *  - the uplink is paced to `bandwidth_kbps` in segments of one MSS, and
+ *    what does not fit in the queue of the bottleneck holds the client's
+ *    writes back, as a full send window does;
+ *  - each segment arrives half a round trip later, give or take half the
+ *    jitter, in order; connecting takes a round trip;
+ *  - a stall holds both directions until its step is over;
+ *  - a lost segment or connection attempt resets the connection, the way a
+ *    Wi-Fi drop ends up for the client.
+ *
+ * The script runs from sr_netem_proxy_start and loops. Loss and jitter come
+ * from `seed`, the timing of the run decides which segments they hit.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sr_provider_netem.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    int         connections;
+    int         resets;             /*!< Connections reset by a lost segment or connection attempt */
+    int         stalls;             /*!< Stalled steps that held data back */
+    int64_t     up_bytes;           /*!< Forwarded to the server */
+    int64_t     down_bytes;         /*!< Forwarded to the client */
+} sr_netem_proxy_stats_t;
+
+typedef struct sr_netem_proxy sr_netem_proxy_t;
+
+/**
+ * @brief      Start a proxy to a server on 127.0.0.1
+ *
+ * @param[in]  upstream_port  Port of the server, see sr_mock_server_port
+ * @param[in]  scenario       The network conditions, referenced
+ * @param[in]  seed           Of loss and jitter, 1 if 0
+ *
+ * @return     The proxy, NULL if it could not listen
+ */
+sr_netem_proxy_t *sr_netem_proxy_start(int upstream_port, const sr_netem_scenario_t *scenario, uint32_t seed);
+
+/**
+ * @brief      Port the proxy listens on, to put in the client's url in place of the server's
+ */
+int sr_netem_proxy_port(sr_netem_proxy_t *proxy);
+
+/**
+ * @brief      Counters since the start or the last reset
+ */
+void sr_netem_proxy_stats(sr_netem_proxy_t *proxy, sr_netem_proxy_stats_t *stats, bool reset);
+
+/**
+ * @brief      Close every connection and free the proxy
+ */
+void sr_netem_proxy_stop(sr_netem_proxy_t *proxy);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,154 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+#include "esp_log.h"
+#include "audio_error.h"
+#include "amrwb_encoder.h"
+#ifdef SR_HOST_VO_AMRWBENC
+#include <vo-amrwbenc/enc_if.h>
+#endif
+
+static const char *TAG = "AMRWB_ENCODER";
+
+#define AMRWB_FRAME_SAMPLES     (320)
+#define AMRWB_HEADER            "#!AMR-WB\n"
+
+/* Storage size of a frame of each mode, its table of contents byte included */
+static const int s_frame_bytes[] = { 18, 24, 33, 37, 41, 47, 51, 59, 61 };
+
+typedef struct {
+    amrwb_encoder_bitrate_t mode;
+    bool                    contain_header;
+    bool                    header_sent;
+#ifdef SR_HOST_VO_AMRWBENC
+    void                    *state;
+#endif
+    uint8_t                 frame[64];
+} amrwb_encoder_t;
+
+static esp_err_t _amrwb_open(audio_element_handle_t self)
+{
+    amrwb_encoder_t *enc = (amrwb_encoder_t *)audio_element_getdata(self);
+    enc->header_sent = false;
+#ifdef SR_HOST_VO_AMRWBENC
+    enc->state = E_IF_init();
+    AUDIO_MEM_CHECK(TAG, enc->state, return ESP_FAIL);
+#endif
+    return ESP_OK;
+}
+
+static esp_err_t _amrwb_close(audio_element_handle_t self)
+{
+#ifdef SR_HOST_VO_AMRWBENC
+    amrwb_encoder_t *enc = (amrwb_encoder_t *)audio_element_getdata(self);
+    if (enc->state) {
+        E_IF_exit(enc->state);
+        enc->state = NULL;
+    }
+#endif
+    return ESP_OK;
+}
+
+static int _amrwb_encode(amrwb_encoder_t *enc, const int16_t *speech)
+{
+#ifdef SR_HOST_VO_AMRWBENC
+    return E_IF_encode(enc->state, enc->mode, speech, enc->frame, 0);
+#else
+    /* Digest of the frame in place of the bit stream, so the payload still follows the audio */
+    int len = s_frame_bytes[enc->mode];
+    uint32_t h = 2166136261u;
+    enc->frame[0] = (enc->mode << 3) | 0x04;
+    for (int i = 1; i < len; i++) {
+        for (int j = i - 1; j < AMRWB_FRAME_SAMPLES; j += len - 1) {
+            h = (h ^ (uint16_t)speech[j]) * 16777619u;
+        }
+        enc->frame[i] = h >> 24;
+    }
+    return len;
+#endif
+}
+
+static int _amrwb_process(audio_element_handle_t self, char *in_buffer, int in_len)
+{
+    amrwb_encoder_t *enc = (amrwb_encoder_t *)audio_element_getdata(self);
+    int r_size = audio_element_input(self, in_buffer, in_len);
+    if (r_size <= 0) {
+        return r_size;
+    }
+    if (r_size < in_len) {
+        memset(in_buffer + r_size, 0, in_len - r_size);
+    }
+    if (enc->contain_header && !enc->header_sent) {
+        int ret = audio_element_output(self, AMRWB_HEADER, strlen(AMRWB_HEADER));
+        if (ret <= 0) {
+            return ret;
+        }
+        enc->header_sent = true;
+    }
+    int len = _amrwb_encode(enc, (const int16_t *)in_buffer);
+    if (len <= 0) {
+        ESP_LOGE(TAG, "Failed to encode");
+        return AEL_PROCESS_FAIL;
+    }
+    int ret = audio_element_output(self, (char *)enc->frame, len);
+    return ret <= 0 ? ret : r_size;
+}
+
+static esp_err_t _amrwb_destroy(audio_element_handle_t self)
+{
+    free(audio_element_getdata(self));
+    return ESP_OK;
+}
+
+audio_element_handle_t amrwb_encoder_init(amrwb_encoder_cfg_t *config)
+{
+    if (config->bitrate_mode > AMRWB_ENC_BITRATE_MD2385) {
+        ESP_LOGE(TAG, "Unknown bit rate mode %d", config->bitrate_mode);
+        return NULL;
+    }
+    amrwb_encoder_t *enc = calloc(1, sizeof(amrwb_encoder_t));
+    AUDIO_MEM_CHECK(TAG, enc, return NULL);
+    enc->mode = config->bitrate_mode;
+    enc->contain_header = config->contain_amrwb_header;
+
+    audio_element_cfg_t cfg = DEFAULT_AUDIO_ELEMENT_CONFIG();
+    cfg.open = _amrwb_open;
+    cfg.process = _amrwb_process;
+    cfg.close = _amrwb_close;
+    cfg.destroy = _amrwb_destroy;
+    cfg.buffer_len = AMRWB_FRAME_SAMPLES * sizeof(int16_t);
+    cfg.task_stack = config->task_stack;
+    cfg.task_prio = config->task_prio;
+    cfg.task_core = config->task_core;
+    cfg.out_rb_size = config->out_rb_size;
+    cfg.tag = "amrwb";
+    audio_element_handle_t el = audio_element_init(&cfg);
+    AUDIO_MEM_CHECK(TAG, el, {
+        free(enc);
+        return NULL;
+    });
+    audio_element_setdata(el, enc);
+    return el;
+}
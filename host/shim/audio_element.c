@@ -0,0 +1,538 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/event_groups.h"
+#include "esp_log.h"
+#include "audio_error.h"
+#include "audio_element.h"
+
+static const char *TAG = "AUDIO_ELEMENT";
+
+#define STOPPED_BIT         BIT0
+#define STARTED_BIT         BIT1
+#define RESUMED_BIT         BIT2
+#define DESTROYED_BIT       BIT3
+
+#define AEL_CMD_QUEUE_SIZE  (8)
+#define AEL_RESUME_WAIT_MS  (2000)
+
+struct audio_element {
+    el_io_func                  open;
+    process_func                process;
+    el_io_func                  close;
+    el_io_func                  destroy;
+    char                        *tag;
+    void                        *data;
+    char                        *buf;
+    int                         buf_len;
+    int                         task_stack;
+    int                         task_prio;
+    int                         task_core;
+    int                         out_rb_size;
+    ringbuf_handle_t            in_rb;
+    ringbuf_handle_t            out_rb;
+    TickType_t                  input_wait;
+    TickType_t                  output_wait;
+    volatile audio_element_state_t state;
+    volatile bool               is_open;
+    volatile bool               is_running;
+    volatile bool               task_run;
+    QueueHandle_t               cmd;
+    EventGroupHandle_t          state_event;
+    audio_event_iface_handle_t  iface;          /* Status reports go to its listeners */
+};
+
+static void _el_report_status(audio_element_handle_t el, audio_element_status_t status)
+{
+    audio_event_iface_msg_t msg = {
+        .cmd = AEL_MSG_CMD_REPORT_STATUS,
+        .data = (void *)(intptr_t)status,
+        .data_len = sizeof(status),
+        .source = el,
+        .source_type = AUDIO_ELEMENT_TYPE_ELEMENT,
+    };
+    audio_event_iface_sendout(el->iface, &msg);
+}
+
+static void _el_close(audio_element_handle_t el)
+{
+    if (el->is_open && el->close) {
+        el->close(el);
+    }
+    el->is_open = false;
+}
+
+static void _el_on_finish(audio_element_handle_t el)
+{
+    if (el->state == AEL_STATE_ERROR || el->state == AEL_STATE_STOPPED) {
+        return;
+    }
+    _el_close(el);
+    el->state = AEL_STATE_FINISHED;
+    _el_report_status(el, AEL_STATUS_STATE_FINISHED);
+    el->is_running = false;
+    xEventGroupSetBits(el->state_event, STOPPED_BIT);
+}
+
+static void _el_on_stop(audio_element_handle_t el)
+{
+    if (el->state != AEL_STATE_FINISHED && el->state != AEL_STATE_STOPPED) {
+        _el_close(el);
+        el->state = AEL_STATE_STOPPED;
+        _el_report_status(el, AEL_STATUS_STATE_STOPPED);
+    }
+    el->is_running = false;
+    xEventGroupSetBits(el->state_event, STOPPED_BIT);
+}
+
+static void _el_on_error(audio_element_handle_t el)
+{
+    _el_close(el);
+    el->state = AEL_STATE_ERROR;
+    el->is_running = false;
+    xEventGroupSetBits(el->state_event, STOPPED_BIT);
+}
+
+static void _el_on_resume(audio_element_handle_t el)
+{
+    if (el->state == AEL_STATE_RUNNING) {
+        _el_report_status(el, AEL_STATUS_STATE_RUNNING);
+        xEventGroupSetBits(el->state_event, RESUMED_BIT);
+        return;
+    }
+    if (el->state != AEL_STATE_INIT && el->state != AEL_STATE_PAUSED) {
+        audio_element_reset_output_ringbuf(el);
+    }
+    el->state = AEL_STATE_RUNNING;
+    _el_report_status(el, AEL_STATUS_STATE_RUNNING);
+    xEventGroupClearBits(el->state_event, STOPPED_BIT);
+    el->is_running = true;
+    xEventGroupSetBits(el->state_event, RESUMED_BIT);
+}
+
+static void _el_on_cmd(audio_element_handle_t el, int cmd)
+{
+    switch (cmd) {
+        case AEL_MSG_CMD_RESUME:
+            _el_on_resume(el);
+            break;
+        case AEL_MSG_CMD_STOP:
+            _el_on_stop(el);
+            break;
+        case AEL_MSG_CMD_FINISH:
+            _el_on_finish(el);
+            break;
+        case AEL_MSG_CMD_DESTROY:
+            el->task_run = false;
+            break;
+        default:
+            ESP_LOGW(TAG, "[%s] Unknown command %d", el->tag, cmd);
+            break;
+    }
+}
+
+static void _el_process_running(audio_element_handle_t el)
+{
+    if (!el->is_open) {
+        if (el->open && el->open(el) != ESP_OK) {
+            ESP_LOGE(TAG, "[%s] Failed to open", el->tag);
+            _el_report_status(el, AEL_STATUS_ERROR_OPEN);
+            _el_on_error(el);
+            return;
+        }
+        el->is_open = true;
+    }
+    int ret = el->process(el, el->buf, el->buf_len);
+    if (ret > 0) {
+        return;
+    }
+    switch (ret) {
+        case AEL_IO_TIMEOUT:
+            break;
+        case AEL_IO_ABORT:
+            _el_on_stop(el);
+            break;
+        case AEL_IO_DONE:
+        case AEL_IO_OK:
+            _el_on_finish(el);
+            break;
+        default:
+            ESP_LOGE(TAG, "[%s] Process failed, %d", el->tag, ret);
+            _el_report_status(el, AEL_STATUS_ERROR_PROCESS);
+            _el_on_error(el);
+            break;
+    }
+}
+
+static void _el_task(void *pv)
+{
+    audio_element_handle_t el = (audio_element_handle_t)pv;
+    el->state = AEL_STATE_INIT;
+    xEventGroupSetBits(el->state_event, STARTED_BIT);
+    while (el->task_run) {
+        int cmd;
+        while (el->task_run && xQueueReceive(el->cmd, &cmd, el->is_running ? 0 : portMAX_DELAY) == pdTRUE) {
+            _el_on_cmd(el, cmd);
+        }
+        if (el->task_run && el->is_running) {
+            _el_process_running(el);
+        }
+    }
+    _el_close(el);
+    el->is_running = false;
+    xEventGroupSetBits(el->state_event, STOPPED_BIT | DESTROYED_BIT);
+    vTaskDelete(NULL);
+}
+
+static esp_err_t _el_cmd_send(audio_element_handle_t el, int cmd)
+{
+    if (xQueueSend(el->cmd, &cmd, portMAX_DELAY) != pdPASS) {
+        ESP_LOGE(TAG, "[%s] Command %d not sent", el->tag, cmd);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+audio_element_handle_t audio_element_init(audio_element_cfg_t *config)
+{
+    audio_element_handle_t el = calloc(1, sizeof(struct audio_element));
+    AUDIO_MEM_CHECK(TAG, el, return NULL);
+    el->open = config->open;
+    el->process = config->process;
+    el->close = config->close;
+    el->destroy = config->destroy;
+    el->data = config->data;
+    el->buf_len = config->buffer_len > 0 ? config->buffer_len : DEFAULT_ELEMENT_BUFFER_LENGTH;
+    el->task_stack = config->task_stack;
+    el->task_prio = config->task_prio;
+    el->task_core = config->task_core;
+    el->out_rb_size = config->out_rb_size > 0 ? config->out_rb_size : DEFAULT_ELEMENT_RINGBUF_SIZE;
+    el->input_wait = portMAX_DELAY;
+    el->output_wait = portMAX_DELAY;
+    el->state = AEL_STATE_INIT;
+    el->tag = strdup(config->tag ? config->tag : "unknown");
+    el->buf = malloc(el->buf_len);
+    el->cmd = xQueueCreate(AEL_CMD_QUEUE_SIZE, sizeof(int));
+    el->state_event = xEventGroupCreate();
+    audio_event_iface_cfg_t evt_cfg = AUDIO_EVENT_IFACE_DEFAULT_CFG();
+    el->iface = audio_event_iface_init(&evt_cfg);
+    AUDIO_MEM_CHECK(TAG, el->tag && el->buf && el->cmd && el->state_event && el->iface, {
+        audio_element_deinit(el);
+        return NULL;
+    });
+    xEventGroupSetBits(el->state_event, STOPPED_BIT);
+    return el;
+}
+
+esp_err_t audio_element_deinit(audio_element_handle_t el)
+{
+    if (el == NULL) {
+        return ESP_FAIL;
+    }
+    if (el->state_event) {
+        audio_element_terminate(el);
+    }
+    if (el->destroy) {
+        el->destroy(el);
+    }
+    if (el->iface) {
+        audio_event_iface_destroy(el->iface);
+    }
+    if (el->state_event) {
+        vEventGroupDelete(el->state_event);
+    }
+    if (el->cmd) {
+        vQueueDelete(el->cmd);
+    }
+    free(el->buf);
+    free(el->tag);
+    free(el);
+    return ESP_OK;
+}
+
+esp_err_t audio_element_setdata(audio_element_handle_t el, void *data)
+{
+    el->data = data;
+    return ESP_OK;
+}
+
+void *audio_element_getdata(audio_element_handle_t el)
+{
+    return el->data;
+}
+
+char *audio_element_get_tag(audio_element_handle_t el)
+{
+    return el->tag;
+}
+
+esp_err_t audio_element_set_tag(audio_element_handle_t el, const char *tag)
+{
+    char *copy = strdup(tag);
+    AUDIO_MEM_CHECK(TAG, copy, return ESP_ERR_NO_MEM);
+    free(el->tag);
+    el->tag = copy;
+    return ESP_OK;
+}
+
+audio_element_state_t audio_element_get_state(audio_element_handle_t el)
+{
+    return el->state;
+}
+
+audio_element_err_t audio_element_input(audio_element_handle_t el, char *buffer, int wanted_size)
+{
+    if (el->in_rb == NULL) {
+        ESP_LOGE(TAG, "[%s] No input ring", el->tag);
+        return AEL_IO_FAIL;
+    }
+    int ret = rb_read(el->in_rb, buffer, wanted_size, el->input_wait);
+    if (ret > 0) {
+        return ret;
+    }
+    switch (ret) {
+        case RB_ABORT:
+            return AEL_IO_ABORT;
+        case RB_TIMEOUT:
+            return AEL_IO_TIMEOUT;
+        case RB_DONE:
+        case RB_OK:
+            if (el->state == AEL_STATE_INIT) {
+                return AEL_IO_OK;
+            }
+            audio_element_set_ringbuf_done(el);
+            _el_report_status(el, AEL_STATUS_INPUT_DONE);
+            return AEL_IO_DONE;
+        default:
+            _el_report_status(el, AEL_STATUS_ERROR_INPUT);
+            return AEL_IO_FAIL;
+    }
+}
+
+audio_element_err_t audio_element_output(audio_element_handle_t el, char *buffer, int write_size)
+{
+    if (el->out_rb == NULL) {
+        return write_size;
+    }
+    int ret = rb_write(el->out_rb, buffer, write_size, el->output_wait);
+    if (ret > 0) {
+        return ret;
+    }
+    switch (ret) {
+        case RB_ABORT:
+            return AEL_IO_ABORT;
+        case RB_TIMEOUT:
+            return AEL_IO_TIMEOUT;
+        default:
+            _el_report_status(el, AEL_STATUS_ERROR_OUTPUT);
+            return AEL_IO_FAIL;
+    }
+}
+
+esp_err_t audio_element_set_input_timeout(audio_element_handle_t el, TickType_t timeout)
+{
+    el->input_wait = timeout;
+    return ESP_OK;
+}
+
+esp_err_t audio_element_set_output_timeout(audio_element_handle_t el, TickType_t timeout)
+{
+    el->output_wait = timeout;
+    return ESP_OK;
+}
+
+esp_err_t audio_element_set_input_ringbuf(audio_element_handle_t el, ringbuf_handle_t rb)
+{
+    el->in_rb = rb;
+    return ESP_OK;
+}
+
+ringbuf_handle_t audio_element_get_input_ringbuf(audio_element_handle_t el)
+{
+    return el->in_rb;
+}
+
+esp_err_t audio_element_set_output_ringbuf(audio_element_handle_t el, ringbuf_handle_t rb)
+{
+    el->out_rb = rb;
+    return ESP_OK;
+}
+
+ringbuf_handle_t audio_element_get_output_ringbuf(audio_element_handle_t el)
+{
+    return el->out_rb;
+}
+
+int audio_element_get_output_ringbuf_size(audio_element_handle_t el)
+{
+    return el->out_rb_size;
+}
+
+esp_err_t audio_element_run(audio_element_handle_t el)
+{
+    if (el->task_run) {
+        ESP_LOGD(TAG, "[%s] Already running", el->tag);
+        return ESP_OK;
+    }
+    if (el->task_stack <= 0) {
+        el->task_run = true;
+        el->is_running = true;
+        el->state = AEL_STATE_RUNNING;
+        xEventGroupClearBits(el->state_event, STOPPED_BIT);
+        _el_report_status(el, AEL_STATUS_STATE_RUNNING);
+        return ESP_OK;
+    }
+    xEventGroupClearBits(el->state_event, STARTED_BIT | DESTROYED_BIT);
+    el->task_run = true;
+    if (xTaskCreatePinnedToCore(_el_task, el->tag, el->task_stack, el, el->task_prio, NULL, el->task_core) != pdPASS) {
+        ESP_LOGE(TAG, "[%s] Error create element task", el->tag);
+        el->task_run = false;
+        return ESP_FAIL;
+    }
+    xEventGroupWaitBits(el->state_event, STARTED_BIT, pdFALSE, pdTRUE, portMAX_DELAY);
+    return ESP_OK;
+}
+
+esp_err_t audio_element_resume(audio_element_handle_t el)
+{
+    if (!el->task_run) {
+        return ESP_FAIL;
+    }
+    if (el->task_stack <= 0) {
+        el->is_running = true;
+        el->state = AEL_STATE_RUNNING;
+        xEventGroupClearBits(el->state_event, STOPPED_BIT);
+        return ESP_OK;
+    }
+    xEventGroupClearBits(el->state_event, RESUMED_BIT);
+    if (_el_cmd_send(el, AEL_MSG_CMD_RESUME) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    if (!(xEventGroupWaitBits(el->state_event, RESUMED_BIT, pdFALSE, pdTRUE, AEL_RESUME_WAIT_MS / portTICK_PERIOD_MS)
+            & RESUMED_BIT)) {
+        ESP_LOGW(TAG, "[%s] Not resumed within %d ms", el->tag, AEL_RESUME_WAIT_MS);
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_element_stop(audio_element_handle_t el)
+{
+    if (!el->task_run) {
+        return ESP_OK;
+    }
+    if (!el->is_running || el->task_stack <= 0) {
+        el->is_running = false;
+        if (el->task_stack <= 0) {
+            el->state = AEL_STATE_STOPPED;
+        }
+        xEventGroupSetBits(el->state_event, STOPPED_BIT);
+        _el_report_status(el, AEL_STATUS_STATE_STOPPED);
+        return ESP_OK;
+    }
+    if (_el_cmd_send(el, AEL_MSG_CMD_STOP) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    if (el->out_rb) {
+        rb_abort(el->out_rb);
+    }
+    if (el->in_rb) {
+        rb_abort(el->in_rb);
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_element_wait_for_stop(audio_element_handle_t el)
+{
+    xEventGroupWaitBits(el->state_event, STOPPED_BIT, pdFALSE, pdTRUE, portMAX_DELAY);
+    return ESP_OK;
+}
+
+esp_err_t audio_element_terminate(audio_element_handle_t el)
+{
+    if (!el->task_run) {
+        return ESP_OK;
+    }
+    if (el->task_stack <= 0) {
+        el->task_run = false;
+        el->is_running = false;
+        return ESP_OK;
+    }
+    if (_el_cmd_send(el, AEL_MSG_CMD_DESTROY) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    /* The task may be blocked on a ring rather than waiting for commands */
+    if (el->out_rb) {
+        rb_abort(el->out_rb);
+    }
+    if (el->in_rb) {
+        rb_abort(el->in_rb);
+    }
+    xEventGroupWaitBits(el->state_event, DESTROYED_BIT, pdFALSE, pdTRUE, portMAX_DELAY);
+    return ESP_OK;
+}
+
+esp_err_t audio_element_reset_state(audio_element_handle_t el)
+{
+    el->state = AEL_STATE_INIT;
+    return ESP_OK;
+}
+
+esp_err_t audio_element_reset_input_ringbuf(audio_element_handle_t el)
+{
+    if (el->in_rb) {
+        rb_reset(el->in_rb);
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_element_reset_output_ringbuf(audio_element_handle_t el)
+{
+    if (el->out_rb) {
+        rb_reset(el->out_rb);
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_element_set_ringbuf_done(audio_element_handle_t el)
+{
+    if (el->out_rb) {
+        rb_done_write(el->out_rb);
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_element_msg_set_listener(audio_element_handle_t el, audio_event_iface_handle_t listener)
+{
+    return audio_event_iface_set_listener(el->iface, listener);
+}
+
+esp_err_t audio_element_msg_remove_listener(audio_element_handle_t el, audio_event_iface_handle_t listener)
+{
+    return audio_event_iface_remove_listener(listener, el->iface);
+}
@@ -0,0 +1,126 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "audio_error.h"
+#include "audio_event_iface.h"
+
+static const char *TAG = "AUDIO_EVT";
+
+#define AUDIO_EVT_MAX_LISTENERS (8)
+
+struct audio_event_iface {
+    QueueHandle_t               queue;          /* Messages for this interface as a listener */
+    SemaphoreHandle_t           lock;
+    audio_event_iface_handle_t  listeners[AUDIO_EVT_MAX_LISTENERS];
+    int                         listener_count;
+};
+
+audio_event_iface_handle_t audio_event_iface_init(audio_event_iface_cfg_t *config)
+{
+    struct audio_event_iface *evt = calloc(1, sizeof(struct audio_event_iface));
+    AUDIO_MEM_CHECK(TAG, evt, return NULL);
+    int size = config->external_queue_size > 0 ? config->external_queue_size : DEFAULT_AUDIO_EVENT_IFACE_SIZE;
+    evt->queue = xQueueCreate(size, sizeof(audio_event_iface_msg_t));
+    evt->lock = xSemaphoreCreateMutex();
+    AUDIO_MEM_CHECK(TAG, evt->queue && evt->lock, {
+        audio_event_iface_destroy(evt);
+        return NULL;
+    });
+    return evt;
+}
+
+esp_err_t audio_event_iface_destroy(audio_event_iface_handle_t evt)
+{
+    if (evt == NULL) {
+        return ESP_FAIL;
+    }
+    if (evt->queue) {
+        vQueueDelete(evt->queue);
+    }
+    if (evt->lock) {
+        vSemaphoreDelete(evt->lock);
+    }
+    free(evt);
+    return ESP_OK;
+}
+
+esp_err_t audio_event_iface_set_listener(audio_event_iface_handle_t evt, audio_event_iface_handle_t listener)
+{
+    if (evt == NULL || listener == NULL) {
+        return ESP_FAIL;
+    }
+    esp_err_t ret = ESP_OK;
+    xSemaphoreTake(evt->lock, portMAX_DELAY);
+    int i;
+    for (i = 0; i < evt->listener_count && evt->listeners[i] != listener; i++);
+    if (i == evt->listener_count) {
+        if (evt->listener_count < AUDIO_EVT_MAX_LISTENERS) {
+            evt->listeners[evt->listener_count++] = listener;
+        } else {
+            ESP_LOGE(TAG, "Too many listeners");
+            ret = ESP_FAIL;
+        }
+    }
+    xSemaphoreGive(evt->lock);
+    return ret;
+}
+
+esp_err_t audio_event_iface_remove_listener(audio_event_iface_handle_t listener, audio_event_iface_handle_t evt)
+{
+    if (evt == NULL || listener == NULL) {
+        return ESP_FAIL;
+    }
+    xSemaphoreTake(evt->lock, portMAX_DELAY);
+    for (int i = 0; i < evt->listener_count; i++) {
+        if (evt->listeners[i] == listener) {
+            evt->listeners[i] = evt->listeners[--evt->listener_count];
+            break;
+        }
+    }
+    xSemaphoreGive(evt->lock);
+    return ESP_OK;
+}
+
+esp_err_t audio_event_iface_sendout(audio_event_iface_handle_t evt, audio_event_iface_msg_t *msg)
+{
+    esp_err_t ret = ESP_OK;
+    xSemaphoreTake(evt->lock, portMAX_DELAY);
+    for (int i = 0; i < evt->listener_count; i++) {
+        if (xQueueSend(evt->listeners[i]->queue, msg, 0) != pdPASS) {
+            ret = ESP_FAIL;
+        }
+    }
+    xSemaphoreGive(evt->lock);
+    return ret;
+}
+
+esp_err_t audio_event_iface_listen(audio_event_iface_handle_t evt, audio_event_iface_msg_t *msg, TickType_t wait_time)
+{
+    return xQueueReceive(evt->queue, msg, wait_time) == pdTRUE ? ESP_OK : ESP_FAIL;
+}
@@ -0,0 +1,264 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "audio_error.h"
+#include "audio_pipeline.h"
+
+static const char *TAG = "AUDIO_PIPELINE";
+
+#define AUDIO_PIPELINE_MAX_ELEMENTS (16)
+
+typedef struct {
+    audio_element_handle_t  el;
+    bool                    linked;
+    ringbuf_handle_t        rb;             /* Output ring created by audio_pipeline_link */
+} audio_pipeline_item_t;
+
+struct audio_pipeline {
+    audio_pipeline_item_t       items[AUDIO_PIPELINE_MAX_ELEMENTS];
+    int                         count;
+    int                         rb_size;
+    audio_element_state_t       state;
+    audio_event_iface_handle_t  listener;
+};
+
+audio_pipeline_handle_t audio_pipeline_init(audio_pipeline_cfg_t *config)
+{
+    audio_pipeline_handle_t pipeline = calloc(1, sizeof(struct audio_pipeline));
+    AUDIO_MEM_CHECK(TAG, pipeline, return NULL);
+    pipeline->rb_size = config->rb_size > 0 ? config->rb_size : DEFAULT_PIPELINE_RINGBUF_SIZE;
+    pipeline->state = AEL_STATE_INIT;
+    return pipeline;
+}
+
+esp_err_t audio_pipeline_deinit(audio_pipeline_handle_t pipeline)
+{
+    if (pipeline == NULL) {
+        return ESP_FAIL;
+    }
+    audio_pipeline_terminate(pipeline);
+    audio_pipeline_unlink(pipeline);
+    free(pipeline);
+    return ESP_OK;
+}
+
+esp_err_t audio_pipeline_register(audio_pipeline_handle_t pipeline, audio_element_handle_t el, const char *name)
+{
+    if (pipeline == NULL || el == NULL || name == NULL) {
+        return ESP_FAIL;
+    }
+    if (pipeline->count == AUDIO_PIPELINE_MAX_ELEMENTS) {
+        ESP_LOGE(TAG, "Too many elements");
+        return ESP_FAIL;
+    }
+    audio_pipeline_unregister(pipeline, el);
+    audio_element_set_tag(el, name);
+    pipeline->items[pipeline->count++] = (audio_pipeline_item_t) {
+        .el = el,
+    };
+    return ESP_OK;
+}
+
+esp_err_t audio_pipeline_unregister(audio_pipeline_handle_t pipeline, audio_element_handle_t el)
+{
+    for (int i = 0; i < pipeline->count; i++) {
+        if (pipeline->items[i].el == el) {
+            if (pipeline->items[i].rb) {
+                rb_destroy(pipeline->items[i].rb);
+            }
+            memmove(&pipeline->items[i], &pipeline->items[i + 1], (pipeline->count - i - 1) * sizeof(audio_pipeline_item_t));
+            pipeline->count--;
+            return ESP_OK;
+        }
+    }
+    return ESP_FAIL;
+}
+
+static audio_pipeline_item_t *_pipeline_find(audio_pipeline_handle_t pipeline, const char *tag)
+{
+    for (int i = 0; i < pipeline->count; i++) {
+        if (strcmp(audio_element_get_tag(pipeline->items[i].el), tag) == 0) {
+            return &pipeline->items[i];
+        }
+    }
+    return NULL;
+}
+
+audio_element_handle_t audio_pipeline_get_el_by_tag(audio_pipeline_handle_t pipeline, const char *tag)
+{
+    audio_pipeline_item_t *item = _pipeline_find(pipeline, tag);
+    return item ? item->el : NULL;
+}
+
+esp_err_t audio_pipeline_link(audio_pipeline_handle_t pipeline, const char *link_tag[], int link_num)
+{
+    audio_pipeline_unlink(pipeline);
+    audio_pipeline_item_t *prev = NULL;
+    for (int i = 0; i < link_num; i++) {
+        audio_pipeline_item_t *item = _pipeline_find(pipeline, link_tag[i]);
+        if (item == NULL) {
+            ESP_LOGE(TAG, "No element named %s", link_tag[i]);
+            audio_pipeline_unlink(pipeline);
+            return ESP_FAIL;
+        }
+        item->linked = true;
+        if (prev) {
+            int size = audio_element_get_output_ringbuf_size(prev->el);
+            prev->rb = rb_create(size > 0 ? size : pipeline->rb_size, 1);
+            AUDIO_MEM_CHECK(TAG, prev->rb, {
+                audio_pipeline_unlink(pipeline);
+                return ESP_ERR_NO_MEM;
+            });
+            audio_element_set_output_ringbuf(prev->el, prev->rb);
+            audio_element_set_input_ringbuf(item->el, prev->rb);
+        }
+        prev = item;
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_pipeline_unlink(audio_pipeline_handle_t pipeline)
+{
+    for (int i = 0; i < pipeline->count; i++) {
+        audio_pipeline_item_t *item = &pipeline->items[i];
+        if (item->rb) {
+            rb_destroy(item->rb);
+            item->rb = NULL;
+        }
+        if (item->linked) {
+            audio_element_set_input_ringbuf(item->el, NULL);
+            audio_element_set_output_ringbuf(item->el, NULL);
+        }
+        item->linked = false;
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_pipeline_run(audio_pipeline_handle_t pipeline)
+{
+    if (pipeline->state != AEL_STATE_INIT) {
+        ESP_LOGW(TAG, "Pipeline already started, state:%d", pipeline->state);
+        return ESP_OK;
+    }
+    for (int i = 0; i < pipeline->count; i++) {
+        if (pipeline->items[i].linked && audio_element_run(pipeline->items[i].el) != ESP_OK) {
+            return ESP_FAIL;
+        }
+    }
+    for (int i = 0; i < pipeline->count; i++) {
+        if (pipeline->items[i].linked) {
+            audio_element_resume(pipeline->items[i].el);
+        }
+    }
+    pipeline->state = AEL_STATE_RUNNING;
+    return ESP_OK;
+}
+
+esp_err_t audio_pipeline_stop(audio_pipeline_handle_t pipeline)
+{
+    if (pipeline->state != AEL_STATE_RUNNING) {
+        ESP_LOGW(TAG, "Without stop, state:%d", pipeline->state);
+        return ESP_FAIL;
+    }
+    for (int i = 0; i < pipeline->count; i++) {
+        if (pipeline->items[i].linked) {
+            audio_element_stop(pipeline->items[i].el);
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_pipeline_wait_for_stop(audio_pipeline_handle_t pipeline)
+{
+    if (pipeline->state != AEL_STATE_RUNNING) {
+        return ESP_FAIL;
+    }
+    for (int i = 0; i < pipeline->count; i++) {
+        if (pipeline->items[i].linked) {
+            audio_element_wait_for_stop(pipeline->items[i].el);
+        }
+    }
+    pipeline->state = AEL_STATE_INIT;
+    return ESP_OK;
+}
+
+esp_err_t audio_pipeline_terminate(audio_pipeline_handle_t pipeline)
+{
+    for (int i = 0; i < pipeline->count; i++) {
+        audio_element_terminate(pipeline->items[i].el);
+    }
+    pipeline->state = AEL_STATE_INIT;
+    return ESP_OK;
+}
+
+esp_err_t audio_pipeline_reset_items_state(audio_pipeline_handle_t pipeline)
+{
+    for (int i = 0; i < pipeline->count; i++) {
+        if (pipeline->items[i].linked) {
+            audio_element_reset_state(pipeline->items[i].el);
+        }
+    }
+    pipeline->state = AEL_STATE_INIT;
+    return ESP_OK;
+}
+
+esp_err_t audio_pipeline_reset_ringbuffer(audio_pipeline_handle_t pipeline)
+{
+    for (int i = 0; i < pipeline->count; i++) {
+        if (pipeline->items[i].linked) {
+            audio_element_reset_input_ringbuf(pipeline->items[i].el);
+            audio_element_reset_output_ringbuf(pipeline->items[i].el);
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_pipeline_set_listener(audio_pipeline_handle_t pipeline, audio_event_iface_handle_t evt)
+{
+    if (pipeline->listener) {
+        audio_pipeline_remove_listener(pipeline);
+    }
+    for (int i = 0; i < pipeline->count; i++) {
+        if (pipeline->items[i].linked) {
+            audio_element_msg_set_listener(pipeline->items[i].el, evt);
+        }
+    }
+    pipeline->listener = evt;
+    return ESP_OK;
+}
+
+esp_err_t audio_pipeline_remove_listener(audio_pipeline_handle_t pipeline)
+{
+    if (pipeline->listener == NULL) {
+        return ESP_FAIL;
+    }
+    for (int i = 0; i < pipeline->count; i++) {
+        audio_element_msg_remove_listener(pipeline->items[i].el, pipeline->listener);
+    }
+    pipeline->listener = NULL;
+    return ESP_OK;
+}
@@ -0,0 +1,74 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * The wpa_supplicant crypto helpers of IDF, on OpenSSL.
+ */
+
+#include <openssl/evp.h>
+#include <openssl/core_names.h>
+#include <openssl/params.h>
+#include "crypto/sha256.h"
+
+int sha256_vector(size_t num_elem, const u8 *addr[], const size_t *len, u8 *mac)
+{
+    EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+    if (ctx == NULL) {
+        return -1;
+    }
+    int ret = EVP_DigestInit_ex(ctx, EVP_sha256(), NULL) ? 0 : -1;
+    for (size_t i = 0; ret == 0 && i < num_elem; i++) {
+        ret = EVP_DigestUpdate(ctx, addr[i], len[i]) ? 0 : -1;
+    }
+    if (ret == 0) {
+        ret = EVP_DigestFinal_ex(ctx, mac, NULL) ? 0 : -1;
+    }
+    EVP_MD_CTX_free(ctx);
+    return ret;
+}
+
+int hmac_sha256_vector(const u8 *key, size_t key_len, size_t num_elem, const u8 *addr[], const size_t *len, u8 *mac)
+{
+    EVP_MAC *hmac = EVP_MAC_fetch(NULL, "HMAC", NULL);
+    EVP_MAC_CTX *ctx = hmac ? EVP_MAC_CTX_new(hmac) : NULL;
+    OSSL_PARAM params[] = {
+        OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, "SHA256", 0),
+        OSSL_PARAM_construct_end(),
+    };
+    int ret = ctx && EVP_MAC_init(ctx, key, key_len, params) ? 0 : -1;
+    for (size_t i = 0; ret == 0 && i < num_elem; i++) {
+        ret = EVP_MAC_update(ctx, addr[i], len[i]) ? 0 : -1;
+    }
+    if (ret == 0) {
+        ret = EVP_MAC_final(ctx, mac, NULL, SHA256_MAC_LEN) ? 0 : -1;
+    }
+    EVP_MAC_CTX_free(ctx);
+    EVP_MAC_free(hmac);
+    return ret;
+}
+
+int hmac_sha256(const u8 *key, size_t key_len, const u8 *data, size_t data_len, u8 *mac)
+{
+    return hmac_sha256_vector(key, key_len, 1, &data, &data_len, mac);
+}
@@ -0,0 +1,622 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+#include <strings.h>
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "esp_log.h"
+#include "audio_error.h"
+#include "esp_http_client.h"
+
+static const char *TAG = "HTTP_CLIENT";
+
+#define HTTP_MAX_HEADERS        (16)
+#define HTTP_HOST_MAX           (128)
+#define HTTP_LINE_MAX           (1024)
+#define HTTP_USER_AGENT         "ESP32 HTTP Client/1.0"
+
+typedef struct {
+    char    *key;
+    char    *value;
+} http_header_t;
+
+struct esp_http_client {
+    char                        host[HTTP_HOST_MAX];
+    int                         port;
+    bool                        is_ssl;
+    char                        *path;          /* Path and query */
+    esp_http_client_method_t    method;
+    int                         timeout_ms;
+    http_event_handle_cb        event_handler;
+    void                        *user_data;
+    http_header_t               headers[HTTP_MAX_HEADERS];
+    const char                  *post_data;
+    int                         post_len;
+
+    int                         sock;
+    char                        conn_host[HTTP_HOST_MAX];   /* Peer of the open connection */
+    int                         conn_port;
+
+    char                        *rx;            /* Bytes received and not consumed yet */
+    int                         rx_size;
+    int                         rx_pos;
+    int                         rx_len;
+
+    int                         status_code;
+    int                         content_length;
+    bool                        chunked;
+    bool                        conn_close;     /* The server closes the connection after this response */
+    int                         body_left;      /* Of the response, or of the current chunk */
+    bool                        body_done;
+};
+
+static const char *s_method_names[] = { "GET", "POST", "PUT", "PATCH", "DELETE", "HEAD" };
+
+static void _http_dispatch(esp_http_client_handle_t client, esp_http_client_event_id_t id, void *data, int len,
+                           char *key, char *value)
+{
+    if (client->event_handler == NULL) {
+        return;
+    }
+    esp_http_client_event_t evt = {
+        .event_id = id,
+        .client = client,
+        .data = data,
+        .data_len = len,
+        .user_data = client->user_data,
+        .header_key = key,
+        .header_value = value,
+    };
+    client->event_handler(&evt);
+}
+
+static esp_err_t _http_parse_url(esp_http_client_handle_t client, const char *url)
+{
+    const char *p;
+    if (strncmp(url, "http://", 7) == 0) {
+        client->is_ssl = false;
+        client->port = 80;
+        p = url + 7;
+    } else if (strncmp(url, "https://", 8) == 0) {
+        client->is_ssl = true;
+        client->port = 443;
+        p = url + 8;
+    } else {
+        ESP_LOGE(TAG, "Invalid url %s", url);
+        return ESP_FAIL;
+    }
+    int host_len = strcspn(p, ":/?");
+    if (host_len == 0 || host_len >= HTTP_HOST_MAX) {
+        ESP_LOGE(TAG, "Invalid host in %s", url);
+        return ESP_FAIL;
+    }
+    memcpy(client->host, p, host_len);
+    client->host[host_len] = 0;
+    p += host_len;
+    if (*p == ':') {
+        client->port = strtol(p + 1, (char **)&p, 10);
+    }
+    char *path = *p == '/' ? strdup(p) : NULL;
+    if (*p != '/') {
+        path = malloc(strlen(p) + 2);
+        if (path) {
+            sprintf(path, "/%s", p);
+        }
+    }
+    AUDIO_MEM_CHECK(TAG, path, return ESP_ERR_NO_MEM);
+    free(client->path);
+    client->path = path;
+    return ESP_OK;
+}
+
+static void _http_disconnect(esp_http_client_handle_t client)
+{
+    if (client->sock < 0) {
+        return;
+    }
+    close(client->sock);
+    client->sock = -1;
+    client->rx_pos = client->rx_len = 0;
+    _http_dispatch(client, HTTP_EVENT_DISCONNECTED, NULL, 0, NULL, NULL);
+}
+
+static esp_err_t _http_connect(esp_http_client_handle_t client)
+{
+    if (client->is_ssl) {
+        ESP_LOGE(TAG, "No TLS on the host, use an http:// url");
+        return ESP_FAIL;
+    }
+    struct addrinfo hints = {
+        .ai_family = AF_INET,
+        .ai_socktype = SOCK_STREAM,
+    };
+    struct addrinfo *res;
+    char port[8];
+    snprintf(port, sizeof(port), "%d", client->port);
+    if (getaddrinfo(client->host, port, &hints, &res) != 0) {
+        ESP_LOGE(TAG, "Failed to resolve %s", client->host);
+        return ESP_FAIL;
+    }
+    int sock = socket(res->ai_family, res->ai_socktype, 0);
+    if (sock < 0) {
+        freeaddrinfo(res);
+        return ESP_FAIL;
+    }
+    struct timeval tv = {
+        .tv_sec = client->timeout_ms / 1000,
+        .tv_usec = (client->timeout_ms % 1000) * 1000,
+    };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    int one = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    int ret = connect(sock, res->ai_addr, res->ai_addrlen);
+    freeaddrinfo(res);
+    if (ret != 0) {
+        ESP_LOGE(TAG, "Failed to connect to %s:%d, %s", client->host, client->port, strerror(errno));
+        close(sock);
+        return ESP_FAIL;
+    }
+    client->sock = sock;
+    strcpy(client->conn_host, client->host);
+    client->conn_port = client->port;
+    client->rx_pos = client->rx_len = 0;
+    _http_dispatch(client, HTTP_EVENT_ON_CONNECTED, NULL, 0, NULL, NULL);
+    return ESP_OK;
+}
+
+/* A kept connection the server has closed meanwhile reads as end of stream */
+static bool _http_peer_closed(esp_http_client_handle_t client)
+{
+    struct pollfd pfd = {
+        .fd = client->sock,
+        .events = POLLIN,
+    };
+    if (poll(&pfd, 1, 0) <= 0) {
+        return false;
+    }
+    char c;
+    return recv(client->sock, &c, 1, MSG_PEEK | MSG_DONTWAIT) <= 0;
+}
+
+static int _http_send_all(esp_http_client_handle_t client, const char *data, int len)
+{
+    int sent = 0;
+    while (sent < len) {
+        int ret = send(client->sock, data + sent, len - sent, MSG_NOSIGNAL);
+        if (ret <= 0) {
+            ESP_LOGE(TAG, "Error write, %s", ret < 0 ? strerror(errno) : "closed");
+            return -1;
+        }
+        sent += ret;
+    }
+    return sent;
+}
+
+static int _http_fill(esp_http_client_handle_t client)
+{
+    if (client->rx_pos == client->rx_len) {
+        client->rx_pos = client->rx_len = 0;
+    }
+    if (client->rx_len == client->rx_size) {
+        memmove(client->rx, client->rx + client->rx_pos, client->rx_len - client->rx_pos);
+        client->rx_len -= client->rx_pos;
+        client->rx_pos = 0;
+    }
+    int ret = recv(client->sock, client->rx + client->rx_len, client->rx_size - client->rx_len, 0);
+    if (ret <= 0) {
+        return -1;
+    }
+    client->rx_len += ret;
+    return ret;
+}
+
+/* One CRLF terminated line, without the CRLF */
+static int _http_read_line(esp_http_client_handle_t client, char *line, int size)
+{
+    int len = 0;
+    for (;;) {
+        while (client->rx_pos < client->rx_len) {
+            char c = client->rx[client->rx_pos++];
+            if (c == '\n') {
+                if (len > 0 && line[len - 1] == '\r') {
+                    len--;
+                }
+                line[len] = 0;
+                return len;
+            }
+            if (len < size - 1) {
+                line[len++] = c;
+            }
+        }
+        if (_http_fill(client) < 0) {
+            return -1;
+        }
+    }
+}
+
+static esp_err_t _http_send_request(esp_http_client_handle_t client, int write_len)
+{
+    int size = 256 + strlen(client->path) + strlen(client->host);
+    for (int i = 0; i < HTTP_MAX_HEADERS; i++) {
+        if (client->headers[i].key) {
+            size += strlen(client->headers[i].key) + strlen(client->headers[i].value) + 4;
+        }
+    }
+    char *req = malloc(size);
+    AUDIO_MEM_CHECK(TAG, req, return ESP_ERR_NO_MEM);
+    int len = snprintf(req, size, "%s %s HTTP/1.1\r\nHost: %s:%d\r\nUser-Agent: %s\r\n",
+                       s_method_names[client->method], client->path, client->host, client->port, HTTP_USER_AGENT);
+    if (write_len >= 0) {
+        if (client->method != HTTP_METHOD_GET && client->method != HTTP_METHOD_HEAD) {
+            len += snprintf(req + len, size - len, "Content-Length: %d\r\n", write_len);
+        }
+    } else {
+        len += snprintf(req + len, size - len, "Transfer-Encoding: chunked\r\n");
+    }
+    for (int i = 0; i < HTTP_MAX_HEADERS; i++) {
+        if (client->headers[i].key) {
+            len += snprintf(req + len, size - len, "%s: %s\r\n", client->headers[i].key, client->headers[i].value);
+        }
+    }
+    len += snprintf(req + len, size - len, "\r\n");
+    int ret = _http_send_all(client, req, len);
+    free(req);
+    if (ret < 0) {
+        return ESP_FAIL;
+    }
+    _http_dispatch(client, HTTP_EVENT_HEADER_SENT, NULL, 0, NULL, NULL);
+    return ESP_OK;
+}
+
+esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t *config)
+{
+    esp_http_client_handle_t client = calloc(1, sizeof(struct esp_http_client));
+    AUDIO_MEM_CHECK(TAG, client, return NULL);
+    client->sock = -1;
+    client->method = config->method;
+    client->timeout_ms = config->timeout_ms > 0 ? config->timeout_ms : 5000;
+    client->event_handler = config->event_handler;
+    client->user_data = config->user_data;
+    client->rx_size = config->buffer_size > DEFAULT_HTTP_BUF_SIZE ? config->buffer_size : DEFAULT_HTTP_BUF_SIZE;
+    client->rx = malloc(client->rx_size);
+    AUDIO_MEM_CHECK(TAG, client->rx, goto _error);
+    if (config->url == NULL || _http_parse_url(client, config->url) != ESP_OK) {
+        goto _error;
+    }
+    return client;
+_error:
+    esp_http_client_cleanup(client);
+    return NULL;
+}
+
+esp_err_t esp_http_client_set_url(esp_http_client_handle_t client, const char *url)
+{
+    if (_http_parse_url(client, url) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    if (client->sock >= 0 && (strcmp(client->host, client->conn_host) != 0 || client->port != client->conn_port)) {
+        _http_disconnect(client);
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_post_field(esp_http_client_handle_t client, const char *data, int len)
+{
+    client->post_data = data;
+    client->post_len = len;
+    return ESP_OK;
+}
+
+int esp_http_client_get_post_field(esp_http_client_handle_t client, char **data)
+{
+    *data = (char *)client->post_data;
+    return client->post_len;
+}
+
+static http_header_t *_http_find_header(esp_http_client_handle_t client, const char *key)
+{
+    for (int i = 0; i < HTTP_MAX_HEADERS; i++) {
+        if (client->headers[i].key && strcasecmp(client->headers[i].key, key) == 0) {
+            return &client->headers[i];
+        }
+    }
+    return NULL;
+}
+
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t client, const char *key, const char *value)
+{
+    http_header_t *header = _http_find_header(client, key);
+    for (int i = 0; header == NULL && i < HTTP_MAX_HEADERS; i++) {
+        if (client->headers[i].key == NULL) {
+            header = &client->headers[i];
+            header->key = strdup(key);
+        }
+    }
+    AUDIO_MEM_CHECK(TAG, header && header->key, return ESP_FAIL);
+    free(header->value);
+    header->value = strdup(value);
+    return header->value ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+esp_err_t esp_http_client_get_header(esp_http_client_handle_t client, const char *key, char **value)
+{
+    http_header_t *header = _http_find_header(client, key);
+    *value = header ? header->value : NULL;
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_delete_header(esp_http_client_handle_t client, const char *key)
+{
+    http_header_t *header = _http_find_header(client, key);
+    if (header) {
+        free(header->key);
+        free(header->value);
+        header->key = header->value = NULL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_method(esp_http_client_handle_t client, esp_http_client_method_t method)
+{
+    client->method = method;
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_get_user_data(esp_http_client_handle_t client, void **data)
+{
+    *data = client->user_data;
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_user_data(esp_http_client_handle_t client, void *data)
+{
+    client->user_data = data;
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_open(esp_http_client_handle_t client, int write_len)
+{
+    if (client->sock >= 0 && _http_peer_closed(client)) {
+        /* Reported like a write to a closed connection on the device */
+        ESP_LOGE(TAG, "Connection closed by the server");
+        _http_disconnect(client);
+        return ESP_FAIL;
+    }
+    if (client->sock < 0 && _http_connect(client) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    client->status_code = -1;
+    client->content_length = -1;
+    client->chunked = false;
+    client->conn_close = false;
+    client->body_done = false;
+    if (_http_send_request(client, write_len) != ESP_OK) {
+        _http_disconnect(client);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+int esp_http_client_write(esp_http_client_handle_t client, const char *buffer, int len)
+{
+    if (client->sock < 0) {
+        return -1;
+    }
+    return _http_send_all(client, buffer, len);
+}
+
+int esp_http_client_fetch_headers(esp_http_client_handle_t client)
+{
+    char line[HTTP_LINE_MAX];
+    if (client->sock < 0 || _http_read_line(client, line, sizeof(line)) < 0) {
+        ESP_LOGE(TAG, "No response");
+        return ESP_FAIL;
+    }
+    if (sscanf(line, "HTTP/%*d.%*d %d", &client->status_code) != 1) {
+        ESP_LOGE(TAG, "Invalid status line %s", line);
+        return ESP_FAIL;
+    }
+    for (;;) {
+        int len = _http_read_line(client, line, sizeof(line));
+        if (len < 0) {
+            return ESP_FAIL;
+        }
+        if (len == 0) {
+            break;
+        }
+        char *colon = strchr(line, ':');
+        if (colon == NULL) {
+            continue;
+        }
+        *colon = 0;
+        char *value = colon + 1;
+        while (*value == ' ') {
+            value++;
+        }
+        if (strcasecmp(line, "Content-Length") == 0) {
+            client->content_length = atoi(value);
+        } else if (strcasecmp(line, "Transfer-Encoding") == 0 && strcasecmp(value, "chunked") == 0) {
+            client->chunked = true;
+        } else if (strcasecmp(line, "Connection") == 0 && strcasecmp(value, "close") == 0) {
+            client->conn_close = true;
+        }
+        _http_dispatch(client, HTTP_EVENT_ON_HEADER, NULL, 0, line, value);
+    }
+    if (client->method == HTTP_METHOD_HEAD || client->status_code == 204 || client->status_code == 304) {
+        client->content_length = 0;
+        client->chunked = false;
+    }
+    if (client->chunked) {
+        client->content_length = -1;
+        client->body_left = 0;
+    } else {
+        client->body_left = client->content_length;
+    }
+    client->body_done = client->content_length == 0;
+    if (client->body_done && client->conn_close) {
+        _http_disconnect(client);
+    }
+    return client->content_length;
+}
+
+bool esp_http_client_is_chunked_response(esp_http_client_handle_t client)
+{
+    return client->chunked;
+}
+
+/* Start of the next chunk, false after the last one */
+static bool _http_next_chunk(esp_http_client_handle_t client)
+{
+    char line[64];
+    int len = _http_read_line(client, line, sizeof(line));
+    if (len == 0) {
+        /* The CRLF behind the previous chunk */
+        len = _http_read_line(client, line, sizeof(line));
+    }
+    if (len < 0) {
+        return false;
+    }
+    client->body_left = strtol(line, NULL, 16);
+    if (client->body_left == 0) {
+        /* Trailers up to the empty line */
+        while (_http_read_line(client, line, sizeof(line)) > 0);
+        return false;
+    }
+    return true;
+}
+
+int esp_http_client_read(esp_http_client_handle_t client, char *buffer, int len)
+{
+    int total = 0;
+    while (total < len && !client->body_done && client->sock >= 0) {
+        if (client->chunked && client->body_left == 0 && !_http_next_chunk(client)) {
+            client->body_done = true;
+            break;
+        }
+        if (client->rx_pos == client->rx_len && _http_fill(client) < 0) {
+            if (client->content_length < 0 && !client->chunked) {
+                /* Body up to the end of the connection */
+                client->body_done = true;
+                break;
+            }
+            ESP_LOGE(TAG, "Connection lost while reading the response");
+            _http_disconnect(client);
+            return total > 0 ? total : -1;
+        }
+        int n = client->rx_len - client->rx_pos;
+        if (n > len - total) {
+            n = len - total;
+        }
+        if (client->body_left >= 0 && n > client->body_left) {
+            n = client->body_left;
+        }
+        memcpy(buffer + total, client->rx + client->rx_pos, n);
+        _http_dispatch(client, HTTP_EVENT_ON_DATA, buffer + total, n, NULL, NULL);
+        client->rx_pos += n;
+        total += n;
+        if (client->body_left >= 0) {
+            client->body_left -= n;
+            if (client->body_left == 0 && !client->chunked) {
+                client->body_done = true;
+            }
+        }
+        if (total > 0) {
+            break;
+        }
+    }
+    if (client->body_done && client->conn_close) {
+        _http_disconnect(client);
+    }
+    return total;
+}
+
+esp_err_t esp_http_client_perform(esp_http_client_handle_t client)
+{
+    int write_len = client->post_data ? client->post_len : 0;
+    if (esp_http_client_open(client, write_len) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    if (write_len > 0 && esp_http_client_write(client, client->post_data, write_len) != write_len) {
+        _http_disconnect(client);
+        return ESP_FAIL;
+    }
+    /* -1 is also what a chunked response gives */
+    if (esp_http_client_fetch_headers(client) < 0 && client->status_code < 0) {
+        _http_disconnect(client);
+        return ESP_FAIL;
+    }
+    char buf[256];
+    int ret;
+    while ((ret = esp_http_client_read(client, buf, sizeof(buf))) > 0);
+    if (ret < 0) {
+        return ESP_FAIL;
+    }
+    _http_dispatch(client, HTTP_EVENT_ON_FINISH, NULL, 0, NULL, NULL);
+    return ESP_OK;
+}
+
+int esp_http_client_get_status_code(esp_http_client_handle_t client)
+{
+    return client->status_code;
+}
+
+int esp_http_client_get_content_length(esp_http_client_handle_t client)
+{
+    return client->content_length;
+}
+
+esp_err_t esp_http_client_close(esp_http_client_handle_t client)
+{
+    _http_disconnect(client);
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client)
+{
+    if (client == NULL) {
+        return ESP_FAIL;
+    }
+    _http_disconnect(client);
+    for (int i = 0; i < HTTP_MAX_HEADERS; i++) {
+        free(client->headers[i].key);
+        free(client->headers[i].value);
+    }
+    free(client->path);
+    free(client->rx);
+    free(client);
+    return ESP_OK;
+}
+
+esp_http_client_transport_t esp_http_client_get_transport_type(esp_http_client_handle_t client)
+{
+    return client->is_ssl ? HTTP_TRANSPORT_OVER_SSL : HTTP_TRANSPORT_OVER_TCP;
+}
@@ -0,0 +1,97 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#define HOST_LOG_TAGS       (32)
+#define HOST_LOG_TAG_MAX    (32)
+
+static pthread_mutex_t s_log_lock = PTHREAD_MUTEX_INITIALIZER;
+static esp_log_level_t s_default_level = CONFIG_LOG_DEFAULT_LEVEL;
+static struct {
+    char            tag[HOST_LOG_TAG_MAX];
+    esp_log_level_t level;
+} s_levels[HOST_LOG_TAGS];
+static int s_level_count;
+
+void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+    pthread_mutex_lock(&s_log_lock);
+    if (strcmp(tag, "*") == 0) {
+        s_default_level = level;
+        s_level_count = 0;
+    } else {
+        int i = 0;
+        while (i < s_level_count && strcmp(s_levels[i].tag, tag)) {
+            i++;
+        }
+        if (i < HOST_LOG_TAGS) {
+            strncpy(s_levels[i].tag, tag, HOST_LOG_TAG_MAX - 1);
+            s_levels[i].level = level;
+            if (i == s_level_count) {
+                s_level_count++;
+            }
+        }
+    }
+    pthread_mutex_unlock(&s_log_lock);
+}
+
+int esp_log_enabled(esp_log_level_t level, const char *tag)
+{
+    esp_log_level_t limit = s_default_level;
+    pthread_mutex_lock(&s_log_lock);
+    for (int i = 0; i < s_level_count; i++) {
+        if (strcmp(s_levels[i].tag, tag) == 0) {
+            limit = s_levels[i].level;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&s_log_lock);
+    return level <= limit;
+}
+
+uint32_t esp_log_timestamp(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    static const char letters[] = "NEWIDV";
+    char line[512];
+    int len = snprintf(line, sizeof(line), "%c (%u) %s: ", letters[level], esp_log_timestamp(), tag);
+    va_list args;
+    va_start(args, format);
+    if (len < (int)sizeof(line)) {
+        vsnprintf(line + len, sizeof(line) - len, format, args);
+    }
+    va_end(args);
+    /* One write per line, the tasks log concurrently */
+    fprintf(stderr, "%s\n", line);
+}
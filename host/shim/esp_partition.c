@@ -0,0 +1,205 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sr_host_flash.h"
+
+static const char *TAG = "HOST_FLASH";
+
+#define HOST_FLASH_MAX_PARTITIONS   (8)
+
+typedef struct {
+    esp_partition_t         part;
+    uint8_t                 *data;
+    int                     fd;                 /* Image file written through, -1 for memory */
+    sr_host_flash_stats_t   stats;
+} host_partition_t;
+
+static host_partition_t s_parts[HOST_FLASH_MAX_PARTITIONS];
+static int s_part_count;
+static int s_erase_ms;
+static pthread_mutex_t s_flash_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static host_partition_t *_flash_part(const esp_partition_t *partition)
+{
+    for (int i = 0; i < s_part_count; i++) {
+        if (&s_parts[i].part == partition) {
+            return &s_parts[i];
+        }
+    }
+    return NULL;
+}
+
+static void _flash_sync(host_partition_t *hp, size_t offset, size_t size)
+{
+    if (hp->fd >= 0 && pwrite(hp->fd, hp->data + offset, size, offset) != (ssize_t)size) {
+        ESP_LOGE(TAG, "Failed to write the image of %s", hp->part.label);
+    }
+}
+
+const esp_partition_t *sr_host_flash_add(const char *label, esp_partition_type_t type, int subtype, uint32_t size,
+                                         const char *path)
+{
+    if (s_part_count == HOST_FLASH_MAX_PARTITIONS || size == 0 || size % SPI_FLASH_SEC_SIZE) {
+        ESP_LOGE(TAG, "Can not add partition %s of %u bytes", label, size);
+        return NULL;
+    }
+    host_partition_t *hp = &s_parts[s_part_count];
+    memset(hp, 0, sizeof(*hp));
+    hp->fd = -1;
+    hp->data = malloc(size);
+    if (hp->data == NULL) {
+        return NULL;
+    }
+    memset(hp->data, 0xFF, size);
+    if (path) {
+        hp->fd = open(path, O_RDWR | O_CREAT, 0644);
+        struct stat st;
+        if (hp->fd < 0 || fstat(hp->fd, &st) != 0) {
+            ESP_LOGE(TAG, "Can not open image %s", path);
+            free(hp->data);
+            return NULL;
+        }
+        if (st.st_size == size && pread(hp->fd, hp->data, size, 0) == size) {
+            ESP_LOGI(TAG, "Partition %s from image %s", label, path);
+        } else {
+            memset(hp->data, 0xFF, size);
+            if (ftruncate(hp->fd, size) != 0) {
+                ESP_LOGW(TAG, "Can not size image %s", path);
+            }
+            _flash_sync(hp, 0, size);
+        }
+    }
+    hp->part.type = type;
+    hp->part.subtype = subtype;
+    hp->part.address = s_part_count == 0 ? 0x110000 : s_parts[s_part_count - 1].part.address
+                       + s_parts[s_part_count - 1].part.size;
+    hp->part.size = size;
+    snprintf(hp->part.label, sizeof(hp->part.label), "%s", label);
+    s_part_count++;
+    return &hp->part;
+}
+
+void sr_host_flash_reset(void)
+{
+    pthread_mutex_lock(&s_flash_lock);
+    for (int i = 0; i < s_part_count; i++) {
+        if (s_parts[i].fd >= 0) {
+            close(s_parts[i].fd);
+        }
+        free(s_parts[i].data);
+    }
+    s_part_count = 0;
+    pthread_mutex_unlock(&s_flash_lock);
+}
+
+void sr_host_flash_set_timing(int erase_ms)
+{
+    s_erase_ms = erase_ms;
+}
+
+esp_err_t sr_host_flash_stats(const esp_partition_t *partition, sr_host_flash_stats_t *stats)
+{
+    host_partition_t *hp = _flash_part(partition);
+    if (hp == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    pthread_mutex_lock(&s_flash_lock);
+    *stats = hp->stats;
+    pthread_mutex_unlock(&s_flash_lock);
+    return ESP_OK;
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char *label)
+{
+    for (int i = 0; i < s_part_count; i++) {
+        esp_partition_t *part = &s_parts[i].part;
+        if (part->type == type && (subtype == ESP_PARTITION_SUBTYPE_ANY || part->subtype == subtype)
+                && (label == NULL || strcmp(part->label, label) == 0)) {
+            return part;
+        }
+    }
+    return NULL;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size)
+{
+    host_partition_t *hp = _flash_part(partition);
+    if (hp == NULL || src_offset > partition->size || size > partition->size - src_offset) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    pthread_mutex_lock(&s_flash_lock);
+    memcpy(dst, hp->data + src_offset, size);
+    hp->stats.reads++;
+    pthread_mutex_unlock(&s_flash_lock);
+    return ESP_OK;
+}
+
+/* NOR flash: a write only clears bits, setting them takes an erase */
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size)
+{
+    host_partition_t *hp = _flash_part(partition);
+    if (hp == NULL || dst_offset > partition->size || size > partition->size - dst_offset) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    pthread_mutex_lock(&s_flash_lock);
+    for (size_t i = 0; i < size; i++) {
+        hp->data[dst_offset + i] &= ((const uint8_t *)src)[i];
+    }
+    _flash_sync(hp, dst_offset, size);
+    hp->stats.writes++;
+    hp->stats.write_bytes += size;
+    pthread_mutex_unlock(&s_flash_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t start_addr, size_t size)
+{
+    host_partition_t *hp = _flash_part(partition);
+    if (hp == NULL || start_addr > partition->size || size > partition->size - start_addr) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (start_addr % SPI_FLASH_SEC_SIZE || size % SPI_FLASH_SEC_SIZE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    int64_t start = esp_timer_get_time();
+    if (s_erase_ms > 0) {
+        usleep(s_erase_ms * 1000 * (size / SPI_FLASH_SEC_SIZE));
+    }
+    pthread_mutex_lock(&s_flash_lock);
+    memset(hp->data + start_addr, 0xFF, size);
+    _flash_sync(hp, start_addr, size);
+    hp->stats.erases += size / SPI_FLASH_SEC_SIZE;
+    hp->stats.erase_us += esp_timer_get_time() - start;
+    pthread_mutex_unlock(&s_flash_lock);
+    return ESP_OK;
+}
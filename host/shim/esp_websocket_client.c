@@ -0,0 +1,502 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+#include <strings.h>
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <openssl/sha.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "esp_log.h"
+#include "audio_error.h"
+#include "esp_websocket_client.h"
+
+static const char *TAG = "WEBSOCKET_CLIENT";
+
+ESP_EVENT_DEFINE_BASE(WEBSOCKET_EVENTS);
+
+#define WS_BUFFER_SIZE_BYTE         (1024)
+#define WS_TASK_STACK               (4*1024)
+#define WS_TASK_PRIORITY            (5)
+#define WS_NETWORK_TIMEOUT_MS       (10*1000)
+#define WS_POLL_MS                  (50)
+#define WS_HOST_MAX                 (128)
+#define WS_GUID                     "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+#define WS_OPCODE_TEXT              (0x01)
+#define WS_OPCODE_BINARY            (0x02)
+#define WS_OPCODE_CLOSE             (0x08)
+#define WS_OPCODE_PING              (0x09)
+#define WS_OPCODE_PONG              (0x0A)
+#define WS_FIN                      (0x80)
+#define WS_MASK                     (0x80)
+
+#define WS_STOPPED_BIT              BIT0
+
+struct esp_websocket_client {
+    char                    host[WS_HOST_MAX];
+    int                     port;
+    bool                    is_ssl;
+    char                    *path;
+    int                     buffer_size;
+    int                     task_stack;
+    int                     task_prio;
+    void                    *user_context;
+    esp_event_handler_t     handler;
+    esp_websocket_event_id_t handler_event;
+    void                    *handler_arg;
+    int                     sock;
+    volatile bool           run;
+    volatile bool           connected;
+    char                    *rx_buffer;
+    SemaphoreHandle_t       tx_lock;
+    EventGroupHandle_t      status;
+};
+
+static void _ws_dispatch(esp_websocket_client_handle_t client, esp_websocket_event_id_t id, const char *data,
+                         int len, uint8_t op_code, int payload_len, int payload_offset)
+{
+    if (client->handler == NULL || (client->handler_event != WEBSOCKET_EVENT_ANY && client->handler_event != id)) {
+        return;
+    }
+    esp_websocket_event_data_t evt = {
+        .data_ptr = data,
+        .data_len = len,
+        .op_code = op_code,
+        .client = client,
+        .user_context = client->user_context,
+        .payload_len = payload_len,
+        .payload_offset = payload_offset,
+    };
+    client->handler(client->handler_arg, WEBSOCKET_EVENTS, id, &evt);
+}
+
+static esp_err_t _ws_parse_uri(esp_websocket_client_handle_t client, const char *uri)
+{
+    const char *p;
+    if (strncmp(uri, "ws://", 5) == 0) {
+        client->is_ssl = false;
+        client->port = 80;
+        p = uri + 5;
+    } else if (strncmp(uri, "wss://", 6) == 0) {
+        client->is_ssl = true;
+        client->port = 443;
+        p = uri + 6;
+    } else {
+        ESP_LOGE(TAG, "Invalid uri %s", uri);
+        return ESP_FAIL;
+    }
+    int host_len = strcspn(p, ":/?");
+    if (host_len == 0 || host_len >= WS_HOST_MAX) {
+        ESP_LOGE(TAG, "Invalid host in %s", uri);
+        return ESP_FAIL;
+    }
+    memcpy(client->host, p, host_len);
+    client->host[host_len] = 0;
+    p += host_len;
+    if (*p == ':') {
+        client->port = strtol(p + 1, (char **)&p, 10);
+    }
+    char *path = malloc(strlen(p) + 2);
+    AUDIO_MEM_CHECK(TAG, path, return ESP_ERR_NO_MEM);
+    sprintf(path, "%s%s", *p == '/' ? "" : "/", p);
+    free(client->path);
+    client->path = path;
+    return ESP_OK;
+}
+
+/* All of `len`, waiting no longer than the network timeout and giving up once stopped */
+static int _ws_read_all(esp_websocket_client_handle_t client, void *buf, int len)
+{
+    int got = 0;
+    int idle_ms = 0;
+    while (got < len && client->run) {
+        struct pollfd pfd = {
+            .fd = client->sock,
+            .events = POLLIN,
+        };
+        int ret = poll(&pfd, 1, WS_POLL_MS);
+        if (ret == 0) {
+            if ((idle_ms += WS_POLL_MS) >= WS_NETWORK_TIMEOUT_MS && got > 0) {
+                return -1;
+            }
+            continue;
+        }
+        ret = recv(client->sock, (char *)buf + got, len - got, 0);
+        if (ret <= 0) {
+            return -1;
+        }
+        got += ret;
+        idle_ms = 0;
+    }
+    return got == len ? got : -1;
+}
+
+static int _ws_write_frame(esp_websocket_client_handle_t client, uint8_t opcode, const char *data, int len)
+{
+    uint8_t header[14];
+    int header_len = 2;
+    header[0] = WS_FIN | opcode;
+    if (len < 126) {
+        header[1] = WS_MASK | len;
+    } else if (len < 65536) {
+        header[1] = WS_MASK | 126;
+        header[2] = len >> 8;
+        header[3] = len;
+        header_len = 4;
+    } else {
+        header[1] = WS_MASK | 127;
+        memset(header + 2, 0, 4);
+        header[6] = len >> 24;
+        header[7] = len >> 16;
+        header[8] = len >> 8;
+        header[9] = len;
+        header_len = 10;
+    }
+    uint8_t *mask = header + header_len;
+    RAND_bytes(mask, 4);
+    header_len += 4;
+    char *frame = malloc(header_len + len);
+    AUDIO_MEM_CHECK(TAG, frame, return -1);
+    memcpy(frame, header, header_len);
+    for (int i = 0; i < len; i++) {
+        frame[header_len + i] = data[i] ^ mask[i % 4];
+    }
+    int sent = 0;
+    while (sent < header_len + len) {
+        int ret = send(client->sock, frame + sent, header_len + len - sent, MSG_NOSIGNAL);
+        if (ret <= 0) {
+            free(frame);
+            return -1;
+        }
+        sent += ret;
+    }
+    free(frame);
+    return len;
+}
+
+static esp_err_t _ws_connect(esp_websocket_client_handle_t client)
+{
+    if (client->is_ssl) {
+        ESP_LOGE(TAG, "No TLS on the host, use a ws:// uri");
+        return ESP_FAIL;
+    }
+    struct addrinfo hints = {
+        .ai_family = AF_INET,
+        .ai_socktype = SOCK_STREAM,
+    };
+    struct addrinfo *res;
+    char port[8];
+    snprintf(port, sizeof(port), "%d", client->port);
+    if (getaddrinfo(client->host, port, &hints, &res) != 0) {
+        ESP_LOGE(TAG, "Failed to resolve %s", client->host);
+        return ESP_FAIL;
+    }
+    client->sock = socket(res->ai_family, res->ai_socktype, 0);
+    int ret = client->sock < 0 ? -1 : connect(client->sock, res->ai_addr, res->ai_addrlen);
+    freeaddrinfo(res);
+    if (ret != 0) {
+        ESP_LOGE(TAG, "Error transport connect, %s", strerror(errno));
+        return ESP_FAIL;
+    }
+    struct timeval tv = {
+        .tv_sec = WS_NETWORK_TIMEOUT_MS / 1000,
+    };
+    setsockopt(client->sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    int one = 1;
+    setsockopt(client->sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    uint8_t nonce[16];
+    char key[32];
+    RAND_bytes(nonce, sizeof(nonce));
+    EVP_EncodeBlock((unsigned char *)key, nonce, sizeof(nonce));
+    int size = strlen(client->path) + strlen(client->host) + 256;
+    char *req = malloc(size);
+    AUDIO_MEM_CHECK(TAG, req, return ESP_ERR_NO_MEM);
+    int len = snprintf(req, size, "GET %s HTTP/1.1\r\nConnection: Upgrade\r\nHost: %s:%d\r\nUpgrade: websocket\r\n"
+                       "Sec-WebSocket-Version: 13\r\nSec-WebSocket-Key: %s\r\nUser-Agent: ESP32 Websocket Client\r\n\r\n",
+                       client->path, client->host, client->port, key);
+    ret = send(client->sock, req, len, MSG_NOSIGNAL);
+    free(req);
+    if (ret != len) {
+        ESP_LOGE(TAG, "Error write upgrade request");
+        return ESP_FAIL;
+    }
+
+    /* Read the response up to the empty line, one byte at a time so no frame is taken along */
+    char resp[1024];
+    int resp_len = 0;
+    while (resp_len < sizeof(resp) - 1) {
+        if (_ws_read_all(client, resp + resp_len, 1) != 1) {
+            ESP_LOGE(TAG, "Error read upgrade response");
+            return ESP_FAIL;
+        }
+        resp_len++;
+        if (resp_len >= 4 && memcmp(resp + resp_len - 4, "\r\n\r\n", 4) == 0) {
+            break;
+        }
+    }
+    resp[resp_len] = 0;
+    int status = 0;
+    if (sscanf(resp, "HTTP/1.1 %d", &status) != 1 || status != 101) {
+        ESP_LOGE(TAG, "Upgrade refused, status %d", status);
+        return ESP_FAIL;
+    }
+    char expected[64];
+    char digest_in[96];
+    unsigned char digest[SHA_DIGEST_LENGTH];
+    snprintf(digest_in, sizeof(digest_in), "%s%s", key, WS_GUID);
+    SHA1((unsigned char *)digest_in, strlen(digest_in), digest);
+    EVP_EncodeBlock((unsigned char *)expected, digest, sizeof(digest));
+    char *accept = strcasestr(resp, "\r\nSec-WebSocket-Accept:");
+    if (accept == NULL) {
+        ESP_LOGE(TAG, "No Sec-WebSocket-Accept");
+        return ESP_FAIL;
+    }
+    accept += strlen("\r\nSec-WebSocket-Accept:");
+    while (*accept == ' ') {
+        accept++;
+    }
+    if (strncmp(accept, expected, strlen(expected)) != 0) {
+        ESP_LOGE(TAG, "Invalid Sec-WebSocket-Accept");
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+/* One frame from the server, handed to the handler in pieces of at most buffer_size */
+static esp_err_t _ws_read_frame(esp_websocket_client_handle_t client)
+{
+    uint8_t header[8];
+    if (_ws_read_all(client, header, 2) != 2) {
+        return ESP_FAIL;
+    }
+    uint8_t opcode = header[0] & 0x0F;
+    bool masked = header[1] & WS_MASK;
+    uint64_t payload_len = header[1] & 0x7F;
+    if (payload_len == 126) {
+        if (_ws_read_all(client, header, 2) != 2) {
+            return ESP_FAIL;
+        }
+        payload_len = (header[0] << 8) | header[1];
+    } else if (payload_len == 127) {
+        if (_ws_read_all(client, header, 8) != 8) {
+            return ESP_FAIL;
+        }
+        payload_len = 0;
+        for (int i = 0; i < 8; i++) {
+            payload_len = (payload_len << 8) | header[i];
+        }
+    }
+    uint8_t mask[4] = { 0 };
+    if (masked && _ws_read_all(client, mask, 4) != 4) {
+        return ESP_FAIL;
+    }
+    int offset = 0;
+    do {
+        int len = payload_len - offset < client->buffer_size ? payload_len - offset : client->buffer_size;
+        if (len > 0 && _ws_read_all(client, client->rx_buffer, len) != len) {
+            return ESP_FAIL;
+        }
+        for (int i = 0; masked && i < len; i++) {
+            client->rx_buffer[i] ^= mask[(offset + i) % 4];
+        }
+        if (opcode == WS_OPCODE_PING) {
+            xSemaphoreTake(client->tx_lock, portMAX_DELAY);
+            _ws_write_frame(client, WS_OPCODE_PONG, client->rx_buffer, len);
+            xSemaphoreGive(client->tx_lock);
+        } else if (opcode == WS_OPCODE_CLOSE) {
+            xSemaphoreTake(client->tx_lock, portMAX_DELAY);
+            _ws_write_frame(client, WS_OPCODE_CLOSE, client->rx_buffer, len < 2 ? len : 2);
+            xSemaphoreGive(client->tx_lock);
+            return ESP_FAIL;
+        } else {
+            _ws_dispatch(client, WEBSOCKET_EVENT_DATA, client->rx_buffer, len, opcode, payload_len, offset);
+        }
+        offset += len;
+    } while (offset < payload_len);
+    return ESP_OK;
+}
+
+static void _ws_task(void *pv)
+{
+    esp_websocket_client_handle_t client = (esp_websocket_client_handle_t)pv;
+    if (_ws_connect(client) == ESP_OK) {
+        client->connected = true;
+        _ws_dispatch(client, WEBSOCKET_EVENT_CONNECTED, NULL, 0, 0, 0, 0);
+        while (client->run && _ws_read_frame(client) == ESP_OK);
+    }
+    bool was_running = client->run;
+    xSemaphoreTake(client->tx_lock, portMAX_DELAY);
+    client->connected = false;
+    if (client->sock >= 0) {
+        close(client->sock);
+        client->sock = -1;
+    }
+    xSemaphoreGive(client->tx_lock);
+    /* No reconnect on the host, and esp_websocket_client_stop raises no event */
+    if (was_running) {
+        _ws_dispatch(client, WEBSOCKET_EVENT_DISCONNECTED, NULL, 0, 0, 0, 0);
+    }
+    xEventGroupSetBits(client->status, WS_STOPPED_BIT);
+    vTaskDelete(NULL);
+}
+
+esp_websocket_client_handle_t esp_websocket_client_init(const esp_websocket_client_config_t *config)
+{
+    esp_websocket_client_handle_t client = calloc(1, sizeof(struct esp_websocket_client));
+    AUDIO_MEM_CHECK(TAG, client, return NULL);
+    client->sock = -1;
+    client->buffer_size = config->buffer_size > 0 ? config->buffer_size : WS_BUFFER_SIZE_BYTE;
+    client->task_stack = config->task_stack > 0 ? config->task_stack : WS_TASK_STACK;
+    client->task_prio = config->task_prio > 0 ? config->task_prio : WS_TASK_PRIORITY;
+    client->user_context = config->user_context;
+    client->rx_buffer = malloc(client->buffer_size);
+    client->tx_lock = xSemaphoreCreateMutex();
+    client->status = xEventGroupCreate();
+    AUDIO_MEM_CHECK(TAG, client->rx_buffer && client->tx_lock && client->status, goto _error);
+    if (config->uri == NULL || _ws_parse_uri(client, config->uri) != ESP_OK) {
+        goto _error;
+    }
+    xEventGroupSetBits(client->status, WS_STOPPED_BIT);
+    return client;
+_error:
+    esp_websocket_client_destroy(client);
+    return NULL;
+}
+
+esp_err_t esp_websocket_client_set_uri(esp_websocket_client_handle_t client, const char *uri)
+{
+    return _ws_parse_uri(client, uri);
+}
+
+esp_err_t esp_websocket_client_start(esp_websocket_client_handle_t client)
+{
+    if (client->run) {
+        ESP_LOGE(TAG, "The client has started");
+        return ESP_FAIL;
+    }
+    client->run = true;
+    xEventGroupClearBits(client->status, WS_STOPPED_BIT);
+    if (xTaskCreate(_ws_task, "websocket_task", client->task_stack, client, client->task_prio, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Error create websocket task");
+        client->run = false;
+        xEventGroupSetBits(client->status, WS_STOPPED_BIT);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_websocket_client_stop(esp_websocket_client_handle_t client)
+{
+    if (!client->run) {
+        /* The task may still be on its way out after the server closed */
+        xEventGroupWaitBits(client->status, WS_STOPPED_BIT, pdFALSE, pdTRUE, portMAX_DELAY);
+        return ESP_FAIL;
+    }
+    client->run = false;
+    xEventGroupWaitBits(client->status, WS_STOPPED_BIT, pdFALSE, pdTRUE, portMAX_DELAY);
+    return ESP_OK;
+}
+
+esp_err_t esp_websocket_client_destroy(esp_websocket_client_handle_t client)
+{
+    if (client == NULL) {
+        return ESP_FAIL;
+    }
+    if (client->status) {
+        esp_websocket_client_stop(client);
+        vEventGroupDelete(client->status);
+    }
+    if (client->tx_lock) {
+        vSemaphoreDelete(client->tx_lock);
+    }
+    free(client->rx_buffer);
+    free(client->path);
+    free(client);
+    return ESP_OK;
+}
+
+static int _ws_send(esp_websocket_client_handle_t client, uint8_t opcode, const char *data, int len, TickType_t timeout)
+{
+    if (!client->connected) {
+        ESP_LOGE(TAG, "Websocket client is not connected");
+        return ESP_FAIL;
+    }
+    if (xSemaphoreTake(client->tx_lock, timeout) != pdPASS) {
+        return ESP_FAIL;
+    }
+    int widx = 0;
+    while (widx < len && client->sock >= 0) {
+        int need_write = len - widx < client->buffer_size ? len - widx : client->buffer_size;
+        if (_ws_write_frame(client, opcode, data + widx, need_write) != need_write) {
+            ESP_LOGE(TAG, "Network error: send frame failed");
+            widx = ESP_FAIL;
+            break;
+        }
+        widx += need_write;
+    }
+    xSemaphoreGive(client->tx_lock);
+    return widx;
+}
+
+int esp_websocket_client_send(esp_websocket_client_handle_t client, const char *data, int len, TickType_t timeout)
+{
+    return _ws_send(client, WS_OPCODE_BINARY, data, len, timeout);
+}
+
+int esp_websocket_client_send_bin(esp_websocket_client_handle_t client, const char *data, int len, TickType_t timeout)
+{
+    return _ws_send(client, WS_OPCODE_BINARY, data, len, timeout);
+}
+
+int esp_websocket_client_send_text(esp_websocket_client_handle_t client, const char *data, int len, TickType_t timeout)
+{
+    return _ws_send(client, WS_OPCODE_TEXT, data, len, timeout);
+}
+
+bool esp_websocket_client_is_connected(esp_websocket_client_handle_t client)
+{
+    return client->connected;
+}
+
+esp_err_t esp_websocket_register_events(esp_websocket_client_handle_t client, esp_websocket_event_id_t event,
+                                        esp_event_handler_t event_handler, void *event_handler_arg)
+{
+    client->handler = event_handler;
+    client->handler_event = event;
+    client->handler_arg = event_handler_arg;
+    return ESP_OK;
+}
@@ -0,0 +1,570 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <pthread.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "HOST_RTOS";
+
+#define HOST_STACK_SLACK        (64 * 1024)     /* The host's frames and C library need more than the device's */
+#define HOST_STACK_PAINT        (0xA5)
+#define HOST_STACK_PAINT_GAP    (1024)          /* Left unpainted below the frame that paints */
+
+struct host_task {
+    pthread_t           thread;
+    char                name[16];
+    TaskFunction_t      fn;
+    void                *param;
+    UBaseType_t         prio;
+    BaseType_t          core;
+    UBaseType_t         number;
+    uint32_t            stack_depth;            /* Bytes asked for, 0 for threads not created here */
+    uint8_t             *stack_lo;              /* Painted from here up */
+    size_t              stack_size;             /* Of the whole thread stack */
+    clockid_t           cpu_clock;
+    bool                has_cpu_clock;
+    uint32_t            notify;
+    pthread_mutex_t     lock;
+    pthread_cond_t      cond;
+    struct host_task    *next;
+};
+
+static pthread_mutex_t s_tasks_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct host_task *s_tasks;
+static UBaseType_t s_task_number;
+static __thread struct host_task *s_current;
+
+static void _cond_init(pthread_cond_t *cond)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+/* Absolute CLOCK_MONOTONIC deadline `ticks` from now, false for portMAX_DELAY */
+static bool _deadline(TickType_t ticks, struct timespec *ts)
+{
+    if (ticks == portMAX_DELAY) {
+        return false;
+    }
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    uint64_t ns = (uint64_t)ticks * portTICK_PERIOD_MS * 1000000ULL + ts->tv_nsec;
+    ts->tv_sec += ns / 1000000000ULL;
+    ts->tv_nsec = ns % 1000000000ULL;
+    return true;
+}
+
+/* Wait on `cond` until the deadline, false once it has passed */
+static bool _cond_wait(pthread_cond_t *cond, pthread_mutex_t *lock, bool timed, const struct timespec *ts)
+{
+    if (!timed) {
+        pthread_cond_wait(cond, lock);
+        return true;
+    }
+    return pthread_cond_timedwait(cond, lock, ts) != ETIMEDOUT;
+}
+
+static void _task_link(struct host_task *task)
+{
+    pthread_mutex_lock(&s_tasks_lock);
+    task->number = ++s_task_number;
+    task->next = s_tasks;
+    s_tasks = task;
+    pthread_mutex_unlock(&s_tasks_lock);
+}
+
+static void _task_unlink(struct host_task *task)
+{
+    pthread_mutex_lock(&s_tasks_lock);
+    for (struct host_task **at = &s_tasks; *at; at = &(*at)->next) {
+        if (*at == task) {
+            *at = task->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&s_tasks_lock);
+}
+
+static struct host_task *_task_alloc(const char *name, UBaseType_t prio, BaseType_t core)
+{
+    struct host_task *task = calloc(1, sizeof(struct host_task));
+    if (task == NULL) {
+        return NULL;
+    }
+    snprintf(task->name, sizeof(task->name), "%s", name ? name : "");
+    task->prio = prio;
+    task->core = core;
+    pthread_mutex_init(&task->lock, NULL);
+    _cond_init(&task->cond);
+    return task;
+}
+
+/* A thread not started by xTaskCreate, e.g. main, gets a task on first use */
+static struct host_task *_task_self(void)
+{
+    if (s_current == NULL) {
+        char name[16] = "main";
+        pthread_getname_np(pthread_self(), name, sizeof(name));
+        s_current = _task_alloc(name, 1, tskNO_AFFINITY);
+        if (s_current == NULL) {
+            abort();
+        }
+        s_current->thread = pthread_self();
+        s_current->has_cpu_clock = pthread_getcpuclockid(pthread_self(), &s_current->cpu_clock) == 0;
+        _task_link(s_current);
+    }
+    return s_current;
+}
+
+/* Paint the stack below this frame, uxTaskGetStackHighWaterMark finds how far the task got */
+static void __attribute__((noinline)) _task_paint_stack(struct host_task *task)
+{
+    pthread_attr_t attr;
+    void *addr;
+    size_t size;
+    if (pthread_getattr_np(pthread_self(), &attr) != 0) {
+        return;
+    }
+    if (pthread_attr_getstack(&attr, &addr, &size) == 0) {
+        uint8_t *here = (uint8_t *)__builtin_frame_address(0);
+        uint8_t *lo = (uint8_t *)addr;
+        if (here - HOST_STACK_PAINT_GAP > lo) {
+            memset(lo, HOST_STACK_PAINT, here - HOST_STACK_PAINT_GAP - lo);
+            task->stack_lo = lo;
+            task->stack_size = size;
+        }
+    }
+    pthread_attr_destroy(&attr);
+}
+
+static void *_task_entry(void *arg)
+{
+    struct host_task *task = (struct host_task *)arg;
+    s_current = task;
+    pthread_setname_np(pthread_self(), task->name);
+    task->has_cpu_clock = pthread_getcpuclockid(pthread_self(), &task->cpu_clock) == 0;
+    _task_paint_stack(task);
+    task->fn(task->param);
+    /* Returning from a task is an error on the device */
+    ESP_LOGE(TAG, "Task %s returned", task->name);
+    vTaskDelete(NULL);
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, const uint32_t stack_depth, void *param,
+                                   UBaseType_t priority, TaskHandle_t *created_task, const BaseType_t core_id)
+{
+    struct host_task *task = _task_alloc(name, priority, core_id);
+    if (task == NULL) {
+        return pdFAIL;
+    }
+    task->fn = fn;
+    task->param = param;
+    task->stack_depth = stack_depth;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    size_t stack = ((size_t)stack_depth + HOST_STACK_SLACK + 4095) & ~(size_t)4095;
+    pthread_attr_setstacksize(&attr, stack);
+    _task_link(task);
+    if (created_task) {
+        *created_task = task;
+    }
+    int err = pthread_create(&task->thread, &attr, _task_entry, task);
+    pthread_attr_destroy(&attr);
+    if (err != 0) {
+        ESP_LOGE(TAG, "Error create task %s: %s", task->name, strerror(err));
+        _task_unlink(task);
+        free(task);
+        if (created_task) {
+            *created_task = NULL;
+        }
+        return pdFAIL;
+    }
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    struct host_task *self = _task_self();
+    if (task != NULL && task != self) {
+        ESP_LOGE(TAG, "Deleting task %s from %s is not supported on the host", task->name, self->name);
+        abort();
+    }
+    _task_unlink(self);
+    s_current = NULL;
+    pthread_mutex_destroy(&self->lock);
+    pthread_cond_destroy(&self->cond);
+    free(self);
+    pthread_exit(NULL);
+}
+
+void vTaskDelay(const TickType_t ticks)
+{
+    struct timespec ts = {
+        .tv_sec = ticks * portTICK_PERIOD_MS / 1000,
+        .tv_nsec = (long)(ticks * portTICK_PERIOD_MS % 1000) * 1000000L,
+    };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(esp_timer_get_time() / 1000 / portTICK_PERIOD_MS);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return _task_self();
+}
+
+char *pcTaskGetTaskName(TaskHandle_t task)
+{
+    return (task ? task : _task_self())->name;
+}
+
+static uint32_t _task_stack_free(const struct host_task *task)
+{
+    if (task->stack_lo == NULL || task->stack_depth == 0) {
+        return 0;
+    }
+    size_t untouched = 0;
+    while (untouched < task->stack_size && task->stack_lo[untouched] == HOST_STACK_PAINT) {
+        untouched++;
+    }
+    size_t used = task->stack_size - untouched;
+    return used < task->stack_depth ? (uint32_t)(task->stack_depth - used) : 0;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    return _task_stack_free(task ? task : _task_self());
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait)
+{
+    struct host_task *self = _task_self();
+    struct timespec ts;
+    bool timed = _deadline(ticks_to_wait, &ts);
+    pthread_mutex_lock(&self->lock);
+    while (self->notify == 0 && ticks_to_wait != 0 && _cond_wait(&self->cond, &self->lock, timed, &ts));
+    uint32_t value = self->notify;
+    if (value) {
+        self->notify = clear_on_exit ? 0 : value - 1;
+    }
+    pthread_mutex_unlock(&self->lock);
+    return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    pthread_mutex_lock(&task->lock);
+    task->notify++;
+    pthread_cond_signal(&task->cond);
+    pthread_mutex_unlock(&task->lock);
+    return pdPASS;
+}
+
+UBaseType_t uxTaskGetNumberOfTasks(void)
+{
+    _task_self();
+    UBaseType_t count = 0;
+    pthread_mutex_lock(&s_tasks_lock);
+    for (struct host_task *task = s_tasks; task; task = task->next) {
+        count++;
+    }
+    pthread_mutex_unlock(&s_tasks_lock);
+    return count;
+}
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *const status, const UBaseType_t size, uint32_t *const total_run_time)
+{
+    _task_self();
+    UBaseType_t count = 0;
+    pthread_mutex_lock(&s_tasks_lock);
+    for (struct host_task *task = s_tasks; task && count < size; task = task->next) {
+        TaskStatus_t *st = &status[count++];
+        memset(st, 0, sizeof(TaskStatus_t));
+        st->xHandle = task;
+        st->pcTaskName = task->name;
+        st->xTaskNumber = task->number;
+        st->eCurrentState = task == s_current ? eRunning : eBlocked;
+        st->uxCurrentPriority = task->prio;
+        st->uxBasePriority = task->prio;
+        st->usStackHighWaterMark = _task_stack_free(task);
+        st->xCoreID = task->core;
+        struct timespec ts;
+        if (task->has_cpu_clock && clock_gettime(task->cpu_clock, &ts) == 0) {
+            st->ulRunTimeCounter = (uint32_t)((uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000);
+        }
+    }
+    pthread_mutex_unlock(&s_tasks_lock);
+    if (total_run_time) {
+        *total_run_time = (uint32_t)esp_timer_get_time();
+    }
+    return count;
+}
+
+struct host_sem {
+    pthread_mutex_t     lock;
+    pthread_cond_t      cond;
+    UBaseType_t         count;
+    UBaseType_t         max;
+};
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count)
+{
+    struct host_sem *sem = calloc(1, sizeof(struct host_sem));
+    if (sem == NULL) {
+        return NULL;
+    }
+    pthread_mutex_init(&sem->lock, NULL);
+    _cond_init(&sem->cond);
+    sem->count = initial_count;
+    sem->max = max_count;
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return xSemaphoreCreateCounting(1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return xSemaphoreCreateCounting(1, 0);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    pthread_mutex_destroy(&sem->lock);
+    pthread_cond_destroy(&sem->cond);
+    free(sem);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks_to_wait)
+{
+    struct timespec ts;
+    bool timed = _deadline(ticks_to_wait, &ts);
+    pthread_mutex_lock(&sem->lock);
+    while (sem->count == 0 && ticks_to_wait != 0 && _cond_wait(&sem->cond, &sem->lock, timed, &ts));
+    BaseType_t ret = pdFALSE;
+    if (sem->count > 0) {
+        sem->count--;
+        ret = pdTRUE;
+    }
+    pthread_mutex_unlock(&sem->lock);
+    return ret;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    BaseType_t ret = pdFALSE;
+    pthread_mutex_lock(&sem->lock);
+    if (sem->count < sem->max) {
+        sem->count++;
+        pthread_cond_signal(&sem->cond);
+        ret = pdTRUE;
+    }
+    pthread_mutex_unlock(&sem->lock);
+    return ret;
+}
+
+struct host_event_group {
+    pthread_mutex_t     lock;
+    pthread_cond_t      cond;
+    EventBits_t         bits;
+};
+
+EventGroupHandle_t xEventGroupCreate(void)
+{
+    struct host_event_group *group = calloc(1, sizeof(struct host_event_group));
+    if (group == NULL) {
+        return NULL;
+    }
+    pthread_mutex_init(&group->lock, NULL);
+    _cond_init(&group->cond);
+    return group;
+}
+
+void vEventGroupDelete(EventGroupHandle_t group)
+{
+    pthread_mutex_destroy(&group->lock);
+    pthread_cond_destroy(&group->cond);
+    free(group);
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, const EventBits_t bits)
+{
+    pthread_mutex_lock(&group->lock);
+    group->bits |= bits;
+    EventBits_t value = group->bits;
+    pthread_cond_broadcast(&group->cond);
+    pthread_mutex_unlock(&group->lock);
+    return value;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, const EventBits_t bits)
+{
+    pthread_mutex_lock(&group->lock);
+    EventBits_t value = group->bits;
+    group->bits &= ~bits;
+    pthread_mutex_unlock(&group->lock);
+    return value;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group)
+{
+    pthread_mutex_lock(&group->lock);
+    EventBits_t value = group->bits;
+    pthread_mutex_unlock(&group->lock);
+    return value;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, const EventBits_t bits, const BaseType_t clear_on_exit,
+                                const BaseType_t wait_for_all, TickType_t ticks_to_wait)
+{
+    struct timespec ts;
+    bool timed = _deadline(ticks_to_wait, &ts);
+    pthread_mutex_lock(&group->lock);
+    for (;;) {
+        bool met = wait_for_all ? (group->bits & bits) == bits : (group->bits & bits) != 0;
+        if (met) {
+            EventBits_t value = group->bits;
+            if (clear_on_exit) {
+                group->bits &= ~bits;
+            }
+            pthread_mutex_unlock(&group->lock);
+            return value;
+        }
+        if (ticks_to_wait == 0 || !_cond_wait(&group->cond, &group->lock, timed, &ts)) {
+            break;
+        }
+    }
+    EventBits_t value = group->bits;
+    pthread_mutex_unlock(&group->lock);
+    return value;
+}
+
+struct host_queue {
+    pthread_mutex_t     lock;
+    pthread_cond_t      cond;
+    UBaseType_t         length;
+    UBaseType_t         item_size;
+    UBaseType_t         head;
+    UBaseType_t         count;
+    uint8_t             *items;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    struct host_queue *queue = calloc(1, sizeof(struct host_queue));
+    if (queue == NULL) {
+        return NULL;
+    }
+    queue->items = malloc((size_t)length * item_size);
+    if (queue->items == NULL) {
+        free(queue);
+        return NULL;
+    }
+    pthread_mutex_init(&queue->lock, NULL);
+    _cond_init(&queue->cond);
+    queue->length = length;
+    queue->item_size = item_size;
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    pthread_mutex_destroy(&queue->lock);
+    pthread_cond_destroy(&queue->cond);
+    free(queue->items);
+    free(queue);
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait)
+{
+    struct timespec ts;
+    bool timed = _deadline(ticks_to_wait, &ts);
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == queue->length && ticks_to_wait != 0 && _cond_wait(&queue->cond, &queue->lock, timed, &ts));
+    BaseType_t ret = errQUEUE_FULL;
+    if (queue->count < queue->length) {
+        UBaseType_t tail = (queue->head + queue->count) % queue->length;
+        memcpy(queue->items + tail * queue->item_size, item, queue->item_size);
+        queue->count++;
+        pthread_cond_broadcast(&queue->cond);
+        ret = pdPASS;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return ret;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks_to_wait)
+{
+    struct timespec ts;
+    bool timed = _deadline(ticks_to_wait, &ts);
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0 && ticks_to_wait != 0 && _cond_wait(&queue->cond, &queue->lock, timed, &ts));
+    BaseType_t ret = errQUEUE_EMPTY;
+    if (queue->count > 0) {
+        memcpy(item, queue->items + queue->head * queue->item_size, queue->item_size);
+        queue->head = (queue->head + 1) % queue->length;
+        queue->count--;
+        pthread_cond_broadcast(&queue->cond);
+        ret = pdPASS;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return ret;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    pthread_mutex_lock(&queue->lock);
+    UBaseType_t count = queue->count;
+    pthread_mutex_unlock(&queue->lock);
+    return count;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue)
+{
+    pthread_mutex_lock(&queue->lock);
+    queue->head = 0;
+    queue->count = 0;
+    pthread_cond_broadcast(&queue->cond);
+    pthread_mutex_unlock(&queue->lock);
+    return pdPASS;
+}
@@ -0,0 +1,101 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "esp_heap_trace.h"
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+static atomic_bool s_tracing;
+static atomic_size_t s_count;
+static size_t s_records;
+
+static inline void _count(void)
+{
+    if (atomic_load_explicit(&s_tracing, memory_order_relaxed)) {
+        atomic_fetch_add_explicit(&s_count, 1, memory_order_relaxed);
+    }
+}
+
+void *__wrap_malloc(size_t size)
+{
+    _count();
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    _count();
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    _count();
+    return __real_realloc(ptr, size);
+}
+
+/* glibc's strdup allocates inside the library, out of reach of the malloc wrapper */
+char *__wrap_strdup(const char *s)
+{
+    size_t len = strlen(s) + 1;
+    char *copy = __wrap_malloc(len);
+    return copy ? memcpy(copy, s, len) : NULL;
+}
+
+esp_err_t heap_trace_init_standalone(heap_trace_record_t *record_buffer, size_t num_records)
+{
+    if (record_buffer == NULL || num_records == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_records = num_records;
+    return ESP_OK;
+}
+
+esp_err_t heap_trace_start(heap_trace_mode_t mode)
+{
+    if (s_records == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    atomic_store(&s_count, 0);
+    atomic_store(&s_tracing, true);
+    return ESP_OK;
+}
+
+esp_err_t heap_trace_stop(void)
+{
+    atomic_store(&s_tracing, false);
+    return ESP_OK;
+}
+
+size_t heap_trace_get_count(void)
+{
+    size_t count = atomic_load(&s_count);
+    return count < s_records ? count : s_records;
+}
@@ -0,0 +1,200 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "audio_error.h"
+#include "i2s_stream.h"
+#include "sr_host_mic.h"
+
+static const char *TAG = "I2S_STREAM";
+
+#define I2S_STREAM_MAX_LAG_US   (100 * 1000)    /* Catch up no more than this after a stall of the reader */
+
+typedef struct {
+    int     rate;
+    int     channels;
+    int64_t next_us;                            /* When the next buffer is due */
+} i2s_stream_t;
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t  played;
+    int16_t         *samples;
+    int             frames;
+    int             channels;
+    int             pos;
+    int             speed;
+} s_mic = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .played = PTHREAD_COND_INITIALIZER,
+    .speed = 100,
+};
+
+esp_err_t sr_host_mic_play(const int16_t *samples, int frames, int channels)
+{
+    int16_t *copy = malloc((size_t)frames * channels * sizeof(int16_t));
+    AUDIO_MEM_CHECK(TAG, copy, return ESP_ERR_NO_MEM);
+    memcpy(copy, samples, (size_t)frames * channels * sizeof(int16_t));
+    pthread_mutex_lock(&s_mic.lock);
+    free(s_mic.samples);
+    s_mic.samples = copy;
+    s_mic.frames = frames;
+    s_mic.channels = channels;
+    s_mic.pos = 0;
+    pthread_mutex_unlock(&s_mic.lock);
+    return ESP_OK;
+}
+
+esp_err_t sr_host_mic_wait_played(int timeout_ms)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint64_t ns = (uint64_t)timeout_ms * 1000000ULL + ts.tv_nsec;
+    ts.tv_sec += ns / 1000000000ULL;
+    ts.tv_nsec = ns % 1000000000ULL;
+    esp_err_t ret = ESP_OK;
+    pthread_mutex_lock(&s_mic.lock);
+    while (s_mic.pos < s_mic.frames) {
+        if (pthread_cond_timedwait(&s_mic.played, &s_mic.lock, &ts) == ETIMEDOUT) {
+            ret = ESP_ERR_TIMEOUT;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&s_mic.lock);
+    return ret;
+}
+
+void sr_host_mic_set_speed(int percent)
+{
+    pthread_mutex_lock(&s_mic.lock);
+    s_mic.speed = percent < 0 ? 0 : percent;
+    pthread_mutex_unlock(&s_mic.lock);
+}
+
+/* Fill `frames` frames of `channels` from the clip, silence past its end, returns the speed the clip plays at or -1 */
+static int _mic_read(int16_t *out, int frames, int channels)
+{
+    pthread_mutex_lock(&s_mic.lock);
+    int speed = -1;
+    int n = 0;
+    if (s_mic.pos < s_mic.frames) {
+        speed = s_mic.speed;
+        n = s_mic.frames - s_mic.pos < frames ? s_mic.frames - s_mic.pos : frames;
+        const int16_t *in = s_mic.samples + (size_t)s_mic.pos * s_mic.channels;
+        for (int i = 0; i < n; i++) {
+            for (int ch = 0; ch < channels; ch++) {
+                out[i * channels + ch] = in[i * s_mic.channels + (ch < s_mic.channels ? ch : 0)];
+            }
+        }
+        s_mic.pos += n;
+        if (s_mic.pos == s_mic.frames) {
+            pthread_cond_broadcast(&s_mic.played);
+        }
+    }
+    pthread_mutex_unlock(&s_mic.lock);
+    memset(out + n * channels, 0, (size_t)(frames - n) * channels * sizeof(int16_t));
+    return speed;
+}
+
+static esp_err_t _i2s_open(audio_element_handle_t self)
+{
+    i2s_stream_t *i2s = (i2s_stream_t *)audio_element_getdata(self);
+    i2s->next_us = esp_timer_get_time();
+    return ESP_OK;
+}
+
+/* Like the DMA, a buffer is there once the microphone has heard all of it */
+static int _i2s_process(audio_element_handle_t self, char *in_buffer, int in_len)
+{
+    i2s_stream_t *i2s = (i2s_stream_t *)audio_element_getdata(self);
+    int frames = in_len / (2 * i2s->channels);
+    int speed = _mic_read((int16_t *)in_buffer, frames, i2s->channels);
+    int64_t duration_us = (int64_t)frames * 1000000 / i2s->rate;
+    if (speed >= 0) {
+        duration_us = duration_us * speed / 100;
+    }
+    int64_t now = esp_timer_get_time();
+    if (i2s->next_us < now - I2S_STREAM_MAX_LAG_US) {
+        i2s->next_us = now;
+    }
+    i2s->next_us += duration_us;
+    if (i2s->next_us > now) {
+        usleep(i2s->next_us - now);
+    }
+    return audio_element_output(self, in_buffer, frames * 2 * i2s->channels);
+}
+
+static esp_err_t _i2s_destroy(audio_element_handle_t self)
+{
+    free(audio_element_getdata(self));
+    return ESP_OK;
+}
+
+audio_element_handle_t i2s_stream_init(i2s_stream_cfg_t *config)
+{
+    if (config->type != AUDIO_STREAM_READER) {
+        ESP_LOGE(TAG, "Only the reader is supported on the host");
+        return NULL;
+    }
+    i2s_stream_t *i2s = calloc(1, sizeof(i2s_stream_t));
+    AUDIO_MEM_CHECK(TAG, i2s, return NULL);
+    i2s->rate = 16000;
+    i2s->channels = 1;
+
+    audio_element_cfg_t cfg = DEFAULT_AUDIO_ELEMENT_CONFIG();
+    cfg.open = _i2s_open;
+    cfg.process = _i2s_process;
+    cfg.destroy = _i2s_destroy;
+    cfg.buffer_len = I2S_STREAM_BUF_SIZE;
+    cfg.task_stack = config->task_stack;
+    cfg.task_prio = config->task_prio;
+    cfg.task_core = config->task_core;
+    cfg.out_rb_size = config->out_rb_size;
+    cfg.tag = "iis";
+    audio_element_handle_t el = audio_element_init(&cfg);
+    AUDIO_MEM_CHECK(TAG, el, {
+        free(i2s);
+        return NULL;
+    });
+    audio_element_setdata(el, i2s);
+    return el;
+}
+
+esp_err_t i2s_stream_set_clk(audio_element_handle_t i2s_stream, int rate, int bits, int ch)
+{
+    if (bits != 16 || ch < 1 || ch > 2 || rate <= 0) {
+        ESP_LOGE(TAG, "Unsupported clock %d Hz, %d bits, %d channels", rate, bits, ch);
+        return ESP_FAIL;
+    }
+    i2s_stream_t *i2s = (i2s_stream_t *)audio_element_getdata(i2s_stream);
+    i2s->rate = rate;
+    i2s->channels = ch;
+    return ESP_OK;
+}
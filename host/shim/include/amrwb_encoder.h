@@ -0,0 +1,85 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * AMR-WB encoder of the host build.
+ *
+ * With libvo-amrwbenc it encodes for real. Without it, the frames have the
+ * size and header of the chosen mode and carry a digest of the audio: the
+ * wire bytes are right, the encoder's CPU time is not.
+ */
+
+#ifndef _AMRWB_ENCODER_H_
+#define _AMRWB_ENCODER_H_
+
+#include "audio_element.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    AMRWB_ENC_BITRATE_MD66 = 0,
+    AMRWB_ENC_BITRATE_MD885,
+    AMRWB_ENC_BITRATE_MD1265,
+    AMRWB_ENC_BITRATE_MD1425,
+    AMRWB_ENC_BITRATE_MD1585,
+    AMRWB_ENC_BITRATE_MD1825,
+    AMRWB_ENC_BITRATE_MD1985,
+    AMRWB_ENC_BITRATE_MD2305,
+    AMRWB_ENC_BITRATE_MD2385,
+} amrwb_encoder_bitrate_t;
+
+typedef struct {
+    amrwb_encoder_bitrate_t bitrate_mode;
+    bool                    contain_amrwb_header;   /*!< Start the output with "#!AMR-WB\n" */
+    int                     out_rb_size;
+    int                     task_stack;
+    int                     task_core;
+    int                     task_prio;
+    bool                    stack_in_ext;
+} amrwb_encoder_cfg_t;
+
+#define AMRWB_ENCODER_TASK_STACK        (15 * 1024)
+#define AMRWB_ENCODER_TASK_CORE         (0)
+#define AMRWB_ENCODER_TASK_PRIO         (5)
+#define AMRWB_ENCODER_RINGBUFFER_SIZE   (2 * 1024)
+
+#define DEFAULT_AMRWB_ENCODER_CONFIG() {                \
+    .bitrate_mode = AMRWB_ENC_BITRATE_MD885,            \
+    .contain_amrwb_header = false,                      \
+    .out_rb_size = AMRWB_ENCODER_RINGBUFFER_SIZE,       \
+    .task_stack = AMRWB_ENCODER_TASK_STACK,             \
+    .task_core = AMRWB_ENCODER_TASK_CORE,               \
+    .task_prio = AMRWB_ENCODER_TASK_PRIO,               \
+    .stack_in_ext = true,                               \
+}
+
+audio_element_handle_t amrwb_encoder_init(amrwb_encoder_cfg_t *config);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,198 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * The audio element of ESP-ADF, on host threads.
+ *
+ * Same life cycle as on the device: a task per element waits for commands,
+ * opens the element on the first resume and calls `process` until it
+ * returns done, abort or an error. An element with `task_stack <= 0` has no
+ * task, its owner reads and writes its ring buffers directly.
+ */
+
+#ifndef _AUDIO_ELEMENT_H_
+#define _AUDIO_ELEMENT_H_
+
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+#include "audio_common.h"
+#include "audio_error.h"
+#include "audio_event_iface.h"
+#include "ringbuf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    AEL_IO_OK           = ESP_OK,
+    AEL_IO_FAIL         = ESP_FAIL,
+    AEL_IO_DONE         = -2,
+    AEL_IO_ABORT        = -3,
+    AEL_IO_TIMEOUT      = -4,
+    AEL_PROCESS_FAIL    = -5,
+} audio_element_err_t;
+
+typedef enum {
+    AEL_STATE_NONE      = 0,
+    AEL_STATE_INIT,
+    AEL_STATE_RUNNING,
+    AEL_STATE_PAUSED,
+    AEL_STATE_STOPPED,
+    AEL_STATE_FINISHED,
+    AEL_STATE_ERROR
+} audio_element_state_t;
+
+typedef enum {
+    AEL_MSG_CMD_NONE                = 0,
+    AEL_MSG_CMD_FINISH              = 2,
+    AEL_MSG_CMD_STOP                = 3,
+    AEL_MSG_CMD_PAUSE               = 4,
+    AEL_MSG_CMD_RESUME              = 5,
+    AEL_MSG_CMD_DESTROY             = 6,
+    AEL_MSG_CMD_REPORT_STATUS       = 8,
+} audio_element_msg_cmd_t;
+
+typedef enum {
+    AEL_STATUS_NONE                 = 0,
+    AEL_STATUS_ERROR_OPEN           = 1,
+    AEL_STATUS_ERROR_INPUT          = 2,
+    AEL_STATUS_ERROR_PROCESS        = 3,
+    AEL_STATUS_ERROR_OUTPUT         = 4,
+    AEL_STATUS_ERROR_CLOSE          = 5,
+    AEL_STATUS_INPUT_DONE           = 8,
+    AEL_STATUS_STATE_RUNNING        = 11,
+    AEL_STATUS_STATE_PAUSED         = 12,
+    AEL_STATUS_STATE_STOPPED        = 13,
+    AEL_STATUS_STATE_FINISHED       = 14,
+} audio_element_status_t;
+
+typedef struct audio_element *audio_element_handle_t;
+
+typedef esp_err_t (*el_io_func)(audio_element_handle_t self);
+typedef audio_element_err_t (*process_func)(audio_element_handle_t self, char *el_buffer, int el_buf_len);
+
+typedef struct {
+    el_io_func          open;
+    el_io_func          seek;
+    process_func        process;
+    el_io_func          close;
+    el_io_func          destroy;
+    int                 buffer_len;     /*!< Buffer handed to `process` */
+    int                 task_stack;     /*!< No task if <= 0 */
+    int                 task_prio;
+    int                 task_core;
+    int                 out_rb_size;    /*!< Ring buffer created behind the element when the pipeline is linked */
+    void                *data;
+    const char          *tag;
+    bool                stack_in_ext;
+} audio_element_cfg_t;
+
+#define DEFAULT_ELEMENT_RINGBUF_SIZE    (8*1024)
+#define DEFAULT_ELEMENT_BUFFER_LENGTH   (1024)
+#define DEFAULT_ELEMENT_STACK_SIZE      (2*1024)
+#define DEFAULT_ELEMENT_TASK_PRIO       (5)
+#define DEFAULT_ELEMENT_TASK_CORE       (0)
+
+#define DEFAULT_AUDIO_ELEMENT_CONFIG() {                \
+    .buffer_len         = DEFAULT_ELEMENT_BUFFER_LENGTH,\
+    .task_stack         = DEFAULT_ELEMENT_STACK_SIZE,   \
+    .task_prio          = DEFAULT_ELEMENT_TASK_PRIO,    \
+    .task_core          = DEFAULT_ELEMENT_TASK_CORE,    \
+    .out_rb_size        = DEFAULT_ELEMENT_RINGBUF_SIZE, \
+}
+
+audio_element_handle_t audio_element_init(audio_element_cfg_t *config);
+
+/**
+ * @brief      Stop the task and free the element, `destroy` is called first
+ */
+esp_err_t audio_element_deinit(audio_element_handle_t el);
+
+esp_err_t audio_element_setdata(audio_element_handle_t el, void *data);
+void *audio_element_getdata(audio_element_handle_t el);
+char *audio_element_get_tag(audio_element_handle_t el);
+esp_err_t audio_element_set_tag(audio_element_handle_t el, const char *tag);
+audio_element_state_t audio_element_get_state(audio_element_handle_t el);
+
+/**
+ * @brief      Read from the input ring, within the input timeout (portMAX_DELAY unless set)
+ *
+ * @return     Bytes read, AEL_IO_DONE once the writer is done and the ring empty, AEL_IO_ABORT, AEL_IO_TIMEOUT
+ */
+audio_element_err_t audio_element_input(audio_element_handle_t el, char *buffer, int wanted_size);
+
+/**
+ * @brief      Write to the output ring
+ *
+ * @return     Bytes written, AEL_IO_ABORT if the ring was aborted
+ */
+audio_element_err_t audio_element_output(audio_element_handle_t el, char *buffer, int write_size);
+
+esp_err_t audio_element_set_input_timeout(audio_element_handle_t el, TickType_t timeout);
+esp_err_t audio_element_set_output_timeout(audio_element_handle_t el, TickType_t timeout);
+esp_err_t audio_element_set_input_ringbuf(audio_element_handle_t el, ringbuf_handle_t rb);
+ringbuf_handle_t audio_element_get_input_ringbuf(audio_element_handle_t el);
+esp_err_t audio_element_set_output_ringbuf(audio_element_handle_t el, ringbuf_handle_t rb);
+ringbuf_handle_t audio_element_get_output_ringbuf(audio_element_handle_t el);
+int audio_element_get_output_ringbuf_size(audio_element_handle_t el);
+
+/**
+ * @brief      Create the task if there is none yet
+ */
+esp_err_t audio_element_run(audio_element_handle_t el);
+
+/**
+ * @brief      Open the element if it is not, and let `process` run
+ */
+esp_err_t audio_element_resume(audio_element_handle_t el);
+
+/**
+ * @brief      Abort the element's rings and have its task close it, does not wait
+ */
+esp_err_t audio_element_stop(audio_element_handle_t el);
+esp_err_t audio_element_wait_for_stop(audio_element_handle_t el);
+
+/**
+ * @brief      Stop the element and end its task
+ */
+esp_err_t audio_element_terminate(audio_element_handle_t el);
+
+esp_err_t audio_element_reset_state(audio_element_handle_t el);
+esp_err_t audio_element_reset_input_ringbuf(audio_element_handle_t el);
+esp_err_t audio_element_reset_output_ringbuf(audio_element_handle_t el);
+esp_err_t audio_element_set_ringbuf_done(audio_element_handle_t el);
+
+/**
+ * @brief      Status changes are sent to `listener`, source_type AUDIO_ELEMENT_TYPE_ELEMENT
+ */
+esp_err_t audio_element_msg_set_listener(audio_element_handle_t el, audio_event_iface_handle_t listener);
+esp_err_t audio_element_msg_remove_listener(audio_element_handle_t el, audio_event_iface_handle_t listener);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,94 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _AUDIO_EVENT_IFACE_H_
+#define _AUDIO_EVENT_IFACE_H_
+
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    int cmd;
+    void *data;
+    int data_len;
+    void *source;
+    int source_type;
+    bool need_free_data;
+} audio_event_iface_msg_t;
+
+typedef esp_err_t (*on_event_iface_func)(audio_event_iface_msg_t *, void *);
+
+typedef struct {
+    int                 internal_queue_size;
+    int                 external_queue_size;
+    int                 queue_set_size;
+    on_event_iface_func on_cmd;
+    void                *context;
+    TickType_t          wait_time;
+    int                 type;
+} audio_event_iface_cfg_t;
+
+typedef struct audio_event_iface *audio_event_iface_handle_t;
+
+#define DEFAULT_AUDIO_EVENT_IFACE_SIZE  (5)
+
+#define AUDIO_EVENT_IFACE_DEFAULT_CFG() {                   \
+    .internal_queue_size = DEFAULT_AUDIO_EVENT_IFACE_SIZE,  \
+    .external_queue_size = DEFAULT_AUDIO_EVENT_IFACE_SIZE,  \
+    .queue_set_size = DEFAULT_AUDIO_EVENT_IFACE_SIZE,       \
+    .on_cmd = NULL,                                         \
+    .context = NULL,                                        \
+    .wait_time = portMAX_DELAY,                             \
+    .type = 0,                                              \
+}
+
+audio_event_iface_handle_t audio_event_iface_init(audio_event_iface_cfg_t *config);
+esp_err_t audio_event_iface_destroy(audio_event_iface_handle_t evt);
+
+/**
+ * @brief      Messages sent out by `evt` go to `listener` as well
+ */
+esp_err_t audio_event_iface_set_listener(audio_event_iface_handle_t evt, audio_event_iface_handle_t listener);
+esp_err_t audio_event_iface_remove_listener(audio_event_iface_handle_t listener, audio_event_iface_handle_t evt);
+
+/**
+ * @brief      Send `msg` to every listener of `evt`, ESP_FAIL if a queue was full
+ */
+esp_err_t audio_event_iface_sendout(audio_event_iface_handle_t evt, audio_event_iface_msg_t *msg);
+
+/**
+ * @brief      Wait for a message sent to `evt` as a listener
+ */
+esp_err_t audio_event_iface_listen(audio_event_iface_handle_t evt, audio_event_iface_msg_t *msg, TickType_t wait_time);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,123 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * esp_websocket_client of IDF 4.0 over plain POSIX sockets, ws:// only.
+ *
+ * The client task connects, then raises the events from its own task as
+ * on the device. Frames are sent masked and split at `buffer_size`, DATA
+ * events come in pieces of at most `buffer_size`. There is no TLS and no
+ * automatic reconnect.
+ */
+
+#ifndef _ESP_WEBSOCKET_CLIENT_H_
+#define _ESP_WEBSOCKET_CLIENT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+#include "esp_event.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct esp_websocket_client *esp_websocket_client_handle_t;
+
+ESP_EVENT_DECLARE_BASE(WEBSOCKET_EVENTS);
+
+typedef enum {
+    WEBSOCKET_EVENT_ANY = -1,
+    WEBSOCKET_EVENT_ERROR = 0,
+    WEBSOCKET_EVENT_CONNECTED,
+    WEBSOCKET_EVENT_DISCONNECTED,
+    WEBSOCKET_EVENT_DATA,
+    WEBSOCKET_EVENT_MAX
+} esp_websocket_event_id_t;
+
+typedef struct {
+    const char *data_ptr;
+    int data_len;
+    uint8_t op_code;
+    esp_websocket_client_handle_t client;
+    void *user_context;
+    int payload_len;
+    int payload_offset;
+} esp_websocket_event_data_t;
+
+typedef enum {
+    WEBSOCKET_TRANSPORT_UNKNOWN = 0x0,
+    WEBSOCKET_TRANSPORT_OVER_TCP,
+    WEBSOCKET_TRANSPORT_OVER_SSL,
+} esp_websocket_transport_t;
+
+typedef struct {
+    const char                  *uri;
+    const char                  *host;
+    int                         port;
+    const char                  *path;
+    bool                        disable_auto_reconnect;
+    void                        *user_context;
+    int                         task_prio;
+    int                         task_stack;
+    int                         buffer_size;
+    const char                  *cert_pem;
+    esp_websocket_transport_t   transport;
+    char                        *subprotocol;
+    char                        *user_agent;
+    char                        *headers;
+} esp_websocket_client_config_t;
+
+esp_websocket_client_handle_t esp_websocket_client_init(const esp_websocket_client_config_t *config);
+esp_err_t esp_websocket_client_set_uri(esp_websocket_client_handle_t client, const char *uri);
+
+/**
+ * @brief      Start the client task, which connects, does not wait for the handshake
+ */
+esp_err_t esp_websocket_client_start(esp_websocket_client_handle_t client);
+
+/**
+ * @brief      Close the connection and end the client task, no event is raised
+ */
+esp_err_t esp_websocket_client_stop(esp_websocket_client_handle_t client);
+esp_err_t esp_websocket_client_destroy(esp_websocket_client_handle_t client);
+
+/**
+ * @brief      Send `len` bytes as binary frames
+ *
+ * @return     Bytes sent, -1 if not connected or on error
+ */
+int esp_websocket_client_send(esp_websocket_client_handle_t client, const char *data, int len, TickType_t timeout);
+int esp_websocket_client_send_bin(esp_websocket_client_handle_t client, const char *data, int len, TickType_t timeout);
+int esp_websocket_client_send_text(esp_websocket_client_handle_t client, const char *data, int len, TickType_t timeout);
+bool esp_websocket_client_is_connected(esp_websocket_client_handle_t client);
+esp_err_t esp_websocket_register_events(esp_websocket_client_handle_t client, esp_websocket_event_id_t event,
+                                        esp_event_handler_t event_handler, void *event_handler_arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,76 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * I2S reader of the host build: the microphone is sr_host_mic.h, played at
+ * the sample rate set by i2s_stream_set_clk. Silence when nothing is played.
+ */
+
+#ifndef _I2S_STREAM_H_
+#define _I2S_STREAM_H_
+
+#include "audio_element.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    audio_stream_type_t type;
+    int                 i2s_port;
+    bool                use_alc;
+    int                 volume;
+    int                 out_rb_size;
+    int                 task_stack;
+    int                 task_core;
+    int                 task_prio;
+    bool                stack_in_ext;
+} i2s_stream_cfg_t;
+
+#define I2S_STREAM_TASK_STACK           (3072)
+#define I2S_STREAM_BUF_SIZE             (2048)
+#define I2S_STREAM_TASK_PRIO            (23)
+#define I2S_STREAM_TASK_CORE            (0)
+#define I2S_STREAM_RINGBUFFER_SIZE      (8 * 1024)
+
+#define I2S_STREAM_CFG_DEFAULT() {                  \
+    .type = AUDIO_STREAM_WRITER,                    \
+    .i2s_port = 0,                                  \
+    .use_alc = false,                               \
+    .volume = 0,                                    \
+    .out_rb_size = I2S_STREAM_RINGBUFFER_SIZE,      \
+    .task_stack = I2S_STREAM_TASK_STACK,            \
+    .task_core = I2S_STREAM_TASK_CORE,              \
+    .task_prio = I2S_STREAM_TASK_PRIO,              \
+    .stack_in_ext = false,                          \
+}
+
+audio_element_handle_t i2s_stream_init(i2s_stream_cfg_t *config);
+esp_err_t i2s_stream_set_clk(audio_element_handle_t i2s_stream, int rate, int bits, int ch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
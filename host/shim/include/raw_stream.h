@@ -0,0 +1,57 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _RAW_STREAM_H_
+#define _RAW_STREAM_H_
+
+#include "audio_element.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    audio_stream_type_t type;
+    int                 out_rb_size;
+} raw_stream_cfg_t;
+
+#define RAW_STREAM_RINGBUFFER_SIZE      (8 * 1024)
+
+#define RAW_STREAM_CFG_DEFAULT() {                  \
+    .type = AUDIO_STREAM_NONE,                      \
+    .out_rb_size = RAW_STREAM_RINGBUFFER_SIZE,      \
+}
+
+/**
+ * @brief      An element without a task, the caller reads its input or writes its output
+ */
+audio_element_handle_t raw_stream_init(raw_stream_cfg_t *config);
+int raw_stream_read(audio_element_handle_t pipeline, char *buffer, int buf_size);
+int raw_stream_write(audio_element_handle_t pipeline, char *buffer, int buf_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
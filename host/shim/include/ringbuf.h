@@ -0,0 +1,71 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _RINGBUF_H_
+#define _RINGBUF_H_
+
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RB_OK           (ESP_OK)
+#define RB_FAIL         (ESP_FAIL)
+#define RB_DONE         (-2)
+#define RB_ABORT        (-3)
+#define RB_TIMEOUT      (-4)
+
+typedef struct ringbuf *ringbuf_handle_t;
+
+ringbuf_handle_t rb_create(int block_size, int n_blocks);
+esp_err_t rb_destroy(ringbuf_handle_t rb);
+esp_err_t rb_abort(ringbuf_handle_t rb);
+esp_err_t rb_reset(ringbuf_handle_t rb);
+int rb_bytes_available(ringbuf_handle_t rb);
+int rb_bytes_filled(ringbuf_handle_t rb);
+int rb_get_size(ringbuf_handle_t rb);
+
+/**
+ * @brief      Read `len` bytes, blocking until they are all there, the writer is done, the ring is aborted or the timeout
+ *
+ * @return     Bytes read, or RB_DONE, RB_ABORT, RB_TIMEOUT if there were none
+ */
+int rb_read(ringbuf_handle_t rb, char *buf, int len, TickType_t ticks_to_wait);
+
+/**
+ * @brief      Write `len` bytes, blocking while the ring is full
+ *
+ * @return     Bytes written, or RB_ABORT, RB_TIMEOUT if there were none
+ */
+int rb_write(ringbuf_handle_t rb, char *buf, int len, TickType_t ticks_to_wait);
+esp_err_t rb_done_write(ringbuf_handle_t rb);
+esp_err_t rb_unblock_reader(ringbuf_handle_t rb);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
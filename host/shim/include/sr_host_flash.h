@@ -0,0 +1,81 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * Flash partitions of the host build.
+ */
+
+#ifndef _SR_HOST_FLASH_H_
+#define _SR_HOST_FLASH_H_
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_partition.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    int reads;
+    int writes;
+    int erases;             /*!< Sectors erased */
+    int64_t write_bytes;
+    int64_t erase_us;       /*!< Time the caller spent blocked in erases, see sr_host_flash_set_timing */
+} sr_host_flash_stats_t;
+
+/**
+ * @brief      Declare a partition, erased when it is created
+ *
+ * @param[in]  label    Partition label
+ * @param[in]  type     Partition type
+ * @param[in]  subtype  Partition subtype
+ * @param[in]  size     Size, a multiple of SPI_FLASH_SEC_SIZE
+ * @param[in]  path     Image file, kept as it is if it has the right size, NULL for memory
+ *
+ * @return     The partition, NULL on error
+ */
+const esp_partition_t *sr_host_flash_add(const char *label, esp_partition_type_t type, int subtype, uint32_t size,
+                                         const char *path);
+
+/**
+ * @brief      Forget all partitions, the image files stay
+ */
+void sr_host_flash_reset(void);
+
+/**
+ * @brief      Have every sector erase block the caller for `erase_ms`, like a real chip (~45 ms per 4 KB sector)
+ */
+void sr_host_flash_set_timing(int erase_ms);
+
+/**
+ * @brief      Counters of a partition since it was added
+ */
+esp_err_t sr_host_flash_stats(const esp_partition_t *partition, sr_host_flash_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,74 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * Microphone of the host build, behind the I2S reader.
+ *
+ * Played audio goes out at the I2S clock (scaled by the speed), after that
+ * the reader delivers silence. The clip must have the channel count set
+ * with i2s_stream_set_clk.
+ */
+
+#ifndef _SR_HOST_MIC_H_
+#define _SR_HOST_MIC_H_
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief      Queue a clip, replacing what is still queued
+ *
+ * @param[in]  samples   Interleaved 16 bit samples, copied
+ * @param[in]  frames    Frames in the clip
+ * @param[in]  channels  1 or 2
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_ERR_NO_MEM
+ */
+esp_err_t sr_host_mic_play(const int16_t *samples, int frames, int channels);
+
+/**
+ * @brief      Block until the queued clip has been read by the I2S reader
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_ERR_TIMEOUT
+ */
+esp_err_t sr_host_mic_wait_played(int timeout_ms);
+
+/**
+ * @brief      Play faster than real time, 100 is real time, 0 as fast as the pipeline takes it
+ */
+void sr_host_mic_set_speed(int percent);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
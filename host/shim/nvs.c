@@ -0,0 +1,212 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * NVS of the host build, in memory: it lasts as long as the process.
+ */
+
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include "esp_log.h"
+#include "nvs.h"
+#include "nvs_flash.h"
+
+#define HOST_NVS_MAX_ENTRIES    (32)
+#define HOST_NVS_MAX_NAMESPACES (8)
+#define HOST_NVS_KEY_MAX        (16)
+
+typedef struct {
+    bool    used;
+    int     ns;
+    char    key[HOST_NVS_KEY_MAX];
+    bool    is_str;
+    int64_t i64;
+    char    *str;
+} host_nvs_entry_t;
+
+static char s_namespaces[HOST_NVS_MAX_NAMESPACES][HOST_NVS_KEY_MAX];
+static int s_namespace_count;
+static host_nvs_entry_t s_entries[HOST_NVS_MAX_ENTRIES];
+static pthread_mutex_t s_nvs_lock = PTHREAD_MUTEX_INITIALIZER;
+
+esp_err_t nvs_flash_init(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void)
+{
+    pthread_mutex_lock(&s_nvs_lock);
+    for (int i = 0; i < HOST_NVS_MAX_ENTRIES; i++) {
+        free(s_entries[i].str);
+    }
+    memset(s_entries, 0, sizeof(s_entries));
+    pthread_mutex_unlock(&s_nvs_lock);
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle)
+{
+    if (strlen(name) >= HOST_NVS_KEY_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t ret = ESP_OK;
+    pthread_mutex_lock(&s_nvs_lock);
+    int ns;
+    for (ns = 0; ns < s_namespace_count && strcmp(s_namespaces[ns], name); ns++);
+    if (ns == s_namespace_count) {
+        if (open_mode == NVS_READONLY) {
+            ret = ESP_ERR_NVS_NOT_FOUND;
+        } else if (s_namespace_count == HOST_NVS_MAX_NAMESPACES) {
+            ret = ESP_ERR_NVS_NO_FREE_PAGES;
+        } else {
+            strcpy(s_namespaces[s_namespace_count++], name);
+        }
+    }
+    pthread_mutex_unlock(&s_nvs_lock);
+    *out_handle = ns + 1;
+    return ret;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    return ESP_OK;
+}
+
+static host_nvs_entry_t *_nvs_find(nvs_handle_t handle, const char *key, bool create)
+{
+    host_nvs_entry_t *free_entry = NULL;
+    for (int i = 0; i < HOST_NVS_MAX_ENTRIES; i++) {
+        host_nvs_entry_t *e = &s_entries[i];
+        if (e->used && e->ns == handle && strcmp(e->key, key) == 0) {
+            return e;
+        }
+        if (!e->used && free_entry == NULL) {
+            free_entry = e;
+        }
+    }
+    if (!create || free_entry == NULL || strlen(key) >= HOST_NVS_KEY_MAX) {
+        return NULL;
+    }
+    free_entry->used = true;
+    free_entry->ns = handle;
+    strcpy(free_entry->key, key);
+    return free_entry;
+}
+
+esp_err_t nvs_set_i64(nvs_handle_t handle, const char *key, int64_t value)
+{
+    pthread_mutex_lock(&s_nvs_lock);
+    host_nvs_entry_t *e = _nvs_find(handle, key, true);
+    if (e) {
+        free(e->str);
+        e->str = NULL;
+        e->is_str = false;
+        e->i64 = value;
+    }
+    pthread_mutex_unlock(&s_nvs_lock);
+    return e ? ESP_OK : ESP_ERR_NVS_NO_FREE_PAGES;
+}
+
+esp_err_t nvs_get_i64(nvs_handle_t handle, const char *key, int64_t *out_value)
+{
+    pthread_mutex_lock(&s_nvs_lock);
+    host_nvs_entry_t *e = _nvs_find(handle, key, false);
+    esp_err_t ret = e && !e->is_str ? ESP_OK : ESP_ERR_NVS_NOT_FOUND;
+    if (ret == ESP_OK) {
+        *out_value = e->i64;
+    }
+    pthread_mutex_unlock(&s_nvs_lock);
+    return ret;
+}
+
+esp_err_t nvs_set_str(nvs_handle_t handle, const char *key, const char *value)
+{
+    char *copy = strdup(value);
+    if (copy == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    pthread_mutex_lock(&s_nvs_lock);
+    host_nvs_entry_t *e = _nvs_find(handle, key, true);
+    if (e) {
+        free(e->str);
+        e->str = copy;
+        e->is_str = true;
+    } else {
+        free(copy);
+    }
+    pthread_mutex_unlock(&s_nvs_lock);
+    return e ? ESP_OK : ESP_ERR_NVS_NO_FREE_PAGES;
+}
+
+esp_err_t nvs_get_str(nvs_handle_t handle, const char *key, char *out_value, size_t *length)
+{
+    pthread_mutex_lock(&s_nvs_lock);
+    host_nvs_entry_t *e = _nvs_find(handle, key, false);
+    esp_err_t ret = ESP_ERR_NVS_NOT_FOUND;
+    if (e && e->is_str) {
+        size_t len = strlen(e->str) + 1;
+        if (out_value == NULL) {
+            ret = ESP_OK;
+        } else if (*length < len) {
+            ret = ESP_ERR_NVS_INVALID_LENGTH;
+        } else {
+            memcpy(out_value, e->str, len);
+            ret = ESP_OK;
+        }
+        *length = len;
+    }
+    pthread_mutex_unlock(&s_nvs_lock);
+    return ret;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key)
+{
+    pthread_mutex_lock(&s_nvs_lock);
+    host_nvs_entry_t *e = _nvs_find(handle, key, false);
+    if (e) {
+        free(e->str);
+        memset(e, 0, sizeof(*e));
+    }
+    pthread_mutex_unlock(&s_nvs_lock);
+    return e ? ESP_OK : ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_erase_all(nvs_handle_t handle)
+{
+    pthread_mutex_lock(&s_nvs_lock);
+    for (int i = 0; i < HOST_NVS_MAX_ENTRIES; i++) {
+        if (s_entries[i].used && s_entries[i].ns == handle) {
+            free(s_entries[i].str);
+            memset(&s_entries[i], 0, sizeof(s_entries[i]));
+        }
+    }
+    pthread_mutex_unlock(&s_nvs_lock);
+    return ESP_OK;
+}
@@ -0,0 +1,236 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <pthread.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "audio_error.h"
+#include "ringbuf.h"
+
+static const char *TAG = "RINGBUF";
+
+struct ringbuf {
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;               /* Broadcast on every change, readers and writers recheck */
+    char            *buf;
+    int             size;
+    int             head;               /* Next byte read */
+    int             fill;
+    bool            done_write;
+    bool            abort_read;
+    bool            abort_write;
+    bool            unblock_reader;
+};
+
+ringbuf_handle_t rb_create(int block_size, int n_blocks)
+{
+    if (block_size <= 0 || n_blocks <= 0) {
+        ESP_LOGE(TAG, "Invalid size %d x %d", block_size, n_blocks);
+        return NULL;
+    }
+    struct ringbuf *rb = calloc(1, sizeof(struct ringbuf));
+    AUDIO_MEM_CHECK(TAG, rb, return NULL);
+    rb->size = block_size * n_blocks;
+    rb->buf = malloc(rb->size);
+    AUDIO_MEM_CHECK(TAG, rb->buf, {
+        free(rb);
+        return NULL;
+    });
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&rb->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&rb->lock, NULL);
+    return rb;
+}
+
+esp_err_t rb_destroy(ringbuf_handle_t rb)
+{
+    if (rb == NULL) {
+        return ESP_FAIL;
+    }
+    pthread_mutex_destroy(&rb->lock);
+    pthread_cond_destroy(&rb->cond);
+    free(rb->buf);
+    free(rb);
+    return ESP_OK;
+}
+
+esp_err_t rb_abort(ringbuf_handle_t rb)
+{
+    pthread_mutex_lock(&rb->lock);
+    rb->abort_read = true;
+    rb->abort_write = true;
+    pthread_cond_broadcast(&rb->cond);
+    pthread_mutex_unlock(&rb->lock);
+    return ESP_OK;
+}
+
+esp_err_t rb_reset(ringbuf_handle_t rb)
+{
+    pthread_mutex_lock(&rb->lock);
+    rb->head = 0;
+    rb->fill = 0;
+    rb->done_write = false;
+    rb->abort_read = false;
+    rb->abort_write = false;
+    rb->unblock_reader = false;
+    pthread_cond_broadcast(&rb->cond);
+    pthread_mutex_unlock(&rb->lock);
+    return ESP_OK;
+}
+
+esp_err_t rb_done_write(ringbuf_handle_t rb)
+{
+    pthread_mutex_lock(&rb->lock);
+    rb->done_write = true;
+    pthread_cond_broadcast(&rb->cond);
+    pthread_mutex_unlock(&rb->lock);
+    return ESP_OK;
+}
+
+esp_err_t rb_unblock_reader(ringbuf_handle_t rb)
+{
+    pthread_mutex_lock(&rb->lock);
+    rb->unblock_reader = true;
+    pthread_cond_broadcast(&rb->cond);
+    pthread_mutex_unlock(&rb->lock);
+    return ESP_OK;
+}
+
+int rb_bytes_available(ringbuf_handle_t rb)
+{
+    pthread_mutex_lock(&rb->lock);
+    int available = rb->size - rb->fill;
+    pthread_mutex_unlock(&rb->lock);
+    return available;
+}
+
+int rb_bytes_filled(ringbuf_handle_t rb)
+{
+    pthread_mutex_lock(&rb->lock);
+    int fill = rb->fill;
+    pthread_mutex_unlock(&rb->lock);
+    return fill;
+}
+
+int rb_get_size(ringbuf_handle_t rb)
+{
+    return rb->size;
+}
+
+/* One wait of up to `ticks`, as the device waits on its semaphores: false on timeout */
+static bool _rb_wait(ringbuf_handle_t rb, TickType_t ticks)
+{
+    if (ticks == portMAX_DELAY) {
+        pthread_cond_wait(&rb->cond, &rb->lock);
+        return true;
+    }
+    if (ticks == 0) {
+        return false;
+    }
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t ns = (uint64_t)ticks * portTICK_PERIOD_MS * 1000000ULL + ts.tv_nsec;
+    ts.tv_sec += ns / 1000000000ULL;
+    ts.tv_nsec = ns % 1000000000ULL;
+    return pthread_cond_timedwait(&rb->cond, &rb->lock, &ts) != ETIMEDOUT;
+}
+
+int rb_read(ringbuf_handle_t rb, char *buf, int len, TickType_t ticks_to_wait)
+{
+    int total = 0;
+    int ret = RB_OK;
+    pthread_mutex_lock(&rb->lock);
+    while (len > 0) {
+        if (rb->fill == 0) {
+            if (rb->done_write) {
+                ret = RB_DONE;
+                break;
+            }
+            if (rb->abort_read) {
+                ret = RB_ABORT;
+                break;
+            }
+            if (rb->unblock_reader) {
+                break;
+            }
+            if (!_rb_wait(rb, ticks_to_wait)) {
+                ret = RB_TIMEOUT;
+                break;
+            }
+            continue;
+        }
+        int n = rb->fill < len ? rb->fill : len;
+        int first = rb->size - rb->head < n ? rb->size - rb->head : n;
+        memcpy(buf, rb->buf + rb->head, first);
+        memcpy(buf + first, rb->buf, n - first);
+        rb->head = (rb->head + n) % rb->size;
+        rb->fill -= n;
+        buf += n;
+        len -= n;
+        total += n;
+        pthread_cond_broadcast(&rb->cond);
+    }
+    rb->unblock_reader = false;
+    pthread_mutex_unlock(&rb->lock);
+    return total > 0 ? total : ret;
+}
+
+int rb_write(ringbuf_handle_t rb, char *buf, int len, TickType_t ticks_to_wait)
+{
+    int total = 0;
+    int ret = RB_OK;
+    pthread_mutex_lock(&rb->lock);
+    while (len > 0) {
+        if (rb->abort_write) {
+            ret = RB_ABORT;
+            break;
+        }
+        int room = rb->size - rb->fill;
+        if (room == 0) {
+            if (!_rb_wait(rb, ticks_to_wait)) {
+                ret = RB_TIMEOUT;
+                break;
+            }
+            continue;
+        }
+        int n = room < len ? room : len;
+        int tail = (rb->head + rb->fill) % rb->size;
+        int first = rb->size - tail < n ? rb->size - tail : n;
+        memcpy(rb->buf + tail, buf, first);
+        memcpy(rb->buf, buf + first, n - first);
+        rb->fill += n;
+        buf += n;
+        len -= n;
+        total += n;
+        pthread_cond_broadcast(&rb->cond);
+    }
+    pthread_mutex_unlock(&rb->lock);
+    return total > 0 ? total : ret;
+}
@@ -0,0 +1,57 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <pthread.h>
+#include "sr_host_clock.h"
+
+static pthread_mutex_t s_clock_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct timeval s_last_set;
+static bool s_was_set;
+
+int __wrap_settimeofday(const struct timeval *tv, const void *tz)
+{
+    pthread_mutex_lock(&s_clock_lock);
+    s_last_set = *tv;
+    s_was_set = true;
+    pthread_mutex_unlock(&s_clock_lock);
+    return 0;
+}
+
+bool sr_host_clock_last_set(struct timeval *tv)
+{
+    pthread_mutex_lock(&s_clock_lock);
+    bool was_set = s_was_set;
+    if (was_set && tv) {
+        *tv = s_last_set;
+    }
+    pthread_mutex_unlock(&s_clock_lock);
+    return was_set;
+}
+
+void sr_host_clock_reset(void)
+{
+    pthread_mutex_lock(&s_clock_lock);
+    s_was_set = false;
+    pthread_mutex_unlock(&s_clock_lock);
+}
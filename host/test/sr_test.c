@@ -0,0 +1,122 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <math.h>
+#include "sr_test.h"
+
+int sr_test_failures;
+
+bool sr_test_clip_speech(sr_test_clip_t *clip, int ms, int sample_rate, int channels)
+{
+    clip->frames = (int64_t)ms * sample_rate / 1000;
+    clip->channels = channels;
+    clip->sample_rate = sample_rate;
+    clip->samples = malloc((size_t)clip->frames * channels * sizeof(int16_t));
+    if (clip->samples == NULL) {
+        return false;
+    }
+    uint32_t seed = 1;
+    for (int i = 0; i < clip->frames; i++) {
+        float t = (float)i / sample_rate;
+        seed = seed * 1664525 + 1013904223;
+        float noise = (float)(int16_t)(seed >> 16) / 32768;
+        float value = fabsf(sinf(M_PI * 4 * t)) * (0.2f * sinf(2 * M_PI * 150 * t) + 0.1f * noise);
+        for (int ch = 0; ch < channels; ch++) {
+            clip->samples[i * channels + ch] = (int16_t)(value * 32767);
+        }
+    }
+    return true;
+}
+
+static uint32_t _le32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t _le16(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+bool sr_test_clip_load_wav(sr_test_clip_t *clip, const char *path)
+{
+    memset(clip, 0, sizeof(sr_test_clip_t));
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        fprintf(stderr, "%s: cannot open\n", path);
+        return false;
+    }
+    uint8_t riff[12];
+    bool ok = fread(riff, 1, sizeof(riff), f) == sizeof(riff)
+              && memcmp(riff, "RIFF", 4) == 0 && memcmp(riff + 8, "WAVE", 4) == 0;
+    int bits = 0;
+    while (ok) {
+        uint8_t chunk[8];
+        if (fread(chunk, 1, sizeof(chunk), f) != sizeof(chunk)) {
+            ok = false;
+            break;
+        }
+        uint32_t size = _le32(chunk + 4);
+        if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+            uint8_t fmt[16];
+            ok = fread(fmt, 1, sizeof(fmt), f) == sizeof(fmt) && fseek(f, size - 16 + (size & 1), SEEK_CUR) == 0;
+            ok = ok && _le16(fmt) == 1;
+            clip->channels = _le16(fmt + 2);
+            clip->sample_rate = _le32(fmt + 4);
+            bits = _le16(fmt + 14);
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            ok = bits == 16 && clip->channels > 0;
+            if (ok) {
+                clip->frames = size / (2 * clip->channels);
+                clip->samples = malloc((size_t)clip->frames * clip->channels * sizeof(int16_t));
+                ok = clip->samples
+                     && fread(clip->samples, 2 * clip->channels, clip->frames, f) == (size_t)clip->frames;
+            }
+            break;
+        } else {
+            ok = fseek(f, size + (size & 1), SEEK_CUR) == 0;
+        }
+    }
+    fclose(f);
+    if (!ok) {
+        fprintf(stderr, "%s: not a 16-bit PCM WAV file\n", path);
+        sr_test_clip_free(clip);
+    }
+    return ok;
+}
+
+void sr_test_clip_free(sr_test_clip_t *clip)
+{
+    free(clip->samples);
+    memset(clip, 0, sizeof(sr_test_clip_t));
+}
+
+int sr_test_result(void)
+{
+    if (sr_test_failures) {
+        fprintf(stderr, "%d assertions failed\n", sr_test_failures);
+    }
+    return sr_test_failures ? 1 : 0;
+}
@@ -0,0 +1,120 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _SR_TEST_H_
+#define _SR_TEST_H_
+
+/*
+ * Assertions and clips for the host tests and benchmarks.
+ *
+ * A failed assertion is printed and counted, the test goes on. The test
+ * program returns sr_test_result() from main, so ctest sees the failures.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int sr_test_failures;
+
+#define TEST_ASSERT(cond) do {                                                          \
+    if (!(cond)) {                                                                      \
+        fprintf(stderr, "%s:%d: FAIL: %s\n", __FILE__, __LINE__, #cond);                \
+        sr_test_failures++;                                                             \
+    }                                                                                   \
+} while (0)
+
+#define TEST_ASSERT_EQUAL_INT(expected, actual) do {                                    \
+    long long _e = (expected), _a = (actual);                                           \
+    if (_e != _a) {                                                                     \
+        fprintf(stderr, "%s:%d: FAIL: %s is %lld, expected %lld\n", __FILE__, __LINE__, \
+                #actual, _a, _e);                                                       \
+        sr_test_failures++;                                                             \
+    }                                                                                   \
+} while (0)
+
+#define TEST_ASSERT_EQUAL_STRING(expected, actual) do {                                 \
+    const char *_e = (expected), *_a = (actual);                                        \
+    if (_a == NULL || strcmp(_e, _a) != 0) {                                            \
+        fprintf(stderr, "%s:%d: FAIL: %s is \"%s\", expected \"%s\"\n", __FILE__,       \
+                __LINE__, #actual, _a ? _a : "(null)", _e);                             \
+        sr_test_failures++;                                                             \
+    }                                                                                   \
+} while (0)
+
+#define RUN_TEST(fn) do {                                                               \
+    int _before = sr_test_failures;                                                     \
+    fn();                                                                               \
+    printf("%s: %s\n", #fn, sr_test_failures == _before ? "PASS" : "FAIL");            \
+} while (0)
+
+/**
+ * A 16-bit clip
+ */
+typedef struct {
+    int16_t *samples;                   /*!< `frames` * `channels` interleaved */
+    int     frames;
+    int     channels;
+    int     sample_rate;
+} sr_test_clip_t;
+
+/**
+ * @brief      Synthetic speech as in sr_bench: noise on a 150 Hz buzz, 4 syllables a second
+ *
+ * @param[out] clip         The clip, free with sr_test_clip_free
+ * @param[in]  ms           Length
+ * @param[in]  sample_rate  Sample rate
+ * @param[in]  channels     1, or 2 for the same signal on both
+ *
+ * @return     true on success
+ */
+bool sr_test_clip_speech(sr_test_clip_t *clip, int ms, int sample_rate, int channels);
+
+/**
+ * @brief      Load a 16-bit PCM WAV file
+ *
+ * @param[out] clip   The clip, free with sr_test_clip_free
+ * @param[in]  path   The file
+ *
+ * @return     true on success
+ */
+bool sr_test_clip_load_wav(sr_test_clip_t *clip, const char *path);
+
+void sr_test_clip_free(sr_test_clip_t *clip);
+
+/**
+ * @brief      Exit status for main: 0 if no assertion failed
+ */
+int sr_test_result(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
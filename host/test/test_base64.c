@@ -0,0 +1,106 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <openssl/evp.h>
+#include "sr_base64.h"
+#include "sr_test.h"
+
+#define B64_MAX_LEN     (3000)
+
+/* `in` fed in pieces of the lengths `seed` picks, 0 included */
+static int _encode_split(const uint8_t *in, int len, char *out, uint32_t seed)
+{
+    sr_base64_t b64;
+    sr_base64_reset(&b64);
+    int pos = 0;
+    int out_len = 0;
+    while (pos < len) {
+        seed = seed * 1664525 + 1013904223;
+        int n = (seed >> 16) % 8 == 0 ? 0 : (int)((seed >> 8) % 700);
+        if (n > len - pos) {
+            n = len - pos;
+        }
+        int expected = sr_base64_encode_len(&b64, n);
+        int written = sr_base64_encode_update(&b64, out + out_len, in + pos, n);
+        TEST_ASSERT_EQUAL_INT(expected, written);
+        TEST_ASSERT(written <= SR_BASE64_ENCODE_MAX(n));
+        out_len += written;
+        pos += n;
+    }
+    out_len += sr_base64_encode_finish(&b64, out + out_len);
+    TEST_ASSERT_EQUAL_INT(0, b64.carry_len);
+    return out_len;
+}
+
+static void test_against_openssl(void)
+{
+    static uint8_t in[B64_MAX_LEN];
+    static char out[SR_BASE64_ENCODE_MAX(B64_MAX_LEN) + 8];
+    static char ref[SR_BASE64_ENCODE_MAX(B64_MAX_LEN) + 8];
+    uint32_t seed = 7;
+    for (int i = 0; i < B64_MAX_LEN; i++) {
+        seed = seed * 1664525 + 1013904223;
+        in[i] = seed >> 24;
+    }
+    for (int len = 0; len < B64_MAX_LEN; len += len < 16 ? 1 : 97) {
+        int ref_len = EVP_EncodeBlock((unsigned char *)ref, in, len);
+        for (uint32_t split = 1; split <= 4; split++) {
+            int out_len = _encode_split(in, len, out, split * len);
+            TEST_ASSERT_EQUAL_INT(ref_len, out_len);
+            if (out_len != ref_len || memcmp(out, ref, ref_len) != 0) {
+                fprintf(stderr, "  %d bytes differ, split %u\n", len, split);
+                sr_test_failures++;
+                return;
+            }
+        }
+    }
+}
+
+static void test_padding(void)
+{
+    char out[16];
+    sr_base64_t b64;
+    const struct {
+        const char *in;
+        const char *out;
+    } vectors[] = {
+        { "", "" }, { "f", "Zg==" }, { "fo", "Zm8=" }, { "foo", "Zm9v" },
+        { "foob", "Zm9vYg==" }, { "fooba", "Zm9vYmE=" }, { "foobar", "Zm9vYmFy" },
+    };
+    for (int i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+        sr_base64_reset(&b64);
+        int len = sr_base64_encode_update(&b64, out, (const uint8_t *)vectors[i].in, strlen(vectors[i].in));
+        len += sr_base64_encode_finish(&b64, out + len);
+        out[len] = 0;
+        TEST_ASSERT_EQUAL_STRING(vectors[i].out, out);
+    }
+}
+
+int main(void)
+{
+    RUN_TEST(test_padding);
+    RUN_TEST(test_against_openssl);
+    return sr_test_result();
+}
@@ -0,0 +1,153 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <time.h>
+#include "esp_http_client.h"
+#include "sr_clock.h"
+#include "sr_provider.h"
+#include "sr_provider_baidu.h"
+#include "baidu_sr_token.h"
+#include "sr_host_clock.h"
+#include "sr_mock_server.h"
+#include "sr_test.h"
+
+#define TEST_DATE       "Wed, 10 Jul 2019 07:35:43 GMT"
+#define TEST_DATE_SEC   (1562744143)
+
+static sr_mock_server_t *s_baidu;
+
+/* The mock's Date is time(NULL) when it replied */
+static bool _clock_set_from_mock(time_t before)
+{
+    struct timeval tv;
+    return sr_host_clock_last_set(&tv) && tv.tv_sec >= before && tv.tv_sec <= time(NULL);
+}
+
+static void test_before_init(void)
+{
+    esp_http_client_event_t evt = {
+        .event_id = HTTP_EVENT_ON_HEADER,
+        .header_key = "Date",
+        .header_value = TEST_DATE,
+    };
+    sr_host_clock_reset();
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_STATE, sr_clock_set_from_http_date(TEST_DATE));
+    TEST_ASSERT_EQUAL_INT(ESP_OK, sr_clock_http_event_handler(&evt));
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_INVALID_STATE, sr_clock_probe(sr_mock_server_url(s_baidu)));
+    TEST_ASSERT(!sr_host_clock_last_set(NULL));
+}
+
+static void test_http_date(void)
+{
+    struct timeval tv;
+    sr_host_clock_reset();
+    TEST_ASSERT_EQUAL_INT(ESP_OK, sr_clock_set_from_http_date(TEST_DATE));
+    TEST_ASSERT(sr_host_clock_last_set(&tv));
+    TEST_ASSERT_EQUAL_INT(TEST_DATE_SEC, tv.tv_sec);
+    TEST_ASSERT_EQUAL_INT(ESP_FAIL, sr_clock_set_from_http_date("Wed, 10 Foo 2019 07:35:43 GMT"));
+    TEST_ASSERT_EQUAL_INT(ESP_FAIL, sr_clock_set_from_http_date("Thu, 01 Jan 1970 00:00:00 GMT"));
+}
+
+static void test_probe(void)
+{
+    time_t before = time(NULL);
+    sr_host_clock_reset();
+    TEST_ASSERT_EQUAL_INT(ESP_OK, sr_clock_probe(sr_mock_server_url(s_baidu)));
+    TEST_ASSERT(_clock_set_from_mock(before));
+}
+
+static void test_baidu_session(void)
+{
+    static char text[64];
+    sr_result_t result = { .text = text, .size = sizeof(text) };
+    sr_latency_t latency = { 0 };
+    sr_provider_env_t env = {
+        .sample_rate = 16000,
+        .format = SR_AUDIO_PCM,
+        .frame_max = 1024,
+        .result = &result,
+        .latency = &latency,
+    };
+    sr_provider_baidu_config_t config = {
+        .token = "token",
+        .cuid = "test",
+        .endpoint = sr_mock_server_url(s_baidu),
+    };
+    static char audio[1024];
+    time_t before = time(NULL);
+    sr_host_clock_reset();
+    void *ctx = sr_provider_baidu.create(&config, &env);
+    TEST_ASSERT(ctx != NULL);
+    if (ctx == NULL) {
+        return;
+    }
+    TEST_ASSERT_EQUAL_INT(ESP_OK, sr_provider_baidu.begin(ctx));
+    TEST_ASSERT_EQUAL_INT(sizeof(audio), sr_provider_baidu.frame(ctx, audio, sizeof(audio)));
+    TEST_ASSERT_EQUAL_INT(ESP_OK, sr_provider_baidu.end(ctx));
+    TEST_ASSERT_EQUAL_STRING("test", text);
+    TEST_ASSERT(_clock_set_from_mock(before));
+    sr_provider_baidu.destroy(ctx);
+}
+
+static void test_token(void)
+{
+    char endpoint[64];
+    snprintf(endpoint, sizeof(endpoint), "http://127.0.0.1:%d/oauth/2.0/token", sr_mock_server_port(s_baidu));
+    baidu_sr_token_config_t config = {
+        .access_key = "key",
+        .secret_key = "secret",
+        .endpoint = endpoint,
+    };
+    time_t before = time(NULL);
+    sr_host_clock_reset();
+    baidu_sr_token_handle_t token = baidu_sr_token_init(&config);
+    TEST_ASSERT(token != NULL);
+    if (token == NULL) {
+        return;
+    }
+    char *value = baidu_sr_token_get(token);
+    TEST_ASSERT(strncmp(value, "24.", 3) == 0);
+    TEST_ASSERT(_clock_set_from_mock(before));
+    free(value);
+    baidu_sr_token_destroy(token);
+}
+
+int main(void)
+{
+    sr_mock_config_t mock_cfg = { .text = "test" };
+    s_baidu = sr_mock_baidu_start(&mock_cfg);
+    TEST_ASSERT(s_baidu != NULL);
+    if (s_baidu == NULL) {
+        return sr_test_result();
+    }
+    RUN_TEST(test_before_init);
+    sr_clock_init(NULL);
+    RUN_TEST(test_http_date);
+    RUN_TEST(test_probe);
+    RUN_TEST(test_baidu_session);
+    RUN_TEST(test_token);
+    sr_mock_server_stop(s_baidu);
+    return sr_test_result();
+}
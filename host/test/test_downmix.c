@@ -0,0 +1,190 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * The two microphone downmix: average, fixed and adaptive delay and sum,
+ * then a stereo recording through the SR core uploaded as mono.
+ */
+
+#include <stdlib.h>
+#include "esp_log.h"
+#include "sr_downmix.h"
+#include "sr_core.h"
+#include "sr_provider_baidu.h"
+#include "sr_host_mic.h"
+#include "sr_mock_server.h"
+#include "sr_test.h"
+
+#define TEST_SAMPLE_RATE    (16000)
+#define TEST_BLOCK          (256)
+#define TEST_FRAMES         (TEST_SAMPLE_RATE * 2)
+#define TEST_TEXT           "stereo"
+
+static sr_test_clip_t s_speech;
+
+/* The speech reaching the right microphone `delay` samples after the left, negative if before */
+static int16_t *_stereo(int delay)
+{
+    int16_t *in = calloc(TEST_FRAMES * 2, sizeof(int16_t));
+    for (int n = 0; n < TEST_FRAMES; n++) {
+        int l = n - (delay < 0 ? -delay : 0);
+        int r = n - (delay > 0 ? delay : 0);
+        in[2 * n] = l >= 0 ? s_speech.samples[l] : 0;
+        in[2 * n + 1] = r >= 0 ? s_speech.samples[r] : 0;
+    }
+    return in;
+}
+
+/* All of `in` through `dm` in blocks, the output count */
+static int _run(sr_downmix_t *dm, const int16_t *in, int frames, int block, int16_t *out)
+{
+    int count = 0;
+    for (int offset = 0; offset < frames; offset += block) {
+        int len = frames - offset < block ? frames - offset : block;
+        count += sr_downmix_process(dm, in + 2 * offset, len, out + count);
+    }
+    return count;
+}
+
+static void test_average(void)
+{
+    sr_downmix_cfg_t cfg = { .mode = SR_DOWNMIX_AVERAGE };
+    sr_downmix_t dm;
+    TEST_ASSERT_EQUAL_INT(0, sr_downmix_init(&dm, &cfg, TEST_SAMPLE_RATE, TEST_BLOCK));
+    TEST_ASSERT_EQUAL_INT(TEST_BLOCK * 2 * (int)sizeof(int16_t), sr_downmix_memory(&cfg, TEST_SAMPLE_RATE, TEST_BLOCK));
+    int16_t in[] = { 100, 300, -32768, -32768, 32767, 32767, 1, -2 };
+    int16_t out[4];
+    TEST_ASSERT_EQUAL_INT(4, sr_downmix_process(&dm, in, 4, out));
+    TEST_ASSERT_EQUAL_INT(200, out[0]);
+    TEST_ASSERT_EQUAL_INT(-32768, out[1]);
+    TEST_ASSERT_EQUAL_INT(32767, out[2]);
+    TEST_ASSERT_EQUAL_INT(0, out[3]);
+    sr_downmix_deinit(&dm);
+}
+
+/* A fixed delay lines both channels up: the output is the later microphone's speech */
+static void test_delay_sum(void)
+{
+    static const int delays_us[] = { 125, -125, 0 };
+    for (int i = 0; i < sizeof(delays_us) / sizeof(delays_us[0]); i++) {
+        int delay = delays_us[i] * TEST_SAMPLE_RATE / 1000000;
+        sr_downmix_cfg_t cfg = { .mode = SR_DOWNMIX_DELAY_SUM, .delay_us = delays_us[i] };
+        sr_downmix_t dm;
+        TEST_ASSERT_EQUAL_INT(0, sr_downmix_init(&dm, &cfg, TEST_SAMPLE_RATE, TEST_BLOCK));
+        TEST_ASSERT_EQUAL_INT(delay, dm.delay);
+        int16_t *in = _stereo(delay);
+        int16_t *out = calloc(TEST_FRAMES, sizeof(int16_t));
+        TEST_ASSERT_EQUAL_INT(TEST_FRAMES, _run(&dm, in, TEST_FRAMES, TEST_BLOCK, out));
+        int lag = abs(delay);
+        int mismatches = 0;
+        for (int n = lag; n < TEST_FRAMES; n++) {
+            mismatches += out[n] != s_speech.samples[n - lag];
+        }
+        TEST_ASSERT_EQUAL_INT(0, mismatches);
+        free(in);
+        free(out);
+        sr_downmix_deinit(&dm);
+    }
+}
+
+/* The adaptive delay finds the talker on either side and settles there, silence leaves it alone */
+static void test_adaptive(void)
+{
+    static const int delays[] = { 2, -2 };
+    for (int i = 0; i < sizeof(delays) / sizeof(delays[0]); i++) {
+        sr_downmix_cfg_t cfg = { .mode = SR_DOWNMIX_ADAPTIVE };
+        sr_downmix_t dm;
+        TEST_ASSERT_EQUAL_INT(0, sr_downmix_init(&dm, &cfg, TEST_SAMPLE_RATE, TEST_BLOCK));
+        TEST_ASSERT_EQUAL_INT(0, dm.delay);
+        TEST_ASSERT(dm.max_delay >= 2);
+        int16_t *in = _stereo(delays[i]);
+        int16_t *out = calloc(TEST_FRAMES, sizeof(int16_t));
+        _run(&dm, in, TEST_FRAMES, TEST_BLOCK, out);
+        TEST_ASSERT_EQUAL_INT(delays[i], dm.delay);
+
+        int16_t silence[TEST_BLOCK * 2] = { 0 };
+        for (int b = 0; b < 20; b++) {
+            sr_downmix_process(&dm, silence, TEST_BLOCK, out);
+        }
+        TEST_ASSERT_EQUAL_INT(delays[i], dm.delay);
+        free(in);
+        free(out);
+        sr_downmix_deinit(&dm);
+    }
+}
+
+/* Both microphones recorded, one channel uploaded */
+static void test_stereo_upload(void)
+{
+    sr_mock_config_t mock_cfg = { .text = TEST_TEXT };
+    sr_mock_server_t *server = sr_mock_baidu_start(&mock_cfg);
+    TEST_ASSERT(server != NULL);
+    if (server == NULL) {
+        return;
+    }
+    sr_provider_baidu_config_t baidu_cfg = {
+        .token = "24.0123456789abcdef0123456789abcdef.2592000.1600000000.282335-12345678",
+        .cuid = "host",
+        .upload_mode = BAIDU_SR_UPLOAD_RAW,
+        .endpoint = sr_mock_server_url(server),
+    };
+    sr_downmix_cfg_t downmix = { .mode = SR_DOWNMIX_ADAPTIVE };
+    sr_core_config_t sr_cfg = {
+        .provider = &sr_provider_baidu,
+        .provider_config = &baidu_cfg,
+        .record_sample_rates = TEST_SAMPLE_RATE,
+        .downmix = &downmix,
+        .encoding = SR_AUDIO_PCM,
+    };
+    sr_core_handle_t sr = sr_core_init(&sr_cfg);
+    TEST_ASSERT(sr != NULL);
+    int16_t *stereo = _stereo(2);
+    if (sr) {
+        TEST_ASSERT_EQUAL_INT(ESP_OK, sr_core_start(sr));
+        /* The first second of the clip, both channels */
+        sr_host_mic_play(stereo, TEST_SAMPLE_RATE, 2);
+        TEST_ASSERT_EQUAL_INT(ESP_OK, sr_host_mic_wait_played(10000));
+        TEST_ASSERT_EQUAL_STRING(TEST_TEXT, sr_core_stop(sr));
+        sr_mock_stats_t stats;
+        sr_mock_server_stats(server, &stats, false);
+        TEST_ASSERT_EQUAL_INT(TEST_SAMPLE_RATE, stats.rate);
+        /* A second of 16 kHz mono is 32000 bytes, the cold stop drops what the uplink had not taken yet */
+        TEST_ASSERT(stats.body_bytes > 28000 && stats.body_bytes <= 33000);
+        sr_core_destroy(sr);
+    }
+    free(stereo);
+    sr_mock_server_stop(server);
+}
+
+int main(void)
+{
+    esp_log_level_set("*", getenv("SR_LOG") ? atoi(getenv("SR_LOG")) : ESP_LOG_WARN);
+    sr_test_clip_speech(&s_speech, TEST_FRAMES * 1000 / TEST_SAMPLE_RATE, TEST_SAMPLE_RATE, 1);
+    RUN_TEST(test_average);
+    RUN_TEST(test_delay_sum);
+    RUN_TEST(test_adaptive);
+    RUN_TEST(test_stereo_upload);
+    sr_test_clip_free(&s_speech);
+    return sr_test_result();
+}
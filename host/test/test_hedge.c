@@ -0,0 +1,216 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * A hedge of two mock recognizers: the first result wins, two empty answers
+ * are an empty result rather than a failure, a leg stuck in a write does not
+ * hold up the other, and both sender tasks run where the placement puts
+ * them and show up in the task report.
+ */
+
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sr_core.h"
+#include "sr_json.h"
+#include "sr_provider_hedge.h"
+#include "sr_provider_mock.h"
+#include "sr_host_mic.h"
+#include "sr_test.h"
+
+#define TEST_SAMPLE_RATE    (16000)
+#define TEST_STALL_MS       (3000)
+
+/* A recognizer whose first write blocks like a stalled TCP send, whatever `cancel` says */
+static void *_stall_create(const void *config, const sr_provider_env_t *env)
+{
+    static int ctx;
+    return &ctx;
+}
+
+static void _stall_destroy(void *ctx)
+{
+}
+
+static int _stall_memory(void *ctx)
+{
+    return 0;
+}
+
+static esp_err_t _stall_begin(void *ctx)
+{
+    return ESP_OK;
+}
+
+static int _stall_frame(void *ctx, const char *audio, int len)
+{
+    vTaskDelay(TEST_STALL_MS / portTICK_PERIOD_MS);
+    return ESP_FAIL;
+}
+
+static esp_err_t _stall_end(void *ctx)
+{
+    return ESP_FAIL;
+}
+
+static int _stall_parse(void *ctx, const char *data, int len, bool first)
+{
+    return SR_JSON_ERROR;
+}
+
+static const sr_provider_t s_stall = {
+    .name = "stall",
+    .create = _stall_create,
+    .destroy = _stall_destroy,
+    .memory = _stall_memory,
+    .begin = _stall_begin,
+    .frame = _stall_frame,
+    .end = _stall_end,
+    .parse = _stall_parse,
+};
+
+static void test_placement(void)
+{
+    sr_provider_mock_config_t primary = { .latency_ms = 2000, .text = "primary" };
+    sr_provider_mock_config_t backup = { .latency_ms = 100, .text = "backup" };
+    sr_provider_hedge_config_t hedge_cfg = {
+        .primary = { .provider = &sr_provider_mock, .config = &primary },
+        .backup = { .provider = &sr_provider_mock, .config = &backup },
+    };
+    sr_core_placement_t placement = SR_CORE_DEFAULT_PLACEMENT();
+    placement.hedge.core = 0;
+    placement.hedge.prio = 7;
+    sr_core_config_t sr_cfg = {
+        .provider = &sr_provider_hedge,
+        .provider_config = &hedge_cfg,
+        .record_sample_rates = TEST_SAMPLE_RATE,
+        .placement = &placement,
+        .task_stats = true,
+    };
+    sr_core_handle_t sr = sr_core_init(&sr_cfg);
+    TEST_ASSERT(sr != NULL);
+    if (sr == NULL) {
+        return;
+    }
+    sr_test_clip_t clip;
+    sr_test_clip_speech(&clip, 1000, TEST_SAMPLE_RATE, 1);
+    TEST_ASSERT_EQUAL_INT(ESP_OK, sr_core_start(sr));
+    sr_host_mic_play(clip.samples, clip.frames, clip.channels);
+    TEST_ASSERT_EQUAL_INT(ESP_OK, sr_host_mic_wait_played(10000));
+    char *text = sr_core_stop(sr);
+    TEST_ASSERT_EQUAL_STRING("backup", text ? text : "");
+
+    const sr_task_stats_t *stats = sr_core_get_task_stats(sr);
+    TEST_ASSERT(stats != NULL);
+    static const char *names[] = { "sr_hedge0", "sr_hedge1" };
+    for (int i = 0; stats && i < sizeof(names) / sizeof(names[0]); i++) {
+        const sr_task_stat_t *task = sr_task_stats_find(stats, names[i]);
+        TEST_ASSERT(task != NULL);
+        if (task) {
+            TEST_ASSERT_EQUAL_INT(0, task->core);
+            TEST_ASSERT_EQUAL_INT(7, task->prio);
+        }
+    }
+    sr_core_destroy(sr);
+    sr_test_clip_free(&clip);
+}
+
+/* Silence: both answer without text, the utterance is done, not retried */
+static void test_empty_results(void)
+{
+    sr_provider_mock_config_t primary = { .latency_ms = 100, .text = "" };
+    sr_provider_mock_config_t backup = { .latency_ms = 200, .text = "" };
+    sr_provider_hedge_config_t hedge_cfg = {
+        .primary = { .provider = &sr_provider_mock, .config = &primary },
+        .backup = { .provider = &sr_provider_mock, .config = &backup },
+    };
+    sr_core_config_t sr_cfg = {
+        .provider = &sr_provider_hedge,
+        .provider_config = &hedge_cfg,
+        .record_sample_rates = TEST_SAMPLE_RATE,
+    };
+    sr_core_handle_t sr = sr_core_init(&sr_cfg);
+    TEST_ASSERT(sr != NULL);
+    if (sr == NULL) {
+        return;
+    }
+    sr_test_clip_t clip;
+    sr_test_clip_speech(&clip, 1000, TEST_SAMPLE_RATE, 1);
+    TEST_ASSERT_EQUAL_INT(ESP_OK, sr_core_start(sr));
+    sr_host_mic_play(clip.samples, clip.frames, clip.channels);
+    TEST_ASSERT_EQUAL_INT(ESP_OK, sr_host_mic_wait_played(10000));
+    char *text = sr_core_stop(sr);
+    TEST_ASSERT(text != NULL);
+    TEST_ASSERT_EQUAL_STRING("", text ? text : "(null)");
+    sr_core_result_info_t info;
+    sr_core_get_result_info(sr, &info);
+    TEST_ASSERT_EQUAL_INT(0, info.retries);
+    sr_core_destroy(sr);
+    sr_test_clip_free(&clip);
+}
+
+/* The primary stalls with the store full, the backup's result comes without waiting for it */
+static void test_stalled_leg(void)
+{
+    sr_provider_mock_config_t backup = { .latency_ms = 100, .text = "backup" };
+    sr_provider_hedge_config_t hedge_cfg = {
+        .primary = { .provider = &s_stall },
+        .backup = { .provider = &sr_provider_mock, .config = &backup },
+        .buffer_size = 8 * 1024,
+    };
+    sr_core_config_t sr_cfg = {
+        .provider = &sr_provider_hedge,
+        .provider_config = &hedge_cfg,
+        .record_sample_rates = TEST_SAMPLE_RATE,
+        .max_retries = -1,
+    };
+    sr_core_handle_t sr = sr_core_init(&sr_cfg);
+    TEST_ASSERT(sr != NULL);
+    if (sr == NULL) {
+        return;
+    }
+    sr_test_clip_t clip;
+    sr_test_clip_speech(&clip, 1000, TEST_SAMPLE_RATE, 1);
+    TEST_ASSERT_EQUAL_INT(ESP_OK, sr_core_start(sr));
+    sr_host_mic_play(clip.samples, clip.frames, clip.channels);
+    TEST_ASSERT_EQUAL_INT(ESP_OK, sr_host_mic_wait_played(10000));
+    int64_t start = esp_timer_get_time();
+    char *text = sr_core_stop(sr);
+    int stop_ms = (int)((esp_timer_get_time() - start) / 1000);
+    TEST_ASSERT_EQUAL_STRING("backup", text ? text : "");
+    TEST_ASSERT(stop_ms < TEST_STALL_MS / 2);
+    sr_core_destroy(sr);
+    sr_test_clip_free(&clip);
+}
+
+int main(void)
+{
+    esp_log_level_set("*", getenv("SR_LOG") ? atoi(getenv("SR_LOG")) : ESP_LOG_WARN);
+    RUN_TEST(test_placement);
+    RUN_TEST(test_empty_results);
+    RUN_TEST(test_stalled_leg);
+    return sr_test_result();
+}
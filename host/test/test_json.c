@@ -0,0 +1,116 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include "sr_json.h"
+#include "sr_test.h"
+
+typedef struct {
+    char    text[256];
+    int     len;
+    char    path_value[64];
+} json_capture_t;
+
+static void _on_value(sr_json_t *json, sr_json_type_t type, const char *data, int len, bool done, void *user_data)
+{
+    json_capture_t *cap = (json_capture_t *)user_data;
+    if (type == SR_JSON_STRING && sr_json_path_is(json, "a[1].b")) {
+        sr_json_append(cap->text, sizeof(cap->text), &cap->len, data, len);
+    } else if (type == SR_JSON_NUMBER && sr_json_path_is(json, "n")) {
+        snprintf(cap->path_value, sizeof(cap->path_value), "%s", data);
+    }
+}
+
+/* Parse `doc` in pieces of `step` bytes, returns the text at a[1].b */
+static const char *_parse(const char *doc, int step, json_capture_t *cap)
+{
+    sr_json_t json;
+    memset(cap, 0, sizeof(json_capture_t));
+    sr_json_init(&json, _on_value, cap);
+    int len = strlen(doc);
+    int ret = SR_JSON_MORE;
+    for (int i = 0; i < len && ret == SR_JSON_MORE; i += step) {
+        ret = sr_json_feed(&json, doc + i, len - i < step ? len - i : step);
+    }
+    return ret == SR_JSON_DONE ? cap->text : NULL;
+}
+
+static void _expect_string(const char *escaped, const char *utf8)
+{
+    char doc[256];
+    snprintf(doc, sizeof(doc), "{\"a\":[0,{\"b\":\"%s\"}],\"n\":-1.5e3}", escaped);
+    for (int step = 1; step <= (int)strlen(doc); step++) {
+        json_capture_t cap;
+        const char *text = _parse(doc, step, &cap);
+        TEST_ASSERT_EQUAL_STRING(utf8, text);
+        TEST_ASSERT_EQUAL_STRING("-1.5e3", cap.path_value);
+        if (text == NULL || strcmp(text, utf8) != 0) {
+            fprintf(stderr, "  \"%s\" fed %d bytes at a time\n", escaped, step);
+            return;
+        }
+    }
+}
+
+static void test_escapes(void)
+{
+    _expect_string("plain", "plain");
+    _expect_string("\\\"\\\\\\/\\b\\f\\n\\r\\t", "\"\\/\b\f\n\r\t");
+    _expect_string("\\u0041\\u00e9\\u4eca", "A\xc3\xa9\xe4\xbb\x8a");
+    _expect_string("今天", "今天");
+}
+
+static void test_surrogate_pair(void)
+{
+    _expect_string("\\ud83d\\ude00", "\xf0\x9f\x98\x80");
+    _expect_string("x\\uD83D\\uDE00y", "x\xf0\x9f\x98\x80y");
+}
+
+static void test_unpaired_surrogates(void)
+{
+    /* Every unpaired half becomes U+FFFD, what follows it is kept */
+    _expect_string("\\ud83d", "\xef\xbf\xbd");
+    _expect_string("\\ud83dA", "\xef\xbf\xbd" "A");
+    _expect_string("\\ud83d\\n", "\xef\xbf\xbd\n");
+    _expect_string("\\ud83d\\u0041", "\xef\xbf\xbd" "A");
+    _expect_string("\\ud83d\\ud83d\\ude00", "\xef\xbf\xbd\xf0\x9f\x98\x80");
+    _expect_string("\\ude00", "\xef\xbf\xbd");
+    _expect_string("\\ude00\\ud83d", "\xef\xbf\xbd\xef\xbf\xbd");
+}
+
+static void test_errors(void)
+{
+    json_capture_t cap;
+    TEST_ASSERT(_parse("{\"a\":\"\\uzzzz\"}", 1, &cap) == NULL);
+    TEST_ASSERT(_parse("{\"a\" 1}", 1, &cap) == NULL);
+    TEST_ASSERT(_parse("[[[[[[[[[[[1]]]]]]]]]]]", 1, &cap) == NULL);
+}
+
+int main(void)
+{
+    RUN_TEST(test_escapes);
+    RUN_TEST(test_surrogate_pair);
+    RUN_TEST(test_unpaired_surrogates);
+    RUN_TEST(test_errors);
+    return sr_test_result();
+}
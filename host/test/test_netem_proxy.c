@@ -0,0 +1,200 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * The netem proxy between a client and an echo server: round trip,
+ * bandwidth, stalls and loss each show up where they should.
+ */
+
+#include <stdlib.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "sr_netem_proxy.h"
+#include "sr_test.h"
+
+#define TEST_BULK_BYTES     (50000)
+
+static int s_echo_fd;
+static int s_echo_port;
+
+static int64_t _now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+/* One connection at a time, everything sent back */
+static void *_echo_thread(void *arg)
+{
+    char buf[4096];
+    int fd;
+    while ((fd = accept(s_echo_fd, NULL, NULL)) >= 0) {
+        int n;
+        while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) {
+            if (send(fd, buf, n, MSG_NOSIGNAL) != n) {
+                break;
+            }
+        }
+        close(fd);
+    }
+    return NULL;
+}
+
+static int _connect(int port)
+{
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* Send `len` bytes and wait until they are all back, the milliseconds taken or -1 */
+static int _echo(int fd, int len)
+{
+    static char out[TEST_BULK_BYTES], in[TEST_BULK_BYTES];
+    int64_t start = _now_ms();
+    if (send(fd, out, len, MSG_NOSIGNAL) != len) {
+        return -1;
+    }
+    for (int got = 0; got < len;) {
+        int n = recv(fd, in, len - got, 0);
+        if (n <= 0) {
+            return -1;
+        }
+        got += n;
+    }
+    return (int)(_now_ms() - start);
+}
+
+static sr_netem_proxy_t *_proxy(const sr_netem_step_t *steps, int step_count)
+{
+    static sr_netem_scenario_t scenario;
+    scenario = (sr_netem_scenario_t) { "test", steps, step_count };
+    sr_netem_proxy_t *proxy = sr_netem_proxy_start(s_echo_port, &scenario, 1);
+    TEST_ASSERT(proxy != NULL);
+    return proxy;
+}
+
+static void test_round_trip(void)
+{
+    static const sr_netem_step_t steps[] = { { 60000, 0, 200, 0, 0 } };
+    sr_netem_proxy_t *proxy = _proxy(steps, 1);
+    int fd = _connect(sr_netem_proxy_port(proxy));
+    TEST_ASSERT(fd >= 0);
+    /* The handshake, then the byte there and back */
+    int ms = _echo(fd, 1);
+    TEST_ASSERT(ms >= 390 && ms < 1000);
+    ms = _echo(fd, 1);
+    TEST_ASSERT(ms >= 190 && ms < 500);
+    close(fd);
+    sr_netem_proxy_stop(proxy);
+}
+
+static void test_bandwidth(void)
+{
+    /* 50000 bytes at 800 kbit/s take 500 ms, the echo comes back unlimited */
+    static const sr_netem_step_t steps[] = { { 60000, 800, 0, 0, 0 } };
+    sr_netem_proxy_t *proxy = _proxy(steps, 1);
+    int fd = _connect(sr_netem_proxy_port(proxy));
+    int ms = _echo(fd, TEST_BULK_BYTES);
+    TEST_ASSERT(ms >= 480 && ms < 1500);
+    sr_netem_proxy_stats_t stats;
+    sr_netem_proxy_stats(proxy, &stats, false);
+    TEST_ASSERT_EQUAL_INT(TEST_BULK_BYTES, stats.up_bytes);
+    TEST_ASSERT_EQUAL_INT(TEST_BULK_BYTES, stats.down_bytes);
+    close(fd);
+    sr_netem_proxy_stop(proxy);
+}
+
+static void test_stall(void)
+{
+    static const sr_netem_step_t steps[] = {
+        { 1000, -1, 0, 0, 0 },
+        { 60000, 0, 0, 0, 0 },
+    };
+    int64_t start = _now_ms();
+    sr_netem_proxy_t *proxy = _proxy(steps, 2);
+    int fd = _connect(sr_netem_proxy_port(proxy));
+    TEST_ASSERT(_echo(fd, 100) >= 0);
+    int ms = (int)(_now_ms() - start);
+    TEST_ASSERT(ms >= 990 && ms < 2000);
+    sr_netem_proxy_stats_t stats;
+    sr_netem_proxy_stats(proxy, &stats, false);
+    TEST_ASSERT_EQUAL_INT(1, stats.stalls);
+    close(fd);
+    sr_netem_proxy_stop(proxy);
+}
+
+static void test_loss_resets(void)
+{
+    static const sr_netem_step_t steps[] = { { 60000, 0, 0, 0, 1000 } };
+    sr_netem_proxy_t *proxy = _proxy(steps, 1);
+    int fd = _connect(sr_netem_proxy_port(proxy));
+    TEST_ASSERT_EQUAL_INT(-1, _echo(fd, 100));
+    sr_netem_proxy_stats_t stats;
+    sr_netem_proxy_stats(proxy, &stats, false);
+    TEST_ASSERT_EQUAL_INT(1, stats.resets);
+    TEST_ASSERT_EQUAL_INT(0, stats.up_bytes);
+    close(fd);
+    sr_netem_proxy_stop(proxy);
+}
+
+int main(void)
+{
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    socklen_t addr_len = sizeof(addr);
+    s_echo_fd = socket(AF_INET, SOCK_STREAM, 0);
+    TEST_ASSERT(bind(s_echo_fd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+    TEST_ASSERT(listen(s_echo_fd, 4) == 0);
+    getsockname(s_echo_fd, (struct sockaddr *)&addr, &addr_len);
+    s_echo_port = ntohs(addr.sin_port);
+    pthread_t echo;
+    pthread_create(&echo, NULL, _echo_thread, NULL);
+
+    RUN_TEST(test_round_trip);
+    RUN_TEST(test_bandwidth);
+    RUN_TEST(test_stall);
+    RUN_TEST(test_loss_resets);
+
+    shutdown(s_echo_fd, SHUT_RDWR);
+    pthread_join(echo, NULL);
+    close(s_echo_fd);
+    return sr_test_result();
+}
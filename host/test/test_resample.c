@@ -0,0 +1,257 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * The polyphase resampler: output rate, block independence, unity DC gain,
+ * passband and alias rejection, then a narrowband upload through the SR
+ * core, recorded at 48 kHz and sent to the mock Baidu server at 8 kHz.
+ */
+
+#include <stdlib.h>
+#include <math.h>
+#include "esp_log.h"
+#include "sr_resample.h"
+#include "sr_core.h"
+#include "sr_provider_baidu.h"
+#include "sr_host_mic.h"
+#include "sr_mock_server.h"
+#include "sr_test.h"
+
+#define TEST_BLOCK          (512)
+#define TEST_TEXT           "narrowband"
+
+static const struct {
+    int in_rate;
+    int out_rate;
+} test_rates[] = {
+    { 48000, 16000 },
+    { 44100, 16000 },
+    { 16000, 8000 },
+    { 48000, 8000 },
+    { 8000, 16000 },
+};
+
+static void _tone(int16_t *out, int samples, int rate, int hz, int amplitude)
+{
+    for (int i = 0; i < samples; i++) {
+        out[i] = (int16_t)lround(amplitude * sin(2 * M_PI * hz * i / rate));
+    }
+}
+
+/* Everything through `rs` in blocks of `block`, or of varying size if 0, returns the output count */
+static int _run(sr_resample_t *rs, const int16_t *in, int samples, int block, int16_t *out)
+{
+    int count = 0;
+    for (int offset = 0, step = 1; offset < samples; offset += step) {
+        step = block ? block : 1 + (offset * 7 + 3) % rs->block;
+        if (step > samples - offset) {
+            step = samples - offset;
+        }
+        count += sr_resample_process(rs, in + offset, step, out + count);
+    }
+    return count;
+}
+
+static double _rms(const int16_t *x, int samples)
+{
+    double sum = 0;
+    for (int i = 0; i < samples; i++) {
+        sum += (double)x[i] * x[i];
+    }
+    return sqrt(sum / samples);
+}
+
+static void test_output_rate(void)
+{
+    for (int r = 0; r < sizeof(test_rates) / sizeof(test_rates[0]); r++) {
+        sr_resample_t rs;
+        int in_rate = test_rates[r].in_rate, out_rate = test_rates[r].out_rate;
+        TEST_ASSERT_EQUAL_INT(0, sr_resample_init(&rs, in_rate, out_rate, TEST_BLOCK));
+        int16_t *in = calloc(in_rate, sizeof(int16_t));
+        int16_t *out = calloc(SR_RESAMPLE_OUT_MAX(&rs, in_rate), sizeof(int16_t));
+        /* One second in, one second out, and never more than the bound per block */
+        int count = 0;
+        for (int offset = 0; offset < in_rate; offset += TEST_BLOCK) {
+            int len = in_rate - offset < TEST_BLOCK ? in_rate - offset : TEST_BLOCK;
+            int n = sr_resample_process(&rs, in + offset, len, out + count);
+            TEST_ASSERT(n <= SR_RESAMPLE_OUT_MAX(&rs, len));
+            count += n;
+        }
+        TEST_ASSERT(abs(count - out_rate) <= 1);
+        TEST_ASSERT_EQUAL_INT(sr_resample_memory(in_rate, out_rate, TEST_BLOCK),
+                              (rs.up * rs.taps + rs.taps - 1 + TEST_BLOCK) * (int)sizeof(int16_t));
+        free(in);
+        free(out);
+        sr_resample_deinit(&rs);
+    }
+}
+
+static void test_block_independent(void)
+{
+    sr_resample_t a, b;
+    TEST_ASSERT_EQUAL_INT(0, sr_resample_init(&a, 44100, 16000, TEST_BLOCK));
+    TEST_ASSERT_EQUAL_INT(0, sr_resample_init(&b, 44100, 16000, TEST_BLOCK));
+    int samples = 44100;
+    int16_t *in = malloc(samples * sizeof(int16_t));
+    int16_t *out_a = calloc(SR_RESAMPLE_OUT_MAX(&a, samples), sizeof(int16_t));
+    int16_t *out_b = calloc(SR_RESAMPLE_OUT_MAX(&b, samples), sizeof(int16_t));
+    uint32_t seed = 1;
+    for (int i = 0; i < samples; i++) {
+        seed = seed * 1664525 + 1013904223;
+        in[i] = (int16_t)(seed >> 16) / 4;
+    }
+    int count_a = _run(&a, in, samples, TEST_BLOCK, out_a);
+    int count_b = _run(&b, in, samples, 0, out_b);
+    TEST_ASSERT_EQUAL_INT(count_a, count_b);
+    TEST_ASSERT(memcmp(out_a, out_b, count_a * sizeof(int16_t)) == 0);
+
+    /* After a reset the same input gives the same output again */
+    sr_resample_reset(&b);
+    count_b = _run(&b, in, samples, TEST_BLOCK, out_b);
+    TEST_ASSERT_EQUAL_INT(count_a, count_b);
+    TEST_ASSERT(memcmp(out_a, out_b, count_a * sizeof(int16_t)) == 0);
+    free(in);
+    free(out_a);
+    free(out_b);
+    sr_resample_deinit(&a);
+    sr_resample_deinit(&b);
+}
+
+static void test_dc_unity(void)
+{
+    for (int r = 0; r < sizeof(test_rates) / sizeof(test_rates[0]); r++) {
+        sr_resample_t rs;
+        TEST_ASSERT_EQUAL_INT(0, sr_resample_init(&rs, test_rates[r].in_rate, test_rates[r].out_rate, TEST_BLOCK));
+        int16_t in[TEST_BLOCK], out[TEST_BLOCK * 2 + 1];
+        for (int i = 0; i < TEST_BLOCK; i++) {
+            in[i] = 10000;
+        }
+        int count = 0;
+        for (int i = 0; i < 8; i++) {
+            count = sr_resample_process(&rs, in, TEST_BLOCK, out);
+        }
+        for (int i = 0; i < count; i++) {
+            TEST_ASSERT(abs(out[i] - 10000) <= 1);
+        }
+        sr_resample_deinit(&rs);
+    }
+}
+
+/* The output level of a tone in dB relative to the input, after the filter filled up */
+static double _tone_gain_db(int in_rate, int out_rate, int hz)
+{
+    sr_resample_t rs;
+    if (sr_resample_init(&rs, in_rate, out_rate, TEST_BLOCK) != 0) {
+        return 999;
+    }
+    int16_t *in = malloc(in_rate * sizeof(int16_t));
+    int16_t *out = calloc(SR_RESAMPLE_OUT_MAX(&rs, in_rate), sizeof(int16_t));
+    _tone(in, in_rate, in_rate, hz, 16000);
+    int count = _run(&rs, in, in_rate, TEST_BLOCK, out);
+    int skip = rs.taps * 2;
+    double gain = 20 * log10((_rms(out + skip, count - skip) + 1e-9) / _rms(in, in_rate));
+    free(in);
+    free(out);
+    sr_resample_deinit(&rs);
+    return gain;
+}
+
+static void test_passband(void)
+{
+    TEST_ASSERT(fabs(_tone_gain_db(48000, 16000, 1000)) < 0.5);
+    TEST_ASSERT(fabs(_tone_gain_db(44100, 16000, 3000)) < 0.5);
+    TEST_ASSERT(fabs(_tone_gain_db(16000, 8000, 1000)) < 0.5);
+}
+
+static void test_alias_rejection(void)
+{
+    /* Above the new Nyquist frequency a tone would fold back into the band, it must be gone instead */
+    TEST_ASSERT(_tone_gain_db(48000, 16000, 10000) < -50);
+    TEST_ASSERT(_tone_gain_db(44100, 16000, 12000) < -50);
+    TEST_ASSERT(_tone_gain_db(16000, 8000, 5000) < -50);
+}
+
+static void test_invalid(void)
+{
+    sr_resample_t rs;
+    TEST_ASSERT_EQUAL_INT(-1, sr_resample_init(&rs, 0, 16000, TEST_BLOCK));
+    TEST_ASSERT_EQUAL_INT(-1, sr_resample_init(&rs, 48000, 16000, 0));
+    TEST_ASSERT_EQUAL_INT(0, sr_resample_memory(16000, -1, TEST_BLOCK));
+}
+
+/* The I2S clock at 48 kHz, the upload at 8 kHz: half the bytes of 16 kHz, labelled rate=8000 */
+static void test_narrowband_upload(void)
+{
+    sr_mock_config_t mock_cfg = { .text = TEST_TEXT };
+    sr_mock_server_t *server = sr_mock_baidu_start(&mock_cfg);
+    TEST_ASSERT(server != NULL);
+    if (server == NULL) {
+        return;
+    }
+    sr_provider_baidu_config_t baidu_cfg = {
+        .token = "24.0123456789abcdef0123456789abcdef.2592000.1600000000.282335-12345678",
+        .cuid = "host",
+        .upload_mode = BAIDU_SR_UPLOAD_RAW,
+        .endpoint = sr_mock_server_url(server),
+    };
+    sr_core_config_t sr_cfg = {
+        .provider = &sr_provider_baidu,
+        .provider_config = &baidu_cfg,
+        .record_sample_rates = 48000,
+        .upload_sample_rate = 8000,
+        .encoding = SR_AUDIO_PCM,
+    };
+    sr_core_handle_t sr = sr_core_init(&sr_cfg);
+    TEST_ASSERT(sr != NULL);
+    sr_test_clip_t clip;
+    sr_test_clip_speech(&clip, 1000, 48000, 1);
+    if (sr) {
+        TEST_ASSERT_EQUAL_INT(ESP_OK, sr_core_start(sr));
+        sr_host_mic_play(clip.samples, clip.frames, clip.channels);
+        TEST_ASSERT_EQUAL_INT(ESP_OK, sr_host_mic_wait_played(10000));
+        char *text = sr_core_stop(sr);
+        TEST_ASSERT_EQUAL_STRING(TEST_TEXT, text);
+        sr_mock_stats_t stats;
+        sr_mock_server_stats(server, &stats, false);
+        TEST_ASSERT_EQUAL_INT(8000, stats.rate);
+        /* A second of 8 kHz PCM is 16000 bytes, the cold stop drops what the uplink had not taken yet */
+        TEST_ASSERT(stats.body_bytes > 14000 && stats.body_bytes <= 16500);
+        sr_core_destroy(sr);
+    }
+    sr_test_clip_free(&clip);
+    sr_mock_server_stop(server);
+}
+
+int main(void)
+{
+    esp_log_level_set("*", getenv("SR_LOG") ? atoi(getenv("SR_LOG")) : ESP_LOG_WARN);
+    RUN_TEST(test_output_rate);
+    RUN_TEST(test_block_independent);
+    RUN_TEST(test_dc_unity);
+    RUN_TEST(test_passband);
+    RUN_TEST(test_alias_rejection);
+    RUN_TEST(test_invalid);
+    RUN_TEST(test_narrowband_upload);
+    return sr_test_result();
+}
@@ -0,0 +1,300 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * The spool on a file-backed partition image: utterances survive a reopen,
+ * the log wraps around the partition, and torn or corrupt sectors only cost
+ * what they hold. Then the SR core, which must only touch the spool once an
+ * upload failed.
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "sr_spool.h"
+#include "sr_core.h"
+#include "sr_provider_baidu.h"
+#include "sr_host_flash.h"
+#include "sr_host_mic.h"
+#include "sr_mock_server.h"
+#include "sr_test.h"
+
+#define TEST_LABEL          "spool"
+#define TEST_SECTORS        (6)
+#define TEST_SECTOR_SIZE    (4096)
+#define TEST_UTTERANCE      (4052)      /* With its BEGIN and END records, fills a sector */
+#define TEST_SAMPLE_RATE    (16000)
+#define TEST_TEXT           "spooled"
+
+static char s_image[64];
+static int s_sectors = TEST_SECTORS;
+static const esp_partition_t *s_part;
+
+/* Power cycle: the partition is read back from the image */
+static sr_spool_handle_t _reopen(sr_spool_handle_t spool)
+{
+    if (spool) {
+        sr_spool_destroy(spool);
+    }
+    sr_host_flash_reset();
+    s_part = sr_host_flash_add(TEST_LABEL, ESP_PARTITION_TYPE_DATA, SR_SPOOL_PARTITION_SUBTYPE,
+                               s_sectors * TEST_SECTOR_SIZE, s_image);
+    return sr_spool_init(TEST_LABEL);
+}
+
+static sr_spool_handle_t _fresh(void)
+{
+    unlink(s_image);
+    return _reopen(NULL);
+}
+
+static void _fill(char *data, int len, int id)
+{
+    for (int i = 0; i < len; i++) {
+        data[i] = (char)(id * 31 + i);
+    }
+}
+
+static esp_err_t _write(sr_spool_handle_t spool, int id, bool end)
+{
+    static char data[TEST_UTTERANCE];
+    sr_spool_meta_t meta = { .sample_rate = TEST_SAMPLE_RATE, .timestamp = id };
+    _fill(data, sizeof(data), id);
+    esp_err_t ret = sr_spool_begin(spool, &meta);
+    if (ret == ESP_OK) {
+        ret = sr_spool_append(spool, data, sizeof(data));
+    }
+    if (ret == ESP_OK && end) {
+        ret = sr_spool_end(spool, true);
+    }
+    return ret;
+}
+
+/* The oldest utterance is `id` with its audio intact, forwarded if `done` */
+static void _expect(sr_spool_handle_t spool, int id, bool done)
+{
+    static char expected[TEST_UTTERANCE];
+    static char data[TEST_UTTERANCE + 512];
+    sr_spool_meta_t meta;
+    TEST_ASSERT_EQUAL_INT(ESP_OK, sr_spool_open(spool, &meta));
+    TEST_ASSERT_EQUAL_INT(id, meta.timestamp);
+    int len = 0, n;
+    while ((n = sr_spool_read(spool, data + len, 512)) > 0) {
+        len += n;
+    }
+    TEST_ASSERT_EQUAL_INT(0, n);
+    TEST_ASSERT_EQUAL_INT(TEST_UTTERANCE, len);
+    _fill(expected, sizeof(expected), id);
+    TEST_ASSERT(memcmp(data, expected, sizeof(expected)) == 0);
+    if (done) {
+        TEST_ASSERT_EQUAL_INT(ESP_OK, sr_spool_done(spool));
+    } else {
+        sr_spool_close(spool);
+    }
+}
+
+/* Overwrite `len` bytes of the image, as a reset in the middle of a write would leave them */
+static void _corrupt(int offset, int len)
+{
+    char garbage[16];
+    memset(garbage, 0x5A, sizeof(garbage));
+    int fd = open(s_image, O_WRONLY);
+    TEST_ASSERT(fd >= 0 && pwrite(fd, garbage, len, offset) == len);
+    close(fd);
+}
+
+static void test_recovery(void)
+{
+    sr_spool_handle_t spool = _fresh();
+    TEST_ASSERT(spool != NULL);
+    for (int id = 1; id <= 3; id++) {
+        TEST_ASSERT_EQUAL_INT(ESP_OK, _write(spool, id, true));
+    }
+    /* Reset while the fourth is recorded */
+    TEST_ASSERT_EQUAL_INT(ESP_OK, _write(spool, 4, false));
+    spool = _reopen(spool);
+    TEST_ASSERT_EQUAL_INT(3, sr_spool_pending(spool));
+    _expect(spool, 1, true);
+    _expect(spool, 2, false);
+    spool = _reopen(spool);
+    TEST_ASSERT_EQUAL_INT(2, sr_spool_pending(spool));
+    _expect(spool, 2, true);
+    _expect(spool, 3, true);
+    TEST_ASSERT_EQUAL_INT(ESP_ERR_NOT_FOUND, sr_spool_open(spool, &(sr_spool_meta_t) { 0 }));
+    spool = _reopen(spool);
+    TEST_ASSERT_EQUAL_INT(0, sr_spool_pending(spool));
+    sr_spool_destroy(spool);
+}
+
+static void test_wrap(void)
+{
+    sr_spool_handle_t spool = _fresh();
+    /* Several rounds of the partition, each utterance forwarded right away */
+    for (int id = 1; id <= TEST_SECTORS * 3; id++) {
+        TEST_ASSERT_EQUAL_INT(ESP_OK, _write(spool, id, true));
+        _expect(spool, id, true);
+    }
+    spool = _reopen(spool);
+    TEST_ASSERT_EQUAL_INT(0, sr_spool_pending(spool));
+    /* Then nothing is forwarded until it is full, the oldest is never overwritten */
+    int first = 100, id = first;
+    while (_write(spool, id, true) == ESP_OK) {
+        id++;
+    }
+    int kept = id - first;
+    TEST_ASSERT(kept >= TEST_SECTORS - 2);
+    TEST_ASSERT_EQUAL_INT(kept, sr_spool_pending(spool));
+    spool = _reopen(spool);
+    TEST_ASSERT_EQUAL_INT(kept, sr_spool_pending(spool));
+    for (int i = 0; i < kept; i++) {
+        _expect(spool, first + i, true);
+    }
+    TEST_ASSERT_EQUAL_INT(ESP_OK, _write(spool, 200, true));
+    _expect(spool, 200, true);
+    sr_spool_destroy(spool);
+}
+
+static void test_corrupt_record(void)
+{
+    sr_spool_handle_t spool = _fresh();
+    for (int id = 1; id <= 4; id++) {
+        TEST_ASSERT_EQUAL_INT(ESP_OK, _write(spool, id, true));
+    }
+    sr_spool_destroy(spool);
+    /* The BEGIN record of the third utterance, right after its sector header: the rest of that sector is skipped */
+    _corrupt(2 * TEST_SECTOR_SIZE + 8, 8);
+    spool = _reopen(NULL);
+    TEST_ASSERT(spool != NULL);
+    TEST_ASSERT_EQUAL_INT(3, sr_spool_pending(spool));
+    _expect(spool, 1, true);
+    _expect(spool, 2, true);
+    _expect(spool, 4, true);
+    TEST_ASSERT_EQUAL_INT(ESP_OK, _write(spool, 5, true));
+    _expect(spool, 5, true);
+    sr_spool_destroy(spool);
+}
+
+static void test_corrupt_sector(void)
+{
+    sr_spool_handle_t spool = _fresh();
+    for (int id = 1; id <= 4; id++) {
+        TEST_ASSERT_EQUAL_INT(ESP_OK, _write(spool, id, true));
+    }
+    sr_spool_destroy(spool);
+    /* The log is found again from the newest sector back to the broken one */
+    _corrupt(1 * TEST_SECTOR_SIZE, 4);
+    spool = _reopen(NULL);
+    TEST_ASSERT(spool != NULL);
+    TEST_ASSERT_EQUAL_INT(2, sr_spool_pending(spool));
+    _expect(spool, 3, true);
+    _expect(spool, 4, true);
+    TEST_ASSERT_EQUAL_INT(ESP_OK, _write(spool, 5, true));
+    spool = _reopen(spool);
+    TEST_ASSERT_EQUAL_INT(1, sr_spool_pending(spool));
+    _expect(spool, 5, true);
+    sr_spool_destroy(spool);
+}
+
+static SemaphoreHandle_t s_forwarded;
+static char s_forward_text[64];
+
+static void _on_forward(sr_core_handle_t sr, const char *text, uint32_t timestamp)
+{
+    snprintf(s_forward_text, sizeof(s_forward_text), "%s", text ? text : "");
+    xSemaphoreGive(s_forwarded);
+}
+
+/* A recognized utterance never reaches the flash, a failed one is spooled then forwarded */
+static void test_core_spools_on_failure(void)
+{
+    sr_test_clip_t clip;
+    sr_host_flash_stats_t stats;
+    sr_mock_config_t mock_cfg = { .text = TEST_TEXT, .fail_request = 2 };
+    sr_mock_server_t *server = sr_mock_baidu_start(&mock_cfg);
+    /* Room for the whole replay buffer */
+    s_sectors = 32;
+    sr_spool_destroy(_fresh());
+    s_forwarded = xSemaphoreCreateBinary();
+    sr_provider_baidu_config_t baidu_cfg = {
+        .token = "token",
+        .cuid = "host",
+        .endpoint = sr_mock_server_url(server),
+    };
+    sr_core_config_t sr_cfg = {
+        .provider = &sr_provider_baidu,
+        .provider_config = &baidu_cfg,
+        .record_sample_rates = TEST_SAMPLE_RATE,
+        .max_retries = -1,
+        .spool_partition = TEST_LABEL,
+        .on_forward = _on_forward,
+    };
+    sr_core_handle_t sr = sr_core_init(&sr_cfg);
+    TEST_ASSERT(server != NULL && sr != NULL);
+    if (server == NULL || sr == NULL) {
+        return;
+    }
+    sr_test_clip_speech(&clip, 1000, TEST_SAMPLE_RATE, 1);
+
+    sr_core_start(sr);
+    sr_host_mic_play(clip.samples, clip.frames, clip.channels);
+    sr_host_mic_wait_played(10000);
+    char *text = sr_core_stop(sr);
+    TEST_ASSERT_EQUAL_STRING(TEST_TEXT, text ? text : "");
+    sr_host_flash_stats(s_part, &stats);
+    TEST_ASSERT_EQUAL_INT(0, stats.write_bytes);
+    TEST_ASSERT_EQUAL_INT(0, stats.erases);
+
+    sr_core_start(sr);
+    sr_host_mic_play(clip.samples, clip.frames, clip.channels);
+    sr_host_mic_wait_played(10000);
+    TEST_ASSERT(sr_core_stop(sr) == NULL);
+    sr_host_flash_stats(s_part, &stats);
+    /* A cold stop drops what the uplink had not taken yet, most of the clip is there */
+    TEST_ASSERT(stats.write_bytes > clip.frames);
+    TEST_ASSERT_EQUAL_INT(ESP_OK, sr_core_spool_flush(sr));
+    TEST_ASSERT(xSemaphoreTake(s_forwarded, 10000 / portTICK_PERIOD_MS) == pdTRUE);
+    TEST_ASSERT_EQUAL_STRING(TEST_TEXT, s_forward_text);
+
+    sr_test_clip_free(&clip);
+    sr_core_destroy(sr);
+    sr_mock_server_stop(server);
+    vSemaphoreDelete(s_forwarded);
+}
+
+int main(void)
+{
+    esp_log_level_set("*", getenv("SR_LOG") ? atoi(getenv("SR_LOG")) : ESP_LOG_WARN);
+    snprintf(s_image, sizeof(s_image), "/tmp/sr_spool_test_%d.img", (int)getpid());
+    RUN_TEST(test_recovery);
+    RUN_TEST(test_wrap);
+    RUN_TEST(test_corrupt_record);
+    RUN_TEST(test_corrupt_sector);
+    RUN_TEST(test_core_spools_on_failure);
+    sr_host_flash_reset();
+    unlink(s_image);
+    return sr_test_result();
+}
@@ -0,0 +1,132 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * Warm pipeline sessions against the mock Baidu server: each stop returns
+ * the text of its own utterance, even after a stop that timed out.
+ */
+
+#include <stdlib.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sr_core.h"
+#include "sr_provider_baidu.h"
+#include "sr_host_mic.h"
+#include "sr_mock_server.h"
+#include "sr_test.h"
+
+#define TEST_SAMPLE_RATE    (16000)
+#define TEST_TEXT           "warm"
+
+static sr_mock_server_t *s_baidu;
+static sr_core_handle_t s_sr;
+static sr_test_clip_t s_clip;
+
+static char *_utterance(void)
+{
+    if (sr_core_start(s_sr) != ESP_OK) {
+        return NULL;
+    }
+    sr_host_mic_play(s_clip.samples, s_clip.frames, s_clip.channels);
+    TEST_ASSERT_EQUAL_INT(ESP_OK, sr_host_mic_wait_played(10000));
+    return sr_core_stop(s_sr);
+}
+
+static void test_sessions(void)
+{
+    sr_mock_stats_t stats;
+    sr_mock_server_stats(s_baidu, &stats, true);
+    for (int i = 0; i < 3; i++) {
+        char *text = _utterance();
+        TEST_ASSERT(text != NULL);
+        TEST_ASSERT_EQUAL_STRING(TEST_TEXT, text ? text : "");
+    }
+    sr_mock_server_stats(s_baidu, &stats, false);
+    TEST_ASSERT_EQUAL_INT(3, stats.requests);
+}
+
+static void test_stop_when_idle(void)
+{
+    int64_t start = esp_timer_get_time();
+    sr_core_stop(s_sr);
+    TEST_ASSERT((esp_timer_get_time() - start) / 1000 < 1000);
+}
+
+/*
+ * The stop gives up while the request is still being retried. The next
+ * session waits for it, then goes out alone: one request carrying one clip
+ * of base64, not both clips.
+ */
+static void test_after_timeout(void)
+{
+    sr_mock_config_t config = { .text = TEST_TEXT, .reply_delay_ms = 12000 };
+    sr_mock_stats_t stats;
+    sr_mock_server_configure(s_baidu, &config);
+    TEST_ASSERT(_utterance() == NULL);
+    config.reply_delay_ms = 0;
+    sr_mock_server_configure(s_baidu, &config);
+    TEST_ASSERT_EQUAL_INT(ESP_OK, sr_core_start(s_sr));
+    sr_mock_server_stats(s_baidu, &stats, true);
+    sr_host_mic_play(s_clip.samples, s_clip.frames, s_clip.channels);
+    TEST_ASSERT_EQUAL_INT(ESP_OK, sr_host_mic_wait_played(10000));
+    char *text = sr_core_stop(s_sr);
+    TEST_ASSERT_EQUAL_STRING(TEST_TEXT, text ? text : "");
+    sr_mock_server_stats(s_baidu, &stats, false);
+    TEST_ASSERT_EQUAL_INT(1, stats.requests);
+    TEST_ASSERT(stats.body_bytes < s_clip.frames * 2 * 3 / 2);
+}
+
+int main(void)
+{
+    sr_mock_config_t mock_cfg = { .text = TEST_TEXT };
+    s_baidu = sr_mock_baidu_start(&mock_cfg);
+    TEST_ASSERT(s_baidu != NULL);
+    if (s_baidu == NULL) {
+        return sr_test_result();
+    }
+    sr_provider_baidu_config_t baidu_cfg = {
+        .token = "token",
+        .cuid = "host",
+        .endpoint = sr_mock_server_url(s_baidu),
+    };
+    sr_core_config_t sr_cfg = {
+        .provider = &sr_provider_baidu,
+        .provider_config = &baidu_cfg,
+        .record_sample_rates = TEST_SAMPLE_RATE,
+        .warm_pipeline = true,
+    };
+    esp_log_level_set("*", getenv("SR_LOG") ? atoi(getenv("SR_LOG")) : ESP_LOG_WARN);
+    s_sr = sr_core_init(&sr_cfg);
+    TEST_ASSERT(s_sr != NULL);
+    if (s_sr) {
+        sr_test_clip_speech(&s_clip, 1000, TEST_SAMPLE_RATE, 1);
+        RUN_TEST(test_sessions);
+        RUN_TEST(test_stop_when_idle);
+        RUN_TEST(test_after_timeout);
+        sr_test_clip_free(&s_clip);
+        sr_core_destroy(s_sr);
+    }
+    sr_mock_server_stop(s_baidu);
+    return sr_test_result();
+}
@@ -0,0 +1,119 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include "xunfei_sr_auth.h"
+#include "sr_test.h"
+
+#define TEST_KEY        "a2c2b3ae1c3e4b5f9a8d7c6b5a4f3e2d"
+#define TEST_SECRET     "0123456789abcdef0123456789abcdef"
+#define TEST_NOW        ((time_t)1562744143)    /* Wed, 10 Jul 2019 07:35:43 GMT */
+
+/* The url as the xfyun.cn documentation builds it, with OpenSSL */
+static void _reference_url(char *url, int size, const char *endpoint, const char *key, const char *secret,
+                           const char *date, const char *date_encoded)
+{
+    char sign_data[256];
+    int sign_len = snprintf(sign_data, sizeof(sign_data), "host: ws-api.xfyun.cn\ndate: %s\nGET /v2/iat HTTP/1.1", date);
+    unsigned char mac[32];
+    unsigned int mac_len = sizeof(mac);
+    HMAC(EVP_sha256(), secret, strlen(secret), (const unsigned char *)sign_data, sign_len, mac, &mac_len);
+    char signature[64];
+    EVP_EncodeBlock((unsigned char *)signature, mac, mac_len);
+    char origin[512];
+    int origin_len = snprintf(origin, sizeof(origin),
+                              "api_key=\"%s\", algorithm=\"hmac-sha256\", headers=\"host date request-line\", signature=\"%s\"",
+                              key, signature);
+    char authorization[700];
+    EVP_EncodeBlock((unsigned char *)authorization, (const unsigned char *)origin, origin_len);
+    snprintf(url, size, "%s?authorization=%s&date=%s&host=ws-api.xfyun.cn", endpoint, authorization, date_encoded);
+}
+
+static void test_matches_reference(void)
+{
+    char expected[XUNFEI_SR_AUTH_URL_MAX * 2];
+    _reference_url(expected, sizeof(expected), "wss://ws-api.xfyun.cn/v2/iat", TEST_KEY, TEST_SECRET,
+                   "Wed,10 Jul 2019 07:35:43 GMT", "Wed%2C10+Jul+2019+07%3A35%3A43+GMT");
+    xunfei_sr_auth_t auth;
+    xunfei_sr_auth_init(&auth, TEST_KEY, TEST_SECRET);
+    const char *url = xunfei_sr_auth_url(&auth, TEST_NOW);
+    TEST_ASSERT_EQUAL_STRING(expected, url);
+    TEST_ASSERT_EQUAL_INT(strlen(expected), auth.url_len);
+}
+
+static void test_endpoint(void)
+{
+    char expected[XUNFEI_SR_AUTH_URL_MAX * 2];
+    _reference_url(expected, sizeof(expected), "ws://127.0.0.1:8080/v2/iat", TEST_KEY, TEST_SECRET,
+                   "Wed,10 Jul 2019 07:35:43 GMT", "Wed%2C10+Jul+2019+07%3A35%3A43+GMT");
+    xunfei_sr_auth_t auth;
+    xunfei_sr_auth_init(&auth, TEST_KEY, TEST_SECRET);
+    xunfei_sr_auth_url(&auth, TEST_NOW);
+    /* Changing the endpoint re-signs even within the same second */
+    xunfei_sr_auth_set_endpoint(&auth, "ws://127.0.0.1:8080/v2/iat");
+    TEST_ASSERT_EQUAL_STRING(expected, xunfei_sr_auth_url(&auth, TEST_NOW));
+    xunfei_sr_auth_set_endpoint(&auth, NULL);
+    TEST_ASSERT(strncmp(xunfei_sr_auth_url(&auth, TEST_NOW), "wss://ws-api.xfyun.cn/v2/iat?", 29) == 0);
+}
+
+static void test_cached_per_second(void)
+{
+    xunfei_sr_auth_t auth;
+    xunfei_sr_auth_init(&auth, TEST_KEY, TEST_SECRET);
+    char first[XUNFEI_SR_AUTH_URL_MAX];
+    snprintf(first, sizeof(first), "%s", xunfei_sr_auth_url(&auth, TEST_NOW));
+    /* Same second: the cached url, untouched even if the buffer was */
+    auth.url[auth.url_len - 1] = '#';
+    TEST_ASSERT(xunfei_sr_auth_url(&auth, TEST_NOW)[auth.url_len - 1] == '#');
+    /* Next second: signed again */
+    const char *next = xunfei_sr_auth_url(&auth, TEST_NOW + 1);
+    TEST_ASSERT(next != NULL && strcmp(first, next) != 0);
+    TEST_ASSERT(strstr(next, "07%3A35%3A44") != NULL);
+    TEST_ASSERT_EQUAL_INT(TEST_NOW + 1, auth.date);
+}
+
+static void test_too_long(void)
+{
+    static char key[XUNFEI_SR_AUTH_URL_MAX];
+    memset(key, 'k', sizeof(key) - 1);
+    xunfei_sr_auth_t auth;
+    xunfei_sr_auth_init(&auth, key, TEST_SECRET);
+    TEST_ASSERT(xunfei_sr_auth_url(&auth, TEST_NOW) == NULL);
+    TEST_ASSERT_EQUAL_INT(0, auth.url_len);
+    /* Nor does an endpoint that leaves no room */
+    xunfei_sr_auth_init(&auth, TEST_KEY, TEST_SECRET);
+    xunfei_sr_auth_set_endpoint(&auth, key);
+    TEST_ASSERT(xunfei_sr_auth_url(&auth, TEST_NOW) == NULL);
+}
+
+int main(void)
+{
+    RUN_TEST(test_matches_reference);
+    RUN_TEST(test_endpoint);
+    RUN_TEST(test_cached_per_second);
+    RUN_TEST(test_too_long);
+    return sr_test_result();
+}
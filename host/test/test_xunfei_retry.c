@@ -0,0 +1,192 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * A xunfei session broken off by the server is a failure, which the SR core
+ * retries from its replay buffer. One the service rejects is answered: it is
+ * neither retried nor spooled.
+ */
+
+#include <stdlib.h>
+#include "esp_log.h"
+#include "sr_core.h"
+#include "sr_provider_xunfei.h"
+#include "sr_clock.h"
+#include "sr_host_flash.h"
+#include "sr_host_mic.h"
+#include "sr_spool.h"
+#include "sr_mock_server.h"
+#include "sr_test.h"
+
+#define TEST_SAMPLE_RATE    (16000)
+#define TEST_TEXT           "retried"
+#define TEST_KEY            "a2c2b3ae1c3e4b5f9a8d7c6b5a4f3e2d"
+#define TEST_SECRET         "0123456789abcdef0123456789abcdef"
+#define TEST_SPOOL          "spool"
+
+static sr_mock_server_t *s_xunfei;
+static sr_test_clip_t s_clip;
+
+static char *_utterance(sr_core_handle_t sr)
+{
+    sr_core_start(sr);
+    sr_host_mic_play(s_clip.samples, s_clip.frames, s_clip.channels);
+    TEST_ASSERT_EQUAL_INT(ESP_OK, sr_host_mic_wait_played(10000));
+    return sr_core_stop(sr);
+}
+
+static sr_core_handle_t _init(int max_retries, const char *spool)
+{
+    static sr_provider_xunfei_config_t xunfei_cfg = {
+        .app_id = "5d2f27d3",
+        .api_key = TEST_KEY,
+        .api_secret = TEST_SECRET,
+    };
+    xunfei_cfg.endpoint = sr_mock_server_url(s_xunfei);
+    sr_core_config_t sr_cfg = {
+        .provider = &sr_provider_xunfei,
+        .provider_config = &xunfei_cfg,
+        .record_sample_rates = TEST_SAMPLE_RATE,
+        .max_retries = max_retries,
+        .spool_partition = spool,
+    };
+    return sr_core_init(&sr_cfg);
+}
+
+/* The server drops the first session at its first frame, or after the last one, before the final result */
+static void _dropped_session_retried(bool at_end)
+{
+    sr_mock_config_t config = {
+        .text = TEST_TEXT,
+        .api_key = TEST_KEY,
+        .api_secret = TEST_SECRET,
+        .fail_request = 1,
+        .fail_at_end = at_end,
+    };
+    sr_mock_stats_t stats;
+    sr_core_result_info_t info;
+    sr_mock_server_configure(s_xunfei, &config);
+    sr_mock_server_stats(s_xunfei, &stats, true);
+    sr_core_handle_t sr = _init(0, NULL);
+    TEST_ASSERT(sr != NULL);
+    if (sr == NULL) {
+        return;
+    }
+    char *text = _utterance(sr);
+    TEST_ASSERT_EQUAL_STRING(TEST_TEXT, text ? text : "");
+    sr_core_get_result_info(sr, &info);
+    TEST_ASSERT_EQUAL_INT(1, info.retries);
+    sr_mock_server_stats(s_xunfei, &stats, false);
+    TEST_ASSERT_EQUAL_INT(2, stats.requests);
+    sr_core_destroy(sr);
+}
+
+static void test_dropped_session_retried(void)
+{
+    _dropped_session_retried(false);
+}
+
+static void test_dropped_before_final_retried(void)
+{
+    _dropped_session_retried(true);
+}
+
+/* Without retries the broken session has no text, not the partial one nor a stale one */
+static void test_dropped_session_fails(void)
+{
+    sr_mock_config_t config = {
+        .text = TEST_TEXT,
+        .api_key = TEST_KEY,
+        .api_secret = TEST_SECRET,
+        .fail_request = 1,
+        .fail_at_end = true,
+    };
+    sr_mock_stats_t stats;
+    sr_mock_server_configure(s_xunfei, &config);
+    sr_mock_server_stats(s_xunfei, &stats, true);
+    sr_core_handle_t sr = _init(-1, NULL);
+    TEST_ASSERT(sr != NULL);
+    if (sr == NULL) {
+        return;
+    }
+    TEST_ASSERT(_utterance(sr) == NULL);
+    char *text = _utterance(sr);
+    TEST_ASSERT_EQUAL_STRING(TEST_TEXT, text ? text : "");
+    sr_core_destroy(sr);
+}
+
+/* 10105 is an unauthorized app id: one session, no retry, nothing spooled, no text */
+static void test_rejected_not_retried(void)
+{
+    sr_mock_config_t config = {
+        .text = TEST_TEXT,
+        .api_key = TEST_KEY,
+        .api_secret = TEST_SECRET,
+        .error_code = 10105,
+    };
+    sr_mock_stats_t stats;
+    sr_host_flash_stats_t flash;
+    sr_core_result_info_t info;
+    sr_mock_server_configure(s_xunfei, &config);
+    sr_mock_server_stats(s_xunfei, &stats, true);
+    sr_host_flash_reset();
+    const esp_partition_t *part = sr_host_flash_add(TEST_SPOOL, ESP_PARTITION_TYPE_DATA, SR_SPOOL_PARTITION_SUBTYPE,
+                                                    4 * SPI_FLASH_SEC_SIZE, NULL);
+    TEST_ASSERT(part != NULL);
+    sr_core_handle_t sr = _init(2, TEST_SPOOL);
+    TEST_ASSERT(sr != NULL);
+    if (sr == NULL || part == NULL) {
+        return;
+    }
+    TEST_ASSERT(_utterance(sr) == NULL);
+    sr_core_get_result_info(sr, &info);
+    TEST_ASSERT_EQUAL_INT(0, info.retries);
+    sr_mock_server_stats(s_xunfei, &stats, false);
+    TEST_ASSERT_EQUAL_INT(1, stats.requests);
+    sr_host_flash_stats(part, &flash);
+    TEST_ASSERT_EQUAL_INT(0, flash.write_bytes);
+    sr_core_destroy(sr);
+    sr_host_flash_reset();
+}
+
+int main(void)
+{
+    esp_log_level_set("*", getenv("SR_LOG") ? atoi(getenv("SR_LOG")) : ESP_LOG_WARN);
+    /* The host clock is right, the url is signed with it */
+    sr_clock_init(NULL);
+    sr_mock_config_t mock_cfg = { .text = TEST_TEXT, .api_key = TEST_KEY, .api_secret = TEST_SECRET };
+    s_xunfei = sr_mock_xunfei_start(&mock_cfg);
+    TEST_ASSERT(s_xunfei != NULL);
+    if (s_xunfei == NULL) {
+        return sr_test_result();
+    }
+    sr_test_clip_speech(&s_clip, 1000, TEST_SAMPLE_RATE, 1);
+    RUN_TEST(test_dropped_session_retried);
+    RUN_TEST(test_dropped_before_final_retried);
+    RUN_TEST(test_dropped_session_fails);
+    RUN_TEST(test_rejected_not_retried);
+    sr_test_clip_free(&s_clip);
+    sr_mock_server_stop(s_xunfei);
+    return sr_test_result();
+}